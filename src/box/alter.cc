@@ -214,6 +214,12 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			  "'euclid' or 'manhattan'");
 		return -1;
 	}
+	if (opts->hash_layout == hash_layout_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 "hash_layout must be either 'light' or 'swiss'");
+		return -1;
+	}
 	if (opts->page_size <= 0 || (opts->range_size > 0 &&
 				     opts->page_size > opts->range_size)) {
 		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
@@ -241,6 +247,12 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			 "less than or equal to 1");
 		return -1;
 	}
+	if (opts->bloom_type == tuple_bloom_type_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 "bloom_type must be either 'classic' or 'fuse'");
+		return -1;
+	}
 	return 0;
 }
 
@@ -862,6 +874,11 @@ static struct alter_space *
 alter_space_new(struct space *old_space)
 {
 	struct txn *txn = in_txn();
+	if (old_space->is_bulk_loading) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(old_space),
+			 "the space is being bulk loaded");
+		return NULL;
+	}
 	size_t size = sizeof(struct alter_space);
 	struct alter_space *alter = (struct alter_space *)
 		region_aligned_alloc(&in_txn()->region, size,
@@ -33,10 +33,12 @@
 #include <msgpuck.h>
 
 #include "xlog.h"
+#include "cbus.h"
 #include "fiber.h"
 #include "fiber_cond.h"
 #include "coio.h"
 #include "coio_buf.h"
+#include "coio_task.h"
 #include "wal.h"
 #include "xrow.h"
 #include "replication.h"
@@ -48,9 +50,11 @@
 #include "session.h"
 #include "cfg.h"
 #include "schema.h"
+#include "space.h"
 #include "txn.h"
 #include "box.h"
 #include "scoped_guard.h"
+#include "tt_static.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -388,6 +392,238 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Start decompressing the stream received from the master.
+ * Data read from the socket along with the last uncompressed
+ * packet is passed to the decompressor.
+ */
+static void
+applier_start_decompression(struct applier *applier)
+{
+	assert(applier->decompressor == NULL);
+	memset(&applier->compression_stat, 0,
+	       sizeof(applier->compression_stat));
+	struct xrow_decompressor *d =
+		xrow_decompressor_new(&cord()->slabc,
+				      &applier->compression_stat);
+	if (d == NULL)
+		diag_raise();
+	if (xrow_decompressor_feed(d, applier->ibuf.rpos,
+				   ibuf_used(&applier->ibuf)) != 0) {
+		xrow_decompressor_delete(d);
+		diag_raise();
+	}
+	ibuf_reset(&applier->ibuf);
+	applier->decompressor = d;
+	applier->is_compressed = true;
+}
+
+static void
+applier_stop_decompression(struct applier *applier)
+{
+	applier->is_compressed = false;
+	if (applier->decompressor == NULL)
+		return;
+	xrow_decompressor_delete(applier->decompressor);
+	applier->decompressor = NULL;
+}
+
+/** Compression of the stream to request from the master. */
+static inline uint32_t
+applier_compression(void)
+{
+	return replication_compression ? IPROTO_COMPRESSION_ZSTD :
+					 IPROTO_COMPRESSION_NONE;
+}
+
+/**
+ * A connection receiving a part of the initial JOIN data
+ * sent over several connections.
+ */
+struct applier_join_stream {
+	struct applier_join *join;
+	/** Fiber reading and applying the rows. */
+	struct fiber *fiber;
+	/** Number of rows applied. */
+	uint64_t row_count;
+};
+
+/** Initial JOIN data received over several connections. */
+struct applier_join {
+	struct applier *applier;
+	/** Set if the connections are compressed. */
+	bool is_compressed;
+	/** Connections additional to the JOIN one. */
+	struct applier_join_stream streams[REPLICATION_JOIN_STREAMS_MAX - 1];
+	int stream_count;
+};
+
+/**
+ * Connect to the master and attach the connection to the JOIN
+ * sent by the applier.
+ */
+static void
+applier_join_stream_connect(struct applier *applier, struct ev_io *coio,
+			    struct ibuf *ibuf)
+{
+	union {
+		struct sockaddr addr;
+		struct sockaddr_storage addrstorage;
+	};
+	socklen_t addr_len = sizeof(addrstorage);
+	coio_connect(coio, &applier->uri, &addr, &addr_len);
+	char greetingbuf[IPROTO_GREETING_SIZE];
+	coio_readn(coio, greetingbuf, IPROTO_GREETING_SIZE);
+	struct greeting greeting;
+	if (greeting_decode(greetingbuf, &greeting) != 0)
+		tnt_raise(LoggedError, ER_PROTOCOL, "Invalid greeting");
+	/* The address may resolve to another instance. */
+	if (!tt_uuid_is_equal(&greeting.uuid, &applier->uuid)) {
+		tnt_raise(LoggedError, ER_PROTOCOL,
+			  "JOIN stream is connected to another instance");
+	}
+
+	struct xrow_header row;
+	struct uri *uri = &applier->uri;
+	if (uri->login != NULL) {
+		xrow_encode_auth_xc(&row, greeting.salt, greeting.salt_len,
+				    uri->login, uri->login_len,
+				    uri->password != NULL ? uri->password : "",
+				    uri->password_len);
+		coio_write_xrow(coio, &row);
+		coio_read_xrow(coio, ibuf, &row);
+		if (row.type != IPROTO_OK)
+			xrow_decode_error_xc(&row); /* auth failed */
+	}
+	xrow_encode_join_stream_xc(&row, &INSTANCE_UUID);
+	coio_write_xrow(coio, &row);
+}
+
+static void
+applier_join_stream_recv(struct applier_join_stream *stream,
+			 struct ev_io *coio, struct ibuf *ibuf,
+			 struct xrow_decompressor *d)
+{
+	struct applier *applier = stream->join->applier;
+	struct xrow_header row;
+	while (true) {
+		coio_read_xrow_compressed_xc(coio, d, ibuf, &row,
+					     TIMEOUT_INFINITY);
+		applier->last_row_time = ev_monotonic_now(loop());
+		if (iproto_type_is_dml(row.type)) {
+			if (apply_snapshot_row(&row) != 0)
+				diag_raise();
+			stream->row_count++;
+		} else if (row.type == IPROTO_OK) {
+			break; /* end of stream */
+		} else if (iproto_type_is_error(row.type)) {
+			xrow_decode_error_xc(&row);  /* rethrow error */
+		} else {
+			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				  (uint32_t) row.type);
+		}
+		if (ibuf_used(ibuf) == 0)
+			ibuf_reset(ibuf);
+	}
+}
+
+static int
+applier_join_stream_f(va_list ap)
+{
+	struct applier_join_stream *stream =
+		va_arg(ap, struct applier_join_stream *);
+	struct applier_join *join = stream->join;
+	struct ev_io io;
+	coio_create(&io, -1);
+	struct ibuf ibuf;
+	ibuf_create(&ibuf, &cord()->slabc, 1024);
+	struct xrow_decompressor *d = NULL;
+	auto guard = make_scoped_guard([&] {
+		if (d != NULL)
+			xrow_decompressor_delete(d);
+		ibuf_destroy(&ibuf);
+		if (io.fd >= 0)
+			coio_close(loop(), &io);
+	});
+	try {
+		applier_join_stream_connect(join->applier, &io, &ibuf);
+		if (join->is_compressed) {
+			d = xrow_decompressor_new(&cord()->slabc,
+					&join->applier->compression_stat);
+			if (d == NULL)
+				diag_raise();
+		}
+		applier_join_stream_recv(stream, &io, &ibuf, d);
+	} catch (FiberIsCancelled *e) {
+		return -1;
+	} catch (Exception *e) {
+		e->log();
+		return -1;
+	}
+	return 0;
+}
+
+/** Open additional connections to receive the initial data. */
+static void
+applier_join_start(struct applier_join *join, int stream_count)
+{
+	assert(stream_count < REPLICATION_JOIN_STREAMS_MAX);
+	for (int i = 0; i < stream_count; i++) {
+		struct applier_join_stream *stream = &join->streams[i];
+		stream->join = join;
+		stream->row_count = 0;
+		stream->fiber = fiber_new_xc("applier_join",
+					     applier_join_stream_f);
+		fiber_set_joinable(stream->fiber, true);
+		join->stream_count++;
+		fiber_start(stream->fiber, stream);
+	}
+}
+
+/**
+ * Wait for all additional connections to receive their rows.
+ * Return the number of rows applied.
+ */
+static uint64_t
+applier_join_wait(struct applier_join *join)
+{
+	uint64_t row_count = 0;
+	int rc = 0;
+	for (int i = 0; i < join->stream_count; i++) {
+		struct applier_join_stream *stream = &join->streams[i];
+		if (fiber_join(stream->fiber) != 0)
+			rc = -1;
+		row_count += stream->row_count;
+	}
+	join->stream_count = 0;
+	if (rc != 0)
+		diag_raise();
+	return row_count;
+}
+
+/** Abort receiving rows over additional connections. */
+static void
+applier_join_stop(struct applier_join *join)
+{
+	if (join->stream_count == 0)
+		return;
+	/*
+	 * Joining a cancelled fiber overwrites the diagnostics,
+	 * keep the error we are stopping on.
+	 */
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	for (int i = 0; i < join->stream_count; i++) {
+		struct applier_join_stream *stream = &join->streams[i];
+		fiber_cancel(stream->fiber);
+		fiber_join(stream->fiber);
+	}
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+	join->stream_count = 0;
+}
+
 static uint64_t
 applier_wait_snapshot(struct applier *applier)
 {
@@ -395,6 +631,16 @@ applier_wait_snapshot(struct applier *applier)
 	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
 
+	struct applier_join join;
+	join.applier = applier;
+	join.is_compressed = false;
+	join.stream_count = 0;
+	auto join_guard = make_scoped_guard([&] {
+		applier_join_stop(&join);
+	});
+	/* Number of additional connections to open. */
+	uint32_t join_streams = 1;
+
 	/**
 	 * Tarantool < 1.7.0: if JOIN is successful, there is no "OK"
 	 * response, but a stream of rows from checkpoint.
@@ -414,22 +660,40 @@ applier_wait_snapshot(struct applier *applier)
 		 * Used to initialize the replica's initial
 		 * vclock in bootstrap_from_master()
 		 */
-		xrow_decode_vclock_xc(&row, &replicaset.vclock);
+		uint32_t compression;
+		xrow_decode_join_response_xc(&row, &replicaset.vclock,
+					     &compression, &join_streams);
+		if (compression == IPROTO_COMPRESSION_ZSTD)
+			applier_start_decompression(applier);
+		join.is_compressed = compression == IPROTO_COMPRESSION_ZSTD;
 	}
+	/*
+	 * The master may send parts of the initial data over
+	 * additional connections after the system spaces.
+	 */
+	join_streams = MAX(join_streams, 1U);
+	join_streams = MIN(join_streams, (uint32_t)REPLICATION_JOIN_STREAMS_MAX);
+	uint32_t join_streams_pending = join_streams - 1;
 
 	/*
 	 * Receive initial data.
 	 */
 	uint64_t row_count = 0;
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow_compressed_xc(coio, applier->decompressor,
+					     ibuf, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			if (apply_snapshot_row(&row) != 0)
 				diag_raise();
 			if (++row_count % 100000 == 0)
 				say_info("%.1fM rows received", row_count / 1e6);
+		} else if (row.type == IPROTO_OK && join_streams_pending > 0) {
+			/* End of system spaces. */
+			applier_join_start(&join, join_streams_pending);
+			join_streams_pending = 0;
 		} else if (row.type == IPROTO_OK) {
+			row_count += applier_join_wait(&join);
 			if (applier->version_id < version_id(1, 7, 0)) {
 				/*
 				 * This is the start vclock if the
@@ -488,7 +752,8 @@ applier_wait_register(struct applier *applier, uint64_t row_count)
 	 * Receive final data.
 	 */
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow_compressed_xc(coio, applier->decompressor,
+					     ibuf, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			vclock_follow_xrow(&replicaset.vclock, &row);
@@ -547,7 +812,8 @@ applier_join(struct applier *applier)
 	struct xrow_header row;
 	uint64_t row_count;
 
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, applier_compression(),
+			    replication_join_streams);
 	coio_write_xrow(coio, &row);
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
@@ -558,7 +824,10 @@ applier_join(struct applier *applier)
 
 	applier_set_state(applier, APPLIER_FINAL_JOIN);
 
-	if (applier_wait_register(applier, row_count) == row_count) {
+	uint64_t final_row_count = applier_wait_register(applier, row_count);
+	/* The JOIN stream is over, SUBSCRIBE negotiates anew. */
+	applier_stop_decompression(applier);
+	if (final_row_count == row_count) {
 		/*
 		 * We didn't receive any rows during registration.
 		 * Proceed to "subscribe" and do not finish bootstrap
@@ -573,6 +842,150 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+enum {
+	/**
+	 * Max number of batches of transactions sent to tx by
+	 * an applier thread and not applied yet.
+	 */
+	APPLIER_BATCH_MAX = 16,
+	/**
+	 * Size of a batch reaching which it is sent to tx without
+	 * waiting for rows already received from the master.
+	 */
+	APPLIER_BATCH_SIZE_MAX = 512 * 1024,
+	/**
+	 * Max number of transactions applied concurrently by
+	 * an applier.
+	 */
+	APPLIER_TX_IN_FLIGHT_MAX = 32,
+};
+
+struct applier_batch;
+
+/**
+ * A transaction received from the master. It's read and decoded
+ * by an applier thread and applied by tx. Rows and their bodies
+ * are stored in the same memory block as the struct.
+ */
+struct applier_tx {
+	/** Link in applier_thread::txs. */
+	struct stailq_entry in_queue;
+	/** Link in applier_pipeline::txs. */
+	struct rlist in_pipeline;
+	/** Batch this transaction was sent to tx in. */
+	struct applier_batch *batch;
+	/** Size of the memory block. */
+	size_t size;
+	/** Commit order, see applier_pipeline::commit_seq. */
+	int64_t seq;
+	/** Monotonic time when the transaction was received. */
+	double recv_time;
+	/** Replication lag of the last row of the transaction. */
+	double lag;
+	/** Number of rows in the transaction. */
+	int row_count;
+	/** Rows of the transaction. */
+	struct xrow_header *rows;
+	/** Ids of spaces changed by the rows, 0 if not a DML row. */
+	uint32_t *space_ids;
+};
+
+/**
+ * A bunch of transactions sent by an applier thread to tx.
+ * It is returned to the thread as soon as all of them are
+ * applied, which limits the memory used for rows received
+ * from the master but not applied yet.
+ */
+struct applier_batch {
+	struct cmsg base;
+	/** Thread that sent the batch. */
+	struct applier_thread *thread;
+	/** Transactions linked by applier_tx::in_queue. */
+	struct stailq txs;
+	/** Number of transactions not freed yet. */
+	int tx_count;
+	/** Total size of the transactions. */
+	size_t size;
+};
+
+/**
+ * A thread reading rows sent by the master to an applier in
+ * SUBSCRIBE mode. It decodes rows and groups them into
+ * transactions so that the tx thread only applies them.
+ */
+struct applier_thread {
+	/** The thread. */
+	struct cord cord;
+	/** Applier the rows are read for. */
+	struct applier *applier;
+	/** Rows read ahead by tx along with SUBSCRIBE response. */
+	const char *readahead;
+	/** Size of readahead data. */
+	size_t readahead_size;
+	/** Set if the rows are compressed, see applier::is_compressed. */
+	bool is_compressed;
+	/** Endpoint of the thread, receives returned batches. */
+	struct cbus_endpoint endpoint;
+	/** A pipe from the thread to tx. */
+	struct cpipe tx_pipe;
+	/** A pipe from tx to the thread. */
+	struct cpipe thread_pipe;
+	/**
+	 * Number of batches sent to tx and not returned yet.
+	 * Accessed only by the thread.
+	 */
+	int batch_count;
+	/** Signaled when a batch is returned to the thread. */
+	struct fiber_cond batch_cond;
+	/** Sent to tx when the thread is paired with it. */
+	struct cmsg ready_msg;
+	/** Sent to tx when the thread stops reading on error. */
+	struct cmsg error_msg;
+	/** The error which stopped the thread. */
+	struct diag diag;
+	/* ----------------- tx ------------------- */
+	/** Received transactions, linked by applier_tx::in_queue. */
+	struct stailq txs;
+	/** Signaled when a message from the thread is delivered. */
+	struct fiber_cond cond;
+	/** Set when ready_msg is delivered. */
+	bool is_ready;
+	/** Set when error_msg is delivered. */
+	bool is_failed;
+	/** Set when tx doesn't accept transactions any longer. */
+	bool is_stopping;
+};
+
+/**
+ * Transactions of an applier which are being applied
+ * concurrently, each by its own fiber. They are submitted to
+ * WAL strictly in the order they were received.
+ */
+struct applier_pipeline {
+	/** Session to apply transactions in. */
+	struct session *session;
+	/**
+	 * Order latch of the replica the transactions originate
+	 * from, held while there are transactions in flight.
+	 */
+	struct latch *latch;
+	/** Transactions being applied, linked by in_pipeline. */
+	struct rlist txs;
+	/** Number of transactions being applied. */
+	int tx_count;
+	/** Sequence number of the next transaction to apply. */
+	int64_t next_seq;
+	/** Sequence number of the next transaction to commit. */
+	int64_t commit_seq;
+	/** Signaled when a transaction is committed. */
+	struct fiber_cond cond;
+	/**
+	 * The error of the first failed transaction. All
+	 * transactions following it are rolled back.
+	 */
+	struct diag diag;
+};
+
 /**
  * A helper struct to link xrow objects in a list.
  */
@@ -584,11 +997,9 @@ struct applier_tx_row {
 };
 
 static struct applier_tx_row *
-applier_read_tx_row(struct applier *applier)
+applier_read_tx_row(struct applier *applier, struct ev_io *coio,
+		    struct xrow_decompressor *d, struct ibuf *ibuf)
 {
-	struct ev_io *coio = &applier->io;
-	struct ibuf *ibuf = &applier->ibuf;
-
 	struct applier_tx_row *tx_row = (struct applier_tx_row *)
 		region_alloc(&fiber()->gc, sizeof(struct applier_tx_row));
 
@@ -606,30 +1017,49 @@ applier_read_tx_row(struct applier *applier)
 	 * broken - the master might just be idle.
 	 */
 	if (applier->version_id < version_id(1, 7, 7))
-		coio_read_xrow(coio, ibuf, row);
-	else
-		coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
-
-	applier->lag = ev_now(loop()) - row->tm;
-	applier->last_row_time = ev_monotonic_now(loop());
+		timeout = TIMEOUT_INFINITY;
+	coio_read_xrow_compressed_xc(coio, d, ibuf, row, timeout);
 	return tx_row;
 }
 
+/** Return the id of the space changed by a row, 0 if none. */
+static uint32_t
+applier_row_space_id(struct xrow_header *row)
+{
+	if (!iproto_type_is_dml(row->type) || row->type == IPROTO_NOP)
+		return 0;
+	struct request request;
+	if (xrow_decode_dml(row, &request,
+			    dml_request_key_map(row->type)) != 0) {
+		/* The error is reported when the row is applied. */
+		diag_clear(diag_get());
+		return 0;
+	}
+	return request.space_id;
+}
+
 /**
  * Read one transaction from network using applier's input buffer.
- * Transaction rows are placed onto fiber gc region.
+ * Called by the applier thread. Transaction rows are collected
+ * on fiber gc region and then copied to a single memory block
+ * which is freed by tx once the transaction is applied.
  * We could not use applier input buffer to store rows because
  * rpos is adjusted as xrow is decoded and the corresponding
  * network input space is reused for the next xrow.
  */
-static void
-applier_read_tx(struct applier *applier, struct stailq *rows)
+static struct applier_tx *
+applier_read_tx(struct applier *applier, struct ev_io *coio,
+		struct xrow_decompressor *d, struct ibuf *ibuf)
 {
 	int64_t tsn = 0;
+	int row_count = 0;
+	size_t body_size = 0;
 
-	stailq_create(rows);
+	struct stailq rows;
+	stailq_create(&rows);
 	do {
-		struct applier_tx_row *tx_row = applier_read_tx_row(applier);
+		struct applier_tx_row *tx_row =
+			applier_read_tx_row(applier, coio, d, ibuf);
 		struct xrow_header *row = &tx_row->row;
 
 		if (iproto_type_is_error(row->type))
@@ -667,10 +1097,9 @@ applier_read_tx(struct applier *applier, struct stailq *rows)
 		if (row->bodycnt == 1 && !row->is_commit) {
 			/*
 			 * Save row body to gc region.
-			 * Not done for single-statement
-			 * transactions knowing that the input
-			 * buffer will not be used while the
-			 * transaction is applied.
+			 * Not done for the last row knowing
+			 * that it is copied before the input
+			 * buffer is used again.
 			 */
 			void *new_base = region_alloc(&fiber()->gc,
 						      row->body->iov_len);
@@ -682,12 +1111,349 @@ applier_read_tx(struct applier *applier, struct stailq *rows)
 			/* Adjust row body pointers. */
 			row->body->iov_base = new_base;
 		}
-		stailq_add_tail(rows, &tx_row->next);
+		if (row->bodycnt == 1)
+			body_size += row->body->iov_len;
+		row_count++;
+		stailq_add_tail(&rows, &tx_row->next);
 
-	} while (!stailq_last_entry(rows, struct applier_tx_row,
+	} while (!stailq_last_entry(&rows, struct applier_tx_row,
 				    next)->row.is_commit);
+
+	size_t size = sizeof(struct applier_tx) + row_count *
+		      (sizeof(struct xrow_header) + sizeof(uint32_t)) +
+		      body_size;
+	struct applier_tx *tx = (struct applier_tx *)malloc(size);
+	if (tx == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "struct applier_tx");
+	tx->size = size;
+	tx->row_count = row_count;
+	tx->rows = (struct xrow_header *)(tx + 1);
+	tx->space_ids = (uint32_t *)(tx->rows + row_count);
+	char *body = (char *)(tx->space_ids + row_count);
+	struct applier_tx_row *item;
+	int i = 0;
+	stailq_foreach_entry(item, &rows, next) {
+		struct xrow_header *row = &tx->rows[i];
+		*row = item->row;
+		if (row->bodycnt == 1) {
+			memcpy(body, row->body->iov_base, row->body->iov_len);
+			row->body->iov_base = body;
+			body += row->body->iov_len;
+		}
+		tx->space_ids[i] = applier_row_space_id(row);
+		i++;
+	}
+	tx->recv_time = ev_monotonic_now(loop());
+	tx->lag = ev_now(loop()) - tx->rows[row_count - 1].tm;
+	return tx;
+}
+
+/** Return a batch to the thread once it is applied. */
+static void
+applier_batch_return(struct applier_batch *batch);
+
+/** Free a transaction after it has been applied. */
+static void
+applier_tx_free(struct applier_tx *tx)
+{
+	struct applier_batch *batch = tx->batch;
+	free(tx);
+	assert(batch->tx_count > 0);
+	if (--batch->tx_count == 0)
+		applier_batch_return(batch);
+}
+
+/* {{{ Applier thread */
+
+/** Free transactions which will never be applied. */
+static void
+applier_batch_delete(struct applier_batch *batch)
+{
+	struct applier_tx *tx, *next;
+	stailq_foreach_entry_safe(tx, next, &batch->txs, in_queue)
+		free(tx);
+	free(batch);
+}
+
+/** Add a batch received from an applier thread to the tx queue. */
+static void
+applier_batch_deliver(struct cmsg *m)
+{
+	struct applier_batch *batch = (struct applier_batch *)m;
+	struct applier_thread *thread = batch->thread;
+	if (thread->is_stopping) {
+		applier_batch_delete(batch);
+		return;
+	}
+	stailq_concat(&thread->txs, &batch->txs);
+	fiber_cond_signal(&thread->cond);
+}
+
+/** Free a batch returned by tx. Runs in the applier thread. */
+static void
+applier_batch_release(struct cmsg *m)
+{
+	struct applier_batch *batch = (struct applier_batch *)m;
+	struct applier_thread *thread = batch->thread;
+	free(batch);
+	assert(thread->batch_count > 0);
+	thread->batch_count--;
+	fiber_cond_signal(&thread->batch_cond);
+}
+
+static void
+applier_batch_return(struct applier_batch *batch)
+{
+	static const struct cmsg_hop route[] = {
+		{applier_batch_release, NULL},
+	};
+	if (batch->thread->is_stopping) {
+		free(batch);
+		return;
+	}
+	cmsg_init(&batch->base, route);
+	cpipe_push(&batch->thread->thread_pipe, &batch->base);
+}
+
+/**
+ * Allocate a batch to send transactions to tx. Wait until tx
+ * has applied enough of the batches sent before.
+ */
+static struct applier_batch *
+applier_batch_new(struct applier_thread *thread)
+{
+	while (thread->batch_count >= APPLIER_BATCH_MAX) {
+		fiber_cond_wait(&thread->batch_cond);
+		fiber_testcancel();
+	}
+	struct applier_batch *batch =
+		(struct applier_batch *)malloc(sizeof(*batch));
+	if (batch == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*batch), "malloc",
+			  "struct applier_batch");
+	}
+	batch->thread = thread;
+	stailq_create(&batch->txs);
+	batch->tx_count = 0;
+	batch->size = 0;
+	thread->batch_count++;
+	return batch;
+}
+
+static void
+applier_batch_send(struct applier_batch *batch)
+{
+	static const struct cmsg_hop route[] = {
+		{applier_batch_deliver, NULL},
+	};
+	cmsg_init(&batch->base, route);
+	cpipe_push(&batch->thread->tx_pipe, &batch->base);
+}
+
+/** Check if an input buffer contains a whole packet. */
+static bool
+applier_ibuf_has_packet(struct ibuf *ibuf)
+{
+	const char *data = ibuf->rpos;
+	if (data == ibuf->wpos || mp_typeof(*data) != MP_UINT ||
+	    mp_check_uint(data, ibuf->wpos) > 0)
+		return false;
+	uint64_t len = mp_decode_uint(&data);
+	return (uint64_t)(ibuf->wpos - data) >= len;
+}
+
+/**
+ * Applier thread fiber reading transactions from the master.
+ * Received transactions are sent to tx in batches: a batch is
+ * sent as soon as there's no whole row left in the input
+ * buffer, so reading more would have to wait for the network.
+ */
+static int
+applier_thread_reader_f(va_list ap)
+{
+	struct applier_thread *thread = va_arg(ap, struct applier_thread *);
+	struct applier *applier = thread->applier;
+	struct ev_io io;
+	coio_create(&io, applier->io.fd);
+	struct ibuf ibuf;
+	ibuf_create(&ibuf, &cord()->slabc, 1024);
+	struct xrow_decompressor *d = NULL;
+	struct applier_batch *batch = NULL;
+	try {
+		if (thread->is_compressed) {
+			d = xrow_decompressor_new(&cord()->slabc,
+						  &applier->compression_stat);
+			if (d == NULL)
+				diag_raise();
+			if (xrow_decompressor_feed(d, thread->readahead,
+						   thread->readahead_size) != 0)
+				diag_raise();
+		} else if (thread->readahead_size > 0) {
+			void *data = ibuf_alloc(&ibuf, thread->readahead_size);
+			if (data == NULL) {
+				tnt_raise(OutOfMemory, thread->readahead_size,
+					  "ibuf", "applier readahead");
+			}
+			memcpy(data, thread->readahead,
+			       thread->readahead_size);
+		}
+		while (true) {
+			if (batch == NULL)
+				batch = applier_batch_new(thread);
+			struct applier_tx *tx = applier_read_tx(applier, &io,
+								d, &ibuf);
+			tx->batch = batch;
+			stailq_add_tail_entry(&batch->txs, tx, in_queue);
+			batch->tx_count++;
+			batch->size += tx->size;
+			if (!applier_ibuf_has_packet(&ibuf) ||
+			    batch->size >= APPLIER_BATCH_SIZE_MAX) {
+				applier_batch_send(batch);
+				batch = NULL;
+			}
+			if (ibuf_used(&ibuf) == 0)
+				ibuf_reset(&ibuf);
+			fiber_gc();
+		}
+	} catch (Exception *e) {
+		/*
+		 * Let tx apply the rows received so far unless
+		 * it has stopped the thread.
+		 */
+		bool is_stopped = fiber_is_cancelled();
+		if (batch != NULL && batch->tx_count > 0 && !is_stopped) {
+			applier_batch_send(batch);
+		} else if (batch != NULL) {
+			applier_batch_delete(batch);
+			thread->batch_count--;
+		}
+		if (!is_stopped) {
+			diag_move(diag_get(), &thread->diag);
+			cpipe_push(&thread->tx_pipe, &thread->error_msg);
+		}
+	}
+	if (d != NULL)
+		xrow_decompressor_delete(d);
+	ibuf_destroy(&ibuf);
+	fiber_gc();
+	return 0;
 }
 
+static int
+applier_thread_f(va_list ap)
+{
+	struct applier_thread *thread = va_arg(ap, struct applier_thread *);
+
+	coio_enable();
+	cbus_endpoint_create(&thread->endpoint,
+			     tt_sprintf("applier_%p", thread),
+			     fiber_schedule_cb, fiber());
+	cbus_pair("tx", thread->endpoint.name, &thread->tx_pipe,
+		  &thread->thread_pipe, NULL, NULL, cbus_process);
+	fiber_cond_create(&thread->batch_cond);
+
+	struct fiber *reader = fiber_new("reader", applier_thread_reader_f);
+	if (reader != NULL) {
+		fiber_set_joinable(reader, true);
+		/* Takes readahead data before tx gets ready_msg. */
+		fiber_start(reader, thread);
+	}
+	cpipe_push(&thread->tx_pipe, &thread->ready_msg);
+	if (reader == NULL) {
+		diag_move(diag_get(), &thread->diag);
+		cpipe_push(&thread->tx_pipe, &thread->error_msg);
+	}
+
+	/* Process returned batches until tx stops the thread. */
+	cbus_loop(&thread->endpoint);
+
+	if (reader != NULL) {
+		fiber_cancel(reader);
+		fiber_join(reader);
+	}
+	cbus_unpair(&thread->tx_pipe, &thread->thread_pipe,
+		    NULL, NULL, cbus_process);
+	cbus_endpoint_destroy(&thread->endpoint, cbus_process);
+	fiber_cond_destroy(&thread->batch_cond);
+	return 0;
+}
+
+static void
+applier_thread_on_ready(struct cmsg *m)
+{
+	struct applier_thread *thread =
+		container_of(m, struct applier_thread, ready_msg);
+	thread->is_ready = true;
+	fiber_cond_signal(&thread->cond);
+}
+
+static void
+applier_thread_on_error(struct cmsg *m)
+{
+	struct applier_thread *thread =
+		container_of(m, struct applier_thread, error_msg);
+	thread->is_failed = true;
+	fiber_cond_signal(&thread->cond);
+}
+
+/**
+ * Start a thread reading rows for an applier which has just
+ * subscribed. Rows already read to the applier input buffer
+ * are handed over to the thread.
+ */
+static void
+applier_thread_start(struct applier_thread *thread, struct applier *applier)
+{
+	static const struct cmsg_hop ready_route[] = {
+		{applier_thread_on_ready, NULL},
+	};
+	static const struct cmsg_hop error_route[] = {
+		{applier_thread_on_error, NULL},
+	};
+	thread->applier = applier;
+	thread->readahead = applier->ibuf.rpos;
+	thread->readahead_size = ibuf_used(&applier->ibuf);
+	thread->is_compressed = applier->is_compressed;
+	thread->batch_count = 0;
+	cmsg_init(&thread->ready_msg, ready_route);
+	cmsg_init(&thread->error_msg, error_route);
+	diag_create(&thread->diag);
+	stailq_create(&thread->txs);
+	fiber_cond_create(&thread->cond);
+	thread->is_ready = false;
+	thread->is_failed = false;
+	thread->is_stopping = false;
+
+	if (cord_costart(&thread->cord, "applier", applier_thread_f,
+			 thread) != 0) {
+		fiber_cond_destroy(&thread->cond);
+		diag_raise();
+	}
+	/* Wait for the thread to pair with tx. */
+	bool cancellable = fiber_set_cancellable(false);
+	while (!thread->is_ready)
+		fiber_cond_wait(&thread->cond);
+	fiber_set_cancellable(cancellable);
+	ibuf_reset(&applier->ibuf);
+}
+
+static void
+applier_thread_stop(struct applier_thread *thread)
+{
+	thread->is_stopping = true;
+	while (!stailq_empty(&thread->txs)) {
+		applier_tx_free(stailq_shift_entry(&thread->txs,
+						   struct applier_tx,
+						   in_queue));
+	}
+	cbus_stop_loop(&thread->thread_pipe);
+	cord_cojoin(&thread->cord);
+	diag_destroy(&thread->diag);
+	fiber_cond_destroy(&thread->cond);
+}
+
+/* }}} */
+
 static int
 applier_txn_rollback_cb(struct trigger *trigger, void *event)
 {
@@ -712,31 +1478,13 @@ applier_txn_commit_cb(struct trigger *trigger, void *event)
 }
 
 /**
- * Apply all rows in the rows queue as a single transaction.
+ * Begin a transaction and apply all rows of @a tx in it.
  *
- * Return 0 for success or -1 in case of an error.
+ * Return the transaction or NULL in case of an error.
  */
-static int
-applier_apply_tx(struct stailq *rows)
+static struct txn *
+applier_apply_rows(struct applier_tx *tx)
 {
-	struct xrow_header *first_row = &stailq_first_entry(rows,
-					struct applier_tx_row, next)->row;
-	struct replica *replica = replica_by_id(first_row->replica_id);
-	/*
-	 * In a full mesh topology, the same set of changes
-	 * may arrive via two concurrently running appliers.
-	 * Hence we need a latch to strictly order all changes
-	 * that belong to the same server id.
-	 */
-	struct latch *latch = (replica ? &replica->order_latch :
-			       &replicaset.applier.order_latch);
-	latch_lock(latch);
-	if (vclock_get(&replicaset.applier.vclock,
-		       first_row->replica_id) >= first_row->lsn) {
-		latch_unlock(latch);
-		return 0;
-	}
-
 	/**
 	 * Explicitly begin the transaction so that we can
 	 * control fiber->gc life cycle and, in case of apply
@@ -744,13 +1492,10 @@ applier_apply_tx(struct stailq *rows)
 	 * IPROTO_NOP on gc.
 	 */
 	struct txn *txn = txn_begin();
-	struct applier_tx_row *item;
-	if (txn == NULL) {
-		latch_unlock(latch);
-		return -1;
-	}
-	stailq_foreach_entry(item, rows, next) {
-		struct xrow_header *row = &item->row;
+	if (txn == NULL)
+		return NULL;
+	for (int i = 0; i < tx->row_count; i++) {
+		struct xrow_header *row = &tx->rows[i];
 		int res = apply_row(row);
 		if (res != 0) {
 			struct error *e = diag_last_error(diag_get());
@@ -789,15 +1534,34 @@ applier_apply_tx(struct stailq *rows)
 			 "Replication", "distributed transactions");
 		goto rollback;
 	}
+	return txn;
+rollback:
+	txn_rollback(txn);
+	fiber_gc();
+	return NULL;
+}
 
+/**
+ * Submit a transaction returned by applier_apply_rows() to WAL
+ * and promote the applier vclock.
+ *
+ * Return 0 for success or -1 in case of an error.
+ */
+static int
+applier_write_tx(struct txn *txn, struct applier_tx *tx)
+{
+	struct xrow_header *first_row = &tx->rows[0];
 	/* We are ready to submit txn to wal. */
 	struct trigger *on_rollback, *on_commit;
 	on_rollback = (struct trigger *)region_alloc(&txn->region,
 						     sizeof(struct trigger));
 	on_commit = (struct trigger *)region_alloc(&txn->region,
 						   sizeof(struct trigger));
-	if (on_rollback == NULL || on_commit == NULL)
-		goto rollback;
+	if (on_rollback == NULL || on_commit == NULL) {
+		txn_rollback(txn);
+		fiber_gc();
+		return -1;
+	}
 
 	trigger_create(on_rollback, applier_txn_rollback_cb, NULL, NULL);
 	txn_on_rollback(txn, on_rollback);
@@ -805,22 +1569,235 @@ applier_apply_tx(struct stailq *rows)
 	trigger_create(on_commit, applier_txn_commit_cb, NULL, NULL);
 	txn_on_commit(txn, on_commit);
 
-	if (txn_write(txn) < 0)
-		goto fail;
+	if (txn_write(txn) < 0) {
+		fiber_gc();
+		return -1;
+	}
 
 	/* Transaction was sent to journal so promote vclock. */
 	vclock_follow(&replicaset.applier.vclock,
 		      first_row->replica_id, first_row->lsn);
-	latch_unlock(latch);
 	return 0;
-rollback:
-	txn_rollback(txn);
-fail:
+}
+
+/**
+ * Apply all rows of a transaction as a single transaction.
+ *
+ * Return 0 for success or -1 in case of an error.
+ */
+static int
+applier_apply_tx(struct applier_tx *tx)
+{
+	struct xrow_header *first_row = &tx->rows[0];
+	struct replica *replica = replica_by_id(first_row->replica_id);
+	/*
+	 * In a full mesh topology, the same set of changes
+	 * may arrive via two concurrently running appliers.
+	 * Hence we need a latch to strictly order all changes
+	 * that belong to the same server id.
+	 */
+	struct latch *latch = (replica ? &replica->order_latch :
+			       &replicaset.applier.order_latch);
+	latch_lock(latch);
+	if (vclock_get(&replicaset.applier.vclock,
+		       first_row->replica_id) >= first_row->lsn) {
+		latch_unlock(latch);
+		return 0;
+	}
+	struct txn *txn = applier_apply_rows(tx);
+	int rc = txn != NULL ? applier_write_tx(txn, tx) : -1;
 	latch_unlock(latch);
+	return rc;
+}
+
+/* {{{ Concurrent apply */
+
+/**
+ * Check if a transaction may be applied concurrently with other
+ * transactions. Only vinyl transactions can yield, and they are
+ * worth applying concurrently, because they yield to read disk.
+ * Changes of system spaces may alter the schema, so they are
+ * applied only after all preceding transactions are committed.
+ */
+static bool
+applier_tx_is_concurrent(struct applier_tx *tx)
+{
+	for (int i = 0; i < tx->row_count; i++) {
+		if (tx->rows[i].type == IPROTO_NOP)
+			continue;
+		uint32_t space_id = tx->space_ids[i];
+		if (space_id < BOX_SYSTEM_ID_MAX)
+			return false;
+		struct space *space = space_by_id(space_id);
+		if (space == NULL || !space_is_vinyl(space))
+			return false;
+	}
+	return true;
+}
+
+/** Check if two transactions change the same space. */
+static bool
+applier_tx_conflicts(struct applier_tx *tx, struct applier_tx *other)
+{
+	for (int i = 0; i < tx->row_count; i++) {
+		if (tx->space_ids[i] == 0)
+			continue;
+		for (int j = 0; j < other->row_count; j++) {
+			if (tx->space_ids[i] == other->space_ids[j])
+				return true;
+		}
+	}
+	return false;
+}
+
+static void
+applier_pipeline_create(struct applier_pipeline *pipeline,
+			struct session *session)
+{
+	pipeline->session = session;
+	pipeline->latch = NULL;
+	rlist_create(&pipeline->txs);
+	pipeline->tx_count = 0;
+	pipeline->next_seq = 0;
+	pipeline->commit_seq = 0;
+	fiber_cond_create(&pipeline->cond);
+	diag_create(&pipeline->diag);
+}
+
+/**
+ * Wait for all transactions being applied to be committed and
+ * release the order latch.
+ */
+static void
+applier_pipeline_drain(struct applier_pipeline *pipeline)
+{
+	bool cancellable = fiber_set_cancellable(false);
+	while (pipeline->tx_count > 0)
+		fiber_cond_wait(&pipeline->cond);
+	fiber_set_cancellable(cancellable);
+	if (pipeline->latch != NULL) {
+		latch_unlock(pipeline->latch);
+		pipeline->latch = NULL;
+	}
+}
+
+static void
+applier_pipeline_destroy(struct applier_pipeline *pipeline)
+{
+	applier_pipeline_drain(pipeline);
+	fiber_cond_destroy(&pipeline->cond);
+	diag_destroy(&pipeline->diag);
+}
+
+/** Raise the error of a failed transaction, if any. */
+static void
+applier_pipeline_check(struct applier_pipeline *pipeline)
+{
+	if (diag_is_empty(&pipeline->diag))
+		return;
+	applier_pipeline_drain(pipeline);
+	diag_move(&pipeline->diag, diag_get());
+	diag_raise();
+}
+
+/** Fiber applying a transaction of an applier pipeline. */
+static int
+applier_pipeline_worker_f(va_list ap)
+{
+	struct applier_pipeline *pipeline =
+		va_arg(ap, struct applier_pipeline *);
+	struct applier_tx *tx = va_arg(ap, struct applier_tx *);
+	fiber_set_session(fiber(), pipeline->session);
+	fiber_set_user(fiber(), &pipeline->session->credentials);
+
+	struct txn *txn = applier_apply_rows(tx);
+	/* Submit transactions to WAL in the order they were received. */
+	while (pipeline->commit_seq != tx->seq)
+		fiber_cond_wait(&pipeline->cond);
+	if (!diag_is_empty(&pipeline->diag)) {
+		/* A preceding transaction failed. */
+		if (txn != NULL) {
+			txn_rollback(txn);
+			fiber_gc();
+		}
+		diag_clear(diag_get());
+	} else if (txn == NULL || applier_write_tx(txn, tx) != 0) {
+		diag_move(diag_get(), &pipeline->diag);
+	}
+	pipeline->commit_seq++;
+	rlist_del_entry(tx, in_pipeline);
+	pipeline->tx_count--;
+	fiber_cond_broadcast(&pipeline->cond);
+	applier_tx_free(tx);
 	fiber_gc();
-	return -1;
+	return 0;
 }
 
+/**
+ * Apply a transaction received from the master. A transaction
+ * which changes only vinyl spaces is applied by a new fiber
+ * concurrently with preceding transactions unless it changes
+ * the same spaces as any of them. Other transactions are
+ * applied once all preceding transactions are committed.
+ * Takes the ownership of @a tx.
+ */
+static void
+applier_pipeline_apply(struct applier_pipeline *pipeline,
+		       struct applier_tx *tx)
+{
+	if (!applier_tx_is_concurrent(tx)) {
+		applier_pipeline_drain(pipeline);
+		int rc = applier_apply_tx(tx);
+		applier_tx_free(tx);
+		if (rc != 0)
+			diag_raise();
+		return;
+	}
+	struct xrow_header *first_row = &tx->rows[0];
+	struct replica *replica = replica_by_id(first_row->replica_id);
+	/* See the comment in applier_apply_tx(). */
+	struct latch *latch = (replica ? &replica->order_latch :
+			       &replicaset.applier.order_latch);
+	if (pipeline->latch != latch) {
+		applier_pipeline_drain(pipeline);
+		latch_lock(latch);
+		pipeline->latch = latch;
+	}
+	if (vclock_get(&replicaset.applier.vclock,
+		       first_row->replica_id) >= first_row->lsn) {
+		applier_tx_free(tx);
+		return;
+	}
+	while (true) {
+		bool is_blocked = pipeline->tx_count >= APPLIER_TX_IN_FLIGHT_MAX;
+		struct applier_tx *other;
+		rlist_foreach_entry(other, &pipeline->txs, in_pipeline) {
+			if (is_blocked)
+				break;
+			is_blocked = applier_tx_conflicts(tx, other);
+		}
+		if (!is_blocked)
+			break;
+		fiber_cond_wait(&pipeline->cond);
+		if (fiber_is_cancelled()) {
+			applier_tx_free(tx);
+			fiber_testcancel();
+		}
+	}
+	struct fiber *worker = fiber_new("applier_tx",
+					 applier_pipeline_worker_f);
+	if (worker == NULL) {
+		applier_tx_free(tx);
+		diag_raise();
+	}
+	tx->seq = pipeline->next_seq++;
+	rlist_add_tail_entry(&pipeline->txs, tx, in_pipeline);
+	pipeline->tx_count++;
+	fiber_start(worker, pipeline, tx);
+}
+
+/* }}} */
+
 /*
  * A trigger to update an applier state after a replication commit.
  */
@@ -867,7 +1844,8 @@ applier_subscribe(struct applier *applier)
 	vclock_create(&vclock);
 	vclock_copy(&vclock, &replicaset.vclock);
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock, replication_anon);
+				 &vclock, replication_anon,
+				 applier_compression());
 	coio_write_xrow(coio, &row);
 
 	/* Read SUBSCRIBE response */
@@ -888,8 +1866,21 @@ applier_subscribe(struct applier *applier)
 		 * its and master's cluster ids match.
 		 */
 		vclock_create(&applier->remote_vclock_at_subscribe);
+		uint32_t compression;
 		xrow_decode_subscribe_response_xc(&row, &cluster_id,
-					&applier->remote_vclock_at_subscribe);
+					&applier->remote_vclock_at_subscribe,
+					&compression);
+		/*
+		 * The rest of the stream is compressed if the
+		 * master confirmed the compression requested by
+		 * this replica. It is decompressed by the applier
+		 * thread, see applier_thread_reader_f().
+		 */
+		if (compression == IPROTO_COMPRESSION_ZSTD) {
+			memset(&applier->compression_stat, 0,
+			       sizeof(applier->compression_stat));
+			applier->is_compressed = true;
+		}
 		/*
 		 * If master didn't send us its cluster id
 		 * assume that it has done all the checks.
@@ -967,6 +1958,22 @@ applier_subscribe(struct applier *applier)
 		trigger_clear(&on_rollback);
 	});
 
+	/*
+	 * Rows are read and decoded by a separate thread, while
+	 * transactions are applied here, see applier_thread and
+	 * applier_pipeline.
+	 */
+	struct applier_thread thread;
+	applier_thread_start(&thread, applier);
+	auto thread_guard = make_scoped_guard([&] {
+		applier_thread_stop(&thread);
+	});
+	struct applier_pipeline pipeline;
+	applier_pipeline_create(&pipeline, current_session());
+	auto pipeline_guard = make_scoped_guard([&] {
+		applier_pipeline_destroy(&pipeline);
+	});
+
 	/*
 	 * Process a stream of rows from the binary log.
 	 */
@@ -979,22 +1986,36 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		struct stailq rows;
-		applier_read_tx(applier, &rows);
-
-		applier->last_row_time = ev_monotonic_now(loop());
+		while (stailq_empty(&thread.txs)) {
+			/*
+			 * Let transactions being applied commit
+			 * before waiting for new ones, so that the
+			 * order latch isn't held while idle.
+			 */
+			applier_pipeline_drain(&pipeline);
+			applier_pipeline_check(&pipeline);
+			if (thread.is_failed) {
+				diag_move(&thread.diag, diag_get());
+				diag_raise();
+			}
+			fiber_cond_wait(&thread.cond);
+			fiber_testcancel();
+		}
+		struct applier_tx *tx = stailq_shift_entry(&thread.txs,
+						struct applier_tx, in_queue);
+		applier->last_row_time = tx->recv_time;
+		applier->lag = tx->lag;
 		/*
 		 * In case of an heartbeat message wake a writer up
 		 * and check applier state.
 		 */
-		if (stailq_first_entry(&rows, struct applier_tx_row,
-				       next)->row.lsn == 0)
+		if (tx->rows[0].lsn == 0) {
+			applier_tx_free(tx);
 			fiber_cond_signal(&applier->writer_cond);
-		else if (applier_apply_tx(&rows) != 0)
-			diag_raise();
-
-		if (ibuf_used(ibuf) == 0)
-			ibuf_reset(ibuf);
+		} else {
+			applier_pipeline_apply(&pipeline, tx);
+		}
+		applier_pipeline_check(&pipeline);
 		fiber_gc();
 	}
 }
@@ -1012,6 +2033,7 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	applier_stop_decompression(applier);
 	fiber_gc();
 }
 
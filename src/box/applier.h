@@ -44,6 +44,7 @@
 #include "uri/uri.h"
 
 #include "xrow.h"
+#include "xrow_io.h"
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
@@ -109,6 +110,16 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/**
+	 * Decompressor of the JOIN stream or NULL if it isn't
+	 * compressed. SUBSCRIBE stream is decompressed by the
+	 * applier thread.
+	 */
+	struct xrow_decompressor *decompressor;
+	/** Set if the stream received from the master is compressed. */
+	bool is_compressed;
+	/** Decompression statistics of the stream. */
+	struct xrow_stream_stat compression_stat;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
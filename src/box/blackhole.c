@@ -124,6 +124,7 @@ static const struct space_vtab blackhole_space_vtab = {
 	/* .drop_primary_key = */ generic_space_drop_primary_key,
 	/* .check_format = */ generic_space_check_format,
 	/* .build_index = */ generic_space_build_index,
+	/* .bulk_load = */ generic_space_bulk_load,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
@@ -156,7 +157,7 @@ blackhole_engine_create_space(struct engine *engine, struct space_def *def,
 	format = tuple_format_new(&tuple_format_runtime->vtab, NULL, NULL, 0,
 				  def->fields, def->field_count,
 				  def->exact_field_count, def->dict, false,
-				  false);
+				  false, false);
 	if (format == NULL) {
 		free(space);
 		return NULL;
@@ -455,6 +455,18 @@ box_check_replication_connect_quorum(void)
 	return quorum;
 }
 
+static int
+box_check_replication_join_streams(void)
+{
+	int streams = cfg_geti("replication_join_streams");
+	if (streams < 1 || streams > REPLICATION_JOIN_STREAMS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_join_streams",
+			  tt_sprintf("the value must be between 1 and %d",
+				     REPLICATION_JOIN_STREAMS_MAX));
+	}
+	return streams;
+}
+
 static double
 box_check_replication_sync_lag(void)
 {
@@ -571,6 +583,79 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static int64_t
+box_check_wal_relay_buffer_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_relay_buffer_size",
+			  "the value must not be less than zero");
+	}
+	return size;
+}
+
+static int
+box_check_compression_level(const char *option)
+{
+	int level = cfg_geti(option);
+	if (level < 1 || level > ZSTD_maxCLevel()) {
+		tnt_raise(ClientError, ER_CFG, option,
+			  tt_sprintf("the value must be between 1 and %d",
+				     ZSTD_maxCLevel()));
+	}
+	return level;
+}
+
+static int
+box_check_snap_compression_threads(void)
+{
+	int threads = cfg_geti("snap_compression_threads");
+	if (threads < 0) {
+		tnt_raise(ClientError, ER_CFG, "snap_compression_threads",
+			  "the value must not be negative");
+	}
+	return threads;
+}
+
+static double
+box_check_wal_commit_delay(double delay)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_commit_delay",
+			  "the value must not be negative");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_batch_max_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_batch_max_size",
+			  "the value must not be negative");
+	}
+	return size;
+}
+
+static double
+box_check_net_trace_rate(double rate)
+{
+	if (rate < 0 || rate > 1) {
+		tnt_raise(ClientError, ER_CFG, "net_trace_rate",
+			  "the value must be in range [0, 1]");
+	}
+	return rate;
+}
+
+static double
+box_check_net_trace_slow_threshold(double threshold)
+{
+	if (threshold < 0) {
+		tnt_raise(ClientError, ER_CFG, "net_trace_slow_threshold",
+			  "the value must not be negative");
+	}
+	return threshold;
+}
+
 static int64_t
 box_check_memtx_memory(int64_t memory)
 {
@@ -591,6 +676,17 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static int
+box_check_vinyl_lookup_prefetch(void)
+{
+	int prefetch = cfg_geti("vinyl_lookup_prefetch");
+	if (prefetch < 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_lookup_prefetch",
+			  "must be greater than or equal to 0");
+	}
+	return prefetch;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -603,6 +699,7 @@ box_check_vinyl_options(void)
 	double bloom_fpr = cfg_getd("vinyl_bloom_fpr");
 
 	box_check_vinyl_memory(cfg_geti64("vinyl_memory"));
+	box_check_vinyl_lookup_prefetch();
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -631,6 +728,19 @@ box_check_vinyl_options(void)
 	}
 }
 
+static int
+box_check_iproto_threads(void)
+{
+	int threads = cfg_geti("iproto_threads");
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
 static int
 box_check_sql_cache_size(int size)
 {
@@ -656,10 +766,21 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_join_streams();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
+	box_check_wal_relay_buffer_size(cfg_geti64("wal_relay_buffer_size"));
+	box_check_wal_commit_delay(cfg_getd("wal_commit_delay"));
+	box_check_compression_level("wal_compression_level");
+	box_check_compression_level("snap_compression_level");
+	box_check_snap_compression_threads();
+	box_check_wal_batch_max_size(cfg_geti64("wal_batch_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_net_trace_rate(cfg_getd("net_trace_rate"));
+	box_check_net_trace_slow_threshold(
+		cfg_getd("net_trace_slow_threshold"));
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
 	box_check_vinyl_options();
@@ -784,6 +905,18 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_compression(void)
+{
+	replication_compression = cfg_geti("replication_compression");
+}
+
+void
+box_set_replication_join_streams(void)
+{
+	replication_join_streams = box_check_replication_join_streams();
+}
+
 void
 box_set_replication_anon(void)
 {
@@ -882,6 +1015,26 @@ box_set_snap_io_rate_limit(void)
 			cfg_getd("snap_io_rate_limit"));
 }
 
+void
+box_set_snap_compression_level(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_compression_level(memtx,
+		box_check_compression_level("snap_compression_level"));
+}
+
+void
+box_set_snap_compression_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_compression_threads(memtx,
+		box_check_snap_compression_threads());
+}
+
 void
 box_set_memtx_memory(void)
 {
@@ -942,6 +1095,29 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_commit_delay(void)
+{
+	double delay = box_check_wal_commit_delay(
+		cfg_getd("wal_commit_delay"));
+	wal_set_commit_delay(delay);
+}
+
+void
+box_set_wal_compression_level(void)
+{
+	wal_set_compression_level(
+		box_check_compression_level("wal_compression_level"));
+}
+
+void
+box_set_wal_batch_max_size(void)
+{
+	int64_t size = box_check_wal_batch_max_size(
+		cfg_geti64("wal_batch_max_size"));
+	wal_set_batch_max_size(size);
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -968,6 +1144,23 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_lookup_prefetch(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_lookup_prefetch(vinyl,
+			box_check_vinyl_lookup_prefetch());
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -981,9 +1174,20 @@ box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
+	/* The limit is applied to each iproto thread. */
 	fiber_pool_set_max_size(&tx_fiber_pool,
 				new_iproto_msg_max *
-				IPROTO_FIBER_POOL_SIZE_FACTOR);
+				IPROTO_FIBER_POOL_SIZE_FACTOR *
+				iproto_thread_count());
+}
+
+void
+box_set_net_trace(void)
+{
+	double rate = box_check_net_trace_rate(cfg_getd("net_trace_rate"));
+	double threshold = box_check_net_trace_slow_threshold(
+		cfg_getd("net_trace_slow_threshold"));
+	iproto_set_trace(rate, threshold);
 }
 
 int
@@ -1157,6 +1361,8 @@ box_select(uint32_t space_id, uint32_t index_id,
 		return -1;
 	if (access_check_space(space, PRIV_R) != 0)
 		return -1;
+	if (space_check_bulk_load(space) != 0)
+		return -1;
 	struct index *index = index_find(space, index_id);
 	if (index == NULL)
 		return -1;
@@ -1210,6 +1416,57 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_select_batch(uint32_t space_id, uint32_t index_id,
+		 const char *keys, uint32_t key_count,
+		 struct tuple **result)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (access_check_space(space, PRIV_R) != 0)
+		return -1;
+	if (space_check_bulk_load(space) != 0)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	/*
+	 * Validate all keys before looking up any of them
+	 * so that a malformed key doesn't waste a lookup.
+	 */
+	const char *key = keys;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*key) != MP_ARRAY) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "key must be an array");
+			return -1;
+		}
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key,
+				       part_count) != 0)
+			return -1;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&key);
+	}
+
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	if (index_get_batch(index, keys, key_count, result) != 0) {
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	return 0;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1338,6 +1595,150 @@ box_truncate(uint32_t space_id)
 	}
 }
 
+/** Write a no-op row to WAL to promote vclock. */
+static int
+box_write_nop(void)
+{
+	struct txn *txn = txn_begin();
+	if (txn == NULL)
+		return -1;
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = IPROTO_NOP;
+	if (txn_begin_stmt(txn, NULL) != 0 ||
+	    txn_commit_stmt(txn, &request) != 0) {
+		txn_rollback(txn);
+		return -1;
+	}
+	return txn_commit(txn);
+}
+
+/**
+ * Check if there's any other instance in the replica set:
+ * one registered in _cluster or an anonymous replica that
+ * keeps xlogs from being collected.
+ */
+static bool
+box_has_other_replicas(void)
+{
+	replicaset_foreach(replica) {
+		if (tt_uuid_is_equal(&replica->uuid, &INSTANCE_UUID))
+			continue;
+		if (replica->id != REPLICA_ID_NIL || replica->gc != NULL)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * The tuples loaded by box_bulk_load() aren't written to WAL,
+ * so other instances would never receive them, even those that
+ * are disconnected now and will resubscribe later.
+ */
+static int
+box_check_bulk_load_replication(struct space *space)
+{
+	if (space_is_temporary(space) ||
+	    space_group_id(space) == GROUP_LOCAL)
+		return 0;
+	if (box_has_other_replicas()) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "replicated spaces in a replica set");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Persist the tuples loaded by box_bulk_load() with a
+ * checkpoint, since they aren't written to WAL.
+ */
+static int
+box_bulk_load_persist(struct space *space)
+{
+	if (space_is_temporary(space))
+		return 0;
+	/*
+	 * A checkpoint isn't created if vclock hasn't changed
+	 * since the last one, hence the no-op row. A checkpoint
+	 * that is already in progress may have missed the loaded
+	 * tuples, so wait for it to complete and make a new one.
+	 */
+	if (box_write_nop() != 0)
+		return -1;
+	gc_wait_checkpoint();
+	if (box_checkpoint() != 0)
+		return -1;
+	/* A replica could join while the space was loaded. */
+	return box_check_bulk_load_replication(space);
+}
+
+int
+box_bulk_load(uint32_t space_id, const char *data, const char *data_end)
+{
+	if (in_txn() != NULL) {
+		diag_set(ClientError, ER_ACTIVE_TRANSACTION);
+		return -1;
+	}
+	if (box_check_writable() != 0)
+		return -1;
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (access_check_space(space, PRIV_W) != 0)
+		return -1;
+	if (space->is_bulk_loading) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "concurrent loads of a space");
+		return -1;
+	}
+	if (box_check_bulk_load_replication(space) != 0)
+		return -1;
+	const char *pos = data;
+	if (data == data_end || mp_typeof(*pos) != MP_ARRAY ||
+	    mp_check(&pos, data_end) != 0 || pos != data_end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "bulk load data");
+		return -1;
+	}
+	pos = data;
+	uint32_t count = mp_decode_array(&pos);
+	for (uint32_t i = 0; i < count; i++) {
+		if (mp_typeof(*pos) != MP_ARRAY) {
+			diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+			return -1;
+		}
+		mp_next(&pos);
+	}
+	if (count == 0)
+		return 0;
+
+	/*
+	 * The space is neither readable nor writable until
+	 * the loaded tuples are persisted.
+	 */
+	space->is_bulk_loading = true;
+	if (space_bulk_load(space, data, data_end) != 0) {
+		space->is_bulk_loading = false;
+		return -1;
+	}
+	int rc = box_bulk_load_persist(space);
+	space->is_bulk_loading = false;
+	if (rc == 0)
+		return 0;
+	/*
+	 * The loaded tuples can't be persisted, so drop them.
+	 * Keep the original error for the caller.
+	 */
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	if (box_truncate(space_id) != 0)
+		diag_log();
+	diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+	return -1;
+}
+
 /** Update a record in _sequence_data space. */
 static int
 sequence_data_update(uint32_t seq_id, int64_t value)
@@ -1512,7 +1913,7 @@ box_process_fetch_snapshot(struct ev_io *io, struct xrow_header *header)
 
 	/* Send the snapshot data to the instance. */
 	struct vclock start_vclock;
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, NULL, NULL, 1);
 	say_info("read-view sent.");
 
 	/* Remember master's vclock after the last request */
@@ -1594,7 +1995,8 @@ box_process_register(struct ev_io *io, struct xrow_header *header)
 	 * (start_vclock, stop_vclock) so that it gets its
 	 * registration.
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock,
+			 NULL);
 	say_info("final data sent.");
 
 	struct xrow_header row;
@@ -1616,6 +2018,22 @@ box_process_register(struct ev_io *io, struct xrow_header *header)
 	gc_guard.is_active = false;
 }
 
+void
+box_process_join_stream(struct ev_io *io, struct xrow_header *header)
+{
+	assert(header->type == IPROTO_JOIN_STREAM);
+
+	struct tt_uuid instance_uuid = uuid_nil;
+	xrow_decode_join_stream_xc(header, &instance_uuid);
+
+	/* Check permissions */
+	access_check_universe_xc(PRIV_R);
+
+	say_info("sending initial data to replica %s at %s",
+		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd));
+	relay_join_stream(io->fd, header->sync, &instance_uuid);
+}
+
 void
 box_process_join(struct ev_io *io, struct xrow_header *header)
 {
@@ -1625,10 +2043,27 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *
 	 * Replica => Master
 	 *
-	 * => JOIN { INSTANCE_UUID: replica_uuid }
-	 * <= OK { VCLOCK: start_vclock }
+	 * => JOIN { INSTANCE_UUID: replica_uuid, REPLICA_COMPRESSION: type,
+	 *           REPLICA_JOIN_STREAMS: count }
+	 * <= OK { VCLOCK: start_vclock, REPLICA_COMPRESSION: type,
+	 *         REPLICA_JOIN_STREAMS: count }
 	 *    Replica has enough permissions and master is ready for JOIN.
 	 *     - start_vclock - master's vclock at the time of join.
+	 *     - type - compression of the rest of the stream, optional.
+	 *     Master confirms the compression requested by replica
+	 *     if it supports it, then all packets following OK are
+	 *     sent as a single zstd stream.
+	 *     - count - number of connections initial data is sent
+	 *     over, optional. If it's greater than 1, master sends
+	 *     rows of system spaces followed by OK { VCLOCK: start_vclock }
+	 *     over the JOIN connection. Upon it replica opens count - 1
+	 *     more connections and sends
+	 *     JOIN_STREAM { INSTANCE_UUID: replica_uuid } over each
+	 *     of them. Rows of other spaces are then sent over all the
+	 *     connections, rows of a space over one connection. Each
+	 *     additional connection gets a part of initial data,
+	 *     compressed if the JOIN connection is, and
+	 *     OK { VCLOCK: start_vclock } after it.
 	 *
 	 * <= INSERT
 	 *    ...
@@ -1665,7 +2100,12 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	uint32_t compression;
+	uint32_t join_streams;
+	xrow_decode_join_xc(header, &instance_uuid, &compression,
+			    &join_streams);
+	join_streams = MAX(join_streams, 1U);
+	join_streams = MIN(join_streams, (uint32_t)REPLICATION_JOIN_STREAMS_MAX);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1716,11 +2156,26 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	say_info("joining replica %s at %s",
 		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd));
 
+	/* Compress the stream if the replica asks for it. */
+	struct xrow_stream_stat compression_stat;
+	memset(&compression_stat, 0, sizeof(compression_stat));
+	struct xrow_compressor *compressor = NULL;
+	if (compression == IPROTO_COMPRESSION_ZSTD) {
+		compressor = xrow_compressor_new(&compression_stat);
+		if (compressor == NULL)
+			diag_raise();
+	}
+	auto compressor_guard = make_scoped_guard([&] {
+		if (compressor != NULL)
+			xrow_compressor_delete(compressor);
+	});
+
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
 	struct vclock start_vclock;
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, compressor,
+			   &instance_uuid, join_streams);
 	say_info("initial data sent.");
 
 	/**
@@ -1741,19 +2196,27 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	struct xrow_header row;
 	xrow_encode_vclock_xc(&row, &stop_vclock);
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow_compressed(io, compressor, &row);
 
 	/*
 	 * Final stage: feed replica with WALs in range
 	 * (start_vclock, stop_vclock).
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock,
+			 compressor);
 	say_info("final data sent.");
 
 	/* Send end of WAL stream marker */
 	xrow_encode_vclock_xc(&row, &replicaset.vclock);
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow_compressed(io, compressor, &row);
+	if (compressor != NULL) {
+		say_info("sent %lld bytes compressed to %lld bytes, "
+			 "compression took %.3f sec",
+			 (long long)compression_stat.bytes,
+			 (long long)compression_stat.compressed_bytes,
+			 compression_stat.cpu_time);
+	}
 
 	/*
 	 * Advance the WAL consumer state to the position where
@@ -1781,8 +2244,13 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	uint32_t replica_version_id;
 	vclock_create(&replica_clock);
 	bool anon;
+	uint32_t compression;
 	xrow_decode_subscribe_xc(header, NULL, &replica_uuid,
-				 &replica_clock, &replica_version_id, &anon);
+				 &replica_clock, &replica_version_id, &anon,
+				 &compression);
+	/* Ignore compression types unknown to this version. */
+	if (compression != IPROTO_COMPRESSION_ZSTD)
+		compression = IPROTO_COMPRESSION_NONE;
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1833,9 +2301,13 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * id to replica, and replica checks that its cluster id
 	 * matches master's one. Older versions will just ignore
 	 * the additional field.
+	 *
+	 * The response confirms the compression requested by
+	 * the replica. Packets following it are compressed.
 	 */
 	struct xrow_header row;
-	xrow_encode_subscribe_response_xc(&row, &REPLICASET_UUID, &vclock);
+	xrow_encode_subscribe_response_xc(&row, &REPLICASET_UUID, &vclock,
+					  compression);
 	/*
 	 * Identify the message with the replica id of this
 	 * instance, this is the only way for a replica to find
@@ -1865,7 +2337,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id);
+			replica_version_id, compression);
 }
 
 void
@@ -1962,6 +2434,8 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
+	box_set_vinyl_lookup_prefetch();
 	box_set_vinyl_timeout();
 }
 
@@ -2331,6 +2805,8 @@ box_cfg_xc(void)
 	fiber_pool_create(&tx_fiber_pool, "tx",
 			  IPROTO_MSG_MAX_MIN * IPROTO_FIBER_POOL_SIZE_FACTOR,
 			  FIBER_POOL_IDLE_TIMEOUT);
+	/* Handle simple requests on fibers with small stacks. */
+	fiber_pool_set_is_light(&tx_fiber_pool, iproto_msg_is_light);
 	/* Add an extra endpoint for WAL wake up/rollback messages. */
 	cbus_endpoint_create(&tx_prio_endpoint, "tx_prio", tx_prio_cb, &tx_prio_endpoint);
 
@@ -2342,13 +2818,16 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(box_check_iproto_threads());
 	sql_init();
 
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
+	int64_t wal_relay_buffer_size = box_check_wal_relay_buffer_size(
+		cfg_geti64("wal_relay_buffer_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
-	if (wal_init(wal_mode, cfg_gets("wal_dir"),
-		     wal_max_size, &INSTANCE_UUID, on_wal_garbage_collection,
+	if (wal_init(wal_mode, cfg_gets("wal_dir"), wal_max_size,
+		     wal_relay_buffer_size, &INSTANCE_UUID,
+		     on_wal_garbage_collection,
 		     on_wal_checkpoint_threshold) != 0) {
 		diag_raise();
 	}
@@ -2362,6 +2841,7 @@ box_cfg_xc(void)
 	if (box_set_prepared_stmt_cache_size() != 0)
 		diag_raise();
 	box_set_net_msg_max();
+	box_set_net_trace();
 	box_set_readahead();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
@@ -2370,6 +2850,8 @@ box_cfg_xc(void)
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_compression();
+	box_set_replication_join_streams();
 	box_set_replication_anon();
 
 	struct gc_checkpoint *checkpoint = gc_last_checkpoint();
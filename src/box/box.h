@@ -52,6 +52,7 @@ struct ev_io;
 struct auth_request;
 struct space;
 struct vclock;
+struct tuple;
 
 /**
  * Pointer to TX thread local vclock.
@@ -198,6 +199,16 @@ box_process_register(struct ev_io *io, struct xrow_header *header);
 void
 box_process_join(struct ev_io *io, struct xrow_header *header);
 
+/**
+ * Attach a connection to a JOIN in progress and feed it with
+ * a part of the initial data.
+ *
+ * \param io coio watcher (initialized with coio_create())
+ * \param JOIN_STREAM packet header
+ */
+void
+box_process_join_stream(struct ev_io *io, struct xrow_header *header);
+
 /**
  * Subscribe a replica.
  *
@@ -225,16 +236,23 @@ void box_set_log_level(void);
 void box_set_log_format(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
+void box_set_snap_compression_level(void);
+void box_set_snap_compression_threads(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_commit_delay(void);
+void box_set_wal_batch_max_size(void);
+void box_set_wal_compression_level(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
+void box_set_vinyl_lookup_prefetch(void);
 void box_set_vinyl_timeout(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
@@ -242,12 +260,34 @@ void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_compression(void);
+void box_set_replication_join_streams(void);
 void box_set_replication_anon(void);
 void box_set_net_msg_max(void);
+void box_set_net_trace(void);
 
 int
 box_set_prepared_stmt_cache_size(void);
 
+/**
+ * Look up a batch of full keys in a unique index in one
+ * read-only statement.
+ *
+ * @param space_id space identifier
+ * @param index_id index identifier
+ * @param keys MsgPack keys, one after another, each an array
+ * @param key_count number of keys
+ * @param[out] result array of @a key_count tuples: the tuple
+ *        found for the corresponding key or NULL. Tuples are
+ *        referenced and must be unreferenced by the caller.
+ * @retval 0 success
+ * @retval -1 error, diag is set, @a result is unset
+ */
+int
+box_select_batch(uint32_t space_id, uint32_t index_id,
+		 const char *keys, uint32_t key_count,
+		 struct tuple **result);
+
 extern "C" {
 #endif /* defined(__cplusplus) */
 
@@ -471,6 +511,28 @@ box_process_rw(struct request *request, struct space *space,
 int
 boxk(int type, uint32_t space_id, const char *format, ...);
 
+/**
+ * Fill an empty space with tuples in bulk. The tuples aren't
+ * written to WAL one by one. Instead, a checkpoint is made
+ * once the load is complete, so that the loaded data is
+ * durable when the function returns. If the checkpoint fails,
+ * the space is truncated. The space can be neither read nor
+ * changed until the load is complete. Triggers and constraints
+ * other than the space format and unique indexes aren't
+ * checked. Since the loaded tuples aren't sent to replicas,
+ * the load is refused if the replica set has other instances,
+ * unless the space is temporary or local. Only memtx spaces
+ * can be loaded.
+ *
+ * \param space_id space identifier
+ * \param data MsgPack array of tuples
+ * \param data_end end of \a data
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_bulk_load(uint32_t space_id, const char *data, const char *data_end);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -204,12 +204,15 @@ fail:
 }
 
 int
-engine_join(struct engine_join_ctx *ctx, struct xstream *stream)
+engine_join(struct engine_join_ctx *ctx, bool is_system,
+	    struct xstream **streams, int stream_count)
 {
+	assert(stream_count > 0);
 	int i = 0;
 	struct engine *engine;
 	engine_foreach(engine) {
-		if (engine->vtab->join(engine, ctx->array[i], stream) != 0)
+		if (engine->vtab->join(engine, ctx->array[i], is_system,
+				       streams, stream_count) != 0)
 			return -1;
 		i++;
 	}
@@ -257,11 +260,14 @@ generic_engine_prepare_join(struct engine *engine, void **ctx)
 }
 
 int
-generic_engine_join(struct engine *engine, void *ctx, struct xstream *stream)
+generic_engine_join(struct engine *engine, void *ctx, bool is_system,
+		    struct xstream **streams, int stream_count)
 {
 	(void)engine;
 	(void)ctx;
-	(void)stream;
+	(void)is_system;
+	(void)streams;
+	(void)stream_count;
 	return 0;
 }
 
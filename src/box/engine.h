@@ -81,9 +81,12 @@ struct engine_vtab {
 	int (*prepare_join)(struct engine *engine, void **ctx);
 	/**
 	 * Feed the read view frozen on the previous step to
-	 * the given stream.
+	 * the given streams: rows of system spaces if is_system
+	 * is set, rows of other spaces otherwise. All rows of
+	 * a space are sent to the same stream.
 	 */
-	int (*join)(struct engine *engine, void *ctx, struct xstream *stream);
+	int (*join)(struct engine *engine, void *ctx, bool is_system,
+		    struct xstream **streams, int stream_count);
 	/**
 	 * Release the read view and free the context prepared
 	 * on the first step.
@@ -347,8 +350,13 @@ engine_end_recovery(void);
 int
 engine_prepare_join(struct engine_join_ctx *ctx);
 
+/**
+ * Feed the read view frozen by engine_prepare_join() to
+ * the given streams, see engine_vtab::join().
+ */
 int
-engine_join(struct engine_join_ctx *ctx, struct xstream *stream);
+engine_join(struct engine_join_ctx *ctx, bool is_system,
+	    struct xstream **streams, int stream_count);
 
 void
 engine_complete_join(struct engine_join_ctx *ctx);
@@ -381,7 +389,8 @@ engine_reset_stat(void);
  * Virtual method stubs.
  */
 int generic_engine_prepare_join(struct engine *, void **);
-int generic_engine_join(struct engine *, void *, struct xstream *);
+int generic_engine_join(struct engine *, void *, bool,
+			struct xstream **, int);
 void generic_engine_complete_join(struct engine *, void *);
 int generic_engine_begin(struct engine *, struct txn *);
 int generic_engine_begin_statement(struct engine *, struct txn *);
@@ -493,9 +502,10 @@ engine_prepare_join_xc(struct engine_join_ctx *ctx)
 }
 
 static inline void
-engine_join_xc(struct engine_join_ctx *ctx, struct xstream *stream)
+engine_join_xc(struct engine_join_ctx *ctx, bool is_system,
+	       struct xstream **streams, int stream_count)
 {
-	if (engine_join(ctx, stream) != 0)
+	if (engine_join(ctx, is_system, streams, stream_count) != 0)
 		diag_raise();
 }
 
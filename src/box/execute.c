@@ -723,11 +723,285 @@ sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
 	return 0;
 }
 
+enum {
+	/** Max nesting of parentheses in a normalized query. */
+	SQL_NORMALIZE_DEPTH_MAX = 32,
+	/** Max number of literals replaced in a normalized query. */
+	SQL_NORMALIZE_BIND_MAX = 64,
+};
+
+/**
+ * Return true if a literal following a token of @a prev_type is
+ * replaced with a parameter by sql_normalize().
+ */
+static bool
+sql_normalize_is_param(int prev_type, bool is_list)
+{
+	switch (prev_type) {
+	case TK_EQ:
+	case TK_NE:
+	case TK_LT:
+	case TK_LE:
+	case TK_GT:
+	case TK_GE:
+		return true;
+	case TK_LP:
+	case TK_COMMA:
+		return is_list;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Convert a literal token to a parameter value.
+ * @retval 0 Success.
+ * @retval -1 The literal must stay in the query.
+ */
+static int
+sql_normalize_literal(char *z, int n, int type, struct sql_bind *bind)
+{
+	bind->name = NULL;
+	bind->name_len = 0;
+	switch (type) {
+	case TK_INTEGER: {
+		/* Keep hex literals and let overflow be reported. */
+		if (n > 1 && (z[1] == 'x' || z[1] == 'X'))
+			return -1;
+		int64_t val;
+		bool is_neg;
+		if (sql_atoi64(z, &val, &is_neg, n) != 0)
+			return -1;
+		assert(!is_neg);
+		bind->type = MP_UINT;
+		bind->u64 = (uint64_t)val;
+		bind->bytes = sizeof(bind->u64);
+		return 0;
+	}
+	case TK_FLOAT:
+		if (sqlAtoF(z, &bind->d, n) == 0)
+			return -1;
+		bind->type = MP_DOUBLE;
+		bind->bytes = sizeof(bind->d);
+		return 0;
+	case TK_STRING: {
+		/* Strip quotes and unescape '' in place. */
+		char *dst = z;
+		for (int i = 1; i < n - 1; i++) {
+			*dst++ = z[i];
+			if (z[i] == '\'' && z[i + 1] == '\'')
+				i++;
+		}
+		bind->type = MP_STR;
+		bind->s = z;
+		bind->bytes = dst - z;
+		return 0;
+	}
+	default:
+		unreachable();
+	}
+	return -1;
+}
+
+/**
+ * Replace literals of an unprepared SELECT or DML query with
+ * anonymous parameters, so that queries differing only in
+ * values share one compiled statement. Whitespaces and comments
+ * are collapsed to a single space.
+ *
+ * Only literals which are compared with something or listed in
+ * IN and VALUES are replaced. The others may matter at compile
+ * time: literals in a result set define column names, LIMIT and
+ * LIKE patterns are optimized when constant.
+ *
+ * @param sql Query text.
+ * @param len Length of @a sql.
+ * @param region Region to allocate the text and parameters on.
+ * @param[out] out_sql Normalized query, zero terminated.
+ * @param[out] out_len Length of @a out_sql.
+ * @param[out] out_bind Values of the replaced literals.
+ * @retval >= 0 Number of replaced literals.
+ * @retval -1 The query can't be normalized.
+ */
+static int
+sql_normalize(const char *sql, int len, struct region *region,
+	      char **out_sql, int *out_len, struct sql_bind **out_bind)
+{
+	size_t size = SQL_NORMALIZE_BIND_MAX * sizeof(struct sql_bind) +
+		      2 * (len + 1);
+	struct sql_bind *bind = region_alloc(region, size);
+	if (bind == NULL)
+		return -1;
+	/* The tokenizer needs a zero terminated string. */
+	char *z = (char *)(bind + SQL_NORMALIZE_BIND_MAX);
+	memcpy(z, sql, len);
+	z[len] = '\0';
+	char *out = z + len + 1;
+	int out_pos = 0, bind_count = 0;
+	/* Parentheses enclosing a list of IN or VALUES. */
+	bool is_list[SQL_NORMALIZE_DEPTH_MAX];
+	/* Parentheses with a result set of SELECT being parsed. */
+	bool is_result_set[SQL_NORMALIZE_DEPTH_MAX];
+	is_list[0] = is_result_set[0] = false;
+	int depth = 0, result_sets = 0;
+	/* Two previous significant tokens. */
+	int prev = 0, prev2 = 0;
+	bool is_list_closed = false;
+	bool is_end = false;
+	int type;
+	bool is_reserved;
+	for (int i = 0; i < len;) {
+		char *tok = z + i;
+		int n = sql_token(tok, &type, &is_reserved);
+		i += n;
+		if (type == TK_SPACE || type == TK_LINEFEED) {
+			if (out_pos > 0 && out[out_pos - 1] != ' ')
+				out[out_pos++] = ' ';
+			continue;
+		}
+		/* Only a single statement is normalized. */
+		if (is_end)
+			return -1;
+		if (prev == 0 && type != TK_SELECT && type != TK_INSERT &&
+		    type != TK_REPLACE && type != TK_UPDATE &&
+		    type != TK_DELETE)
+			return -1;
+		switch (type) {
+		case TK_ILLEGAL:
+		case TK_VARIABLE:
+			return -1;
+		case TK_SEMI:
+			is_end = true;
+			continue;
+		case TK_SELECT:
+			if (!is_result_set[depth]) {
+				is_result_set[depth] = true;
+				result_sets++;
+			}
+			break;
+		case TK_FROM:
+			if (is_result_set[depth]) {
+				is_result_set[depth] = false;
+				result_sets--;
+			}
+			break;
+		case TK_LP:
+			if (++depth == SQL_NORMALIZE_DEPTH_MAX)
+				return -1;
+			is_list[depth] = prev == TK_IN || prev == TK_VALUES ||
+					 (prev == TK_COMMA && prev2 == TK_RP &&
+					  is_list_closed);
+			is_result_set[depth] = false;
+			break;
+		case TK_RP:
+			if (depth == 0)
+				return -1;
+			if (is_result_set[depth])
+				result_sets--;
+			is_list_closed = is_list[depth--];
+			break;
+		case TK_INTEGER:
+		case TK_FLOAT:
+		case TK_STRING:
+			if (result_sets > 0 ||
+			    !sql_normalize_is_param(prev, is_list[depth]))
+				break;
+			if (bind_count == SQL_NORMALIZE_BIND_MAX)
+				return -1;
+			if (sql_normalize_literal(tok, n, type,
+						  &bind[bind_count]) != 0)
+				break;
+			bind[bind_count].pos = bind_count + 1;
+			bind_count++;
+			out[out_pos++] = '?';
+			prev2 = prev;
+			prev = type;
+			continue;
+		default:
+			break;
+		}
+		memcpy(out + out_pos, tok, n);
+		out_pos += n;
+		prev2 = prev;
+		prev = type;
+	}
+	if (prev == 0)
+		return -1;
+	if (out[out_pos - 1] == ' ')
+		out_pos--;
+	out[out_pos] = '\0';
+	*out_sql = out;
+	*out_len = out_pos;
+	*out_bind = bind;
+	return bind_count;
+}
+
+/**
+ * Execute an unprepared query by a statement compiled for its
+ * normalized text (see sql_normalize()). The statement is taken
+ * from the prepared statement cache or compiled and saved there.
+ * @retval 0 Success.
+ * @retval -1 Error.
+ * @retval 1 The query can't be normalized.
+ */
+static int
+sql_execute_normalized(const char *sql, int len, struct port *port,
+		       struct region *region)
+{
+	size_t used = region_used(region);
+	char *norm_sql;
+	int norm_len;
+	struct sql_bind *bind;
+	int bind_count = sql_normalize(sql, len, region, &norm_sql, &norm_len,
+				       &bind);
+	if (bind_count < 0) {
+		region_truncate(region, used);
+		return 1;
+	}
+	bool do_finalize = false;
+	struct sql_stmt *stmt =
+		sql_stmt_cache_auto_find(norm_sql, norm_len,
+					 current_session()->sql_flags);
+	if (stmt == NULL) {
+		/*
+		 * Let the original query report compilation
+		 * errors: it refers to the literals as they are.
+		 */
+		if (sql_stmt_compile(norm_sql, norm_len, NULL, &stmt,
+				     NULL) != 0) {
+			diag_clear(diag_get());
+			region_truncate(region, used);
+			return 1;
+		}
+		do_finalize = !sql_stmt_cache_auto_insert(stmt);
+	}
+	enum sql_serialization_format format = sql_column_count(stmt) > 0 ?
+					       DQL_EXECUTE : DML_EXECUTE;
+	port_sql_create(port, stmt, format, do_finalize);
+	if (sql_bind(stmt, bind, bind_count) != 0 ||
+	    sql_execute(stmt, port, region) != 0) {
+		port_destroy(port);
+		if (!do_finalize)
+			sql_stmt_reset(stmt);
+		return -1;
+	}
+	if (!do_finalize)
+		sql_stmt_reset(stmt);
+	return 0;
+}
+
 int
 sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct port *port,
 			struct region *region)
 {
+	if (bind_count == 0 &&
+	    (current_session()->sql_flags & SQL_AutoParam) != 0 &&
+	    sql_stmt_cache_auto_is_enabled()) {
+		int rc = sql_execute_normalized(sql, len, port, region);
+		if (rc <= 0)
+			return rc;
+	}
 	struct sql_stmt *stmt;
 	if (sql_stmt_compile(sql, len, NULL, &stmt, NULL) != 0)
 		return -1;
@@ -112,6 +112,7 @@ gc_init(void)
 	rlist_create(&gc.checkpoints);
 	gc_tree_new(&gc.consumers);
 	fiber_cond_create(&gc.cleanup_cond);
+	fiber_cond_create(&gc.checkpoint_cond);
 	checkpoint_schedule_cfg(&gc.checkpoint_schedule, 0, 0);
 	engine_collect_garbage(&gc.vclock);
 
@@ -393,6 +394,7 @@ out:
 		engine_abort_checkpoint();
 
 	gc.checkpoint_is_in_progress = false;
+	fiber_cond_broadcast(&gc.checkpoint_cond);
 	return rc;
 }
 
@@ -434,6 +436,13 @@ gc_checkpoint(void)
 	return 0;
 }
 
+void
+gc_wait_checkpoint(void)
+{
+	while (gc.checkpoint_is_in_progress)
+		fiber_cond_wait(&gc.checkpoint_cond);
+}
+
 void
 gc_trigger_checkpoint(void)
 {
@@ -151,6 +151,11 @@ struct gc_state {
 	 * Set if there's a fiber making a checkpoint right now.
 	 */
 	bool checkpoint_is_in_progress;
+	/**
+	 * Condition variable signaled whenever a checkpoint
+	 * completes, successfully or not.
+	 */
+	struct fiber_cond checkpoint_cond;
 	/**
 	 * If this flag is set, the checkpoint daemon should create
 	 * a checkpoint as soon as possible despite the schedule.
@@ -253,6 +258,13 @@ gc_add_checkpoint(const struct vclock *vclock);
 int
 gc_checkpoint(void);
 
+/**
+ * Wait until the checkpoint that is being made right now,
+ * if any, completes.
+ */
+void
+gc_wait_checkpoint(void);
+
 /**
  * Trigger background checkpointing.
  *
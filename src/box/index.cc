@@ -171,6 +171,8 @@ check_index(uint32_t space_id, uint32_t index_id,
 		return -1;
 	if (access_check_space(*space, PRIV_R) != 0)
 		return -1;
+	if (space_check_bulk_load(*space) != 0)
+		return -1;
 	*index = index_find(*space, index_id);
 	if (*index == NULL)
 		return -1;
@@ -668,6 +670,34 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_batch(struct index *index, const char *keys,
+			uint32_t key_count, struct tuple **result)
+{
+	const char *key = keys;
+	for (uint32_t i = 0; i < key_count; i++) {
+		uint32_t part_count = mp_decode_array(&key);
+		struct tuple *tuple;
+		if (index_get(index, key, part_count, &tuple) != 0) {
+			for (uint32_t j = 0; j < i; j++) {
+				if (result[j] != NULL)
+					tuple_unref(result[j]);
+			}
+			return -1;
+		}
+		/*
+		 * Tuples returned by index_get() are only pinned
+		 * until the next lookup, so reference them.
+		 */
+		if (tuple != NULL)
+			tuple_ref(tuple);
+		result[i] = tuple;
+		for (uint32_t j = 0; j < part_count; j++)
+			mp_next(&key);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -412,6 +412,17 @@ struct index_vtab {
 			 const char *key, uint32_t part_count);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up a batch of full keys in a unique index.
+	 * @keys is a sequence of @key_count msgpack arrays that
+	 * have been validated by the caller. On success result[i]
+	 * is set to the tuple matching the i-th key or NULL. Found
+	 * tuples are referenced and must be unreferenced by the
+	 * caller. Implementations may interleave the lookups to
+	 * overlap their cache misses.
+	 */
+	int (*get_batch)(struct index *index, const char *keys,
+			 uint32_t key_count, struct tuple **result);
 	int (*replace)(struct index *index, struct tuple *old_tuple,
 		       struct tuple *new_tuple, enum dup_replace_mode mode,
 		       struct tuple **result);
@@ -622,6 +633,13 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_batch(struct index *index, const char *keys,
+		uint32_t key_count, struct tuple **result)
+{
+	return index->vtab->get_batch(index, keys, key_count, result);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -704,6 +722,8 @@ int generic_index_random(struct index *, uint32_t, struct tuple **);
 ssize_t generic_index_count(struct index *, enum iterator_type,
 			    const char *, uint32_t);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_batch(struct index *, const char *, uint32_t,
+			    struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
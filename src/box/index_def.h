@@ -33,6 +33,7 @@
 
 #include "key_def.h"
 #include "opt_def.h"
+#include "tuple_bloom.h"
 #include "small/rlist.h"
 
 #if defined(__cplusplus)
@@ -58,6 +59,16 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Memory layout of a memtx HASH index. */
+enum hash_layout {
+	/** Linear hashing with chained records, see salad/light.h. */
+	HASH_LAYOUT_LIGHT,
+	/** Open addressing with tagged chunks, see salad/swiss.h. */
+	HASH_LAYOUT_SWISS,
+	hash_layout_MAX
+};
+extern const char *hash_layout_strs[];
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -135,6 +146,10 @@ struct index_opts {
 	 * RTREE distance type.
 	 */
 	enum rtree_index_distance_type distance;
+	/**
+	 * Memtx HASH index layout.
+	 */
+	enum hash_layout hash_layout;
 	/**
 	 * Vinyl index options.
 	 */
@@ -153,6 +168,8 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/** Type of filters built for vinyl runs. */
+	enum tuple_bloom_type bloom_type;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -198,6 +215,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->dimension < o2->dimension ? -1 : 1;
 	if (o1->distance != o2->distance)
 		return o1->distance < o2->distance ? -1 : 1;
+	if (o1->hash_layout != o2->hash_layout)
+		return o1->hash_layout < o2->hash_layout ? -1 : 1;
 	if (o1->range_size != o2->range_size)
 		return o1->range_size < o2->range_size ? -1 : 1;
 	if (o1->page_size != o2->page_size)
@@ -209,6 +228,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->bloom_type != o2->bloom_type)
+		return o1->bloom_type < o2->bloom_type ? -1 : 1;
 	if (o1->func_id != o2->func_id)
 		return o1->func_id - o2->func_id;
 	return 0;
@@ -36,6 +36,7 @@
 #include <msgpuck.h>
 #include <small/ibuf.h>
 #include <small/obuf.h>
+#include <pmatomic.h>
 #include "third_party/base64.h"
 
 #include "version.h"
@@ -53,6 +54,7 @@
 #include "port.h"
 #include "box.h"
 #include "call.h"
+#include "tuple.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
@@ -60,6 +62,7 @@
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
+#include "iproto_trace.h"
 #include "execute.h"
 #include "errinj.h"
 #include "tt_static.h"
@@ -126,8 +129,12 @@ struct iproto_kharon {
  */
 unsigned iproto_readahead = 16320;
 
-/* The maximal number of iproto messages in fly. */
-static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
+/**
+ * Incremented by box.stat.reset(). Network threads reset their
+ * trace statistics when they see it changed, so that the reset
+ * doesn't need to wait for them.
+ */
+static unsigned iproto_trace_reset_gen;
 
 /**
  * How big is a buffer which needs to be shrunk before
@@ -158,6 +165,21 @@ iproto_reset_input(struct ibuf *ibuf)
 
 /* {{{ iproto_msg - declaration */
 
+/**
+ * Latency trace of a sampled request. Belongs to the network
+ * thread, the tx thread accesses it only while it owns the
+ * request message. When the reply is delivered back to the
+ * network thread, the trace is queued in the connection until
+ * the reply is written to the socket.
+ */
+struct iproto_net_trace {
+	struct iproto_trace base;
+	/** End of the reply in the connection output buffer. */
+	struct iproto_wpos wpos;
+	/** Link in iproto_connection::traces. */
+	struct stailq_entry in_connection;
+};
+
 /**
  * A single msg from io thread. All requests
  * from all connections are queued into a single queue
@@ -210,6 +232,8 @@ struct iproto_msg
 	 * Used by long (yielding) CALL/EVAL requests.
 	 */
 	struct cmsg discard_input;
+	/** Latency trace of the request, NULL if not sampled. */
+	struct iproto_net_trace *trace;
 	/**
 	 * Used in "connect" msgs, true if connect trigger failed
 	 * and the connection must be closed.
@@ -217,55 +241,17 @@ struct iproto_msg
 	bool close_connection;
 };
 
-static struct mempool iproto_msg_pool;
-
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
 
-/**
- * Resume stopped connections, if any.
- */
-static void
-iproto_resume();
-
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input);
 
 static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-
-/**
- * Network thread.
- */
-static struct cord net_cord;
-
-/**
- * Slab cache used for allocating memory for output network buffers
- * in the tx thread.
- */
-static struct slab_cache net_slabc;
-
-struct rmean *rmean_net;
+iproto_msg_delete(struct iproto_msg *msg);
 
+/** Network thread statistics. */
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
@@ -281,17 +267,115 @@ const char *rmean_net_strings[IPROTO_LAST] = {
 	"REQUESTS",
 };
 
+/**
+ * A network thread. Every thread has its own event loop, message
+ * and connection pools and a pair of pipes to and from tx. The
+ * first thread accepts connections and hands them over to all
+ * threads in turn. A connection lives in the thread it was handed
+ * over to until it is closed.
+ */
+struct iproto_thread {
+	/** Ordinal number of the thread, starting from 0. */
+	int id;
+	/** Name of the cbus endpoint of the thread. */
+	char name[FIBER_NAME_MAX];
+	/** Network cord. */
+	struct cord net_cord;
+	/**
+	 * A single queue for all requests in all connections of
+	 * the thread. All requests from all connections are
+	 * processed concurrently. Is also used as a queue for
+	 * just established connections and to execute disconnect
+	 * triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	struct cpipe net_pipe;
+	/**
+	 * Pipe from the first thread to this one to hand accepted
+	 * connections over. Unused in the first thread.
+	 */
+	struct cpipe accept_pipe;
+	/**
+	 * Slab cache used for allocating memory for output
+	 * network buffers in the tx thread.
+	 */
+	struct slab_cache net_slabc;
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	/** Connections with input stopped by net_msg_max. */
+	struct rlist stopped_connections;
+	/**
+	 * The maximal number of iproto messages in fly in the
+	 * thread, see box.cfg.net_msg_max. Accessed only by the
+	 * network thread once it is started.
+	 */
+	int msg_max;
+	/** Network statistics of the thread. */
+	struct rmean *rmean;
+	/** Latency traces of sampled requests. */
+	struct mempool trace_pool;
+	/** Fraction of requests to sample, see box.cfg.net_trace_rate. */
+	double trace_rate;
+	/**
+	 * Sum of trace_rate over requests read since the last
+	 * sampled one. A request is sampled when it reaches 1.
+	 */
+	double trace_credit;
+	/**
+	 * Latency statistics of sampled requests. Accessed with
+	 * iproto_thread_trace_stat().
+	 */
+	struct iproto_trace_stat trace_stat;
+	/** Value of iproto_trace_reset_gen trace_stat is reset at. */
+	unsigned trace_reset_gen;
+	/** iproto binary listener. */
+	struct evio_service binary;
+	/*
+	 * Message routes, bound to the pipes of this thread.
+	 * See iproto_thread_init_routes().
+	 */
+	struct cmsg_hop destroy_route[2];
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop select_batch_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
+};
+
+/** Network threads, see box.cfg.iproto_threads. */
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
+/**
+ * Thread to hand the next accepted connection over to. Accessed
+ * only by the first network thread.
+ */
+static int iproto_accept_next;
+
+/**
+ * Resume stopped connections of a thread, if any.
+ */
+static void
+iproto_resume(struct iproto_thread *iproto_thread);
+
 static void
 tx_process_destroy(struct cmsg *m);
 
 static void
 net_finish_destroy(struct cmsg *m);
 
-static const struct cmsg_hop destroy_route[] = {
-	{ tx_process_destroy, &net_pipe },
-	{ net_finish_destroy, NULL },
-};
-
 /** Fire on_disconnect triggers in the tx thread. */
 static void
 tx_process_disconnect(struct cmsg *m);
@@ -300,11 +384,6 @@ tx_process_disconnect(struct cmsg *m);
 static void
 net_finish_disconnect(struct cmsg *m);
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL }
-};
-
 /**
  * Kharon is in the dead world (iproto). Schedule an event to
  * flush new obuf as reflected in the fresh wpos.
@@ -322,12 +401,6 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
-
 /* }}} */
 
 /* {{{ iproto_connection - declaration and definition */
@@ -468,6 +541,11 @@ struct iproto_connection
 	 */
 	enum iproto_connection_state state;
 	struct rlist in_stop_list;
+	/**
+	 * Traces of sampled requests which replies have not
+	 * been written to the socket yet, in reply order.
+	 */
+	struct stailq traces;
 	/**
 	 * Kharon is used to implement box.session.push().
 	 * When a new push is ready, tx uses kharon to notify
@@ -517,29 +595,39 @@ struct iproto_connection
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
+	/** Network thread which serves the connection. */
+	struct iproto_thread *iproto_thread;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool of the thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
+{
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
+	return request_count > (size_t) iproto_thread->msg_max;
+}
+
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > (size_t) iproto_msg_max;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	if (msg->trace != NULL)
+		mempool_free(&iproto_thread->trace_pool, msg->trace);
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_msg *msg = (struct iproto_msg *)
+		mempool_alloc(&iproto_thread->iproto_msg_pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(&iproto_thread->iproto_msg_pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -549,10 +637,42 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
-	rmean_collect(rmean_net, IPROTO_REQUESTS, 1);
+	msg->trace = NULL;
+	rmean_collect(iproto_thread->rmean, IPROTO_REQUESTS, 1);
 	return msg;
 }
 
+/**
+ * Decide if a decoded request is sampled for latency tracing
+ * and take its first timestamp if so. Replication requests,
+ * which never reply in the usual way, are not traced.
+ */
+static inline void
+iproto_msg_start_trace(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	if (iproto_thread->trace_rate == 0)
+		return;
+	uint32_t type = msg->header.type;
+	if (!iproto_type_is_request(type) && type != IPROTO_PING)
+		return;
+	iproto_thread->trace_credit += iproto_thread->trace_rate;
+	if (iproto_thread->trace_credit < 1)
+		return;
+	iproto_thread->trace_credit -= 1;
+	struct iproto_net_trace *trace = (struct iproto_net_trace *)
+		mempool_alloc(&iproto_thread->trace_pool);
+	if (trace == NULL) {
+		/* Tracing is best effort. */
+		return;
+	}
+	memset(&trace->base, 0, sizeof(trace->base));
+	trace->base.type = type;
+	trace->base.sync = msg->header.sync;
+	iproto_trace_mark(&trace->base, IPROTO_TRACE_READ);
+	msg->trace = trace;
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -604,7 +724,8 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -633,7 +754,7 @@ iproto_connection_try_to_start_destroy(struct iproto_connection *con)
 	 * other parts of the connection.
 	 */
 	con->state = IPROTO_CONNECTION_DESTROYED;
-	cpipe_push(&tx_pipe, &con->destroy_msg);
+	cpipe_push(&con->iproto_thread->tx_pipe, &con->destroy_msg);
 }
 
 /**
@@ -660,7 +781,7 @@ iproto_connection_close(struct iproto_connection *con)
 		 * is done only once.
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
-		cpipe_push(&tx_pipe, &con->disconnect_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect_msg);
 		assert(con->state == IPROTO_CONNECTION_ALIVE);
 		con->state = IPROTO_CONNECTION_CLOSED;
 	} else if (con->state == IPROTO_CONNECTION_PENDING_DESTROY) {
@@ -790,13 +911,14 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct cpipe *tx_pipe = &con->iproto_thread->tx_pipe;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_check_msg_max(con->iproto_thread)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -805,7 +927,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -837,11 +959,12 @@ err_msgpack:
 		msg->len = reqend - reqstart; /* total request length */
 
 		iproto_msg_decode(msg, &pos, reqend, &stop_input);
+		iproto_msg_start_trace(msg);
 		/*
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		cpipe_push_input(tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -879,7 +1002,7 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(tx_pipe);
 	return 0;
 }
 
@@ -891,7 +1014,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -915,15 +1038,16 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	struct rlist *stopped = &iproto_thread->stopped_connections;
+	while (!iproto_check_msg_max(iproto_thread) && !rlist_empty(stopped)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
+			rlist_first_entry(stopped,
 					  struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
@@ -945,7 +1069,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_check_msg_max(con->iproto_thread)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -970,7 +1094,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -986,6 +1110,63 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * Check if the connection output up to @a wpos has been written
+ * to the socket.
+ */
+static inline bool
+iproto_connection_is_flushed(struct iproto_connection *con,
+			     const struct iproto_wpos *wpos)
+{
+	if (wpos->obuf == con->wpos.obuf)
+		return wpos->svp.used <= con->wpos.svp.used;
+	/*
+	 * The other buffer is either filled by tx after the one
+	 * being flushed or has been flushed before it.
+	 */
+	return con->wend.obuf == con->wpos.obuf;
+}
+
+/**
+ * Return the trace statistics of a network thread, resetting
+ * them first if box.stat.reset() was called since the last
+ * access.
+ */
+static struct iproto_trace_stat *
+iproto_thread_trace_stat(struct iproto_thread *iproto_thread)
+{
+	unsigned gen = pm_atomic_load(&iproto_trace_reset_gen);
+	if (iproto_thread->trace_reset_gen != gen) {
+		iproto_trace_stat_reset(&iproto_thread->trace_stat);
+		iproto_thread->trace_reset_gen = gen;
+	}
+	return &iproto_thread->trace_stat;
+}
+
+/**
+ * Account traces of sampled requests which replies have been
+ * written to the socket in the thread statistics.
+ */
+static void
+iproto_connection_end_traces(struct iproto_connection *con)
+{
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	while (!stailq_empty(&con->traces)) {
+		struct iproto_net_trace *trace =
+			stailq_first_entry(&con->traces,
+					   struct iproto_net_trace,
+					   in_connection);
+		if (!iproto_connection_is_flushed(con, &trace->wpos))
+			break;
+		stailq_shift(&con->traces);
+		iproto_trace_mark(&trace->base, IPROTO_TRACE_FLUSH);
+		iproto_trace_stat_collect(
+			iproto_thread_trace_stat(iproto_thread),
+			&trace->base);
+		mempool_free(&iproto_thread->trace_pool, trace);
+	}
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
@@ -1029,7 +1210,7 @@ iproto_flush(struct iproto_connection *con)
 
 	if (nwr > 0) {
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_SENT, nwr);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
 			return 0;
@@ -1057,6 +1238,7 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 		int rc;
 		while ((rc = iproto_flush(con)) <= 0) {
 			if (rc != 0) {
+				iproto_connection_end_traces(con);
 				ev_io_start(loop, &con->output);
 				return;
 			}
@@ -1065,6 +1247,7 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 				ev_feed_event(loop, &con->input, EV_READ);
 			}
 		}
+		iproto_connection_end_traces(con);
 		if (ev_is_active(&con->output))
 			ev_io_stop(con->loop, &con->output);
 	} catch (Exception *e) {
@@ -1074,22 +1257,23 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
 	}
 	con->input.data = con->output.data = con;
+	con->iproto_thread = iproto_thread;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
 	ibuf_create(&con->ibuf[0], cord_slab_cache(), iproto_readahead);
 	ibuf_create(&con->ibuf[1], cord_slab_cache(), iproto_readahead);
-	obuf_create(&con->obuf[0], &net_slabc, iproto_readahead);
-	obuf_create(&con->obuf[1], &net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[0], &iproto_thread->net_slabc, iproto_readahead);
+	obuf_create(&con->obuf[1], &iproto_thread->net_slabc, iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
@@ -1098,13 +1282,14 @@ iproto_connection_new(int fd)
 	con->long_poll_count = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	stailq_create(&con->traces);
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->destroy_msg, destroy_route);
-	cmsg_init(&con->disconnect_msg, disconnect_route);
+	cmsg_init(&con->destroy_msg, iproto_thread->destroy_route);
+	cmsg_init(&con->disconnect_msg, iproto_thread->disconnect_route);
 	con->state = IPROTO_CONNECTION_ALIVE;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
-	rmean_collect(rmean_net, IPROTO_CONNECTIONS, 1);
+	rmean_collect(iproto_thread->rmean, IPROTO_CONNECTIONS, 1);
 	return con;
 }
 
@@ -1127,7 +1312,11 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	/* Replies of these requests will never be sent. */
+	struct iproto_net_trace *trace, *tmp;
+	stailq_foreach_entry_safe(trace, tmp, &con->traces, in_connection)
+		mempool_free(&con->iproto_thread->trace_pool, trace);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1146,6 +1335,9 @@ tx_process1(struct cmsg *msg);
 static void
 tx_process_select(struct cmsg *msg);
 
+static void
+tx_process_select_batch(struct cmsg *msg);
+
 static void
 tx_process_sql(struct cmsg *msg);
 
@@ -1170,68 +1362,76 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-	sql_route,                              /* IPROTO_PREPARE */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_replication, &net_pipe },
-	{ net_end_join, NULL },
-};
+static void
+tx_process_connect(struct cmsg *m);
 
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_replication, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
+static void
+net_send_greeting(struct cmsg *m);
 
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
+/**
+ * Bind message routes of a network thread to its pipes.
+ */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+	struct cpipe *tx_pipe = &iproto_thread->tx_pipe;
+
+	iproto_thread->destroy_route[0] = { tx_process_destroy, net_pipe };
+	iproto_thread->destroy_route[1] = { net_finish_destroy, NULL };
+	iproto_thread->disconnect_route[0] =
+		{ tx_process_disconnect, net_pipe };
+	iproto_thread->disconnect_route[1] =
+		{ net_finish_disconnect, NULL };
+	iproto_thread->push_route[0] = { iproto_process_push, tx_pipe };
+	iproto_thread->push_route[1] = { tx_end_push, NULL };
+	iproto_thread->misc_route[0] = { tx_process_misc, net_pipe };
+	iproto_thread->misc_route[1] = { net_send_msg, NULL };
+	iproto_thread->call_route[0] = { tx_process_call, net_pipe };
+	iproto_thread->call_route[1] = { net_send_msg, NULL };
+	iproto_thread->select_route[0] = { tx_process_select, net_pipe };
+	iproto_thread->select_route[1] = { net_send_msg, NULL };
+	iproto_thread->select_batch_route[0] =
+		{ tx_process_select_batch, net_pipe };
+	iproto_thread->select_batch_route[1] = { net_send_msg, NULL };
+	iproto_thread->process1_route[0] = { tx_process1, net_pipe };
+	iproto_thread->process1_route[1] = { net_send_msg, NULL };
+	iproto_thread->sql_route[0] = { tx_process_sql, net_pipe };
+	iproto_thread->sql_route[1] = { net_send_msg, NULL };
+	iproto_thread->join_route[0] = { tx_process_replication, net_pipe };
+	iproto_thread->join_route[1] = { net_end_join, NULL };
+	iproto_thread->subscribe_route[0] =
+		{ tx_process_replication, net_pipe };
+	iproto_thread->subscribe_route[1] = { net_end_subscribe, NULL };
+	iproto_thread->error_route[0] = { tx_reply_iproto_error, net_pipe };
+	iproto_thread->error_route[1] = { net_send_error, NULL };
+	iproto_thread->connect_route[0] = { tx_process_connect, net_pipe };
+	iproto_thread->connect_route[1] = { net_send_greeting, NULL };
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	dml_route[IPROTO_OK] = NULL;
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_NOP] = NULL;
+	dml_route[IPROTO_PREPARE] = iproto_thread->sql_route;
+	dml_route[IPROTO_SELECT_BATCH] = iproto_thread->select_batch_route;
+}
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	if (xrow_header_decode(&msg->header, pos, reqend, true))
 		goto error;
@@ -1251,46 +1451,48 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_UPDATE:
 	case IPROTO_DELETE:
 	case IPROTO_UPSERT:
+	case IPROTO_SELECT_BATCH:
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < lengthof(iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
 	case IPROTO_PREPARE:
 		if (xrow_decode_sql(&msg->header, &msg->sql) != 0)
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
+	case IPROTO_JOIN_STREAM:
 	case IPROTO_FETCH_SNAPSHOT:
 	case IPROTO_REGISTER:
-		cmsg_init(&msg->base, join_route);
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -1303,7 +1505,7 @@ error:
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1414,7 +1616,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1462,9 +1665,29 @@ tx_accept_msg(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	tx_accept_wpos(msg->connection, &msg->wpos);
 	tx_fiber_init(msg->connection->session, msg->header.sync);
+	if (msg->trace != NULL) {
+		iproto_trace_mark(&msg->trace->base, IPROTO_TRACE_TX);
+		fiber()->storage.net.trace = &msg->trace->base;
+	} else {
+		fiber()->storage.net.trace = NULL;
+	}
 	return msg;
 }
 
+/**
+ * Set the end of the request reply in the output buffer and
+ * stop tracing the request in tx.
+ */
+static inline void
+tx_end_msg(struct iproto_msg *msg, struct obuf *out)
+{
+	iproto_wpos_create(&msg->wpos, out);
+	if (msg->trace != NULL) {
+		iproto_trace_mark(&msg->trace->base, IPROTO_TRACE_REPLY);
+		fiber()->storage.net.trace = NULL;
+	}
+}
+
 /**
  * Write error message to the output buffer and advance
  * write position. Doesn't throw.
@@ -1475,7 +1698,7 @@ tx_reply_error(struct iproto_msg *msg)
 	struct obuf *out = msg->connection->tx.p_obuf;
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 }
 
 /**
@@ -1489,7 +1712,7 @@ tx_reply_iproto_error(struct cmsg *m)
 	struct obuf *out = msg->connection->tx.p_obuf;
 	iproto_reply_error(out, diag_last_error(&msg->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 }
 
 /** Inject a short delay on tx request processing for testing. */
@@ -1522,7 +1745,7 @@ tx_process1(struct cmsg *m)
 		goto error;
 	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
 			    tuple != 0);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1565,9 +1788,84 @@ tx_process_select(struct cmsg *m)
 	}
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/**
+ * Look up all keys of an IPROTO_SELECT_BATCH request and
+ * reply with an array holding a tuple or nil for each key,
+ * in the order the keys were sent.
+ */
+static void
+tx_process_select_batch(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct request *req = &msg->dml;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct obuf *out;
+	struct obuf_svp svp;
+	struct tuple **result;
+	const char *keys;
+	uint32_t count;
+	uint32_t i;
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	tx_inject_delay();
+	keys = req->key;
+	count = mp_decode_array(&keys);
+	result = (struct tuple **)region_alloc(region,
+					       count * sizeof(*result) + 1);
+	if (result == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*result),
+			 "region", "result");
+		goto error;
+	}
+	if (box_select_batch(req->space_id, req->index_id,
+			     keys, count, result) != 0)
+		goto error;
+
+	out = msg->connection->tx.p_obuf;
+	if (iproto_prepare_select(out, &svp) != 0)
+		goto error_unref;
+	for (i = 0; i < count; i++) {
+		if (result[i] != NULL) {
+			if (tuple_to_obuf(result[i], out) != 0)
+				break;
+		} else {
+			char nil;
+			mp_encode_nil(&nil);
+			if (obuf_dup(out, &nil, 1) != 1) {
+				diag_set(OutOfMemory, 1, "obuf_dup", "nil");
+				break;
+			}
+		}
+	}
+	if (i < count) {
+		/* Discard the prepared select. */
+		obuf_rollback_to_svp(out, &svp);
+		goto error_unref;
+	}
+	iproto_reply_select(out, &svp, msg->header.sync,
+			    ::schema_version, count);
+	tx_end_msg(msg, out);
+	for (i = 0; i < count; i++) {
+		if (result[i] != NULL)
+			tuple_unref(result[i]);
+	}
+	region_truncate(region, region_svp);
 	return;
+error_unref:
+	for (i = 0; i < count; i++) {
+		if (result[i] != NULL)
+			tuple_unref(result[i]);
+	}
 error:
+	region_truncate(region, region_svp);
 	tx_reply_error(msg);
 }
 
@@ -1655,7 +1953,7 @@ tx_process_call(struct cmsg *m)
 
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1695,7 +1993,7 @@ tx_process_misc(struct cmsg *m)
 		default:
 			unreachable();
 		}
-		iproto_wpos_create(&msg->wpos, out);
+		tx_end_msg(msg, out);
 	} catch (Exception *e) {
 		tx_reply_error(msg);
 	}
@@ -1793,7 +2091,7 @@ tx_process_sql(struct cmsg *m)
 		port_destroy(&port);
 	}
 	iproto_reply_sql(out, &header_svp, msg->header.sync, schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1816,6 +2114,9 @@ tx_process_replication(struct cmsg *m)
 			 */
 			box_process_join(&io, &msg->header);
 			break;
+		case IPROTO_JOIN_STREAM:
+			box_process_join_stream(&io, &msg->header);
+			break;
 		case IPROTO_FETCH_SNAPSHOT:
 			box_process_fetch_snapshot(&io, &msg->header);
 			break;
@@ -1857,6 +2158,12 @@ net_send_msg(struct cmsg *m)
 		con->long_poll_count--;
 	}
 	con->wend = msg->wpos;
+	if (msg->trace != NULL) {
+		iproto_trace_mark(&msg->trace->base, IPROTO_TRACE_NET);
+		msg->trace->wpos = msg->wpos;
+		stailq_add_tail_entry(&con->traces, msg->trace, in_connection);
+		msg->trace = NULL;
+	}
 
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
@@ -1963,7 +2270,8 @@ net_send_greeting(struct cmsg *m)
 
 		if (nwr > 0) {
 			/* Count statistics. */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean,
+				      IPROTO_SENT, nwr);
 		} else if (nwr < 0 && ! sio_wouldblock(errno)) {
 			diag_log();
 		}
@@ -1984,24 +2292,18 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
- * Create a connection and start input.
+ * Create a connection in the current network thread and start
+ * input.
  */
 static int
-iproto_on_accept(struct evio_service * /* service */, int fd,
-		 struct sockaddr *addr, socklen_t addrlen)
+iproto_thread_accept(struct iproto_thread *iproto_thread, int fd)
 {
-	(void) addr;
-	(void) addrlen;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		return -1;
 	/*
@@ -2011,62 +2313,144 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	 */
 	msg = iproto_msg_new(con);
 	if (msg == NULL) {
-		mempool_free(&iproto_connection_pool, con);
+		mempool_free(&iproto_thread->iproto_connection_pool, con);
 		return -1;
 	}
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 	return 0;
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/**
+ * A connection accepted by the first network thread and handed
+ * over to another one. Allocated with malloc(), as it is freed
+ * by the receiving thread.
+ */
+struct iproto_accept_msg {
+	struct cmsg base;
+	/** Thread to serve the connection. */
+	struct iproto_thread *iproto_thread;
+	/** Socket of the connection. */
+	int fd;
+};
+
+/** Serve a handed over connection in its network thread. */
+static void
+net_process_accept(struct cmsg *m)
+{
+	struct iproto_accept_msg *msg = (struct iproto_accept_msg *) m;
+	if (iproto_thread_accept(msg->iproto_thread, msg->fd) != 0) {
+		close(msg->fd);
+		diag_log();
+	}
+	free(msg);
+}
+
+static const struct cmsg_hop net_accept_route[] = {
+	{ net_process_accept, NULL },
+};
+
+/**
+ * Hand an accepted connection over to the next network thread
+ * in turn, so that connections are spread evenly among them.
+ */
+static int
+iproto_on_accept(struct evio_service *service, int fd,
+		 struct sockaddr *addr, socklen_t addrlen)
+{
+	(void) addr;
+	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
+	assert(iproto_thread->id == 0);
+	int id = iproto_accept_next;
+	iproto_accept_next = (id + 1) % iproto_threads_count;
+	if (id == 0)
+		return iproto_thread_accept(iproto_thread, fd);
+	struct iproto_accept_msg *msg =
+		(struct iproto_accept_msg *) malloc(sizeof(*msg));
+	if (msg == NULL) {
+		diag_set(OutOfMemory, sizeof(*msg), "malloc",
+			 "struct iproto_accept_msg");
+		return -1;
+	}
+	cmsg_init(&msg->base, net_accept_route);
+	msg->iproto_thread = &iproto_threads[id];
+	msg->fd = fd;
+	cpipe_push(&iproto_threads[id].accept_pipe, &msg->base);
+	return 0;
+}
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&iproto_thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
-
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
+	mempool_create(&iproto_thread->trace_pool, &cord()->slabc,
+		       sizeof(struct iproto_net_trace));
+	if (iproto_trace_stat_create(&iproto_thread->trace_stat) != 0) {
+		tnt_raise(OutOfMemory, sizeof(struct iproto_trace_stat),
+			  "malloc", "struct iproto_trace_stat");
+	}
+	iproto_thread->trace_reset_gen =
+		pm_atomic_load(&iproto_trace_reset_gen);
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint, iproto_thread->name,
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe,
+			    iproto_thread->msg_max / 2);
+	/* Create pipes to hand accepted connections over. */
+	if (iproto_thread->id == 0) {
+		for (int i = 1; i < iproto_threads_count; i++) {
+			cpipe_create(&iproto_threads[i].accept_pipe,
+				     iproto_threads[i].name);
+		}
+	}
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	if (iproto_thread->id == 0) {
+		for (int i = 1; i < iproto_threads_count; i++)
+			cpipe_destroy(&iproto_threads[i].accept_pipe);
+	}
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (evio_service_is_active(&iproto_thread->binary))
+		evio_service_stop(&iproto_thread->binary);
 
-	rmean_delete(rmean_net);
+	iproto_trace_stat_destroy(&iproto_thread->trace_stat);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
@@ -2108,11 +2492,12 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe,
+		   (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -2160,18 +2545,36 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int threads_count)
 {
-	slab_cache_create(&net_slabc, &runtime);
-
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
-
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL) {
+		tnt_raise(OutOfMemory, threads_count * sizeof(*iproto_threads),
+			  "calloc", "struct iproto_thread");
+	}
+	iproto_threads_count = threads_count;
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		snprintf(iproto_thread->name, sizeof(iproto_thread->name),
+			 "net%d", i);
+		rlist_create(&iproto_thread->stopped_connections);
+		iproto_thread->msg_max = IPROTO_MSG_MAX_MIN;
+		iproto_thread_init_routes(iproto_thread);
+		slab_cache_create(&iproto_thread->net_slabc, &runtime);
+
+		if (cord_costart(&iproto_thread->net_cord, "iproto",
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe, iproto_thread->name);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    IPROTO_MSG_MAX_MIN / 2);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -2183,7 +2586,9 @@ iproto_init()
 /** Available iproto configuration changes. */
 enum iproto_cfg_op {
 	IPROTO_CFG_MSG_MAX,
-	IPROTO_CFG_LISTEN
+	IPROTO_CFG_LISTEN,
+	IPROTO_CFG_TRACE,
+	IPROTO_CFG_TRACE_STAT,
 };
 
 /**
@@ -2196,12 +2601,23 @@ struct iproto_cfg_msg: public cbus_call_msg
 {
 	/** Operation to execute in iproto thread. */
 	enum iproto_cfg_op op;
+	/** Thread to apply the change to. */
+	struct iproto_thread *iproto_thread;
 	union {
 		/** New URI to bind to. */
 		const char *uri;
 
 		/** New iproto max message count. */
 		int iproto_msg_max;
+
+		/** New request sampling rate and slow threshold. */
+		struct {
+			double rate;
+			double slow_threshold;
+		} trace;
+
+		/** Statistics to add the thread trace statistics to. */
+		struct iproto_trace_stat *trace_stat;
 	};
 };
 
@@ -2216,25 +2632,34 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
 					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
-			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			iproto_thread->msg_max = cfg_msg->iproto_msg_max;
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
+			if (evio_service_is_active(binary))
+				evio_service_stop(binary);
 			if (cfg_msg->uri != NULL &&
-			    (evio_service_bind(&binary, cfg_msg->uri) != 0 ||
-			     evio_service_listen(&binary) != 0))
+			    (evio_service_bind(binary, cfg_msg->uri) != 0 ||
+			     evio_service_listen(binary) != 0))
 				diag_raise();
 			break;
+		case IPROTO_CFG_TRACE:
+			iproto_thread->trace_rate = cfg_msg->trace.rate;
+			iproto_thread->trace_credit = 0;
+			iproto_thread->trace_stat.slow_threshold =
+				cfg_msg->trace.slow_threshold;
+			break;
+		case IPROTO_CFG_TRACE_STAT:
+			iproto_trace_stat_merge(cfg_msg->trace_stat,
+				iproto_thread_trace_stat(iproto_thread));
+			break;
 		default:
 			unreachable();
 		}
@@ -2245,44 +2670,139 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread, struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
 void
 iproto_listen(const char *uri)
 {
+	/* Only the first thread accepts connections. */
 	struct iproto_cfg_msg cfg_msg;
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = 0;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		mem += slab_cache_used(&iproto_thread->net_cord.slabc);
+		mem += slab_cache_used(&iproto_thread->net_slabc);
+	}
+	return mem;
+}
+
+int
+iproto_thread_count(void)
+{
+	return iproto_threads_count;
+}
+
+bool
+iproto_msg_is_light(struct cmsg *m)
+{
+	/* An access error runs box.session.on_access_denied(). */
+	if (!rlist_empty(&on_access_denied))
+		return false;
+	cmsg_f f = m->hop->f;
+	if (f != tx_process_select && f != tx_process_select_batch &&
+	    f != tx_process1)
+		return false;
+	/*
+	 * There's no fallback on stack overflow, so only accept
+	 * requests with a known shallow call graph: DDL and
+	 * vinyl requests go much deeper.
+	 */
+	struct iproto_msg *msg = (struct iproto_msg *)m;
+	struct space *space = space_by_id(msg->dml.space_id);
+	return space != NULL && space_is_memtx(space) &&
+	       !space_is_system(space) && !space_runs_user_code(space);
+}
+
+size_t
+iproto_thread_connection_count(int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	struct iproto_thread *iproto_thread = &iproto_threads[thread_id];
+	return mempool_count(&iproto_thread->iproto_connection_pool);
+}
+
+size_t
+iproto_thread_request_count(int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	struct iproto_thread *iproto_thread = &iproto_threads[thread_id];
+	return mempool_count(&iproto_thread->iproto_msg_pool);
+}
+
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	return rmean_foreach(iproto_threads[thread_id].rmean, cb, cb_ctx);
 }
 
 size_t
 iproto_connection_count(void)
 {
-	return mempool_count(&iproto_connection_pool);
+	size_t count = 0;
+	for (int i = 0; i < iproto_threads_count; i++)
+		count += iproto_thread_connection_count(i);
+	return count;
 }
 
 size_t
 iproto_request_count(void)
 {
-	return mempool_count(&iproto_msg_pool);
+	size_t count = 0;
+	for (int i = 0; i < iproto_threads_count; i++)
+		count += iproto_thread_request_count(i);
+	return count;
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0;
+		int64_t total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+void
+iproto_trace_stat(struct iproto_trace_stat *stat)
+{
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_TRACE_STAT);
+		cfg_msg.trace_stat = stat;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
+	pm_atomic_fetch_add(&iproto_trace_reset_gen, 1);
 }
 
 void
@@ -2293,23 +2813,44 @@ iproto_set_msg_max(int new_iproto_msg_max)
 			  tt_sprintf("minimal value is %d",
 				     IPROTO_MSG_MAX_MIN));
 	}
-	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+		cpipe_set_max_input(&iproto_threads[i].net_pipe,
+				    new_iproto_msg_max / 2);
+	}
+}
+
+void
+iproto_set_trace(double rate, double slow_threshold)
+{
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_TRACE);
+		cfg_msg.trace.rate = rate;
+		cfg_msg.trace.slow_threshold = slow_threshold;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 }
 
 void
 iproto_free()
 {
-	tt_pthread_cancel(net_cord.id);
-	tt_pthread_join(net_cord.id, NULL);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		tt_pthread_cancel(iproto_threads[i].net_cord.id);
+		tt_pthread_join(iproto_threads[i].net_cord.id, NULL);
+	}
 	/*
 	* Close socket descriptor to prevent hot standby instance
 	* failing to bind in case it tries to bind before socket
 	* is closed by OS.
 	*/
-	if (evio_service_is_active(&binary))
-		close(binary.ev.fd);
+	struct evio_service *binary = &iproto_threads[0].binary;
+	if (evio_service_is_active(binary))
+		close(binary->ev.fd);
+	free(iproto_threads);
+	iproto_threads = NULL;
+	iproto_threads_count = 0;
 }
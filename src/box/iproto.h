@@ -32,11 +32,17 @@
  */
 
 #include <stddef.h>
+#include <stdbool.h>
+
+#include "rmean.h"
 
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+struct cmsg;
+struct iproto_trace_stat;
+
 enum {
 	/** The minimal value for net_msg_max. */
 	IPROTO_MSG_MAX_MIN = 2,
@@ -52,6 +58,8 @@ enum {
 	 * processing stops until some new fibers are freed up.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/** The maximal number of iproto threads. */
+	IPROTO_THREADS_MAX = 1000,
 };
 
 extern unsigned iproto_readahead;
@@ -75,7 +83,57 @@ size_t
 iproto_request_count(void);
 
 /**
- * Reset network statistics.
+ * Call @a cb for each network metric summed over all iproto
+ * threads. Metrics are the same as in rmean_foreach().
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
+/**
+ * Return the number of iproto threads.
+ */
+int
+iproto_thread_count(void);
+
+/**
+ * Return true if a request message sent to the tx thread may
+ * be handled by a fiber with a small stack, i.e. it can't run
+ * Lua or SQL code. These are SELECTs and DML requests to memtx
+ * user spaces without triggers, constraints and functional
+ * indexes. Calls, evals and SQL requests are never light.
+ * @sa fiber_pool_set_is_light().
+ */
+bool
+iproto_msg_is_light(struct cmsg *msg);
+
+/**
+ * Return the number of active connections of an iproto thread.
+ */
+size_t
+iproto_thread_connection_count(int thread_id);
+
+/**
+ * Return the number of requests in flight of an iproto thread.
+ */
+size_t
+iproto_thread_request_count(int thread_id);
+
+/**
+ * Call @a cb for each network metric of an iproto thread.
+ */
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx);
+
+/**
+ * Add latency statistics of sampled requests of all iproto
+ * threads to @a stat, see box.cfg.net_trace_rate.
+ */
+void
+iproto_trace_stat(struct iproto_trace_stat *stat);
+
+/**
+ * Reset network statistics. Doesn't yield: network threads
+ * reset their request traces the next time they access them.
  */
 void
 iproto_reset_stat(void);
@@ -83,8 +141,12 @@ iproto_reset_stat(void);
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Start @a threads_count network threads. Client connections
+ * are spread among the threads by the kernel.
+ */
 void
-iproto_init();
+iproto_init(int threads_count);
 
 void
 iproto_listen(const char *uri);
@@ -92,6 +154,14 @@ iproto_listen(const char *uri);
 void
 iproto_set_msg_max(int iproto_msg_max);
 
+/**
+ * Sample the given fraction of requests for latency tracing.
+ * Sampled requests which took at least @a slow_threshold
+ * seconds are kept as slow.
+ */
+void
+iproto_set_trace(double rate, double slow_threshold);
+
 void
 iproto_free();
 
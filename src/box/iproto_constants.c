@@ -108,6 +108,7 @@ const char *iproto_type_strs[] =
 	"EXECUTE",
 	NULL, /* NOP */
 	"PREPARE",
+	NULL, /* SELECT_BATCH, accounted as SELECT */
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -126,6 +127,7 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* EXECUTE */
 	0,                                                     /* NOP */
 	0,                                                     /* PREPARE */
+	bit(SPACE_ID) | bit(KEY),                              /* SELECT_BATCH */
 };
 #undef bit
 
@@ -220,6 +222,7 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"bloom filter fuse",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
@@ -125,9 +125,35 @@ enum iproto_key {
 	IPROTO_STMT_ID = 0x43,
 	/* Leave a gap between SQL keys and additional request keys */
 	IPROTO_REPLICA_ANON = 0x50,
+	/**
+	 * Compression of the stream sent by the master to the
+	 * replica, see enum iproto_compression. Sent by a replica
+	 * in JOIN and SUBSCRIBE requests and confirmed by the
+	 * master in the response, which is the last packet sent
+	 * uncompressed.
+	 */
+	IPROTO_REPLICA_COMPRESSION = 0x51,
+	/**
+	 * Number of connections to send the initial JOIN data
+	 * over. Sent by a replica in JOIN request, the master
+	 * replies with the number of connections it agrees to.
+	 */
+	IPROTO_REPLICA_JOIN_STREAMS = 0x52,
 	IPROTO_KEY_MAX
 };
 
+/** Compression of a replication stream. */
+enum iproto_compression {
+	IPROTO_COMPRESSION_NONE = 0,
+	/**
+	 * The stream is compressed with zstd as a whole, and
+	 * each packet is flushed so that it can be decoded as
+	 * soon as it is received.
+	 */
+	IPROTO_COMPRESSION_ZSTD = 1,
+	iproto_compression_MAX
+};
+
 /**
  * Keys, stored in IPROTO_METADATA. They can not be received
  * in a request. Only sent as response, so no necessity in _strs
@@ -214,6 +240,12 @@ enum iproto_type {
 	IPROTO_NOP = 12,
 	/** Prepare SQL statement. */
 	IPROTO_PREPARE = 13,
+	/**
+	 * Look up a batch of keys in one unique index.
+	 * IPROTO_KEY is an array of full keys, the reply
+	 * contains a tuple or nil for each of them.
+	 */
+	IPROTO_SELECT_BATCH = 14,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -231,6 +263,11 @@ enum iproto_type {
 	IPROTO_FETCH_SNAPSHOT = 69,
 	/** REGISTER request to leave anonymous replication. */
 	IPROTO_REGISTER = 70,
+	/**
+	 * Attach a connection to a JOIN in progress to receive
+	 * a part of the initial data.
+	 */
+	IPROTO_JOIN_STREAM = 71,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -259,11 +296,14 @@ static inline const char *
 iproto_type_name(uint32_t type)
 {
 	/*
-	 * Sic: iptoto_type_strs[IPROTO_NOP] is NULL
+	 * Sic: iptoto_type_strs[IPROTO_NOP] and
+	 * iproto_type_strs[IPROTO_SELECT_BATCH] are NULL
 	 * to suppress box.stat() output.
 	 */
 	if (type == IPROTO_NOP)
 		return "NOP";
+	if (type == IPROTO_SELECT_BATCH)
+		return "SELECT_BATCH";
 
 	if (type < IPROTO_TYPE_STAT_MAX)
 		return iproto_type_strs[type];
@@ -309,7 +349,7 @@ static inline uint64_t
 dml_request_key_map(uint32_t type)
 {
 	/** Advanced requests don't have a defined key map. */
-	assert(iproto_type_is_dml(type));
+	assert(iproto_type_is_dml(type) || type == IPROTO_SELECT_BATCH);
 	extern const uint64_t iproto_body_key_map[];
 	return iproto_body_key_map[type];
 }
@@ -322,7 +362,8 @@ dml_request_key_map(uint32_t type)
 static inline bool
 iproto_type_is_select(uint32_t type)
 {
-	return type <= IPROTO_SELECT || type == IPROTO_CALL || type == IPROTO_EVAL;
+	return type <= IPROTO_SELECT || type == IPROTO_CALL ||
+	       type == IPROTO_EVAL || type == IPROTO_SELECT_BATCH;
 }
 
 /** A common request with a mandatory and simple body (key, tuple, ops)  */
@@ -391,6 +432,8 @@ enum vy_run_info_key {
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Bloom filter for keys built of binary fuse filters. */
+	VY_RUN_INFO_BLOOM_FUSE = 9,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
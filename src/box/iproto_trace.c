@@ -0,0 +1,157 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "iproto_trace.h"
+
+#include <string.h>
+
+#include "trivia/util.h"
+
+const char *iproto_trace_point_strs[] = {
+	"read",
+	"tx",
+	"wal_submit",
+	"wal_write",
+	"wal_sync",
+	"reply",
+	"net",
+	"flush",
+};
+
+static_assert(lengthof(iproto_trace_point_strs) == iproto_trace_point_MAX,
+	      "each trace point must have a name");
+
+double
+iproto_trace_total(const struct iproto_trace *trace)
+{
+	for (int i = iproto_trace_point_MAX - 1; i > IPROTO_TRACE_READ; i--) {
+		if (trace->time[i] != 0)
+			return trace->time[i] - trace->time[IPROTO_TRACE_READ];
+	}
+	return 0;
+}
+
+double
+iproto_trace_stage(const struct iproto_trace *trace,
+		   enum iproto_trace_point point)
+{
+	if (point == IPROTO_TRACE_READ || trace->time[point] == 0)
+		return 0;
+	int prev = point - 1;
+	while (trace->time[prev] == 0)
+		prev--;
+	return trace->time[point] - trace->time[prev];
+}
+
+int
+iproto_trace_stat_create(struct iproto_trace_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	if (latency_create(&stat->total) != 0)
+		return -1;
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++) {
+		if (latency_create(&stat->stage[i]) != 0) {
+			while (--i > IPROTO_TRACE_READ)
+				latency_destroy(&stat->stage[i]);
+			latency_destroy(&stat->total);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void
+iproto_trace_stat_destroy(struct iproto_trace_stat *stat)
+{
+	latency_destroy(&stat->total);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++)
+		latency_destroy(&stat->stage[i]);
+}
+
+void
+iproto_trace_stat_reset(struct iproto_trace_stat *stat)
+{
+	stat->count = 0;
+	stat->slow_count = 0;
+	latency_reset(&stat->total);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++)
+		latency_reset(&stat->stage[i]);
+}
+
+/**
+ * Add a request to the slow request array. When the array is
+ * full, replace the request read the earliest if it was read
+ * before the new one.
+ */
+static void
+iproto_trace_stat_add_slow(struct iproto_trace_stat *stat,
+			   const struct iproto_trace *trace)
+{
+	if (stat->slow_count < IPROTO_TRACE_SLOW_MAX) {
+		stat->slow[stat->slow_count++] = *trace;
+		return;
+	}
+	struct iproto_trace *oldest = &stat->slow[0];
+	for (int i = 1; i < IPROTO_TRACE_SLOW_MAX; i++) {
+		if (stat->slow[i].time[IPROTO_TRACE_READ] <
+		    oldest->time[IPROTO_TRACE_READ])
+			oldest = &stat->slow[i];
+	}
+	if (oldest->time[IPROTO_TRACE_READ] < trace->time[IPROTO_TRACE_READ])
+		*oldest = *trace;
+}
+
+void
+iproto_trace_stat_collect(struct iproto_trace_stat *stat,
+			  const struct iproto_trace *trace)
+{
+	stat->count++;
+	double total = iproto_trace_total(trace);
+	latency_collect(&stat->total, total);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++) {
+		if (trace->time[i] != 0)
+			latency_collect(&stat->stage[i],
+					iproto_trace_stage(trace, i));
+	}
+	if (total >= stat->slow_threshold)
+		iproto_trace_stat_add_slow(stat, trace);
+}
+
+void
+iproto_trace_stat_merge(struct iproto_trace_stat *dst,
+			const struct iproto_trace_stat *src)
+{
+	dst->count += src->count;
+	latency_merge(&dst->total, &src->total);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++)
+		latency_merge(&dst->stage[i], &src->stage[i]);
+	for (int i = 0; i < src->slow_count; i++)
+		iproto_trace_stat_add_slow(dst, &src->slow[i]);
+}
@@ -0,0 +1,167 @@
+#ifndef TARANTOOL_BOX_IPROTO_TRACE_H_INCLUDED
+#define TARANTOOL_BOX_IPROTO_TRACE_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include "latency.h"
+#include <tarantool_ev.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Points of the path of an iproto request at which a sampled
+ * request is timestamped. A stage of the request is the time
+ * between the previous point the request passed and the point
+ * ending the stage, so points which are not passed (e.g. WAL
+ * points of a SELECT) are skipped.
+ */
+enum iproto_trace_point {
+	/** The request is read and decoded by a network thread. */
+	IPROTO_TRACE_READ,
+	/** The request is delivered to the tx thread. */
+	IPROTO_TRACE_TX,
+	/** A transaction of the request is submitted to WAL. */
+	IPROTO_TRACE_WAL_SUBMIT,
+	/** The transaction is written to the WAL file. */
+	IPROTO_TRACE_WAL_WRITE,
+	/** The transaction is synced to disk, wal_mode = 'fsync'. */
+	IPROTO_TRACE_WAL_SYNC,
+	/** The reply is written to the output buffer by tx. */
+	IPROTO_TRACE_REPLY,
+	/** The reply is delivered to the network thread. */
+	IPROTO_TRACE_NET,
+	/** The reply is written to the socket. */
+	IPROTO_TRACE_FLUSH,
+	iproto_trace_point_MAX,
+};
+
+extern const char *iproto_trace_point_strs[];
+
+enum {
+	/** Number of slow requests kept by a trace statistics. */
+	IPROTO_TRACE_SLOW_MAX = 32,
+};
+
+/** Timestamps of a sampled iproto request. */
+struct iproto_trace {
+	/** Request type. */
+	uint32_t type;
+	/** Request sync. */
+	uint64_t sync;
+	/**
+	 * ev_monotonic_time() at each point of the request
+	 * path, 0 if the request didn't pass the point.
+	 */
+	double time[iproto_trace_point_MAX];
+};
+
+/** Timestamp a sampled request at the given point. */
+static inline void
+iproto_trace_mark(struct iproto_trace *trace, enum iproto_trace_point point)
+{
+	trace->time[point] = ev_monotonic_time();
+}
+
+/**
+ * Return the time between the first and the last point passed
+ * by a request.
+ */
+double
+iproto_trace_total(const struct iproto_trace *trace);
+
+/**
+ * Return the duration of the stage of a request ending at the
+ * given point, 0 if the request didn't pass the point.
+ */
+double
+iproto_trace_stage(const struct iproto_trace *trace,
+		   enum iproto_trace_point point);
+
+/** Latency statistics of sampled iproto requests. */
+struct iproto_trace_stat {
+	/** Number of sampled requests. */
+	int64_t count;
+	/** Total request latency. */
+	struct latency total;
+	/**
+	 * Latency of each stage, by the point ending it. The
+	 * counter of IPROTO_TRACE_READ is not used.
+	 */
+	struct latency stage[iproto_trace_point_MAX];
+	/**
+	 * Requests which took at least this long are kept in
+	 * @slow, in seconds.
+	 */
+	double slow_threshold;
+	/** Number of requests in @slow. */
+	int slow_count;
+	/**
+	 * The latest slow requests. When the array is full, a new
+	 * request replaces the one read the earliest.
+	 */
+	struct iproto_trace slow[IPROTO_TRACE_SLOW_MAX];
+};
+
+/**
+ * Initialize trace statistics.
+ * Return 0 on success, -1 on OOM.
+ */
+int
+iproto_trace_stat_create(struct iproto_trace_stat *stat);
+
+/** Destroy trace statistics. */
+void
+iproto_trace_stat_destroy(struct iproto_trace_stat *stat);
+
+/** Reset trace statistics. */
+void
+iproto_trace_stat_reset(struct iproto_trace_stat *stat);
+
+/** Account a completed request trace in statistics. */
+void
+iproto_trace_stat_collect(struct iproto_trace_stat *stat,
+			  const struct iproto_trace *trace);
+
+/**
+ * Add statistics @a src to @a dst. Only the latest slow
+ * requests of both are kept in @a dst.
+ */
+void
+iproto_trace_stat_merge(struct iproto_trace_stat *dst,
+			const struct iproto_trace_stat *src);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_IPROTO_TRACE_H_INCLUDED */
@@ -68,6 +68,8 @@ journal_entry_new(size_t n_rows, struct region *region,
 		diag_set(OutOfMemory, size, "region", "struct journal_entry");
 		return NULL;
 	}
+	entry->write_time = 0;
+	entry->sync_time = 0;
 	entry->approx_len = 0;
 	entry->n_rows = n_rows;
 	entry->res = -1;
@@ -71,6 +71,13 @@ struct journal_entry {
 	 * A journal entry completion callback argument.
 	 */
 	void *on_done_cb_data;
+	/**
+	 * ev_monotonic_time() when the entry was written to and
+	 * synced to disk by the WAL thread, or 0. Used to trace
+	 * latency of iproto requests.
+	 */
+	double write_time;
+	double sync_time;
 	/**
 	 * Approximate size of this request when encoded.
 	 */
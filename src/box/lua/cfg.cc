@@ -186,6 +186,61 @@ lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_snap_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_snap_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_snap_compression_threads(struct lua_State *L)
+{
+	try {
+		box_set_snap_compression_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_wal_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_commit_delay(struct lua_State *L)
+{
+	try {
+		box_set_wal_commit_delay();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_batch_max_size(struct lua_State *L)
+{
+	try {
+		box_set_wal_batch_max_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -252,6 +307,28 @@ lbox_cfg_set_vinyl_cache(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_page_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_lookup_prefetch(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_lookup_prefetch();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 {
@@ -263,6 +340,17 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_net_trace(struct lua_State *L)
+{
+	try {
+		box_set_net_trace();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_net_msg_max(struct lua_State *L)
 {
@@ -365,6 +453,25 @@ lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_compression(struct lua_State *L)
+{
+	(void) L;
+	box_set_replication_compression();
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_join_streams(struct lua_State *L)
+{
+	try {
+		box_set_replication_join_streams();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -380,15 +487,22 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_io_collect_interval", lbox_cfg_set_io_collect_interval},
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
 		{"cfg_set_snap_io_rate_limit", lbox_cfg_set_snap_io_rate_limit},
+		{"cfg_set_snap_compression_level", lbox_cfg_set_snap_compression_level},
+		{"cfg_set_snap_compression_threads", lbox_cfg_set_snap_compression_threads},
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
+		{"cfg_set_wal_commit_delay", lbox_cfg_set_wal_commit_delay},
+		{"cfg_set_wal_batch_max_size", lbox_cfg_set_wal_batch_max_size},
+		{"cfg_set_wal_compression_level", lbox_cfg_set_wal_compression_level},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
+		{"cfg_set_vinyl_page_cache", lbox_cfg_set_vinyl_page_cache},
+		{"cfg_set_vinyl_lookup_prefetch", lbox_cfg_set_vinyl_lookup_prefetch},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
 		{"cfg_set_replication_connect_quorum", lbox_cfg_set_replication_connect_quorum},
@@ -396,8 +510,11 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_sync_lag", lbox_cfg_set_replication_sync_lag},
 		{"cfg_set_replication_sync_timeout", lbox_cfg_set_replication_sync_timeout},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
+		{"cfg_set_replication_compression", lbox_cfg_set_replication_compression},
+		{"cfg_set_replication_join_streams", lbox_cfg_set_replication_join_streams},
 		{"cfg_set_replication_anon", lbox_cfg_set_replication_anon},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_net_trace", lbox_cfg_set_net_trace},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
 		{NULL, NULL}
 	};
@@ -36,6 +36,7 @@
 #include "box/index.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "fiber.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -294,6 +295,33 @@ lbox_truncate(struct lua_State *L)
 	return 0;
 }
 
+/**
+ * Fill an empty space with tuples in bulk. The tuples are given
+ * either as a table or as a string with a MsgPack array.
+ */
+static int
+lbox_bulk_load(struct lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    (!lua_istable(L, 2) && lua_type(L, 2) != LUA_TSTRING))
+		return luaL_error(L, "Usage space:bulk_load(tuples)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	size_t data_len;
+	const char *data;
+	if (lua_type(L, 2) == LUA_TSTRING)
+		data = lua_tolstring(L, 2, &data_len);
+	else
+		data = lbox_encode_tuple_on_gc(L, 2, &data_len);
+	int rc = box_bulk_load(space_id, data, data + data_len);
+	region_truncate(gc, used);
+	if (rc != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ Introspection */
@@ -363,6 +391,7 @@ box_lua_index_init(struct lua_State *L)
 		{"iterator", lbox_index_iterator},
 		{"iterator_next", lbox_iterator_next},
 		{"truncate", lbox_truncate},
+		{"bulk_load", lbox_bulk_load},
 		{"stat", lbox_index_stat},
 		{"compact", lbox_index_compact},
 		{NULL, NULL}
@@ -41,10 +41,12 @@
 #include "box/iproto.h"
 #include "box/wal.h"
 #include "box/replication.h"
+#include "box/xrow_io.h"
 #include "info/info.h"
 #include "box/gc.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/memtx_engine.h"
 #include "box/sql_stmt_cache.h"
 #include "main.h"
 #include "version.h"
@@ -81,6 +83,26 @@ lbox_push_replication_error_message(struct lua_State *L, struct error *e,
 	lua_settable(L, idx - 2);
 }
 
+/** Push statistics of a compressed replication stream. */
+static void
+lbox_pushcompression(lua_State *L, const struct xrow_stream_stat *stat)
+{
+	lua_createtable(L, 0, 4);
+	lua_pushstring(L, "bytes");
+	luaL_pushint64(L, stat->bytes);
+	lua_settable(L, -3);
+	lua_pushstring(L, "compressed_bytes");
+	luaL_pushint64(L, stat->compressed_bytes);
+	lua_settable(L, -3);
+	lua_pushstring(L, "ratio");
+	lua_pushnumber(L, stat->compressed_bytes > 0 ?
+		       (double)stat->bytes / stat->compressed_bytes : 0);
+	lua_settable(L, -3);
+	lua_pushstring(L, "cpu_time");
+	lua_pushnumber(L, stat->cpu_time);
+	lua_settable(L, -3);
+}
+
 static void
 lbox_pushapplier(lua_State *L, struct applier *applier)
 {
@@ -118,6 +140,12 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		if (applier->is_compressed) {
+			lua_pushstring(L, "compression");
+			lbox_pushcompression(L, &applier->compression_stat);
+			lua_settable(L, -3);
+		}
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL)
 			lbox_push_replication_error_message(L, e, -1);
@@ -141,6 +169,13 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushnumber(L, ev_monotonic_now(loop()) -
 			       relay_last_row_time(relay));
 		lua_settable(L, -3);
+		const struct xrow_stream_stat *stat =
+			relay_compression_stat(relay);
+		if (stat != NULL) {
+			lua_pushstring(L, "compression");
+			lbox_pushcompression(L, stat);
+			lua_settable(L, -3);
+		}
 		break;
 	case RELAY_STOPPED:
 	{
@@ -393,6 +428,26 @@ lbox_info_gc_call(struct lua_State *L)
 	lua_pushboolean(L, gc.checkpoint_is_in_progress);
 	lua_settable(L, -3);
 
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	struct memtx_checkpoint_stat *stat = &memtx->checkpoint_stat;
+	lua_pushstring(L, "checkpoint_compression");
+	lua_createtable(L, 0, 4);
+	lua_pushstring(L, "input");
+	luaL_pushuint64(L, stat->compress_in);
+	lua_settable(L, -3);
+	lua_pushstring(L, "output");
+	luaL_pushuint64(L, stat->compress_out);
+	lua_settable(L, -3);
+	lua_pushstring(L, "time");
+	lua_pushnumber(L, stat->time);
+	lua_settable(L, -3);
+	lua_pushstring(L, "rate");
+	lua_pushnumber(L, stat->time > 0 ? stat->compress_in / stat->time : 0);
+	lua_settable(L, -3);
+	lua_settable(L, -3);
+
 	lua_pushstring(L, "checkpoints");
 	lua_newtable(L);
 
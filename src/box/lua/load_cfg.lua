@@ -36,6 +36,8 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 64 * 1024 * 1024,
+    vinyl_lookup_prefetch = 1,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
@@ -52,10 +54,16 @@ local default_cfg = {
     io_collect_interval = nil,
     readahead           = 16320,
     snap_io_rate_limit  = nil, -- no limit
+    snap_compression_level = 3,
+    snap_compression_threads = 2,
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
+    wal_commit_delay    = 0,
+    wal_batch_max_size  = 0,
+    wal_compression_level = 3,
+    wal_relay_buffer_size = 16 * 1024 * 1024,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -78,10 +86,15 @@ local default_cfg = {
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
     replication_anon      = false,
+    replication_compression = false,
+    replication_join_streams = 1,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    net_trace_rate        = 0,
+    net_trace_slow_threshold = 0.1,
+    iproto_threads        = 1,
     sql_cache_size        = 5 * 1024 * 1024,
 }
 
@@ -100,6 +113,8 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
+    vinyl_lookup_prefetch     = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
@@ -117,10 +132,16 @@ local template_cfg = {
     io_collect_interval = 'number',
     readahead           = 'number',
     snap_io_rate_limit  = 'number',
+    snap_compression_level = 'number',
+    snap_compression_threads = 'number',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_commit_delay    = 'number',
+    wal_batch_max_size  = 'number',
+    wal_compression_level = 'number',
+    wal_relay_buffer_size = 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -143,10 +164,15 @@ local template_cfg = {
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
     replication_anon      = 'boolean',
+    replication_compression = 'boolean',
+    replication_join_streams = 'number',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    net_trace_rate        = 'number',
+    net_trace_slow_threshold = 'number',
+    iproto_threads        = 'number',
     sql_cache_size        = 'number',
 }
 
@@ -225,16 +251,23 @@ local dynamic_cfg = {
     readahead               = private.cfg_set_readahead,
     too_long_threshold      = private.cfg_set_too_long_threshold,
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
+    snap_compression_level  = private.cfg_set_snap_compression_level,
+    snap_compression_threads = private.cfg_set_snap_compression_threads,
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_lookup_prefetch   = private.cfg_set_vinyl_lookup_prefetch,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
+    wal_commit_delay        = private.cfg_set_wal_commit_delay,
+    wal_batch_max_size      = private.cfg_set_wal_batch_max_size,
+    wal_compression_level   = private.cfg_set_wal_compression_level,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
     feedback_enabled        = private.feedback_daemon.set_feedback_params,
     feedback_host           = private.feedback_daemon.set_feedback_params,
@@ -252,9 +285,13 @@ local dynamic_cfg = {
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
     replication_anon        = private.cfg_set_replication_anon,
+    replication_compression = private.cfg_set_replication_compression,
+    replication_join_streams = private.cfg_set_replication_join_streams,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    net_trace_rate          = private.cfg_set_net_trace,
+    net_trace_slow_threshold = private.cfg_set_net_trace,
     sql_cache_size          = private.cfg_set_sql_cache_size,
 }
 
@@ -307,6 +344,8 @@ local dynamic_cfg_skip_at_load = {
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
+    vinyl_page_cache        = true,
+    vinyl_lookup_prefetch   = true,
     vinyl_timeout           = true,
     too_long_threshold      = true,
     replication             = true,
@@ -317,12 +356,16 @@ local dynamic_cfg_skip_at_load = {
     replication_sync_timeout = true,
     replication_skip_conflict = true,
     replication_anon        = true,
+    replication_compression = true,
+    replication_join_streams = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
     instance_uuid           = true,
     replicaset_uuid         = true,
     net_msg_max             = true,
+    net_trace_rate          = true,
+    net_trace_slow_threshold = true,
     readahead               = true,
 }
 
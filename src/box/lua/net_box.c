@@ -271,6 +271,44 @@ netbox_encode_select(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_select_batch(lua_State *L)
+{
+	if (lua_gettop(L) < 5 || lua_type(L, 5) != LUA_TTABLE) {
+		return luaL_error(L, "Usage netbox.encode_select_batch(ibuf, "
+				     "sync, space_id, index_id, keys)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT_BATCH);
+
+	mpstream_encode_map(&stream, 3);
+
+	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t index_id = lua_tonumber(L, 4);
+
+	/* encode space_id */
+	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
+	mpstream_encode_uint(&stream, space_id);
+
+	/* encode index_id */
+	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
+	mpstream_encode_uint(&stream, index_id);
+
+	/* encode keys */
+	mpstream_encode_uint(&stream, IPROTO_KEY);
+	uint32_t key_count = lua_objlen(L, 5);
+	mpstream_encode_array(&stream, key_count);
+	for (uint32_t i = 1; i <= key_count; i++) {
+		lua_rawgeti(L, 5, i);
+		luamp_convert_key(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static inline int
 netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 {
@@ -631,6 +669,12 @@ netbox_decode_data(struct lua_State *L, const char **data,
 	for (uint32_t j = 0; j < count; ++j) {
 		const char *begin = *data;
 		mp_next(data);
+		if (mp_typeof(*begin) == MP_NIL) {
+			/* A missing key of IPROTO_SELECT_BATCH. */
+			luaL_pushnull(L);
+			lua_rawseti(L, -2, j + 1);
+			continue;
+		}
 		struct tuple *tuple =
 			box_tuple_new(format, begin, *data);
 		if (tuple == NULL)
@@ -893,6 +937,7 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_call",    netbox_encode_call },
 		{ "encode_eval",    netbox_encode_eval },
 		{ "encode_select",  netbox_encode_select },
+		{ "encode_select_batch", netbox_encode_select_batch },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
@@ -107,6 +107,7 @@ local method_encoder = {
     prepare = internal.encode_prepare,
     unprepare = internal.encode_prepare,
     get     = internal.encode_select,
+    get_batch = internal.encode_select_batch,
     min     = internal.encode_select,
     max     = internal.encode_select,
     count   = internal.encode_call,
@@ -133,6 +134,7 @@ local method_decoder = {
     prepare = internal.decode_prepare,
     unprepare = decode_nil,
     get     = decode_get,
+    get_batch = internal.decode_select,
     min     = decode_get,
     max     = decode_get,
     count   = decode_count,
@@ -1430,6 +1432,11 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:get_batch(keys, opts)
+        check_space_arg(self, 'get_batch')
+        return check_primary_index(self):get_batch(keys, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1467,6 +1474,20 @@ index_metatable = function(remote)
                                                box.index.EQ, 0, 2, key))
     end
 
+    -- Look up all keys in one request. Returns an array with
+    -- a tuple or box.NULL for each key, in the order of keys.
+    function methods:get_batch(keys, opts)
+        check_index_arg(self, 'get_batch')
+        if type(keys) ~= 'table' then
+            error("Usage: index:get_batch({key1, key2, ...})")
+        end
+        if opts and opts.buffer then
+            error("index:get_batch() doesn't support `buffer` argument")
+        end
+        return remote:_request('get_batch', opts, self.space._format_cdata,
+                               self.space.id, self.id, keys)
+    end
+
     function methods:min(key, opts)
         check_index_arg(self, 'min')
         if opts and opts.buffer then
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "box/lua/read_view.h"
+#include "box/lua/tuple.h"
+#include "lua/utils.h"
+
+#include "diag.h"
+#include "box/box.h"
+#include "box/read_view.h"
+#include "box/schema_def.h"
+#include "box/tuple.h"
+
+static const char read_view_typename[] = "box.read_view";
+
+static struct read_view **
+lbox_check_read_view(struct lua_State *L, int idx, const char *usage)
+{
+	if (idx > lua_gettop(L))
+		luaL_error(L, "usage: %s", usage);
+	return (struct read_view **)luaL_checkudata(L, idx,
+						    read_view_typename);
+}
+
+/**
+ * Resolve a space id or name passed at the given stack index.
+ * Returns BOX_ID_NIL and sets diag if there's no such space.
+ */
+static uint32_t
+lbox_read_view_space_id(struct lua_State *L, int idx)
+{
+	if (lua_type(L, idx) == LUA_TNUMBER)
+		return lua_tointeger(L, idx);
+	size_t len;
+	const char *name = lua_tolstring(L, idx, &len);
+	if (name == NULL) {
+		diag_set(IllegalParams, "space must be an id or a name");
+		return BOX_ID_NIL;
+	}
+	uint32_t space_id = box_space_id_by_name(name, len);
+	if (space_id == BOX_ID_NIL)
+		diag_set(ClientError, ER_NO_SUCH_SPACE, name);
+	return space_id;
+}
+
+/**
+ * box.read_view.open({space, ...}) - open a read view of the
+ * given memtx spaces, identified by ids or names.
+ */
+static int
+lbox_read_view_open(struct lua_State *L)
+{
+	static const char usage[] = "box.read_view.open({space, ...})";
+	if (lua_gettop(L) != 1 || !lua_istable(L, 1))
+		return luaL_error(L, "usage: %s", usage);
+	uint32_t space_count = lua_objlen(L, 1);
+	uint32_t *space_ids = (uint32_t *)
+		lua_newuserdata(L, (space_count + 1) * sizeof(*space_ids));
+	for (uint32_t i = 0; i < space_count; i++) {
+		lua_rawgeti(L, 1, i + 1);
+		space_ids[i] = lbox_read_view_space_id(L, -1);
+		lua_pop(L, 1);
+		if (space_ids[i] == BOX_ID_NIL)
+			return luaT_error(L);
+	}
+	struct read_view **prv = (struct read_view **)
+		lua_newuserdata(L, sizeof(*prv));
+	*prv = box_read_view_open(space_ids, space_count);
+	if (*prv == NULL)
+		return luaT_error(L);
+	luaL_getmetatable(L, read_view_typename);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int
+lbox_read_view_close(struct lua_State *L)
+{
+	struct read_view **prv = lbox_check_read_view(L, 1, "rv:close()");
+	if (*prv != NULL) {
+		box_read_view_close(*prv);
+		*prv = NULL;
+	}
+	return 0;
+}
+
+/**
+ * Iteration function returned by rv:pairs(). The read view
+ * and the space id are kept in upvalues, the control variable
+ * is the number of tuples returned so far.
+ */
+static int
+lbox_read_view_iterate(struct lua_State *L)
+{
+	struct read_view **prv = (struct read_view **)
+		lua_touserdata(L, lua_upvalueindex(1));
+	uint32_t space_id = lua_tointeger(L, lua_upvalueindex(2));
+	if (*prv == NULL)
+		return luaL_error(L, "read view is closed");
+	const char *data;
+	uint32_t size;
+	if (box_read_view_next(*prv, space_id, &data, &size) != 0)
+		return luaT_error(L);
+	if (data == NULL)
+		return 0;
+	struct tuple *tuple = box_tuple_new(box_tuple_format_default(),
+					    data, data + size);
+	if (tuple == NULL)
+		return luaT_error(L);
+	lua_pushinteger(L, lua_tointeger(L, 2) + 1);
+	luaT_pushtuple(L, tuple);
+	return 2;
+}
+
+/**
+ * rv:pairs(space) - iterate over the frozen tuples of a space
+ * in the order of its primary index, which is unspecified for
+ * HASH. Every space can be iterated once.
+ */
+static int
+lbox_read_view_pairs(struct lua_State *L)
+{
+	static const char usage[] = "rv:pairs(space)";
+	struct read_view **prv = lbox_check_read_view(L, 1, usage);
+	if (lua_gettop(L) != 2)
+		return luaL_error(L, "usage: %s", usage);
+	if (*prv == NULL)
+		return luaL_error(L, "read view is closed");
+	uint32_t space_id = lbox_read_view_space_id(L, 2);
+	if (space_id == BOX_ID_NIL)
+		return luaT_error(L);
+	lua_pushvalue(L, 1);
+	lua_pushinteger(L, space_id);
+	lua_pushcclosure(L, lbox_read_view_iterate, 2);
+	lua_pushnil(L);
+	lua_pushinteger(L, 0);
+	return 3;
+}
+
+static int
+lbox_read_view_tostring(struct lua_State *L)
+{
+	struct read_view **prv = lbox_check_read_view(L, 1, "");
+	lua_pushstring(L, *prv != NULL ? "read view" : "closed read view");
+	return 1;
+}
+
+void
+box_lua_read_view_init(struct lua_State *L)
+{
+	static const struct luaL_Reg read_view_meta[] = {
+		{"__gc",	lbox_read_view_close},
+		{"__tostring",	lbox_read_view_tostring},
+		{"close",	lbox_read_view_close},
+		{"pairs",	lbox_read_view_pairs},
+		{NULL, NULL}
+	};
+	luaL_register_type(L, read_view_typename, read_view_meta);
+
+	static const struct luaL_Reg read_view_lib[] = {
+		{"open",	lbox_read_view_open},
+		{NULL, NULL}
+	};
+	luaL_register(L, "box.read_view", read_view_lib);
+	lua_pop(L, 1);
+}
@@ -432,6 +432,7 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        compact_tuples = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -476,6 +477,7 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        compact_tuples = options.compact_tuples and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -955,11 +957,13 @@ local index_options = {
     unique = 'boolean',
     dimension = 'number',
     distance = 'string',
+    hash_layout = 'string',
     run_count_per_level = 'number',
     run_size_ratio = 'number',
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    bloom_type = 'string',
     func = 'number, string',
 }
 
@@ -1070,11 +1074,13 @@ box.schema.index.create = function(space_id, name, options)
             dimension = options.dimension,
             unique = options.unique,
             distance = options.distance,
+            hash_layout = options.hash_layout,
             page_size = options.page_size,
             range_size = options.range_size,
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            bloom_type = options.bloom_type,
             func = options.func,
     }
     local field_type_aliases = {
@@ -1208,6 +1214,10 @@ box.schema.index.alter = function(space_id, index_id, options)
     end
     if options.type == nil then
         options.type = tuple.type
+    elseif string.upper(options.type) ~= 'HASH' and
+           options.hash_layout == nil then
+        -- The layout only applies to HASH indexes.
+        index_opts.hash_layout = nil
     end
     for k, t in pairs(index_options) do
         if options[k] ~= nil then
@@ -1724,6 +1734,10 @@ space_mt.truncate = function(space)
     check_space_arg(space, 'truncate')
     return internal.truncate(space.id)
 end
+space_mt.bulk_load = function(space, tuples)
+    check_space_arg(space, 'bulk_load')
+    return internal.bulk_load(space.id, tuples)
+end
 space_mt.format = function(space, format)
     check_space_arg(space, 'format')
     return box.schema.space.format(space.id, format)
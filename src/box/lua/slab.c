@@ -115,6 +115,7 @@ lbox_slab_stats(struct lua_State *L)
 	 * indexes, with their stats.
 	 */
 	small_stats(&memtx->alloc, &totals, small_stats_lua_cb, L);
+	memtx_engine_compact_stats(memtx, &totals, small_stats_lua_cb, L);
 	struct mempool_stats index_stats;
 	mempool_stats(&memtx->index_extent_pool, &index_stats);
 	small_stats_lua_cb(&index_stats, L);
@@ -136,6 +137,7 @@ lbox_slab_info(struct lua_State *L)
 	 */
 	lua_newtable(L);
 	small_stats(&memtx->alloc, &totals, small_stats_noop_cb, L);
+	memtx_engine_compact_stats(memtx, &totals, small_stats_noop_cb, L);
 	struct mempool_stats index_stats;
 	mempool_stats(&memtx->index_extent_pool, &index_stats);
 
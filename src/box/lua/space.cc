@@ -340,6 +340,16 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_setfield(L, -2, "dimension");
 		}
 
+		lua_pushstring(L, "hash_layout");
+		if (index_def->type == HASH &&
+		    index_opts->hash_layout != HASH_LAYOUT_LIGHT) {
+			lua_pushstring(L, hash_layout_strs[
+					index_opts->hash_layout]);
+		} else {
+			lua_pushnil(L);
+		}
+		lua_rawset(L, -3);
+
 		if (index_opts->func_id > 0) {
 			lua_pushstring(L, "func");
 			lua_newtable(L);
@@ -427,6 +437,12 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->bloom_type != TUPLE_BLOOM_CLASSIC) {
+				lua_pushstring(L, tuple_bloom_type_strs[
+						index_opts->bloom_type]);
+				lua_setfield(L, -2, "bloom_type");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -31,6 +31,7 @@
  */
 #include "stat.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <rmean.h>
 
@@ -40,17 +41,19 @@
 
 #include "box/box.h"
 #include "box/iproto.h"
+#include "box/iproto_trace.h"
+#include "box/iproto_constants.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
 #include "box/sql.h"
 #include "info/info.h"
 #include "lua/info.h"
 #include "lua/utils.h"
+#include "tt_static.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -127,12 +130,45 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct wal_stat stat;
+	wal_stat(&stat);
+
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	info_append_int(&h, "batches", stat.batches);
+	info_append_int(&h, "rows", stat.rows);
+	info_append_int(&h, "bytes", stat.bytes);
+	info_append_double(&h, "rows_per_batch", stat.batches == 0 ? 0 :
+			   (double)stat.rows / stat.batches);
+	info_append_double(&h, "bytes_per_write", stat.batches == 0 ? 0 :
+			   (double)stat.bytes / stat.batches);
+
+	info_table_begin(&h, "sync");
+	info_append_int(&h, "count", stat.syncs);
+	info_table_begin(&h, "latency");
+	info_append_double(&h, "p50", stat.sync_p50);
+	info_append_double(&h, "p75", stat.sync_p75);
+	info_append_double(&h, "p90", stat.sync_p90);
+	info_append_double(&h, "p95", stat.sync_p95);
+	info_append_double(&h, "p99", stat.sync_p99);
+	info_table_end(&h); /* latency */
+	info_table_end(&h); /* sync */
+
+	info_end(&h);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
 	(void)L;
 	box_reset_stat();
 	iproto_reset_stat();
+	wal_reset_stat();
 	return 0;
 }
 
@@ -148,7 +184,7 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	const char *key = luaL_checkstring(L, -1);
-	if (rmean_foreach(rmean_net, seek_stat_item, L) == 0)
+	if (iproto_rmean_foreach(seek_stat_item, L) == 0)
 		return 0;
 
 	if (strcmp(key, "CONNECTIONS") == 0) {
@@ -179,26 +215,156 @@ lbox_stat_net_index(struct lua_State *L)
  * - current -- amount of resources currently hold (say, number of
  *   open connections).
  */
-static int
-lbox_stat_net_call(struct lua_State *L)
+static void
+lbox_stat_net_push_current(struct lua_State *L, size_t connections,
+			   size_t requests)
 {
-	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
-
 	lua_pushstring(L, "CONNECTIONS");
 	lua_rawget(L, -2);
 	lua_pushstring(L, "current");
-	lua_pushnumber(L, iproto_connection_count());
+	lua_pushnumber(L, connections);
 	lua_rawset(L, -3);
 	lua_pop(L, 1);
 
 	lua_pushstring(L, "REQUESTS");
 	lua_rawget(L, -2);
 	lua_pushstring(L, "current");
-	lua_pushnumber(L, iproto_request_count());
+	lua_pushnumber(L, requests);
 	lua_rawset(L, -3);
 	lua_pop(L, 1);
+}
+
+static int
+lbox_stat_net_call(struct lua_State *L)
+{
+	lua_newtable(L);
+	iproto_rmean_foreach(set_stat_item, L);
+	lbox_stat_net_push_current(L, iproto_connection_count(),
+				   iproto_request_count());
+	return 1;
+}
+
+/** Push a table of network metrics of an iproto thread. */
+static void
+lbox_stat_net_push_thread(struct lua_State *L, int thread_id)
+{
+	lua_newtable(L);
+	iproto_thread_rmean_foreach(thread_id, set_stat_item, L);
+	lbox_stat_net_push_current(L, iproto_thread_connection_count(thread_id),
+				   iproto_thread_request_count(thread_id));
+}
+
+/**
+ * Push an array of network metrics of each iproto thread to a
+ * Lua stack, or metrics of one thread if its number (starting
+ * from 1) is given. Metrics are the same as in
+ * lbox_stat_net_call().
+ */
+static int
+lbox_stat_net_thread(struct lua_State *L)
+{
+	int count = iproto_thread_count();
+	if (lua_gettop(L) > 0) {
+		int id = luaL_checkinteger(L, 1);
+		if (id < 1 || id > count)
+			return luaL_error(L, "invalid iproto thread %d", id);
+		lbox_stat_net_push_thread(L, id - 1);
+		return 1;
+	}
+	lua_createtable(L, count, 0);
+	for (int i = 0; i < count; i++) {
+		lbox_stat_net_push_thread(L, i);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+/** Push a table of latency percentiles to a Lua stack. */
+static void
+lbox_stat_push_latency(struct lua_State *L, struct latency *latency)
+{
+	static const int pcts[] = {50, 75, 90, 95, 99};
+	lua_createtable(L, 0, lengthof(pcts));
+	for (size_t i = 0; i < lengthof(pcts); i++) {
+		lua_pushnumber(L, latency_get(latency, pcts[i]));
+		lua_setfield(L, -2, tt_sprintf("p%d", pcts[i]));
+	}
+}
+
+/** Push a slow request trace to a Lua stack. */
+static void
+lbox_stat_push_trace(struct lua_State *L, const struct iproto_trace *trace)
+{
+	lua_newtable(L);
+	const char *type = iproto_type_name(trace->type);
+	if (type != NULL) {
+		lua_pushstring(L, type);
+		lua_setfield(L, -2, "type");
+	}
+	luaL_pushuint64(L, trace->sync);
+	lua_setfield(L, -2, "sync");
+	lua_pushnumber(L, iproto_trace_total(trace));
+	lua_setfield(L, -2, "total");
+	lua_newtable(L);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++) {
+		if (trace->time[i] == 0)
+			continue;
+		lua_pushnumber(L, iproto_trace_stage(trace, i));
+		lua_setfield(L, -2, iproto_trace_point_strs[i]);
+	}
+	lua_setfield(L, -2, "stages");
+}
+
+static int
+lbox_stat_trace_cmp(const void *a, const void *b)
+{
+	double ta = ((const struct iproto_trace *)a)->time[IPROTO_TRACE_READ];
+	double tb = ((const struct iproto_trace *)b)->time[IPROTO_TRACE_READ];
+	return ta < tb ? -1 : ta > tb;
+}
+
+/**
+ * Push latency statistics of requests sampled by all iproto
+ * threads to a Lua stack:
+ *
+ * - count -- number of sampled requests;
+ * - total -- percentiles of request latency;
+ * - stages -- percentiles of each stage latency, by the name
+ *   of the point ending the stage;
+ * - slow -- the latest requests which took longer than
+ *   box.cfg.net_trace_slow_threshold, in read order.
+ */
+static int
+lbox_stat_net_trace(struct lua_State *L)
+{
+	struct iproto_trace_stat stat;
+	if (iproto_trace_stat_create(&stat) != 0)
+		return luaL_error(L, "failed to allocate trace statistics");
+	iproto_trace_stat(&stat);
+
+	lua_newtable(L);
+	luaL_pushint64(L, stat.count);
+	lua_setfield(L, -2, "count");
+	lbox_stat_push_latency(L, &stat.total);
+	lua_setfield(L, -2, "total");
+
+	lua_newtable(L);
+	for (int i = IPROTO_TRACE_READ + 1; i < iproto_trace_point_MAX; i++) {
+		lbox_stat_push_latency(L, &stat.stage[i]);
+		lua_setfield(L, -2, iproto_trace_point_strs[i]);
+	}
+	lua_setfield(L, -2, "stages");
+
+	qsort(stat.slow, stat.slow_count, sizeof(stat.slow[0]),
+	      lbox_stat_trace_cmp);
+	lua_createtable(L, stat.slow_count, 0);
+	for (int i = 0; i < stat.slow_count; i++) {
+		lbox_stat_push_trace(L, &stat.slow[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "slow");
 
+	iproto_trace_stat_destroy(&stat);
 	return 1;
 }
 
@@ -229,6 +395,7 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
 		{NULL, NULL}
@@ -242,6 +409,8 @@ box_lua_stat_init(struct lua_State *L)
 	lua_pop(L, 1); /* stat module */
 
 	static const struct luaL_Reg netstatlib [] = {
+		{"thread", lbox_stat_net_thread},
+		{"trace", lbox_stat_net_trace},
 		{NULL, NULL}
 	};
 
@@ -487,6 +487,7 @@ static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_bitset_index_count,
 	/* .get = */ generic_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ memtx_bitset_index_replace,
 	/* .create_iterator = */ memtx_bitset_index_create_iterator,
 	/* .create_snapshot_iterator = */
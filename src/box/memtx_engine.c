@@ -36,8 +36,11 @@
 #include <small/mempool.h>
 
 #include "fiber.h"
+#include "cbus.h"
 #include "errinj.h"
+#include "error.h"
 #include "coio_file.h"
+#include "coio_task.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tree.h"
@@ -55,8 +58,10 @@
 static void
 checkpoint_cancel(struct checkpoint *ckpt);
 
+struct memtx_join_ctx;
+
 static void
-replica_join_cancel(struct cord *replica_join_cord);
+replica_join_cancel(struct memtx_join_ctx *ctx);
 
 struct PACKED memtx_tuple {
 	/*
@@ -89,6 +94,89 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	return 0;
 }
 
+static int
+memtx_index_sort_f(va_list ap)
+{
+	struct index *index = va_arg(ap, struct index *);
+	return memtx_tree_index_sort(index, false);
+}
+
+/**
+ * Build all secondary indexes of a space in one pass over
+ * the primary key. Build arrays of tree indexes are sorted
+ * concurrently in coio threads.
+ */
+static int
+memtx_build_secondary_keys_bulk(struct space *space)
+{
+	struct index *pk = space->index[0];
+	ssize_t n_tuples = index_size(pk);
+	if (n_tuples < 0)
+		return -1;
+	uint32_t estimated_tuples = n_tuples * 1.2;
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		index_begin_build(index);
+		if (index_reserve(index, estimated_tuples) < 0)
+			return -1;
+		if (n_tuples > 0) {
+			say_info("Adding %zd keys to %s index '%s' ...",
+				 n_tuples, index_type_strs[index->def->type],
+				 index->def->name);
+		}
+	}
+
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	int rc;
+	struct tuple *tuple;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		for (uint32_t j = 1; j < space->index_count; j++) {
+			rc = index_build_next(space->index[j], tuple);
+			if (rc != 0)
+				break;
+		}
+		if (rc != 0)
+			break;
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		return -1;
+
+	/*
+	 * Sorting is the most expensive part of building a tree
+	 * index so do it for all tree indexes of the space in
+	 * parallel. Fall back on sorting in tx if we fail to
+	 * start a fiber.
+	 */
+	struct fiber *sort_fibers[BOX_INDEX_MAX];
+	uint32_t sort_fiber_count = 0;
+	for (uint32_t j = 1; j < space->index_count; j++) {
+		struct index *index = space->index[j];
+		if (index->def->type != TREE)
+			continue;
+		struct fiber *f = fiber_new("index_sort", memtx_index_sort_f);
+		if (f == NULL) {
+			diag_clear(diag_get());
+			continue;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, index);
+		sort_fibers[sort_fiber_count++] = f;
+	}
+	for (uint32_t i = 0; i < sort_fiber_count; i++) {
+		if (fiber_join(sort_fibers[i]) != 0)
+			rc = -1;
+	}
+	if (rc != 0)
+		return -1;
+
+	for (uint32_t j = 1; j < space->index_count; j++)
+		index_end_build(space->index[j]);
+	return 0;
+}
+
 /**
  * Secondary indexes are built in bulk after all data is
  * recovered. This function enables secondary keys on a space.
@@ -113,10 +201,8 @@ memtx_build_secondary_keys(struct space *space, void *param)
 				 space_name(space));
 		}
 
-		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
-				return -1;
-		}
+		if (memtx_build_secondary_keys_bulk(space) != 0)
+			return -1;
 
 		if (n_tuples > 0) {
 			say_info("Space '%s': done", space_name(space));
@@ -132,13 +218,17 @@ memtx_engine_shutdown(struct engine *engine)
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	if (memtx->checkpoint != NULL)
 		checkpoint_cancel(memtx->checkpoint);
-	if (memtx->replica_join_cord != NULL)
-		replica_join_cancel(memtx->replica_join_cord);
+	if (memtx->replica_join != NULL)
+		replica_join_cancel(memtx->replica_join);
 	mempool_destroy(&memtx->iterator_pool);
 	if (mempool_is_initialized(&memtx->rtree_iterator_pool))
 		mempool_destroy(&memtx->rtree_iterator_pool);
 	mempool_destroy(&memtx->index_extent_pool);
 	slab_cache_destroy(&memtx->index_slab_cache);
+	for (int i = 0; i < MEMTX_COMPACT_POOL_COUNT; i++) {
+		if (mempool_is_initialized(&memtx->compact_pool[i]))
+			mempool_destroy(&memtx->compact_pool[i]);
+	}
 	small_alloc_destroy(&memtx->alloc);
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
@@ -150,6 +240,326 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
+/* {{{ Snapshot reader */
+
+enum {
+	/** Number of row batches circulating between tx and reader. */
+	SNAP_READER_BATCH_COUNT = 4,
+	/** Amount of row data the reader packs into one batch. */
+	SNAP_READER_BATCH_SIZE = 1024 * 1024,
+};
+
+struct snap_reader;
+
+/**
+ * A batch of raw (decompressed) snapshot rows read by the
+ * snapshot reader thread and applied in tx.
+ */
+struct snap_batch {
+	/** Message sent between tx and the reader thread. */
+	struct cmsg base;
+	/** The reader this batch belongs to. */
+	struct snap_reader *reader;
+	/** Link in snap_reader::ready. */
+	struct stailq_entry in_ready;
+	/** Row data, allocated with malloc(). */
+	char *data;
+	/** Size of row data stored in the batch. */
+	size_t size;
+	/** Size of the memory allocated for row data. */
+	size_t capacity;
+	/** Set if there's no more data to read after this batch. */
+	bool is_last;
+	/** Set if reading the batch failed. The error is in @diag. */
+	bool is_error;
+	/** Error that occurred while reading the batch. */
+	struct diag diag;
+};
+
+/**
+ * Snapshot reader reads and decompresses xlog_tx blocks of
+ * a snapshot file in a separate thread so that tx only has to
+ * decode rows and build the primary keys.
+ */
+struct snap_reader {
+	/** Reader thread. */
+	struct cord cord;
+	/** Name of the snapshot file. */
+	char filename[PATH_MAX];
+	/** Snapshot cursor, opened and used by the reader thread. */
+	struct xlog_cursor cursor;
+	/** Set if the cursor was opened successfully. */
+	bool is_open;
+	/** Set once the reader has no more data to send. */
+	bool is_done;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Reader thread endpoint. */
+	struct cbus_endpoint endpoint;
+	/** Route of a batch: read in the reader thread, apply in tx. */
+	struct cmsg_hop route[2];
+	/** Set when the pipes between tx and the reader are ready. */
+	bool is_paired;
+	/** The tx fiber waiting for batches. */
+	struct fiber *fiber;
+	/** Batches read by the reader thread, waiting to be applied. */
+	struct stailq ready;
+	/** Number of batches sent to the reader thread. */
+	int in_flight;
+	/** Row batches. */
+	struct snap_batch batches[SNAP_READER_BATCH_COUNT];
+};
+
+static int
+snap_batch_reserve(struct snap_batch *batch, size_t size)
+{
+	if (batch->size + size <= batch->capacity)
+		return 0;
+	size_t capacity = MAX(batch->capacity * 2, batch->size + size);
+	char *data = realloc(batch->data, capacity);
+	if (data == NULL) {
+		diag_set(OutOfMemory, capacity, "realloc",
+			 "snapshot row batch");
+		return -1;
+	}
+	batch->data = data;
+	batch->capacity = capacity;
+	return 0;
+}
+
+/**
+ * Fill a batch with rows read from the snapshot.
+ * Executed in the reader thread.
+ */
+static int
+snap_reader_fill_batch(struct snap_reader *reader, struct snap_batch *batch)
+{
+	if (!reader->is_open) {
+		if (xlog_cursor_open(&reader->cursor, reader->filename) != 0)
+			return -1;
+		reader->is_open = true;
+	}
+	struct xlog_cursor *cursor = &reader->cursor;
+	while (batch->size < SNAP_READER_BATCH_SIZE) {
+		int rc = xlog_cursor_next_tx(cursor);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
+			batch->is_last = true;
+			break;
+		}
+		/*
+		 * Copy raw rows of the current tx and let the
+		 * cursor proceed to the next one. Rows are
+		 * decoded by tx.
+		 */
+		struct xlog_tx_cursor *tx_cursor = &cursor->tx_cursor;
+		size_t size = tx_cursor->end - tx_cursor->rpos;
+		if (snap_batch_reserve(batch, size) != 0)
+			return -1;
+		memcpy(batch->data + batch->size, tx_cursor->rpos, size);
+		batch->size += size;
+		tx_cursor->rpos = tx_cursor->end;
+		struct xrow_header unused;
+		rc = xlog_cursor_next_row(cursor, &unused);
+		assert(rc > 0);
+		(void)rc;
+	}
+	return 0;
+}
+
+static void
+snap_batch_read(struct cmsg *msg)
+{
+	struct snap_batch *batch = (struct snap_batch *)msg;
+	struct snap_reader *reader = batch->reader;
+	batch->size = 0;
+	batch->is_last = false;
+	batch->is_error = false;
+	if (reader->is_done) {
+		batch->is_last = true;
+		return;
+	}
+	if (snap_reader_fill_batch(reader, batch) != 0) {
+		batch->is_last = true;
+		batch->is_error = true;
+		diag_move(diag_get(), &batch->diag);
+	}
+	if (batch->is_last)
+		reader->is_done = true;
+}
+
+static void
+snap_batch_complete(struct cmsg *msg)
+{
+	struct snap_batch *batch = (struct snap_batch *)msg;
+	struct snap_reader *reader = batch->reader;
+	assert(reader->in_flight > 0);
+	reader->in_flight--;
+	stailq_add_tail_entry(&reader->ready, batch, in_ready);
+	fiber_wakeup(reader->fiber);
+}
+
+static void
+snap_reader_pair_cb(void *arg)
+{
+	struct snap_reader *reader = arg;
+	reader->is_paired = true;
+	fiber_wakeup(reader->fiber);
+}
+
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	cbus_endpoint_create(&reader->endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_pair("tx", reader->endpoint.name, &reader->tx_pipe,
+		  &reader->reader_pipe, snap_reader_pair_cb, reader,
+		  cbus_process);
+	cbus_loop(&reader->endpoint);
+	cbus_unpair(&reader->tx_pipe, &reader->reader_pipe,
+		    NULL, NULL, cbus_process);
+	cbus_endpoint_destroy(&reader->endpoint, cbus_process);
+	if (reader->is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	return 0;
+}
+
+static void
+snap_reader_send(struct snap_reader *reader, struct snap_batch *batch)
+{
+	cmsg_init(&batch->base, reader->route);
+	reader->in_flight++;
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+static int
+snap_reader_start(struct snap_reader *reader, const char *filename)
+{
+	memset(reader, 0, sizeof(*reader));
+	snprintf(reader->filename, sizeof(reader->filename), "%s", filename);
+	reader->route[0].f = snap_batch_read;
+	reader->route[0].pipe = &reader->tx_pipe;
+	reader->route[1].f = snap_batch_complete;
+	reader->route[1].pipe = NULL;
+	reader->fiber = fiber();
+	stailq_create(&reader->ready);
+	for (int i = 0; i < SNAP_READER_BATCH_COUNT; i++) {
+		reader->batches[i].reader = reader;
+		diag_create(&reader->batches[i].diag);
+	}
+	if (cord_costart(&reader->cord, "snap_reader",
+			 snap_reader_f, reader) != 0)
+		return -1;
+	while (!reader->is_paired)
+		fiber_yield();
+	for (int i = 0; i < SNAP_READER_BATCH_COUNT; i++)
+		snap_reader_send(reader, &reader->batches[i]);
+	return 0;
+}
+
+/**
+ * Wait for all batches to return to tx, stop the reader thread
+ * and free the batches.
+ */
+static void
+snap_reader_stop(struct snap_reader *reader)
+{
+	while (reader->in_flight > 0)
+		fiber_yield();
+	cbus_stop_loop(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		diag_log();
+	for (int i = 0; i < SNAP_READER_BATCH_COUNT; i++) {
+		free(reader->batches[i].data);
+		diag_destroy(&reader->batches[i].diag);
+	}
+}
+
+/** Wait for the next batch read by the reader thread. */
+static struct snap_batch *
+snap_reader_next(struct snap_reader *reader)
+{
+	while (stailq_empty(&reader->ready))
+		fiber_yield();
+	return stailq_shift_entry(&reader->ready, struct snap_batch,
+				  in_ready);
+}
+
+/* }}} */
+
+/**
+ * Recover a snapshot with the help of the snapshot reader
+ * thread. Used for the fast start path when rows are known
+ * to be consistent and sorted by the primary key.
+ */
+static int
+memtx_engine_recover_snapshot_threaded(struct memtx_engine *memtx,
+				       const char *filename,
+				       int64_t signature)
+{
+	struct snap_reader *reader = malloc(sizeof(*reader));
+	if (reader == NULL) {
+		diag_set(OutOfMemory, sizeof(*reader),
+			 "malloc", "struct snap_reader");
+		return -1;
+	}
+	if (snap_reader_start(reader, filename) != 0) {
+		free(reader);
+		return -1;
+	}
+	int rc = 0;
+	uint64_t row_count = 0;
+	struct snap_batch *batch;
+	do {
+		batch = snap_reader_next(reader);
+		if (batch->is_error) {
+			diag_move(&batch->diag, diag_get());
+			rc = -1;
+			break;
+		}
+		const char *pos = batch->data;
+		const char *end = batch->data + batch->size;
+		while (pos < end) {
+			struct xrow_header row;
+			if (xrow_header_decode(&row, &pos, end, false) != 0) {
+				diag_set(XlogError, "can't parse row");
+				rc = -1;
+				break;
+			}
+			row.lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(memtx, &row);
+			if (rc < 0)
+				break;
+			++row_count;
+			if (row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
+		}
+		if (rc == 0 && !batch->is_last)
+			snap_reader_send(reader, batch);
+	} while (rc == 0 && !batch->is_last);
+
+	snap_reader_stop(reader);
+	bool is_eof = xlog_cursor_is_eof(&reader->cursor);
+	free(reader);
+	if (rc < 0)
+		return -1;
+	/**
+	 * We should never try to read snapshots with no EOF
+	 * marker - such snapshots are very likely corrupted and
+	 * should not be trusted.
+	 */
+	if (!is_eof)
+		panic("snapshot `%s' has no EOF marker", filename);
+	return 0;
+}
+
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock)
@@ -161,6 +571,14 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
+	/*
+	 * Unless it's a disaster recovery, which needs to skip
+	 * broken rows and transactions, offload reading and
+	 * decompression of the snapshot to a separate thread.
+	 */
+	if (!memtx->force_recovery)
+		return memtx_engine_recover_snapshot_threaded(memtx, filename,
+							      signature);
 	struct xlog_cursor cursor;
 	if (xlog_cursor_open(&cursor, filename) < 0)
 		return -1;
@@ -222,6 +640,30 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 		diag_set(ClientError, ER_CROSS_ENGINE_TRANSACTION);
 		return -1;
 	}
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace == memtx_space_replace_build_next &&
+	    space->sequence == NULL &&
+	    rlist_empty(&space->before_replace) &&
+	    rlist_empty(&space->on_replace)) {
+		/*
+		 * Fast path: snapshot rows are consistent and
+		 * sorted by the primary key, so there's no need
+		 * to wrap each of them in a transaction - feed
+		 * the tuple directly to the primary key build.
+		 */
+		struct tuple *tuple = memtx_tuple_new(space->format,
+						      request.tuple,
+						      request.tuple_end);
+		if (tuple == NULL)
+			return -1;
+		tuple_ref(tuple);
+		struct tuple *unused;
+		rc = memtx_space->replace(space, NULL, tuple,
+					  DUP_INSERT, &unused);
+		tuple_unref(tuple);
+		fiber_gc();
+		return rc;
+	}
 	struct txn *txn = txn_begin();
 	if (txn == NULL)
 		return -1;
@@ -482,10 +924,13 @@ struct checkpoint {
 	 * checkpoint already exists.
 	 */
 	bool touch;
+	/** Statistics of writing the snapshot file. */
+	struct memtx_checkpoint_stat stat;
 };
 
 static struct checkpoint *
-checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
+checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit,
+	       int compression_level, int compression_threads)
 {
 	struct checkpoint *ckpt = malloc(sizeof(*ckpt));
 	if (ckpt == NULL) {
@@ -499,9 +944,12 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 	opts.rate_limit = snap_io_rate_limit;
 	opts.sync_interval = SNAP_SYNC_INTERVAL;
 	opts.free_cache = true;
+	opts.compression_level = compression_level;
+	opts.compression_threads = compression_threads;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID, &opts);
 	vclock_create(&ckpt->vclock);
 	ckpt->touch = false;
+	memset(&ckpt->stat, 0, sizeof(ckpt->stat));
 	return ckpt;
 }
 
@@ -532,18 +980,6 @@ checkpoint_cancel(struct checkpoint *ckpt)
 	checkpoint_delete(ckpt);
 }
 
-static void
-replica_join_cancel(struct cord *replica_join_cord)
-{
-	/*
-	 * Cancel the thread being used to join replica if it's
-	 * running and wait for it to terminate so as to
-	 * eliminate the possibility of use-after-free.
-	 */
-	tt_pthread_cancel(replica_join_cord->id);
-	tt_pthread_join(replica_join_cord->id, NULL);
-}
-
 static int
 checkpoint_add_space(struct space *sp, void *data)
 {
@@ -554,6 +990,10 @@ checkpoint_add_space(struct space *sp, void *data)
 	struct index *pk = space_index(sp, 0);
 	if (!pk)
 		return 0;
+	/* The space is empty until its indexes are built. */
+	struct memtx_space *memtx_space = (struct memtx_space *)sp;
+	if (memtx_space->replace == memtx_space_replace_bulk_load)
+		return 0;
 	struct checkpoint *ckpt = (struct checkpoint *)data;
 	struct checkpoint_entry *entry = malloc(sizeof(*entry));
 	if (entry == NULL) {
@@ -587,6 +1027,10 @@ checkpoint_f(va_list ap)
 		ckpt->touch = false;
 	}
 
+	/* Snapshot blocks may be compressed in coio threads. */
+	coio_enable();
+
+	double start = ev_monotonic_time();
 	struct xlog snap;
 	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
 		return -1;
@@ -610,6 +1054,9 @@ checkpoint_f(va_list ap)
 	if (xlog_flush(&snap) < 0)
 		goto fail;
 
+	ckpt->stat.compress_in = snap.zstat_in;
+	ckpt->stat.compress_out = snap.zstat_out;
+	ckpt->stat.time = ev_monotonic_time() - start;
 	xlog_close(&snap, false);
 	say_info("done");
 	return 0;
@@ -625,7 +1072,9 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 
 	assert(memtx->checkpoint == NULL);
 	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
+					   memtx->snap_io_rate_limit,
+					   memtx->snap_compression_level,
+					   memtx->snap_compression_threads);
 	if (memtx->checkpoint == NULL)
 		return -1;
 
@@ -666,6 +1115,8 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 		diag_log();
 
 	memtx->checkpoint->waiting_for_snap_thread = false;
+	if (result == 0 && !memtx->checkpoint->touch)
+		memtx->checkpoint_stat = memtx->checkpoint->stat;
 	return result;
 }
 
@@ -754,14 +1205,50 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 struct memtx_join_entry {
 	struct rlist in_ctx;
 	uint32_t space_id;
+	/** Size of the space data, used to balance streams. */
+	size_t bsize;
+	/** Set for system spaces, see engine_vtab::join(). */
+	bool is_system;
 	struct snapshot_iterator *iterator;
 };
 
-struct memtx_join_ctx {
+/** Part of the read view sent to one stream by one thread. */
+struct memtx_join_stream {
+	/** List of entries sent to the stream. */
 	struct rlist entries;
+	/** Total size of the entries. */
+	size_t bsize;
 	struct xstream *stream;
+	struct cord cord;
+	/** Set while the cord is started and not joined. */
+	bool is_running;
+};
+
+struct memtx_join_ctx {
+	struct rlist entries;
+	/** Streams being fed or NULL. */
+	struct memtx_join_stream *streams;
+	int stream_count;
 };
 
+static void
+replica_join_cancel(struct memtx_join_ctx *ctx)
+{
+	/*
+	 * Cancel the threads being used to join replica if they
+	 * are running and wait for them to terminate so as to
+	 * eliminate the possibility of use-after-free.
+	 */
+	for (int i = 0; i < ctx->stream_count; i++) {
+		struct memtx_join_stream *js = &ctx->streams[i];
+		if (!js->is_running)
+			continue;
+		tt_pthread_cancel(js->cord.id);
+		tt_pthread_join(js->cord.id, NULL);
+		js->is_running = false;
+	}
+}
+
 static int
 memtx_join_add_space(struct space *space, void *arg)
 {
@@ -782,6 +1269,8 @@ memtx_join_add_space(struct space *space, void *arg)
 		return -1;
 	}
 	entry->space_id = space_id(space);
+	entry->bsize = space_bsize(space);
+	entry->is_system = space_is_system(space);
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL) {
 		free(entry);
@@ -802,6 +1291,8 @@ memtx_engine_prepare_join(struct engine *engine, void **arg)
 		return -1;
 	}
 	rlist_create(&ctx->entries);
+	ctx->streams = NULL;
+	ctx->stream_count = 0;
 	if (space_foreach(memtx_join_add_space, ctx) != 0) {
 		free(ctx);
 		return -1;
@@ -833,15 +1324,15 @@ memtx_join_send_tuple(struct xstream *stream, uint32_t space_id,
 static int
 memtx_join_f(va_list ap)
 {
-	struct memtx_join_ctx *ctx = va_arg(ap, struct memtx_join_ctx *);
+	struct memtx_join_stream *js = va_arg(ap, struct memtx_join_stream *);
 	struct memtx_join_entry *entry;
-	rlist_foreach_entry(entry, &ctx->entries, in_ctx) {
+	rlist_foreach_entry(entry, &js->entries, in_ctx) {
 		struct snapshot_iterator *it = entry->iterator;
 		int rc;
 		uint32_t size;
 		const char *data;
 		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (memtx_join_send_tuple(ctx->stream, entry->space_id,
+			if (memtx_join_send_tuple(js->stream, entry->space_id,
 						  data, size) != 0)
 				return -1;
 		}
@@ -851,24 +1342,86 @@ memtx_join_f(va_list ap)
 	return 0;
 }
 
+/**
+ * Distribute system or non-system spaces among streams so
+ * that the streams carry about the same amount of data.
+ */
+static void
+memtx_join_distribute(struct memtx_join_ctx *ctx, bool is_system)
+{
+	struct memtx_join_entry *entry, *next;
+	rlist_foreach_entry_safe(entry, &ctx->entries, in_ctx, next) {
+		if (entry->is_system != is_system)
+			continue;
+		struct memtx_join_stream *js = &ctx->streams[0];
+		for (int i = 1; i < ctx->stream_count; i++) {
+			if (ctx->streams[i].bsize < js->bsize)
+				js = &ctx->streams[i];
+		}
+		js->bsize += entry->bsize;
+		rlist_move_tail_entry(&js->entries, entry, in_ctx);
+	}
+}
+
+/** Move all entries back to the context to free them. */
+static void
+memtx_join_collect(struct memtx_join_ctx *ctx)
+{
+	for (int i = 0; i < ctx->stream_count; i++)
+		rlist_splice_tail(&ctx->entries, &ctx->streams[i].entries);
+	free(ctx->streams);
+	ctx->streams = NULL;
+	ctx->stream_count = 0;
+}
+
 static int
-memtx_engine_join(struct engine *engine, void *arg, struct xstream *stream)
+memtx_engine_join(struct engine *engine, void *arg, bool is_system,
+		  struct xstream **streams, int stream_count)
 {
-	(void)engine;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	struct memtx_join_ctx *ctx = arg;
-	ctx->stream = stream;
+	assert(ctx->streams == NULL);
+	ctx->streams = calloc(stream_count, sizeof(*ctx->streams));
+	if (ctx->streams == NULL) {
+		diag_set(OutOfMemory, stream_count * sizeof(*ctx->streams),
+			 "calloc", "struct memtx_join_stream");
+		return -1;
+	}
+	ctx->stream_count = stream_count;
+	for (int i = 0; i < stream_count; i++) {
+		rlist_create(&ctx->streams[i].entries);
+		ctx->streams[i].stream = streams[i];
+	}
+	memtx_join_distribute(ctx, is_system);
 	/*
 	 * Memtx snapshot iterators are safe to use from another
 	 * thread and so we do so as not to consume too much of
 	 * precious tx cpu time while a new replica is joining.
+	 * Each stream is fed by its own thread.
 	 */
-	struct cord cord;
-	if (cord_costart(&cord, "initial_join", memtx_join_f, ctx) != 0)
-		return -1;
-	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	memtx->replica_join_cord = &cord;
-	int res = cord_cojoin(&cord);
-	memtx->replica_join_cord = NULL;
+	int res = 0;
+	memtx->replica_join = ctx;
+	for (int i = 0; i < stream_count; i++) {
+		struct memtx_join_stream *js = &ctx->streams[i];
+		if (rlist_empty(&js->entries))
+			continue;
+		if (cord_costart(&js->cord, "initial_join",
+				 memtx_join_f, js) != 0) {
+			res = -1;
+			break;
+		}
+		js->is_running = true;
+	}
+	for (int i = 0; i < stream_count; i++) {
+		struct memtx_join_stream *js = &ctx->streams[i];
+		if (!js->is_running)
+			continue;
+		if (cord_cojoin(&js->cord) != 0)
+			res = -1;
+		js->is_running = false;
+	}
+	memtx->replica_join = NULL;
+	memtx_join_collect(ctx);
 	return res;
 }
 
@@ -901,6 +1454,8 @@ memtx_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	struct mempool_stats index_stats;
 	mempool_stats(&memtx->index_extent_pool, &index_stats);
 	small_stats(&memtx->alloc, &data_stats, small_stats_noop_cb, NULL);
+	memtx_engine_compact_stats(memtx, &data_stats,
+				   small_stats_noop_cb, NULL);
 	stat->data += data_stats.used;
 	stat->index += index_stats.totals.used;
 }
@@ -990,6 +1545,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	xdir_create(&memtx->snap_dir, snap_dirname, SNAP, &INSTANCE_UUID,
 		    &xlog_opts_default);
 	memtx->snap_dir.force_recovery = force_recovery;
+	memtx->snap_compression_level = xlog_opts_default.compression_level;
+	memtx->snap_compression_threads = 0;
 
 	if (xdir_scan(&memtx->snap_dir) != 0)
 		goto fail;
@@ -1051,7 +1608,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
 	memtx->force_recovery = force_recovery;
 
-	memtx->replica_join_cord = NULL;
+	memtx->replica_join = NULL;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
@@ -1078,6 +1635,20 @@ memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+void
+memtx_engine_set_snap_compression_level(struct memtx_engine *memtx,
+					int level)
+{
+	memtx->snap_compression_level = level;
+}
+
+void
+memtx_engine_set_snap_compression_threads(struct memtx_engine *memtx,
+					  int threads)
+{
+	memtx->snap_compression_threads = threads;
+}
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 {
@@ -1112,6 +1683,95 @@ memtx_leave_delayed_free_mode(struct memtx_engine *memtx)
 		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
 }
 
+void
+memtx_engine_compact_stats(struct memtx_engine *memtx,
+			   struct small_stats *totals,
+			   mempool_stats_cb cb, void *cb_ctx)
+{
+	for (int i = 0; i < MEMTX_COMPACT_POOL_COUNT; i++) {
+		struct mempool *pool = &memtx->compact_pool[i];
+		if (!mempool_is_initialized(pool))
+			continue;
+		struct mempool_stats stats;
+		mempool_stats(pool, &stats);
+		totals->used += stats.totals.used;
+		totals->total += stats.totals.total;
+		if (cb(&stats, cb_ctx))
+			break;
+	}
+}
+
+/**
+ * Return the pool of compact tuples of the given allocation
+ * size. The size is rounded up, as the field map preceding
+ * tuple data must be aligned.
+ */
+static inline struct mempool *
+memtx_compact_pool(struct memtx_engine *memtx, size_t total)
+{
+	assert(total <= MEMTX_COMPACT_TUPLE_SIZE_MAX);
+	size_t i = DIV_ROUND_UP(total, MEMTX_COMPACT_TUPLE_ALIGN);
+	return &memtx->compact_pool[i];
+}
+
+/**
+ * Free a few compact tuples whose release was delayed by
+ * a snapshot. Like small_alloc, we spread the work over
+ * subsequent allocations instead of doing it all at once.
+ */
+static void
+memtx_compact_collect_garbage(struct memtx_engine *memtx)
+{
+	if (memtx->delayed_free_mode > 0)
+		return;
+	for (int i = 0; i < 2 && memtx->compact_garbage != NULL; i++) {
+		struct memtx_tuple *memtx_tuple = memtx->compact_garbage;
+		/*
+		 * Only the first 8 bytes of the header are reused.
+		 * The tuple may be aligned less than a pointer.
+		 */
+		memcpy(&memtx->compact_garbage, memtx_tuple, sizeof(void *));
+		size_t total = tuple_size(&memtx_tuple->base) +
+			       offsetof(struct memtx_tuple, base);
+		mempool_free(memtx_compact_pool(memtx, total), memtx_tuple);
+	}
+}
+
+static inline struct memtx_tuple *
+memtx_tuple_alloc(struct memtx_engine *memtx, struct tuple_format *format,
+		  size_t total)
+{
+	if (!format->is_compact || total > MEMTX_COMPACT_TUPLE_SIZE_MAX)
+		return smalloc(&memtx->alloc, total);
+	memtx_compact_collect_garbage(memtx);
+	struct mempool *pool = memtx_compact_pool(memtx, total);
+	if (!mempool_is_initialized(pool)) {
+		mempool_create(pool, &memtx->slab_cache,
+			       small_align(total, MEMTX_COMPACT_TUPLE_ALIGN));
+	}
+	return mempool_alloc(pool);
+}
+
+static inline void
+memtx_tuple_free(struct memtx_engine *memtx, struct tuple_format *format,
+		 struct memtx_tuple *memtx_tuple, size_t total, bool is_delayed)
+{
+	if (!format->is_compact || total > MEMTX_COMPACT_TUPLE_SIZE_MAX) {
+		if (is_delayed)
+			smfree_delayed(&memtx->alloc, memtx_tuple, total);
+		else
+			smfree(&memtx->alloc, memtx_tuple, total);
+		return;
+	}
+	if (is_delayed) {
+		memcpy(memtx_tuple, &memtx->compact_garbage, sizeof(void *));
+		memtx->compact_garbage = memtx_tuple;
+		return;
+	}
+	mempool_free(memtx_compact_pool(memtx, total), memtx_tuple);
+	memtx_compact_collect_garbage(memtx);
+}
+
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -1139,7 +1799,8 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	}
 
 	struct memtx_tuple *memtx_tuple;
-	while ((memtx_tuple = smalloc(&memtx->alloc, total)) == NULL) {
+	while ((memtx_tuple = memtx_tuple_alloc(memtx, format,
+						total)) == NULL) {
 		bool stop;
 		memtx_engine_run_gc(memtx, &stop);
 		if (stop)
@@ -1180,12 +1841,10 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
 	size_t total = tuple_size(tuple) + offsetof(struct memtx_tuple, base);
-	if (memtx->alloc.free_mode != SMALL_DELAYED_FREE ||
-	    memtx_tuple->version == memtx->snapshot_version ||
-	    format->is_temporary)
-		smfree(&memtx->alloc, memtx_tuple, total);
-	else
-		smfree_delayed(&memtx->alloc, memtx_tuple, total);
+	bool is_delayed = memtx->alloc.free_mode == SMALL_DELAYED_FREE &&
+			  memtx_tuple->version != memtx->snapshot_version &&
+			  !format->is_temporary;
+	memtx_tuple_free(memtx, format, memtx_tuple, total, is_delayed);
 	tuple_format_unref(format);
 }
 
@@ -1316,6 +1975,9 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.func_id != new_def->opts.func_id)
 		return true;
+	if (new_def->type == HASH &&
+	    old_def->opts.hash_layout != new_def->opts.hash_layout)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
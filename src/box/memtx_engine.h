@@ -49,6 +49,7 @@ struct index;
 struct fiber;
 struct tuple;
 struct tuple_format;
+struct memtx_join_ctx;
 
 /**
  * The state of memtx recovery process.
@@ -95,6 +96,29 @@ extern struct mempool memtx_index_extent_pool;
  */
 #define MEMTX_ITERATOR_SIZE (152)
 
+/**
+ * Tuples of compact formats up to this size, header included,
+ * are allocated from exact size pools rather than from
+ * small_alloc size classes. Sizes are rounded up to the field
+ * map slot size so that field maps stay aligned.
+ */
+enum {
+	MEMTX_COMPACT_TUPLE_SIZE_MAX = 128,
+	MEMTX_COMPACT_TUPLE_ALIGN = sizeof(uint32_t),
+	MEMTX_COMPACT_POOL_COUNT =
+		MEMTX_COMPACT_TUPLE_SIZE_MAX / MEMTX_COMPACT_TUPLE_ALIGN + 1,
+};
+
+/** Statistics of writing a snapshot. */
+struct memtx_checkpoint_stat {
+	/** Size of data passed to the compressor, in bytes. */
+	uint64_t compress_in;
+	/** Size of compressed data, in bytes. */
+	uint64_t compress_out;
+	/** Time it took to write the snapshot, in seconds. */
+	double time;
+};
+
 struct memtx_engine {
 	struct engine base;
 	/** Engine recovery state. */
@@ -105,13 +129,22 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/** zstd compression level used for snapshots. */
+	int snap_compression_level;
+	/**
+	 * Number of coio threads compressing a snapshot,
+	 * 0 to compress in the snapshot thread.
+	 */
+	int snap_compression_threads;
+	/** Statistics of the last written snapshot. */
+	struct memtx_checkpoint_stat checkpoint_stat;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/**
-	 * Cord being currently used to join replica. It is only
-	 * needed to be able to cancel it on shutdown.
+	 * Replica join being currently fed by cords. It is only
+	 * needed to be able to cancel them on shutdown.
 	 */
-	struct cord *replica_join_cord;
+	struct memtx_join_ctx *replica_join;
 	/** Common quota for tuples and indexes. */
 	struct quota quota;
 	/**
@@ -125,6 +158,17 @@ struct memtx_engine {
 	struct slab_cache slab_cache;
 	/** Tuple allocator. */
 	struct small_alloc alloc;
+	/**
+	 * Exact size pools for small tuples of compact formats,
+	 * indexed by allocation size divided by
+	 * MEMTX_COMPACT_TUPLE_ALIGN and created on demand.
+	 */
+	struct mempool compact_pool[MEMTX_COMPACT_POOL_COUNT];
+	/**
+	 * Compact tuples freed in delayed free mode, linked
+	 * through their headers like in smfree_delayed.
+	 */
+	void *compact_garbage;
 	/** Slab cache for allocating index extents. */
 	struct slab_cache index_slab_cache;
 	/** Index extent allocator. */
@@ -210,6 +254,14 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+void
+memtx_engine_set_snap_compression_level(struct memtx_engine *memtx,
+					int level);
+
+void
+memtx_engine_set_snap_compression_threads(struct memtx_engine *memtx,
+					  int threads);
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 
@@ -233,6 +285,15 @@ memtx_enter_delayed_free_mode(struct memtx_engine *memtx);
 void
 memtx_leave_delayed_free_mode(struct memtx_engine *memtx);
 
+/**
+ * Add memory used by compact tuple pools to @a totals and
+ * call @a cb for each pool in use, like small_stats() does.
+ */
+void
+memtx_engine_compact_stats(struct memtx_engine *memtx,
+			   struct small_stats *totals,
+			   mempool_stats_cb cb, void *cb_ctx);
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
@@ -287,6 +287,44 @@ memtx_hash_index_get(struct index *base, const char *key,
 	return 0;
 }
 
+static int
+memtx_hash_index_get_batch(struct index *base, const char *keys,
+			   uint32_t key_count, struct tuple **result)
+{
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct key_def *key_def = base->def->key_def;
+	assert(base->def->opts.is_unique);
+
+	enum { BATCH_SIZE = 32 };
+	const char *batch[BATCH_SIZE];
+	uint32_t hashes[BATCH_SIZE];
+	uint32_t found[BATCH_SIZE];
+	const char *key = keys;
+	for (uint32_t start = 0; start < key_count; start += BATCH_SIZE) {
+		uint32_t size = MIN(key_count - start, (uint32_t)BATCH_SIZE);
+		for (uint32_t i = 0; i < size; i++) {
+			uint32_t part_count = mp_decode_array(&key);
+			assert(part_count == key_def->part_count);
+			batch[i] = key;
+			hashes[i] = key_hash(key, key_def);
+			for (uint32_t j = 0; j < part_count; j++)
+				mp_next(&key);
+		}
+		light_index_find_key_batch(&index->hash_table, hashes, batch,
+					   size, found);
+		for (uint32_t i = 0; i < size; i++) {
+			struct tuple *tuple = NULL;
+			if (found[i] != light_index_end) {
+				tuple = light_index_get(&index->hash_table,
+							found[i]);
+				tuple_ref(tuple);
+			}
+			result[start + i] = tuple;
+		}
+	}
+	return 0;
+}
+
 static int
 memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -488,6 +526,7 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .random = */ memtx_hash_index_random,
 	/* .count = */ memtx_hash_index_count,
 	/* .get = */ memtx_hash_index_get,
+	/* .get_batch = */ memtx_hash_index_get_batch,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -325,6 +325,7 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_rtree_index_count,
 	/* .get = */ memtx_rtree_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ memtx_rtree_index_replace,
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
 	/* .create_snapshot_iterator = */
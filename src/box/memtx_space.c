@@ -36,6 +36,7 @@
 #include "xrow_update.h"
 #include "xrow.h"
 #include "memtx_hash.h"
+#include "memtx_swiss.h"
 #include "memtx_tree.h"
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
@@ -772,6 +773,8 @@ memtx_space_create_index(struct space *space, struct index_def *index_def)
 
 	switch (index_def->type) {
 	case HASH:
+		if (index_def->opts.hash_layout == HASH_LAYOUT_SWISS)
+			return memtx_swiss_index_new(memtx, index_def);
 		return memtx_hash_index_new(memtx, index_def);
 	case TREE:
 		return memtx_tree_index_new(memtx, index_def);
@@ -817,6 +820,30 @@ memtx_space_add_primary_key(struct space *space)
 	return 0;
 }
 
+/*
+ * Build a new secondary tree index in bulk, sorting its tuples
+ * in a coio thread, if the space has at least this many tuples.
+ */
+enum { MEMTX_DDL_BULK_BUILD_THRESHOLD = 100000 };
+
+/*
+ * A change done to the space while a new index was being
+ * built in bulk. Applied to the index once it's built, unless
+ * the statement which made it is rolled back before that.
+ */
+struct memtx_ddl_change {
+	/* Link in memtx_ddl_state::changes. */
+	struct rlist in_changes;
+	/* Replaced tuple, referenced. May be NULL. */
+	struct tuple *old_tuple;
+	/* New tuple, referenced. May be NULL. */
+	struct tuple *new_tuple;
+	/* Drops the change if the statement is rolled back. */
+	struct trigger on_rollback;
+	/* Stops tracking the statement once it's committed. */
+	struct trigger on_commit;
+};
+
 /*
  * Ongoing index build or format check state used by
  * corrseponding on_replace triggers.
@@ -830,6 +857,14 @@ struct memtx_ddl_state {
 	struct tuple *cursor;
 	/* Primary key key_def to compare new tuples with cursor. */
 	struct key_def *cmp_def;
+	/*
+	 * Set if the index is built in bulk. In this mode all
+	 * changes are logged in @changes instead of being applied
+	 * to the index right away.
+	 */
+	bool is_bulk;
+	/* List of memtx_ddl_change objects. */
+	struct rlist changes;
 	struct diag diag;
 	int rc;
 };
@@ -958,6 +993,52 @@ memtx_init_ephemeral_space(struct space *space)
 	memtx_space_add_primary_key(space);
 }
 
+/*
+ * Unlink a change logged while a new index was built in bulk
+ * from the build state and the statement which made it, and
+ * free it.
+ */
+static void
+memtx_ddl_change_delete(struct memtx_ddl_change *change)
+{
+	trigger_clear(&change->on_rollback);
+	trigger_clear(&change->on_commit);
+	rlist_del_entry(change, in_changes);
+	if (change->old_tuple != NULL)
+		tuple_unref(change->old_tuple);
+	if (change->new_tuple != NULL)
+		tuple_unref(change->new_tuple);
+	free(change);
+}
+
+/*
+ * The statement which made a change has been rolled back
+ * while the index was being built, so the change must not be
+ * applied to it.
+ */
+static int
+memtx_ddl_change_on_rollback(struct trigger *trigger, void *event)
+{
+	(void)event;
+	memtx_ddl_change_delete(trigger->data);
+	return 0;
+}
+
+/*
+ * The statement which made a change has been committed. Detach
+ * the change from it, since the statement is freed along with
+ * its transaction.
+ */
+static int
+memtx_ddl_change_on_commit(struct trigger *trigger, void *event)
+{
+	(void)event;
+	struct memtx_ddl_change *change = trigger->data;
+	trigger_clear(&change->on_rollback);
+	trigger_clear(&change->on_commit);
+	return 0;
+}
+
 static int
 memtx_build_on_replace(struct trigger *trigger, void *event)
 {
@@ -965,6 +1046,31 @@ memtx_build_on_replace(struct trigger *trigger, void *event)
 	struct memtx_ddl_state *state = trigger->data;
 	struct txn_stmt *stmt = txn_current_stmt(txn);
 
+	if (state->is_bulk) {
+		struct memtx_ddl_change *change = malloc(sizeof(*change));
+		if (change == NULL) {
+			diag_set(OutOfMemory, sizeof(*change),
+				 "malloc", "struct memtx_ddl_change");
+			state->rc = -1;
+			diag_move(diag_get(), &state->diag);
+			return 0;
+		}
+		change->old_tuple = stmt->old_tuple;
+		if (change->old_tuple != NULL)
+			tuple_ref(change->old_tuple);
+		change->new_tuple = stmt->new_tuple;
+		if (change->new_tuple != NULL)
+			tuple_ref(change->new_tuple);
+		trigger_create(&change->on_rollback,
+			       memtx_ddl_change_on_rollback, change, NULL);
+		txn_stmt_on_rollback(stmt, &change->on_rollback);
+		trigger_create(&change->on_commit,
+			       memtx_ddl_change_on_commit, change, NULL);
+		txn_stmt_on_commit(stmt, &change->on_commit);
+		rlist_add_tail_entry(&state->changes, change, in_changes);
+		return 0;
+	}
+
 	struct tuple *cmp_tuple = stmt->new_tuple != NULL ? stmt->new_tuple :
 							    stmt->old_tuple;
 	/*
@@ -995,6 +1101,93 @@ memtx_build_on_replace(struct trigger *trigger, void *event)
 	return 0;
 }
 
+/*
+ * Free changes logged while a new index was built in bulk.
+ * Statements which made them and haven't been completed yet
+ * are being written to WAL ahead of the index build, so should
+ * they fail, the index build is rolled back too.
+ */
+static void
+memtx_ddl_state_free_changes(struct memtx_ddl_state *state)
+{
+	struct memtx_ddl_change *change, *next;
+	rlist_foreach_entry_safe(change, &state->changes, in_changes, next)
+		memtx_ddl_change_delete(change);
+}
+
+/*
+ * Apply changes logged while a new index was built in bulk
+ * to the index.
+ */
+static int
+memtx_ddl_state_apply_changes(struct memtx_ddl_state *state)
+{
+	enum dup_replace_mode mode =
+		state->index->def->opts.is_unique ? DUP_INSERT :
+						    DUP_REPLACE_OR_INSERT;
+	struct memtx_ddl_change *change;
+	rlist_foreach_entry(change, &state->changes, in_changes) {
+		if (change->new_tuple != NULL &&
+		    tuple_validate(state->format, change->new_tuple) != 0)
+			return -1;
+		struct tuple *delete;
+		if (index_replace(state->index, change->old_tuple,
+				  change->new_tuple, mode, &delete) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/*
+ * Build a new secondary tree index in bulk: collect all tuples
+ * of the primary key, sort them in a coio thread without blocking
+ * tx, then build the tree. Changes done to the space while the
+ * tuples are being sorted are logged by the on_replace trigger
+ * and applied once the tree is built.
+ */
+static int
+memtx_space_build_index_bulk(struct index *pk, struct memtx_ddl_state *state)
+{
+	struct index *new_index = state->index;
+	ssize_t n_tuples = index_size(pk);
+	if (n_tuples < 0)
+		return -1;
+	index_begin_build(new_index);
+	if (index_reserve(new_index, n_tuples * 1.2) != 0)
+		return -1;
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	/*
+	 * No yields while collecting tuples: the sort below relies
+	 * on the fact that all collected tuples are referenced
+	 * either by the primary key or by the logged changes.
+	 */
+	int rc;
+	struct tuple *tuple;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		rc = tuple_validate(state->format, tuple);
+		if (rc != 0)
+			break;
+		rc = index_build_next(new_index, tuple);
+		if (rc != 0)
+			break;
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		return -1;
+	state->is_bulk = true;
+	if (memtx_tree_index_sort(new_index, true) != 0)
+		return -1;
+	if (state->rc != 0) {
+		diag_move(&state->diag, diag_get());
+		return -1;
+	}
+	index_end_build(new_index);
+	state->is_bulk = false;
+	return memtx_ddl_state_apply_changes(state);
+}
+
 static int
 memtx_space_build_index(struct space *src_space, struct index *new_index,
 			struct tuple_format *new_format,
@@ -1041,6 +1234,8 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 	state.index = new_index;
 	state.format = new_format;
 	state.cmp_def = pk->def->key_def;
+	state.is_bulk = false;
+	rlist_create(&state.changes);
 	state.rc = 0;
 	diag_create(&state.diag);
 
@@ -1048,6 +1243,19 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 	trigger_create(&on_replace, memtx_build_on_replace, &state, NULL);
 	trigger_add(&src_space->on_replace, &on_replace);
 
+	if (new_index->def->iid != 0 && new_index->def->type == TREE &&
+	    !new_index->def->key_def->for_func_index &&
+	    memtx->state == MEMTX_OK &&
+	    index_size(pk) >= MEMTX_DDL_BULK_BUILD_THRESHOLD) {
+		iterator_delete(it);
+		int rc = memtx_space_build_index_bulk(pk, &state);
+		memtx_ddl_state_free_changes(&state);
+		diag_destroy(&state.diag);
+		trigger_clear(&on_replace);
+		txn_can_yield(txn, false);
+		return rc;
+	}
+
 	/*
 	 * The index has to be built tuple by tuple, since
 	 * there is no guarantee that all tuples satisfy
@@ -1116,6 +1324,138 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 	return rc;
 }
 
+int
+memtx_space_replace_bulk_load(struct space *space, struct tuple *old_tuple,
+			      struct tuple *new_tuple,
+			      enum dup_replace_mode mode,
+			      struct tuple **result)
+{
+	(void)space;
+	(void)old_tuple;
+	(void)new_tuple;
+	(void)mode;
+	(void)result;
+	diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+		 "changes to the space being loaded");
+	return -1;
+}
+
+/*
+ * Undo index_build_next() calls done for the first @a count
+ * tuples of @a tuples so that the index is empty again.
+ */
+static void
+memtx_space_abort_build(struct index *index, struct tuple **tuples,
+			uint32_t count)
+{
+	if (index->def->type == TREE) {
+		memtx_tree_index_abort_build(index);
+		return;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		struct tuple *unused;
+		if (index_replace(index, tuples[i], NULL,
+				  DUP_REPLACE_OR_INSERT, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to abort bulk load");
+		}
+	}
+}
+
+/*
+ * Fill an empty space in bulk: create all tuples, then build
+ * every index the way it's done on snapshot recovery. Tree
+ * indexes are sorted in a coio thread, which also checks the
+ * unique constraint, so tx isn't blocked by the sort. Nothing
+ * is written to WAL.
+ */
+static int
+memtx_space_bulk_load(struct space *space, const char *data,
+		      const char *data_end)
+{
+	(void)data_end;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	struct index *pk = index_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	if (memtx->state != MEMTX_OK ||
+	    memtx_space->replace != memtx_space_replace_all_keys) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "spaces that are being recovered or loaded");
+		return -1;
+	}
+	if (index_size(pk) != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "non-empty spaces");
+		return -1;
+	}
+	uint32_t count = mp_decode_array(&data);
+	if (count == 0)
+		return 0;
+	struct tuple **tuples = malloc(count * sizeof(*tuples));
+	if (tuples == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*tuples),
+			 "malloc", "tuples");
+		return -1;
+	}
+	memtx_space->replace = memtx_space_replace_bulk_load;
+
+	int rc = 0;
+	uint32_t i, n_built = 0, n_tuples = 0;
+	while (n_tuples < count) {
+		const char *tuple_end = data;
+		mp_next(&tuple_end);
+		struct tuple *tuple = memtx_tuple_new(space->format, data,
+						      tuple_end);
+		if (tuple == NULL) {
+			rc = -1;
+			goto out;
+		}
+		tuple_ref(tuple);
+		tuples[n_tuples++] = tuple;
+		data = tuple_end;
+		if (n_tuples % MEMTX_DDL_YIELD_LOOPS == 0)
+			fiber_sleep(0);
+	}
+
+	for (i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		index_begin_build(index);
+		rc = index_reserve(index, count);
+		for (n_built = 0; rc == 0 && n_built < count; n_built++) {
+			rc = index_build_next(index, tuples[n_built]);
+			if (rc != 0)
+				break;
+		}
+		if (rc == 0 && index->def->type == TREE)
+			rc = memtx_tree_index_sort(index, true);
+		if (rc != 0)
+			break;
+	}
+	if (rc != 0) {
+		/* The failed index is aborted along with built ones. */
+		for (uint32_t j = 0; j <= i && j < space->index_count; j++) {
+			memtx_space_abort_build(space->index[j], tuples,
+						j < i ? count : n_built);
+		}
+		goto out;
+	}
+	for (i = 0; i < space->index_count; i++)
+		index_end_build(space->index[i]);
+	/* The tuples are now referenced by the primary key. */
+	for (i = 0; i < count; i++)
+		memtx_space_update_bsize(space, NULL, tuples[i]);
+	n_tuples = 0;
+out:
+	for (i = 0; i < n_tuples; i++)
+		tuple_unref(tuples[i]);
+	free(tuples);
+	memtx_space->replace = memtx_space_replace_all_keys;
+	return rc;
+}
+
 static int
 memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 {
@@ -1154,6 +1494,7 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .drop_primary_key = */ memtx_space_drop_primary_key,
 	/* .check_format  = */ memtx_space_check_format,
 	/* .build_index = */ memtx_space_build_index,
+	/* .bulk_load = */ memtx_space_bulk_load,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ memtx_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
@@ -1181,7 +1522,8 @@ memtx_space_new(struct memtx_engine *memtx,
 		tuple_format_new(&memtx_tuple_format_vtab, memtx, keys, key_count,
 				 def->fields, def->field_count,
 				 def->exact_field_count, def->dict,
-				 def->opts.is_temporary, def->opts.is_ephemeral);
+				 def->opts.is_temporary, def->opts.is_ephemeral,
+				 def->opts.compact_tuples);
 	if (format == NULL) {
 		free(memtx_space);
 		return NULL;
@@ -82,6 +82,14 @@ memtx_space_replace_primary_key(struct space *, struct tuple *, struct tuple *,
 int
 memtx_space_replace_all_keys(struct space *, struct tuple *, struct tuple *,
 			     enum dup_replace_mode, struct tuple **);
+/**
+ * A version of replace() used while indexes of a space are
+ * built by bulk load: the space can't be changed until the
+ * load is complete.
+ */
+int
+memtx_space_replace_bulk_load(struct space *, struct tuple *, struct tuple *,
+			      enum dup_replace_mode, struct tuple **);
 
 struct space *
 memtx_space_new(struct memtx_engine *memtx,
@@ -35,6 +35,7 @@
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
+#include "coio_task.h"
 #include "key_list.h"
 #include "tuple.h"
 #include <third_party/qsort_arg.h>
@@ -109,6 +110,8 @@ struct memtx_tree_index {
 	struct memtx_tree tree;
 	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Set if build_array was sorted by memtx_tree_index_sort(). */
+	bool build_array_is_sorted;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
 };
@@ -543,6 +546,44 @@ memtx_tree_index_get(struct index *base, const char *key,
 	return 0;
 }
 
+static int
+memtx_tree_index_get_batch(struct index *base, const char *keys,
+			   uint32_t key_count, struct tuple **result)
+{
+	assert(base->def->opts.is_unique);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+
+	enum { BATCH_SIZE = 32 };
+	struct memtx_tree_key_data key_data[BATCH_SIZE];
+	struct memtx_tree_key_data *batch[BATCH_SIZE];
+	struct memtx_tree_data *found[BATCH_SIZE];
+	const char *key = keys;
+	for (uint32_t start = 0; start < key_count; start += BATCH_SIZE) {
+		uint32_t size = MIN(key_count - start, (uint32_t)BATCH_SIZE);
+		for (uint32_t i = 0; i < size; i++) {
+			uint32_t part_count = mp_decode_array(&key);
+			assert(part_count == base->def->key_def->part_count);
+			key_data[i].key = key;
+			key_data[i].part_count = part_count;
+			key_data[i].hint = key_hint(key, part_count, cmp_def);
+			batch[i] = &key_data[i];
+			for (uint32_t j = 0; j < part_count; j++)
+				mp_next(&key);
+		}
+		memtx_tree_find_batch(&index->tree, batch, size, found);
+		for (uint32_t i = 0; i < size; i++) {
+			struct tuple *tuple = NULL;
+			if (found[i] != NULL) {
+				tuple = found[i]->tuple;
+				tuple_ref(tuple);
+			}
+			result[start + i] = tuple;
+		}
+	}
+	return 0;
+}
+
 static int
 memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -1179,8 +1220,12 @@ memtx_tree_index_end_build(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
-	qsort_arg(index->build_array, index->build_array_size,
-		  sizeof(index->build_array[0]), memtx_tree_qcompare, cmp_def);
+	if (!index->build_array_is_sorted) {
+		qsort_arg(index->build_array, index->build_array_size,
+			  sizeof(index->build_array[0]),
+			  memtx_tree_qcompare, cmp_def);
+	}
+	index->build_array_is_sorted = false;
 	if (cmp_def->is_multikey) {
 		/*
 		 * Multikey index may have equal(in terms of
@@ -1203,6 +1248,93 @@ memtx_tree_index_end_build(struct index *base)
 	index->build_array_alloc_size = 0;
 }
 
+/**
+ * Sort the build array of a tree index and look for duplicates
+ * if requested. Doesn't access any tx thread state and hence is
+ * run in a coio thread. Returns the position of the first found
+ * duplicate in @a dup_pos or 0 if there's none.
+ */
+static ssize_t
+memtx_tree_index_sort_f(va_list ap)
+{
+	struct memtx_tree_index *index = va_arg(ap, struct memtx_tree_index *);
+	bool check_unique = va_arg(ap, int);
+	size_t *dup_pos = va_arg(ap, size_t *);
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct memtx_tree_data *array = index->build_array;
+#ifdef HAVE_OPENMP
+	/*
+	 * Tx isn't blocked by the sort, so use the parallel
+	 * version regardless of the array size.
+	 */
+	qsort_arg_mt(array, index->build_array_size, sizeof(array[0]),
+		     memtx_tree_qcompare, cmp_def);
+#else
+	qsort_arg(array, index->build_array_size, sizeof(array[0]),
+		  memtx_tree_qcompare, cmp_def);
+#endif
+	*dup_pos = 0;
+	if (!check_unique)
+		return 0;
+	/*
+	 * Equal keys pointing to the same tuple are produced by
+	 * multikey and functional indexes. They are removed by
+	 * memtx_tree_index_build_array_deduplicate() and are not
+	 * duplicates in terms of the unique constraint.
+	 */
+	for (size_t i = 1; i < index->build_array_size; i++) {
+		if (array[i - 1].tuple != array[i].tuple &&
+		    memtx_tree_qcompare(&array[i - 1], &array[i],
+					cmp_def) == 0) {
+			*dup_pos = i;
+			break;
+		}
+	}
+	return 0;
+}
+
+int
+memtx_tree_index_sort(struct index *base, bool check_unique)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	assert(!index->build_array_is_sorted);
+	if (index->build_array_size == 0)
+		return 0;
+	check_unique = check_unique && base->def->opts.is_unique;
+	size_t dup_pos = 0;
+	if (coio_call(memtx_tree_index_sort_f, index,
+		      (int)check_unique, &dup_pos) != 0) {
+		diag_set(OutOfMemory, sizeof(struct coio_task),
+			 "calloc", "struct coio_task");
+		return -1;
+	}
+	index->build_array_is_sorted = true;
+	if (dup_pos != 0) {
+		struct space *space = space_by_id(base->def->space_id);
+		diag_set(ClientError, ER_TUPLE_FOUND, base->def->name,
+			 space != NULL ? space_name(space) : "");
+		return -1;
+	}
+	return 0;
+}
+
+void
+memtx_tree_index_abort_build(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (base->def->key_def->for_func_index) {
+		for (size_t i = 0; i < index->build_array_size; i++) {
+			tuple_chunk_delete(index->build_array[i].tuple,
+				(const char *)index->build_array[i].hint);
+		}
+	}
+	free(index->build_array);
+	index->build_array = NULL;
+	index->build_array_size = 0;
+	index->build_array_alloc_size = 0;
+	index->build_array_is_sorted = false;
+}
+
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct memtx_tree_index *index;
@@ -1285,6 +1417,7 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_batch = */ memtx_tree_index_get_batch,
 	/* .replace = */ memtx_tree_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1315,6 +1448,7 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_batch = */ memtx_tree_index_get_batch,
 	/* .replace = */ memtx_tree_index_replace_multikey,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1345,6 +1479,7 @@ static const struct index_vtab memtx_tree_func_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_batch = */ memtx_tree_index_get_batch,
 	/* .replace = */ memtx_tree_func_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1381,6 +1516,7 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ generic_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ disabled_index_replace,
 	/* .create_iterator = */ generic_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -31,6 +31,8 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -42,6 +44,28 @@ struct memtx_engine;
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Sort tuples collected by index_build_next() of a tree index
+ * in a coio thread, yielding the calling fiber until the sort
+ * is complete, so that index_end_build() doesn't have to do it
+ * in tx. Several indexes may be sorted concurrently this way.
+ * If @a check_unique is set and the index is unique, fail with
+ * ER_TUPLE_FOUND if the index would contain duplicates.
+ *
+ * Tuples collected by the index must not be freed until the
+ * function returns.
+ */
+int
+memtx_tree_index_sort(struct index *index, bool check_unique);
+
+/**
+ * Discard tuples collected by index_build_next() of a tree index
+ * instead of building the index out of them with index_end_build().
+ * The index is left empty.
+ */
+void
+memtx_tree_index_abort_build(struct index *index);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "read_view.h"
+
+#include <stdlib.h>
+
+#include "diag.h"
+#include "error.h"
+#include "index.h"
+#include "space.h"
+#include "schema.h"
+
+box_read_view_t *
+box_read_view_open(const uint32_t *space_ids, uint32_t space_count)
+{
+	size_t size = sizeof(struct read_view) +
+		      space_count * sizeof(struct read_view_space);
+	struct read_view *rv = (struct read_view *)calloc(1, size);
+	if (rv == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct read_view");
+		return NULL;
+	}
+	/*
+	 * Freezing an index doesn't yield, so all indexes
+	 * are frozen at the same point of the history.
+	 */
+	for (uint32_t i = 0; i < space_count; i++) {
+		struct space *space = space_cache_find(space_ids[i]);
+		if (space == NULL)
+			goto fail;
+		if (access_check_space(space, PRIV_R) != 0)
+			goto fail;
+		if (!space_is_memtx(space)) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 space->engine->name, "read views");
+			goto fail;
+		}
+		struct index *pk = index_find(space, 0);
+		if (pk == NULL)
+			goto fail;
+		struct read_view_space *rv_space = &rv->spaces[i];
+		rv_space->space_id = space_ids[i];
+		rv_space->iterator = index_create_snapshot_iterator(pk);
+		if (rv_space->iterator == NULL)
+			goto fail;
+		rv->space_count++;
+	}
+	return rv;
+fail:
+	box_read_view_close(rv);
+	return NULL;
+}
+
+int
+box_read_view_next(box_read_view_t *rv, uint32_t space_id,
+		   const char **data, uint32_t *size)
+{
+	for (uint32_t i = 0; i < rv->space_count; i++) {
+		struct snapshot_iterator *it = rv->spaces[i].iterator;
+		if (rv->spaces[i].space_id == space_id)
+			return it->next(it, data, size);
+	}
+	diag_set(ClientError, ER_NO_SUCH_SPACE, int2str(space_id));
+	return -1;
+}
+
+void
+box_read_view_close(box_read_view_t *rv)
+{
+	for (uint32_t i = 0; i < rv->space_count; i++) {
+		struct snapshot_iterator *it = rv->spaces[i].iterator;
+		it->free(it);
+	}
+	free(rv);
+}
@@ -0,0 +1,121 @@
+#ifndef TARANTOOL_BOX_READ_VIEW_H_INCLUDED
+#define TARANTOOL_BOX_READ_VIEW_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "trivia/util.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct snapshot_iterator;
+
+/** A space frozen in a read view. */
+struct read_view_space {
+	/** Space id. */
+	uint32_t space_id;
+	/** Iterator over the frozen primary index of the space. */
+	struct snapshot_iterator *iterator;
+};
+
+/**
+ * A consistent read view of a set of memtx spaces.
+ *
+ * It is built from the same snapshot iterators that are used
+ * by checkpointing: every primary index is frozen at the time
+ * the read view is opened, and writers keep going on their own
+ * copy of the index blocks. Tuples deleted after the read view
+ * was opened are not freed until it is closed, so a long-living
+ * read view holds back memory.
+ *
+ * A read view must be opened and closed in the TX thread, but
+ * its spaces may be scanned from any thread, or from fibers
+ * that yield between tuples.
+ */
+struct read_view {
+	/** Number of spaces in the read view. */
+	uint32_t space_count;
+	/** Spaces of the read view. */
+	struct read_view_space spaces[0];
+};
+
+/** \cond public */
+
+typedef struct read_view box_read_view_t;
+
+/**
+ * Open a read view of memtx spaces.
+ * Must be called from the TX thread.
+ *
+ * \param space_ids ids of spaces to include in the read view
+ * \param space_count number of spaces
+ * \retval NULL on error (check box_error_last())
+ * \retval read view otherwise
+ */
+API_EXPORT box_read_view_t *
+box_read_view_open(const uint32_t *space_ids, uint32_t space_count);
+
+/**
+ * Fetch the next tuple of a space from a read view.
+ * Every space of a read view can be scanned once, in the order
+ * of its primary index: key order for TREE, unspecified for
+ * HASH. May be called from any thread, but a space must not be
+ * scanned from several threads at the same time.
+ *
+ * \param rv read view
+ * \param space_id space id
+ * \param[out] data tuple data or NULL if the space is exhausted
+ * \param[out] size tuple data size
+ * \retval -1 on error (the space is not in the read view)
+ * \retval 0 on success
+ */
+API_EXPORT int
+box_read_view_next(box_read_view_t *rv, uint32_t space_id,
+		   const char **data, uint32_t *size);
+
+/**
+ * Close a read view and release the memory it holds back.
+ * Must be called from the TX thread.
+ *
+ * \param rv read view
+ */
+API_EXPORT void
+box_read_view_close(box_read_view_t *rv);
+
+/** \endcond public */
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_READ_VIEW_H_INCLUDED */
@@ -159,6 +159,22 @@ recovery_close_log(struct recovery *r)
 	trigger_run_xc(&r->on_close_log, NULL);
 }
 
+void
+recovery_release_log(struct recovery *r)
+{
+	if (xlog_cursor_is_open(&r->cursor)) {
+		xlog_cursor_close(&r->cursor, false);
+		trigger_run_xc(&r->on_close_log, NULL);
+	}
+	/*
+	 * Rows following the closed WAL are read by the caller,
+	 * so the next WAL to open isn't necessarily the one
+	 * following the closed WAL. Make recovery_open_log()
+	 * check it against r->vclock instead.
+	 */
+	r->cursor.state = XLOG_CURSOR_NEW;
+}
+
 static void
 recovery_open_log(struct recovery *r, const struct vclock *vclock)
 {
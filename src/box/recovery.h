@@ -92,6 +92,15 @@ recovery_finalize(struct recovery *r);
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
 
+/**
+ * Close the WAL file being read, if any, without reading it up.
+ * The next recover_remaining_wals() call will start from the
+ * WAL file containing rows following r->vclock. Used by relays
+ * which get rows from the WAL memory buffer, see wal_relay_buffer().
+ */
+void
+recovery_release_log(struct recovery *r);
+
 /**
  * Find out if there are new .xlog files since the current
  * vclock, and read them all up.
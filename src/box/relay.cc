@@ -51,6 +51,7 @@
 #include "version.h"
 #include "xrow.h"
 #include "xrow_io.h"
+#include "xrow_ring.h"
 #include "xstream.h"
 #include "wal.h"
 
@@ -115,6 +116,28 @@ struct relay {
 	 */
 	struct vclock local_vclock_at_subscribe;
 
+	/**
+	 * Buffer of rows recently written to WAL, see
+	 * wal_relay_buffer(), or NULL if it is disabled.
+	 */
+	struct xrow_ring *wal_buf;
+	/**
+	 * Set if rows are sent from wal_buf rather than
+	 * read from xlog files.
+	 */
+	bool wal_buf_is_used;
+	/** Position of the next row to read from wal_buf. */
+	uint64_t wal_buf_pos;
+	/** Rows copied from wal_buf to be sent. */
+	struct ibuf wal_buf_rows;
+	/**
+	 * Compressor of the stream sent to the replica or NULL
+	 * if the stream isn't compressed.
+	 */
+	struct xrow_compressor *compressor;
+	/** Compression statistics of the SUBSCRIBE stream. */
+	struct xrow_stream_stat compression_stat;
+
 	/** Relay endpoint */
 	struct cbus_endpoint endpoint;
 	/** A pipe from 'relay' thread to 'tx' */
@@ -165,6 +188,12 @@ relay_last_row_time(const struct relay *relay)
 	return relay->last_row_time;
 }
 
+const struct xrow_stream_stat *
+relay_compression_stat(const struct relay *relay)
+{
+	return relay->compressor != NULL ? &relay->compression_stat : NULL;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
@@ -285,9 +314,106 @@ relay_set_cord_name(int fd)
 	cord_set_name(name);
 }
 
+/**
+ * A connection attached to an initial JOIN to receive a part
+ * of the rows. Lives on the stack of the fiber which serves
+ * the connection until the JOIN is done with it.
+ */
+struct relay_join_stream {
+	/** Client connection. */
+	int fd;
+	/** Sync from incoming JOIN_STREAM request. */
+	uint64_t sync;
+	/** Set when the JOIN doesn't use the connection anymore. */
+	bool is_done;
+	/** Signaled when is_done is set. */
+	struct fiber_cond done_cond;
+};
+
+/** An initial JOIN sent over several connections. */
+struct relay_join {
+	/** Link in relay_joins. */
+	struct rlist in_joins;
+	/** UUID of the joining replica. */
+	struct tt_uuid instance_uuid;
+	/** Connections attached to the JOIN. */
+	struct relay_join_stream *streams[REPLICATION_JOIN_STREAMS_MAX];
+	/** Number of attached connections. */
+	int stream_count;
+	/** Number of connections to wait for. */
+	int stream_count_max;
+	/** Signaled when a connection is attached. */
+	struct fiber_cond attach_cond;
+};
+
+/** Initial JOINs waiting for connections or sending rows. */
+static RLIST_HEAD(relay_joins);
+
+static void
+relay_join_create(struct relay_join *join, const struct tt_uuid *uuid,
+		  int stream_count_max)
+{
+	assert(stream_count_max < REPLICATION_JOIN_STREAMS_MAX);
+	join->instance_uuid = *uuid;
+	join->stream_count = 0;
+	join->stream_count_max = stream_count_max;
+	fiber_cond_create(&join->attach_cond);
+	rlist_add_tail_entry(&relay_joins, join, in_joins);
+}
+
+/** Release all attached connections. */
+static void
+relay_join_destroy(struct relay_join *join)
+{
+	rlist_del_entry(join, in_joins);
+	for (int i = 0; i < join->stream_count; i++) {
+		struct relay_join_stream *stream = join->streams[i];
+		stream->is_done = true;
+		fiber_cond_signal(&stream->done_cond);
+	}
+	fiber_cond_destroy(&join->attach_cond);
+}
+
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_join_stream(int fd, uint64_t sync, const struct tt_uuid *instance_uuid)
 {
+	struct relay_join *join = NULL, *it;
+	rlist_foreach_entry(it, &relay_joins, in_joins) {
+		if (tt_uuid_is_equal(&it->instance_uuid, instance_uuid) &&
+		    it->stream_count < it->stream_count_max) {
+			join = it;
+			break;
+		}
+	}
+	if (join == NULL) {
+		tnt_raise(ClientError, ER_PROTOCOL,
+			  tt_sprintf("No JOIN of replica %s to attach to",
+				     tt_uuid_str(instance_uuid)));
+	}
+	struct relay_join_stream stream;
+	stream.fd = fd;
+	stream.sync = sync;
+	stream.is_done = false;
+	fiber_cond_create(&stream.done_cond);
+	join->streams[join->stream_count++] = &stream;
+	fiber_cond_signal(&join->attach_cond);
+	/*
+	 * The JOIN refers to the stream until it's done, so
+	 * wait for it even if the fiber is cancelled.
+	 */
+	while (!stream.is_done)
+		fiber_cond_wait(&stream.done_cond);
+	fiber_cond_destroy(&stream.done_cond);
+}
+
+void
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   struct xrow_compressor *compressor,
+		   const struct tt_uuid *instance_uuid, uint32_t stream_count)
+{
+	assert(stream_count >= 1 &&
+	       stream_count <= REPLICATION_JOIN_STREAMS_MAX);
+	assert(stream_count == 1 || instance_uuid != NULL);
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
@@ -313,14 +439,111 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 	if (wal_sync(vclock) != 0)
 		diag_raise();
 
-	/* Respond to the JOIN request with the current vclock. */
+	/*
+	 * Register the JOIN before responding so that additional
+	 * connections can't come before it.
+	 */
+	struct relay_join join;
+	if (stream_count > 1)
+		relay_join_create(&join, instance_uuid, stream_count - 1);
+	auto streams_guard = make_scoped_guard([&] {
+		if (stream_count > 1)
+			relay_join_destroy(&join);
+	});
+
+	/*
+	 * Respond to the JOIN request with the current vclock.
+	 * The response tells the replica whether the following
+	 * rows are compressed, so it's sent as is.
+	 */
 	struct xrow_header row;
-	xrow_encode_vclock_xc(&row, vclock);
+	xrow_encode_join_response_xc(&row, vclock, compressor != NULL ?
+				     IPROTO_COMPRESSION_ZSTD :
+				     IPROTO_COMPRESSION_NONE, stream_count);
 	row.sync = sync;
 	coio_write_xrow(&relay->io, &row);
+	relay->compressor = compressor;
+
+	/* Send read view to the replica, system spaces go first. */
+	struct xstream *streams[REPLICATION_JOIN_STREAMS_MAX];
+	streams[0] = &relay->stream;
+	engine_join_xc(&ctx, true, streams, 1);
+	if (stream_count == 1) {
+		engine_join_xc(&ctx, false, streams, 1);
+		return;
+	}
 
-	/* Send read view to the replica. */
-	engine_join_xc(&ctx, &relay->stream);
+	/*
+	 * Rows of other spaces are sent over several connections
+	 * in no particular order, so the replica needs to apply
+	 * the schema first. Mark the end of system spaces, the
+	 * replica attaches additional connections upon it.
+	 */
+	xrow_encode_vclock_xc(&row, vclock);
+	relay_send(relay, &row);
+	double deadline = ev_monotonic_now(loop()) +
+			  replication_connect_timeout;
+	while (join.stream_count < join.stream_count_max) {
+		if (fiber_cond_wait_deadline(&join.attach_cond,
+					     deadline) != 0)
+			diag_raise();
+	}
+
+	/*
+	 * Each connection is served by its own relay and has its
+	 * own compression context, because the connections are
+	 * fed concurrently.
+	 */
+	struct relay *stream_relays[REPLICATION_JOIN_STREAMS_MAX];
+	struct xrow_compressor *compressors[REPLICATION_JOIN_STREAMS_MAX];
+	struct xrow_stream_stat stats[REPLICATION_JOIN_STREAMS_MAX];
+	int relay_count = 0;
+	auto stream_relays_guard = make_scoped_guard([&] {
+		for (int i = 0; i < relay_count; i++) {
+			if (compressor != NULL) {
+				struct xrow_stream_stat *stat =
+					xrow_compressor_stat(compressor);
+				stat->bytes += stats[i].bytes;
+				stat->compressed_bytes +=
+					stats[i].compressed_bytes;
+				stat->cpu_time += stats[i].cpu_time;
+				xrow_compressor_delete(compressors[i]);
+			}
+			relay_stop(stream_relays[i]);
+			relay_delete(stream_relays[i]);
+		}
+	});
+	for (int i = 0; i < join.stream_count; i++) {
+		struct relay_join_stream *stream = join.streams[i];
+		struct relay *r = relay_new(NULL);
+		if (r == NULL)
+			diag_raise();
+		memset(&stats[relay_count], 0, sizeof(stats[relay_count]));
+		if (compressor != NULL) {
+			compressors[relay_count] =
+				xrow_compressor_new(&stats[relay_count]);
+			if (compressors[relay_count] == NULL) {
+				relay_delete(r);
+				diag_raise();
+			}
+		}
+		relay_start(r, stream->fd, stream->sync,
+			    relay_send_initial_join_row);
+		if (compressor != NULL)
+			r->compressor = compressors[relay_count];
+		stream_relays[relay_count++] = r;
+		streams[relay_count] = &r->stream;
+	}
+
+	engine_join_xc(&ctx, false, streams, stream_count);
+	/*
+	 * Let the replica know that a connection is over, it
+	 * doesn't know which spaces are sent over it.
+	 */
+	for (int i = 0; i < relay_count; i++) {
+		xrow_encode_vclock_xc(&row, vclock);
+		relay_send(stream_relays[i], &row);
+	}
 }
 
 int
@@ -342,13 +565,14 @@ relay_final_join_f(va_list ap)
 
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock)
+		 struct vclock *stop_vclock, struct xrow_compressor *compressor)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
 	relay_start(relay, fd, sync, relay_send_row);
+	relay->compressor = compressor;
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		relay_delete(relay);
@@ -475,6 +699,57 @@ relay_set_error(struct relay *relay, struct error *e)
 		diag_add_error(&relay->diag, e);
 }
 
+/**
+ * Send rows following the relay vclock from the WAL memory
+ * buffer. Return false if some of them have been discarded
+ * from the buffer and so must be read from xlog files.
+ */
+static bool
+relay_send_buffered_rows(struct relay *relay)
+{
+	struct recovery *r = relay->r;
+	struct ibuf *buf = &relay->wal_buf_rows;
+	while (true) {
+		ibuf_reset(buf);
+		ssize_t len = xrow_ring_read(relay->wal_buf,
+					     &relay->wal_buf_pos, buf);
+		if (len <= 0)
+			return len == 0;
+		const char *data = buf->rpos;
+		const char *end = data + len;
+		while (data < end) {
+			struct xrow_header row;
+			if (xrow_ring_decode(&data, end, &row) != 0)
+				diag_raise();
+			/* Skip rows which have been read from xlogs. */
+			if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+				continue;
+			vclock_follow_xrow(&r->vclock, &row);
+			xstream_write_xc(&relay->stream, &row);
+		}
+	}
+}
+
+/**
+ * Switch to sending rows from the WAL memory buffer if all rows
+ * following the relay vclock are still there. Called when the
+ * relay has read up all xlog files.
+ */
+static void
+relay_try_use_wal_buf(struct relay *relay)
+{
+	if (relay->wal_buf == NULL ||
+	    !xrow_ring_seek(relay->wal_buf, &relay->r->vclock,
+			    &relay->wal_buf_pos))
+		return;
+	recovery_release_log(relay->r);
+	say_info("the replica caught up, reading rows from the WAL buffer");
+	relay->wal_buf_is_used = true;
+	/* Send rows written after the last xlog was read. */
+	if (!relay_send_buffered_rows(relay))
+		relay->wal_buf_is_used = false;
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -492,8 +767,28 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
+		if (relay->wal_buf_is_used) {
+			if (relay_send_buffered_rows(relay)) {
+				/*
+				 * Let the garbage collector know that
+				 * the replica is done with the xlog
+				 * closed by the WAL writer.
+				 */
+				if ((events & WAL_EVENT_ROTATE) != 0) {
+					trigger_run_xc(&relay->r->on_close_log,
+						       NULL);
+				}
+				return;
+			}
+			say_info("the replica fell behind the WAL buffer, "
+				 "reading rows from xlogs");
+			relay->wal_buf_is_used = false;
+			/* The directory index is stale by now. */
+			events |= WAL_EVENT_ROTATE;
+		}
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
 				       (events & WAL_EVENT_ROTATE) != 0);
+		relay_try_use_wal_buf(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -579,6 +874,10 @@ relay_subscribe_f(va_list ap)
 	if (!relay->replica->anon)
 		trigger_add(&r->on_close_log, &on_close_log);
 
+	relay->wal_buf = wal_relay_buffer();
+	relay->wal_buf_is_used = false;
+	ibuf_create(&relay->wal_buf_rows, &cord()->slabc, 16 * 1024);
+
 	/* Setup WAL watcher for sending new rows to the replica. */
 	wal_set_watcher(&relay->wal_watcher, relay->endpoint.name,
 			relay_process_wal_event, cbus_process);
@@ -659,6 +958,7 @@ relay_subscribe_f(va_list ap)
 	if (!relay->replica->anon)
 		trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	ibuf_destroy(&relay->wal_buf_rows);
 
 	/* Join ack reader fiber. */
 	fiber_cancel(reader);
@@ -676,7 +976,8 @@ relay_subscribe_f(va_list ap)
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		uint32_t compression)
 {
 	assert(replica->anon || replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -693,9 +994,23 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 			diag_raise();
 	}
 
+	struct xrow_compressor *compressor = NULL;
+	memset(&relay->compression_stat, 0, sizeof(relay->compression_stat));
+	if (compression == IPROTO_COMPRESSION_ZSTD) {
+		compressor = xrow_compressor_new(&relay->compression_stat);
+		if (compressor == NULL)
+			diag_raise();
+	}
+
 	relay_start(relay, fd, sync, relay_send_row);
-	auto relay_guard = make_scoped_guard([=] {
+	relay->compressor = compressor;
+	auto relay_guard = make_scoped_guard([&] {
 		relay_stop(relay);
+		if (relay->compressor != NULL) {
+			relay->compressor = NULL;
+			xrow_compressor_delete(compressor);
+		}
+		/* May delete the relay. */
 		replica_on_relay_stop(replica);
 	});
 
@@ -720,7 +1035,7 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 
 	packet->sync = relay->sync;
 	relay->last_row_time = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	coio_write_xrow_compressed(&relay->io, relay->compressor, packet);
 	fiber_gc();
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
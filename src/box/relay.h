@@ -41,6 +41,8 @@ struct relay;
 struct replica;
 struct tt_uuid;
 struct vclock;
+struct xrow_compressor;
+struct xrow_stream_stat;
 
 enum relay_state {
 	/**
@@ -93,6 +95,13 @@ relay_vclock(const struct relay *relay);
 double
 relay_last_row_time(const struct relay *relay);
 
+/**
+ * Return compression statistics of the stream sent by the
+ * relay or NULL if the stream isn't compressed.
+ */
+const struct xrow_stream_stat *
+relay_compression_stat(const struct relay *relay);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -103,27 +112,55 @@ relay_last_row_time(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock[out] vclock of the read view sent to the replica
+ * @param compressor compressor of the rows following the
+ *                   response or NULL
+ * @param instance_uuid UUID of the replica, used to attach
+ *                   additional connections, or NULL
+ * @param stream_count number of connections to send the rows
+ *                   over, including the client connection.
+ *                   Additional connections are waited for
+ *                   after rows of system spaces are sent.
+ */
+void
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   struct xrow_compressor *compressor,
+		   const struct tt_uuid *instance_uuid, uint32_t stream_count);
+
+/**
+ * Attach a connection to the initial JOIN of the replica and
+ * wait until the part of rows sent over it is sent.
+ *
+ * @param fd        client connection
+ * @param sync      sync from incoming JOIN_STREAM request
+ * @param instance_uuid UUID of the replica
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_join_stream(int fd, uint64_t sync, const struct tt_uuid *instance_uuid);
 
 /**
  * Send final JOIN rows to the replica.
  *
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
+ * @param compressor compressor of the rows or NULL
  */
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock);
+		 struct vclock *stop_vclock,
+		 struct xrow_compressor *compressor);
 
 /**
  * Subscribe a replica to updates.
  *
+ * @param compression compression of the stream negotiated
+ *                    in the response to SUBSCRIBE,
+ *                    see enum iproto_compression
+ *
  * @return none.
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		uint32_t compression);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -53,6 +53,8 @@ int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
+bool replication_compression = false;
+int replication_join_streams = 1;
 bool replication_anon = false;
 
 struct replicaset replicaset;
@@ -98,6 +98,9 @@ struct gc_consumer;
 
 static const int REPLICATION_CONNECT_QUORUM_ALL = INT_MAX;
 
+/** Max number of connections a JOIN is sent over. */
+enum { REPLICATION_JOIN_STREAMS_MAX = 16 };
+
 /**
  * Network timeout. Determines how often master and slave exchange
  * heartbeat messages. Set by box.cfg.replication_timeout.
@@ -137,6 +140,18 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Whether this replica asks masters to compress the stream of
+ * rows they send. Takes effect on the next JOIN or SUBSCRIBE.
+ */
+extern bool replication_compression;
+
+/**
+ * Number of connections this replica asks a master to send
+ * the initial JOIN data over. Takes effect on the next JOIN.
+ */
+extern int replication_join_streams;
+
 /**
  * Whether this replica will be anonymous or not, e.g. be preset
  * in _cluster table and have a non-zero id.
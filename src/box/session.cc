@@ -142,6 +142,7 @@ session_create(enum session_type type)
 	session_set_type(session, type);
 	session->sql_flags = default_flags;
 	session->sql_default_engine = SQL_STORAGE_ENGINE_MEMTX;
+	session->sql_sort_memory = SQL_SORT_MEMORY_DEFAULT;
 	session->sql_stmts = NULL;
 
 	/* For on_connect triggers. */
@@ -68,6 +68,14 @@ extern const char *session_type_strs[];
  */
 extern uint32_t default_flags;
 
+enum {
+	/**
+	 * Default memory budget of an SQL sorter. Sorted data
+	 * that doesn't fit is spilled to temporary files.
+	 */
+	SQL_SORT_MEMORY_DEFAULT = 16 * 1024 * 1024,
+};
+
 /**
  * Session meta is used in different ways by sessions of different
  * types, and allows to do not store attributes in struct session,
@@ -96,6 +104,8 @@ struct session {
 	uint8_t sql_default_engine;
 	/** SQL Connection flag for current user session */
 	uint32_t sql_flags;
+	/** Memory budget of a single SQL sorter, in bytes. */
+	uint64_t sql_sort_memory;
 	enum session_type type;
 	/** Session virtual methods. */
 	const struct session_vtab *vtab;
@@ -297,6 +297,7 @@ static const struct index_vtab session_settings_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ session_settings_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ session_settings_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -466,6 +467,7 @@ const struct space_vtab session_settings_space_vtab = {
 	/* .drop_primary_key = */ generic_space_drop_primary_key,
 	/* .check_format = */ generic_space_check_format,
 	/* .build_index = */ generic_space_build_index,
+	/* .bulk_load = */ generic_space_bulk_load,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
@@ -534,6 +534,8 @@ int
 space_execute_dml(struct space *space, struct txn *txn,
 		  struct request *request, struct tuple **result)
 {
+	if (space_check_bulk_load(space) != 0)
+		return -1;
 	if (unlikely(space->sequence != NULL) &&
 	    (request->type == IPROTO_INSERT ||
 	     request->type == IPROTO_REPLACE)) {
@@ -758,6 +760,16 @@ generic_space_build_index(struct space *src_space, struct index *new_index,
 	return 0;
 }
 
+int
+generic_space_bulk_load(struct space *space, const char *data,
+			const char *data_end)
+{
+	(void)data;
+	(void)data_end;
+	diag_set(ClientError, ER_UNSUPPORTED, space->engine->name, "bulk load");
+	return -1;
+}
+
 int
 generic_space_prepare_alter(struct space *old_space, struct space *new_space)
 {
@@ -129,6 +129,20 @@ struct space_vtab {
 	int (*build_index)(struct space *src_space, struct index *new_index,
 			   struct tuple_format *new_format,
 			   bool check_unique_constraint);
+	/**
+	 * Fill an empty space with tuples in bulk, bypassing
+	 * transactions and WAL. The space must not be changed
+	 * until the function returns.
+	 *
+	 * @param space     space to fill
+	 * @param data      MsgPack array of tuples
+	 * @param data_end  end of @a data
+	 *
+	 * @retval  0           success, all tuples were loaded
+	 * @retval -1           load failed, the space is empty
+	 */
+	int (*bulk_load)(struct space *space, const char *data,
+			 const char *data_end);
 	/**
 	 * Exchange two index objects in two spaces. Used
 	 * to update a space with a newly built index, while
@@ -189,6 +203,12 @@ struct space {
 	char *sequence_path;
 	/** Enable/disable triggers. */
 	bool run_triggers;
+	/**
+	 * Set while the space is filled by box_bulk_load() and
+	 * until the loaded tuples are persisted. Such a space
+	 * can be neither read nor changed, DDL isn't allowed.
+	 */
+	bool is_bulk_loading;
 	/**
 	 * Space format or NULL if space does not have format
 	 * (sysview engine, for example).
@@ -265,6 +285,27 @@ space_is_temporary(struct space *space)
 	return space->def->opts.is_temporary;
 }
 
+/**
+ * Return true if a DML request to the space may run Lua or SQL
+ * code: triggers, constraints or functional indexes.
+ */
+static inline bool
+space_runs_user_code(struct space *space)
+{
+	if (!rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace) ||
+	    space->sql_triggers != NULL ||
+	    !rlist_empty(&space->ck_constraint) ||
+	    !rlist_empty(&space->parent_fk_constraint) ||
+	    !rlist_empty(&space->child_fk_constraint))
+		return true;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.func_id > 0)
+			return true;
+	}
+	return false;
+}
+
 /** Return replication group id of a space. */
 static inline uint32_t
 space_group_id(struct space *space)
@@ -320,6 +361,21 @@ index_find(struct space *space, uint32_t index_id)
 	return index;
 }
 
+/**
+ * Check that the space isn't being filled by box_bulk_load():
+ * its indexes are incomplete until the load is over.
+ */
+static inline int
+space_check_bulk_load(struct space *space)
+{
+	if (unlikely(space->is_bulk_loading)) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Bulk load",
+			 "access to the space being loaded");
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * Wrapper around index_find() which checks that
  * the found index is unique.
@@ -438,6 +494,12 @@ space_build_index(struct space *src_space, struct space *new_space,
 					    new_space->format, check);
 }
 
+static inline int
+space_bulk_load(struct space *space, const char *data, const char *data_end)
+{
+	return space->vtab->bulk_load(space, data, data_end);
+}
+
 static inline void
 space_swap_index(struct space *old_space, struct space *new_space,
 		 uint32_t old_index_id, uint32_t new_index_id)
@@ -555,6 +617,7 @@ void generic_space_drop_primary_key(struct space *space);
 int generic_space_check_format(struct space *, struct tuple_format *);
 int generic_space_build_index(struct space *, struct index *,
 			      struct tuple_format *, bool);
+int generic_space_bulk_load(struct space *, const char *, const char *);
 int generic_space_prepare_alter(struct space *, struct space *);
 void generic_space_invalidate(struct space *);
 
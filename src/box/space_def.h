@@ -61,6 +61,11 @@ struct space_opts {
 	 * its format might be re-used.
 	 */
 	bool is_ephemeral;
+	/**
+	 * Store tuples of the space in the compact format,
+	 * see tuple_format::is_compact.
+	 */
+	bool compact_tuples;
 	/**
 	 * If the space is a view, then it can't feature any
 	 * indexes, and must have SQL statement. Moreover,
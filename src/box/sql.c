@@ -317,6 +317,8 @@ int64_t
 tarantoolsqlCount(struct BtCursor *pCur)
 {
 	assert(pCur->curFlags & BTCF_TaCursor);
+	if (space_check_bulk_load(pCur->space) != 0)
+		return -1;
 	return index_count(pCur->index, pCur->iter_type, NULL, 0);
 }
 
@@ -833,6 +835,28 @@ key_alloc(BtCursor *cur, size_t key_size)
 	return 0;
 }
 
+struct iterator *
+tarantoolsqlIteratorCreate(struct BtCursor *cursor, enum iterator_type type,
+			   const char *key, uint32_t part_count)
+{
+	struct space *space = cursor->space;
+	if (space_check_bulk_load(space) != 0)
+		return NULL;
+	struct txn *txn = NULL;
+	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn) != 0)
+		return NULL;
+	struct iterator *it = index_create_iterator(cursor->index, type, key,
+						    part_count);
+	if (it == NULL) {
+		if (txn != NULL)
+			txn_rollback_stmt(txn);
+		return NULL;
+	}
+	if (txn != NULL)
+		txn_commit_ro_stmt(txn);
+	return it;
+}
+
 /*
  * Create new Tarantool iterator and set it to the first entry found by
  * given key. If cursor already contains iterator, it will be freed.
@@ -860,21 +884,12 @@ cursor_seek(BtCursor *pCur, int *pRes)
 		return -1;
 	}
 
-	struct space *space = pCur->space;
-	struct txn *txn = NULL;
-	if (space->def->id != 0 && txn_begin_ro_stmt(space, &txn) != 0)
-		return -1;
-	struct iterator *it =
-		index_create_iterator(pCur->index, pCur->iter_type, key,
-				      part_count);
+	struct iterator *it = tarantoolsqlIteratorCreate(pCur, pCur->iter_type,
+							key, part_count);
 	if (it == NULL) {
-		if (txn != NULL)
-			txn_rollback_stmt(txn);
 		pCur->eState = CURSOR_INVALID;
 		return -1;
 	}
-	if (txn != NULL)
-		txn_commit_ro_stmt(txn);
 	pCur->iter = it;
 	pCur->eState = CURSOR_VALID;
 
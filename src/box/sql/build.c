@@ -3320,7 +3320,8 @@ sql_fieldno_by_name(struct Parse *parse_context, struct Expr *field_name,
  * space iterator will not be sorted properly.
  */
 enum {
-	SQL_SESSION_SETTING_DEFAULT_ENGINE = 0,
+	SQL_SESSION_SETTING_AUTO_PARAMETERIZE = 0,
+	SQL_SESSION_SETTING_DEFAULT_ENGINE,
 	SQL_SESSION_SETTING_DEFER_FOREIGN_KEYS,
 	SQL_SESSION_SETTING_FULL_COLUMN_NAMES,
 	SQL_SESSION_SETTING_FULL_METADATA,
@@ -3328,11 +3329,13 @@ enum {
 	SQL_SESSION_SETTING_RECURSIVE_TRIGGERS,
 	SQL_SESSION_SETTING_REVERSE_UNORDERED_SELECTS,
 	SQL_SESSION_SETTING_SELECT_DEBUG,
+	SQL_SESSION_SETTING_SORT_MEMORY,
 	SQL_SESSION_SETTING_VDBE_DEBUG,
 	sql_session_setting_MAX,
 };
 
 static const char *sql_session_setting_strs[sql_session_setting_MAX] = {
+	"sql_auto_parameterize",
 	"sql_default_engine",
 	"sql_defer_foreign_keys",
 	"sql_full_column_names",
@@ -3341,6 +3344,7 @@ static const char *sql_session_setting_strs[sql_session_setting_MAX] = {
 	"sql_recursive_triggers",
 	"sql_reverse_unordered_selects",
 	"sql_select_debug",
+	"sql_sort_memory",
 	"sql_vdbe_debug",
 };
 
@@ -3361,6 +3365,8 @@ struct sql_option_metadata
  * It is IMPORTANT that these options sorted by name.
  */
 static struct sql_option_metadata sql_session_opts[] = {
+	/** SQL_SESSION_SETTING_AUTO_PARAMETERIZE */
+	{FIELD_TYPE_BOOLEAN, SQL_AutoParam},
 	/** SQL_SESSION_SETTING_DEFAULT_ENGINE */
 	{FIELD_TYPE_STRING, 0},
 	/** SQL_SESSION_SETTING_DEFER_FOREIGN_KEYS */
@@ -3378,6 +3384,8 @@ static struct sql_option_metadata sql_session_opts[] = {
 	/** SQL_SESSION_SETTING_SELECT_DEBUG */
 	{FIELD_TYPE_BOOLEAN,
 	 SQL_SqlTrace | SQL_SelectTrace | SQL_WhereTrace},
+	/** SQL_SESSION_SETTING_SORT_MEMORY */
+	{FIELD_TYPE_UNSIGNED, 0},
 	/** SQL_SESSION_SETTING_VDBE_DEBUG */
 	{FIELD_TYPE_BOOLEAN,
 	 SQL_SqlTrace | SQL_VdbeListing | SQL_VdbeTrace},
@@ -3397,27 +3405,40 @@ sql_session_setting_get(int id, const char **mp_pair, const char **mp_pair_end)
 	const char *engine;
 	size_t size = mp_sizeof_array(2) + mp_sizeof_str(name_len);
 	/*
-	 * Currently, SQL session settings are of a boolean or
-	 * string type.
+	 * Currently, SQL session settings are of a boolean,
+	 * unsigned or string type.
 	 */
-	bool is_bool = opt->field_type == FIELD_TYPE_BOOLEAN;
-	if (is_bool) {
+	switch (opt->field_type) {
+	case FIELD_TYPE_BOOLEAN:
 		size += mp_sizeof_bool(true);
-	} else {
+		break;
+	case FIELD_TYPE_UNSIGNED:
+		assert(id == SQL_SESSION_SETTING_SORT_MEMORY);
+		size += mp_sizeof_uint(session->sql_sort_memory);
+		break;
+	default:
 		assert(id == SQL_SESSION_SETTING_DEFAULT_ENGINE);
 		engine = sql_storage_engine_strs[session->sql_default_engine];
 		engine_len = strlen(engine);
 		size += mp_sizeof_str(engine_len);
+		break;
 	}
 
 	char *pos = static_alloc(size);
 	assert(pos != NULL);
 	char *pos_end = mp_encode_array(pos, 2);
 	pos_end = mp_encode_str(pos_end, name, name_len);
-	if (is_bool)
+	switch (opt->field_type) {
+	case FIELD_TYPE_BOOLEAN:
 		pos_end = mp_encode_bool(pos_end, (flags & mask) == mask);
-	else
+		break;
+	case FIELD_TYPE_UNSIGNED:
+		pos_end = mp_encode_uint(pos_end, session->sql_sort_memory);
+		break;
+	default:
 		pos_end = mp_encode_str(pos_end, engine, engine_len);
+		break;
+	}
 	*mp_pair = pos;
 	*mp_pair_end = pos_end;
 }
@@ -3465,6 +3486,16 @@ sql_set_string_option(int id, const char *value)
 	return 0;
 }
 
+static int
+sql_set_unsigned_option(int id, uint64_t value)
+{
+	assert(sql_session_opts[id].field_type == FIELD_TYPE_UNSIGNED);
+	assert(id == SQL_SESSION_SETTING_SORT_MEMORY);
+	(void)id;
+	current_session()->sql_sort_memory = value;
+	return 0;
+}
+
 static int
 sql_session_setting_set(int id, const char *mp_value)
 {
@@ -3478,6 +3509,10 @@ sql_session_setting_set(int id, const char *mp_value)
 		if (mtype != MP_BOOL)
 			break;
 		return sql_set_boolean_option(id, mp_decode_bool(&mp_value));
+	case FIELD_TYPE_UNSIGNED:
+		if (mtype != MP_UINT)
+			break;
+		return sql_set_unsigned_option(id, mp_decode_uint(&mp_value));
 	case FIELD_TYPE_STRING:
 		if (mtype != MP_STR)
 			break;
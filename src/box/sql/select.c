@@ -4463,6 +4463,236 @@ is_simple_count(struct Select *select, struct AggInfo *agg_info)
 	return space;
 }
 
+/**
+ * Return true if a field is the first part of a key of an index
+ * of a space. A lookup or an ordered scan of the index may be
+ * cheaper than a full scan then.
+ */
+static bool
+space_field_is_indexed(struct space *space, uint32_t fieldno)
+{
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (space->index[i]->def->key_def->parts[0].fieldno == fieldno)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Add a field to the fields decoded by OP_AggScan.
+ * @retval Index of the field in @a scan->fieldno.
+ */
+static uint32_t
+agg_scan_add_field(struct sql_agg_scan *scan, uint32_t fieldno,
+		   bool is_numeric)
+{
+	uint32_t i;
+	for (i = 0; i < scan->field_count; i++) {
+		if (scan->fieldno[i] == fieldno)
+			break;
+	}
+	if (i == scan->field_count) {
+		scan->fieldno[scan->field_count] = fieldno;
+		scan->is_numeric[scan->field_count++] = false;
+	}
+	scan->is_numeric[i] |= is_numeric;
+	return i;
+}
+
+/**
+ * Add filters of a WHERE clause to the program of OP_AggScan.
+ * Only a conjunction of comparisons of a numeric field with a
+ * constant is accepted.
+ *
+ * @param scan Program of the scan.
+ * @param space Scanned space.
+ * @param cursor Cursor of the space in the query.
+ * @param expr WHERE clause or a part of it.
+ * @param[out] consts Constants the fields are compared with.
+ * @retval 0 Success.
+ * @retval -1 The clause can't be processed by OP_AggScan.
+ */
+static int
+agg_scan_add_filters(struct sql_agg_scan *scan, struct space *space,
+		     int cursor, struct Expr *expr, struct Expr **consts)
+{
+	if (expr->op == TK_AND) {
+		if (agg_scan_add_filters(scan, space, cursor, expr->pLeft,
+					 consts) != 0)
+			return -1;
+		return agg_scan_add_filters(scan, space, cursor,
+					    expr->pRight, consts);
+	}
+	int op = expr->op;
+	struct Expr *column = expr->pLeft;
+	struct Expr *value = expr->pRight;
+	switch (op) {
+	case TK_EQ:
+	case TK_NE:
+	case TK_LT:
+	case TK_LE:
+	case TK_GT:
+	case TK_GE:
+		break;
+	default:
+		return -1;
+	}
+	if (column->op != TK_COLUMN) {
+		column = expr->pRight;
+		value = expr->pLeft;
+		/* Mirror the operator: 1 < a is a > 1. */
+		if (op == TK_LT)
+			op = TK_GT;
+		else if (op == TK_LE)
+			op = TK_GE;
+		else if (op == TK_GT)
+			op = TK_LT;
+		else if (op == TK_GE)
+			op = TK_LE;
+	}
+	if (column->op != TK_COLUMN || column->iTable != cursor ||
+	    column->iColumn < 0 || !sqlExprIsConstant(value) ||
+	    scan->filter_count == SQL_AGG_SCAN_ITEM_MAX)
+		return -1;
+	uint32_t fieldno = column->iColumn;
+	if (!sql_type_is_numeric(space->def->fields[fieldno].type) ||
+	    space_field_is_indexed(space, fieldno))
+		return -1;
+	consts[scan->filter_count] = value;
+	scan->filter[scan->filter_count].op = op;
+	scan->filter[scan->filter_count].field =
+		agg_scan_add_field(scan, fieldno, true);
+	scan->filter_count++;
+	return 0;
+}
+
+/**
+ * Test if an aggregate query without GROUP BY can be computed by
+ * OP_AggScan, i.e. it is of the form:
+ *
+ *   SELECT <aggregates> FROM <tbl> [WHERE <field> <op> <const>
+ *                                   [AND ...]]
+ *
+ * where aggregates are COUNT(), SUM(), TOTAL(), AVG(), MIN() and
+ * MAX() of fields and the table is not a sub-select or view.
+ * Queries which may use an index are left to the planner.
+ *
+ * @param parse Parsing context.
+ * @param select The select statement in form of aggregate query.
+ * @param agg_info The associated aggregate-info object.
+ * @param[out] consts Constants the fields are compared with.
+ * @retval Program of OP_AggScan or NULL.
+ */
+static struct sql_agg_scan *
+agg_scan_new(struct Parse *parse, struct Select *select,
+	     struct AggInfo *agg_info, struct Expr **consts)
+{
+	assert(select->pGroupBy == NULL);
+	struct SrcList *src = select->pSrc;
+	if (src->nSrc != 1 || src->a[0].pSelect != NULL ||
+	    src->a[0].fg.isIndexedBy || agg_info->nAccumulator != 0 ||
+	    agg_info->nFunc == 0 || agg_info->nFunc > SQL_AGG_SCAN_ITEM_MAX)
+		return NULL;
+	struct space *space = src->a[0].space;
+	assert(space != NULL && !space->def->opts.is_view);
+	if (space->index_count == 0)
+		return NULL;
+	int cursor = src->a[0].iCursor;
+	struct sql_agg_scan scan;
+	memset(&scan, 0, sizeof(scan));
+	for (int i = 0; i < agg_info->nFunc; i++) {
+		struct AggInfo_func *func = &agg_info->aFunc[i];
+		struct Expr *expr = func->pExpr;
+		struct ExprList *args = expr->x.pList;
+		if (func->func->def->language != FUNC_LANGUAGE_SQL_BUILTIN ||
+		    (expr->flags & EP_Distinct) != 0)
+			return NULL;
+		const char *name = func->func->def->name;
+		enum sql_agg_scan_func type;
+		if (strcmp(name, "COUNT") == 0)
+			type = SQL_AGG_SCAN_COUNT;
+		else if (strcmp(name, "SUM") == 0)
+			type = SQL_AGG_SCAN_SUM;
+		else if (strcmp(name, "TOTAL") == 0)
+			type = SQL_AGG_SCAN_TOTAL;
+		else if (strcmp(name, "AVG") == 0)
+			type = SQL_AGG_SCAN_AVG;
+		else if (strcmp(name, "MIN") == 0)
+			type = SQL_AGG_SCAN_MIN;
+		else if (strcmp(name, "MAX") == 0)
+			type = SQL_AGG_SCAN_MAX;
+		else
+			return NULL;
+		scan.func[i].type = type;
+		scan.func[i].reg = func->iMem;
+		if (args == NULL || args->nExpr == 0) {
+			if (type != SQL_AGG_SCAN_COUNT)
+				return NULL;
+			scan.func[i].type = SQL_AGG_SCAN_COUNT_ALL;
+			continue;
+		}
+		struct Expr *arg = args->a[0].pExpr;
+		if (args->nExpr != 1 ||
+		    (arg->op != TK_COLUMN && arg->op != TK_AGG_COLUMN) ||
+		    arg->iTable != cursor || arg->iColumn < 0)
+			return NULL;
+		uint32_t fieldno = arg->iColumn;
+		bool is_numeric = type != SQL_AGG_SCAN_COUNT;
+		if (is_numeric &&
+		    !sql_type_is_numeric(space->def->fields[fieldno].type))
+			return NULL;
+		if ((type == SQL_AGG_SCAN_MIN || type == SQL_AGG_SCAN_MAX) &&
+		    space_field_is_indexed(space, fieldno))
+			return NULL;
+		scan.func[i].field = agg_scan_add_field(&scan, fieldno,
+							is_numeric);
+	}
+	scan.func_count = agg_info->nFunc;
+	if (select->pWhere != NULL &&
+	    agg_scan_add_filters(&scan, space, cursor, select->pWhere,
+				 consts) != 0)
+		return NULL;
+	/* OP_Count is used for a bare COUNT(*). */
+	if (scan.field_count == 0)
+		return NULL;
+	struct sql_agg_scan *res = sqlDbMallocRawNN(parse->db, sizeof(scan));
+	if (res == NULL)
+		return NULL;
+	*res = scan;
+	return res;
+}
+
+/**
+ * Generate code computing aggregates of a query without GROUP BY
+ * by OP_AggScan (see agg_scan_new()). It jumps to @a done_label
+ * on success and falls through to the ordinary loop otherwise.
+ *
+ * @retval Cursor of the scanned space to be closed at
+ *         @a done_label, or -1 if the query can't be computed
+ *         this way.
+ */
+static int
+agg_scan_code(struct Parse *parse, struct Select *select,
+	      struct AggInfo *agg_info, int done_label)
+{
+	struct Expr *consts[SQL_AGG_SCAN_ITEM_MAX];
+	struct sql_agg_scan *scan = agg_scan_new(parse, select, agg_info,
+						 consts);
+	if (scan == NULL)
+		return -1;
+	struct Vdbe *v = parse->pVdbe;
+	int reg_consts = parse->nMem + 1;
+	parse->nMem += scan->filter_count;
+	for (uint32_t i = 0; i < scan->filter_count; i++)
+		sqlExprCode(parse, consts[i], reg_consts + i);
+	int cursor = parse->nTab++;
+	vdbe_emit_open_cursor(parse, cursor, 0, select->pSrc->a[0].space);
+	sqlVdbeAddOp4(v, OP_AggScan, cursor, done_label, reg_consts,
+		      (char *)scan, P4_AGGSCAN);
+	sqlVdbeAddOp1(v, OP_Close, cursor);
+	return cursor;
+}
+
 /*
  * If the source-list item passed as an argument was augmented with an
  * INDEXED BY clause, then try to locate the specified index. If there
@@ -6338,6 +6568,14 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				explain_simple_count(pParse, space->def->name);
 			} else
 			{
+				/*
+				 * Try to compute the aggregates over
+				 * vectors of decoded fields first.
+				 */
+				int scan_done = sqlVdbeMakeLabel(v);
+				int scan_cursor = agg_scan_code(pParse, p,
+								&sAggInfo,
+								scan_done);
 				/* Check if the query is of one of the following forms:
 				 *
 				 *   SELECT min(x) FROM ...
@@ -6417,6 +6655,14 @@ sqlSelect(Parse * pParse,		/* The parser context */
 				sqlWhereEnd(pWInfo);
 				finalizeAggFunctions(pParse, &sAggInfo);
 				sql_expr_list_delete(db, pDel);
+				if (scan_cursor >= 0) {
+					int scan_end = sqlVdbeMakeLabel(v);
+					sqlVdbeGoto(v, scan_end);
+					sqlVdbeResolveLabel(v, scan_done);
+					sqlVdbeAddOp1(v, OP_Close,
+						      scan_cursor);
+					sqlVdbeResolveLabel(v, scan_end);
+				}
 			}
 
 			sSort.pOrderBy = 0;
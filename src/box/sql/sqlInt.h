@@ -589,6 +589,10 @@ sql_column_span(sql_stmt *stmt, int n);
 uint32_t
 sql_stmt_schema_version(const struct sql_stmt *stmt);
 
+/** Session SQL flags the statement was compiled with. */
+uint32_t
+sql_stmt_sql_flags(const struct sql_stmt *stmt);
+
 int
 sql_initialize(void);
 
@@ -1204,6 +1208,9 @@ struct sql {
 					 * (nullability, autoincrement, alias)
 					 * in metadata.
 					 */
+#define SQL_AutoParam      0x10000000	/* Replace literals of unprepared
+					 * queries with parameters.
+					 */
 
 /* Bits of the sql.dbOptFlags field. */
 #define SQL_QueryFlattener 0x0001	/* Query flattening */
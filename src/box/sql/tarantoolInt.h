@@ -21,6 +21,22 @@ int tarantoolsqlMovetoUnpacked(BtCursor * pCur, UnpackedRecord * pIdxKey,
 				   int *pRes);
 int64_t
 tarantoolsqlCount(struct BtCursor *pCur);
+
+/**
+ * Create an iterator over the index of a cursor the same way
+ * the cursor does: the space must not be bulk loaded and the
+ * read is bound to the current transaction, if any.
+ *
+ * @param cursor Cursor which points to space.
+ * @param type Type of the iterator.
+ * @param key Key without the array header.
+ * @param part_count Number of key parts.
+ *
+ * @retval Iterator on success, NULL otherwise.
+ */
+struct iterator *
+tarantoolsqlIteratorCreate(struct BtCursor *cursor, enum iterator_type type,
+			   const char *key, uint32_t part_count);
 int tarantoolsqlInsert(struct space *space, const char *tuple,
 			   const char *tuple_end);
 int tarantoolsqlReplace(struct space *space, const char *tuple,
@@ -797,6 +797,365 @@ vdbe_field_ref_fetch(struct vdbe_field_ref *field_ref, uint32_t fieldno,
 	return 0;
 }
 
+enum {
+	/** Number of tuples decoded at once by OP_AggScan. */
+	AGG_SCAN_BATCH_SIZE = 256,
+};
+
+/** Field value decoded by OP_AggScan. */
+struct agg_scan_value {
+	/**
+	 * MP_NIL, MP_INT, MP_UINT, MP_DOUBLE or MP_STR which
+	 * stands for any other non-NULL value.
+	 */
+	enum mp_type type;
+	union {
+		int64_t i;
+		uint64_t u;
+		double d;
+	};
+};
+
+/**
+ * State of an aggregate function computed by OP_AggScan. The
+ * same as the one of sum_step(), countStep() and minmaxStep().
+ */
+struct agg_scan_acc {
+	/** Number of non-NULL values. */
+	int64_t count;
+	/** Sum of values as a double. */
+	double sum_double;
+	/** Sum of values as an integer. */
+	int64_t sum_int;
+	/** True if @a sum_int is negative. */
+	bool is_neg;
+	/** True if a double value was summed. */
+	bool is_approx;
+	/** True if @a sum_int has overflowed. */
+	bool is_overflow;
+	/** The best value of MIN() or MAX(). */
+	struct agg_scan_value best;
+};
+
+/**
+ * Decode a field of a tuple.
+ * @retval 0 Success.
+ * @retval -1 A number is expected but the field is not.
+ */
+static inline int
+agg_scan_decode(const char *data, bool is_numeric,
+		struct agg_scan_value *value)
+{
+	if (data == NULL) {
+		value->type = MP_NIL;
+		return 0;
+	}
+	switch (mp_typeof(*data)) {
+	case MP_NIL:
+		value->type = MP_NIL;
+		return 0;
+	case MP_UINT:
+		value->type = MP_UINT;
+		value->u = mp_decode_uint(&data);
+		return 0;
+	case MP_INT:
+		value->i = mp_decode_int(&data);
+		value->type = value->i < 0 ? MP_INT : MP_UINT;
+		return 0;
+	case MP_DOUBLE:
+		value->type = MP_DOUBLE;
+		value->d = mp_decode_double(&data);
+		return 0;
+	case MP_FLOAT:
+		value->type = MP_DOUBLE;
+		value->d = mp_decode_float(&data);
+		return 0;
+	default:
+		value->type = MP_STR;
+		return is_numeric ? -1 : 0;
+	}
+}
+
+/** Compare two numbers the same way sqlMemCompare() does. */
+static inline int
+agg_scan_value_cmp(const struct agg_scan_value *a,
+		   const struct agg_scan_value *b)
+{
+	if (a->type == b->type) {
+		switch (a->type) {
+		case MP_INT:
+			return a->i < b->i ? -1 : a->i > b->i;
+		case MP_UINT:
+			return a->u < b->u ? -1 : a->u > b->u;
+		default:
+			assert(a->type == MP_DOUBLE);
+			return a->d < b->d ? -1 : a->d > b->d;
+		}
+	}
+	if (a->type == MP_INT) {
+		if (b->type == MP_DOUBLE)
+			return double_compare_uint64(-b->d, -(uint64_t)a->i, 1);
+		return -1;
+	}
+	if (a->type == MP_UINT) {
+		if (b->type == MP_DOUBLE)
+			return double_compare_uint64(b->d, a->u, -1);
+		return +1;
+	}
+	assert(a->type == MP_DOUBLE);
+	if (b->type == MP_INT)
+		return double_compare_uint64(-a->d, -(uint64_t)b->i, -1);
+	return double_compare_uint64(a->d, b->u, 1);
+}
+
+/** Return true if a comparison result satisfies operator @a op. */
+static inline bool
+agg_scan_cmp_is_true(int op, int cmp)
+{
+	switch (op) {
+	case TK_EQ:
+		return cmp == 0;
+	case TK_NE:
+		return cmp != 0;
+	case TK_LT:
+		return cmp < 0;
+	case TK_LE:
+		return cmp <= 0;
+	case TK_GT:
+		return cmp > 0;
+	default:
+		assert(op == TK_GE);
+		return cmp >= 0;
+	}
+}
+
+/**
+ * Account values of rows listed in @a sel in the state of an
+ * aggregate function.
+ */
+static void
+agg_scan_step(struct agg_scan_acc *acc, enum sql_agg_scan_func type,
+	      const struct agg_scan_value *values, const uint16_t *sel,
+	      uint32_t sel_count)
+{
+	switch (type) {
+	case SQL_AGG_SCAN_COUNT_ALL:
+		acc->count += sel_count;
+		return;
+	case SQL_AGG_SCAN_COUNT:
+		for (uint32_t i = 0; i < sel_count; i++)
+			acc->count += values[sel[i]].type != MP_NIL;
+		return;
+	case SQL_AGG_SCAN_SUM:
+	case SQL_AGG_SCAN_TOTAL:
+	case SQL_AGG_SCAN_AVG:
+		for (uint32_t i = 0; i < sel_count; i++) {
+			const struct agg_scan_value *v = &values[sel[i]];
+			if (v->type == MP_NIL)
+				continue;
+			acc->count++;
+			if (v->type == MP_DOUBLE) {
+				acc->sum_double += v->d;
+				acc->is_approx = true;
+				continue;
+			}
+			bool is_neg = v->type == MP_INT;
+			if (is_neg)
+				acc->sum_double += v->i;
+			else
+				acc->sum_double += v->u;
+			if (!acc->is_approx && !acc->is_overflow &&
+			    sql_add_int(acc->sum_int, acc->is_neg, v->i, is_neg,
+					&acc->sum_int, &acc->is_neg) != 0)
+				acc->is_overflow = true;
+		}
+		return;
+	case SQL_AGG_SCAN_MIN:
+	case SQL_AGG_SCAN_MAX: {
+		int sign = type == SQL_AGG_SCAN_MAX ? -1 : 1;
+		for (uint32_t i = 0; i < sel_count; i++) {
+			const struct agg_scan_value *v = &values[sel[i]];
+			if (v->type == MP_NIL)
+				continue;
+			if (acc->count++ == 0 ||
+			    sign * agg_scan_value_cmp(&acc->best, v) > 0)
+				acc->best = *v;
+		}
+		return;
+	}
+	default:
+		unreachable();
+	}
+}
+
+/**
+ * Store the result of an aggregate function.
+ * @retval 0 Success.
+ * @retval -1 The result can't be computed by OP_AggScan.
+ */
+static int
+agg_scan_finalize(const struct agg_scan_acc *acc,
+		  enum sql_agg_scan_func type, struct Mem *out)
+{
+	switch (type) {
+	case SQL_AGG_SCAN_COUNT_ALL:
+	case SQL_AGG_SCAN_COUNT:
+		mem_set_u64(out, acc->count);
+		return 0;
+	case SQL_AGG_SCAN_SUM:
+		if (acc->count == 0)
+			return 0;
+		/* Let sumFinalize() raise the error. */
+		if (acc->is_overflow)
+			return -1;
+		if (acc->is_approx)
+			sqlVdbeMemSetDouble(out, acc->sum_double);
+		else
+			mem_set_int(out, acc->sum_int, acc->is_neg);
+		return 0;
+	case SQL_AGG_SCAN_TOTAL:
+		sqlVdbeMemSetDouble(out, acc->sum_double);
+		return 0;
+	case SQL_AGG_SCAN_AVG:
+		if (acc->count > 0)
+			sqlVdbeMemSetDouble(out,
+					    acc->sum_double / acc->count);
+		return 0;
+	case SQL_AGG_SCAN_MIN:
+	case SQL_AGG_SCAN_MAX:
+		if (acc->count == 0)
+			return 0;
+		if (acc->best.type == MP_INT)
+			mem_set_int(out, acc->best.i, true);
+		else if (acc->best.type == MP_UINT)
+			mem_set_u64(out, acc->best.u);
+		else
+			sqlVdbeMemSetDouble(out, acc->best.d);
+		return 0;
+	default:
+		unreachable();
+	}
+	return 0;
+}
+
+/**
+ * Execute OP_AggScan program: decode fields of a batch of
+ * tuples into vectors, filter the batch with a selection vector
+ * and account the selected rows in aggregates.
+ *
+ * @param v VDBE to store results to.
+ * @param cursor Cursor of the scanned space.
+ * @param scan Program of the scan.
+ * @param consts Registers with values to compare fields with.
+ * @retval 0 Success.
+ * @retval 1 The scan met a value it can't process, aggregates
+ *         are to be computed by an ordinary loop.
+ * @retval -1 Error.
+ */
+static int
+vdbe_agg_scan(struct Vdbe *v, struct BtCursor *cursor,
+	      const struct sql_agg_scan *scan, struct Mem *consts)
+{
+	struct agg_scan_value filter_value[SQL_AGG_SCAN_ITEM_MAX];
+	for (uint32_t i = 0; i < scan->filter_count; i++) {
+		struct Mem *mem = &consts[i];
+		struct agg_scan_value *value = &filter_value[i];
+		if ((mem->flags & MEM_Int) != 0) {
+			value->type = MP_INT;
+			value->i = mem->u.i;
+		} else if ((mem->flags & MEM_UInt) != 0) {
+			value->type = MP_UINT;
+			value->u = mem->u.u;
+		} else if ((mem->flags & MEM_Real) != 0) {
+			value->type = MP_DOUBLE;
+			value->d = mem->u.r;
+		} else {
+			return 1;
+		}
+	}
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	size_t size = sizeof(struct agg_scan_value) * AGG_SCAN_BATCH_SIZE *
+		      scan->field_count;
+	struct agg_scan_value *values = region_alloc(region, size);
+	if (values == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "values");
+		return -1;
+	}
+	struct iterator *it = tarantoolsqlIteratorCreate(cursor, ITER_ALL,
+							 NULL, 0);
+	if (it == NULL) {
+		region_truncate(region, used);
+		return -1;
+	}
+	struct agg_scan_acc acc[SQL_AGG_SCAN_ITEM_MAX];
+	memset(acc, 0, sizeof(acc));
+	uint16_t sel[AGG_SCAN_BATCH_SIZE];
+	int rc = 0;
+	bool is_eof = false;
+	while (!is_eof) {
+		uint32_t count = 0;
+		for (; count < AGG_SCAN_BATCH_SIZE; count++) {
+			struct tuple *tuple;
+			if (iterator_next(it, &tuple) != 0) {
+				rc = -1;
+				goto out;
+			}
+			if (tuple == NULL) {
+				is_eof = true;
+				break;
+			}
+			struct agg_scan_value *row = &values[count];
+			for (uint32_t i = 0; i < scan->field_count; i++) {
+				const char *data =
+					tuple_field(tuple, scan->fieldno[i]);
+				if (agg_scan_decode(data, scan->is_numeric[i],
+						    &row[i * AGG_SCAN_BATCH_SIZE]) != 0) {
+					rc = 1;
+					goto out;
+				}
+			}
+		}
+		uint32_t sel_count = count;
+		for (uint32_t i = 0; i < count; i++)
+			sel[i] = i;
+		for (uint32_t i = 0; i < scan->filter_count; i++) {
+			const struct agg_scan_value *column = &values[
+				scan->filter[i].field * AGG_SCAN_BATCH_SIZE];
+			int op = scan->filter[i].op;
+			uint32_t selected = 0;
+			for (uint32_t j = 0; j < sel_count; j++) {
+				const struct agg_scan_value *value =
+					&column[sel[j]];
+				if (value->type == MP_NIL)
+					continue;
+				int cmp = agg_scan_value_cmp(value,
+							     &filter_value[i]);
+				if (agg_scan_cmp_is_true(op, cmp))
+					sel[selected++] = sel[j];
+			}
+			sel_count = selected;
+		}
+		for (uint32_t i = 0; i < scan->func_count; i++) {
+			const struct agg_scan_value *column = &values[
+				scan->func[i].field * AGG_SCAN_BATCH_SIZE];
+			agg_scan_step(&acc[i], scan->func[i].type, column, sel,
+				      sel_count);
+		}
+	}
+	for (uint32_t i = 0; i < scan->func_count; i++) {
+		struct Mem *out = vdbe_prepare_null_out(v, scan->func[i].reg);
+		if (agg_scan_finalize(&acc[i], scan->func[i].type, out) != 0) {
+			rc = 1;
+			break;
+		}
+	}
+out:
+	iterator_delete(it);
+	region_truncate(region, used);
+	return rc;
+}
+
 /*
  * Execute as much of a VDBE program as we can.
  * This is the core of sql_step().
@@ -2909,6 +3268,8 @@ case OP_Count: {         /* out2 */
 	assert(pCrsr);
 	if (pCrsr->curFlags & BTCF_TaCursor) {
 		nEntry = tarantoolsqlCount(pCrsr);
+		if (nEntry < 0)
+			goto abort_due_to_error;
 	} else {
 		assert((pCrsr->curFlags & BTCF_TEphemCursor) != 0);
 		nEntry = tarantoolsqlEphemeralCount(pCrsr);
@@ -2918,6 +3279,28 @@ case OP_Count: {         /* out2 */
 	break;
 }
 
+/* Opcode: AggScan P1 P2 P3 P4 *
+ * Synopsis: aggregate scan
+ *
+ * Compute aggregate functions described by P4 over tuples of
+ * the space opened by cursor P1, comparing fields with registers
+ * starting from P3, and jump to P2. Fall through if the scan
+ * met values it can't process: the aggregates must be computed
+ * by an ordinary loop then.
+ */
+case OP_AggScan: {         /* jump */
+	assert(p->apCsr[pOp->p1]->eCurType == CURTYPE_TARANTOOL);
+	BtCursor *cursor = p->apCsr[pOp->p1]->uc.pCursor;
+	assert((cursor->curFlags & BTCF_TaCursor) != 0);
+	int res = vdbe_agg_scan(p, cursor, pOp->p4.agg_scan,
+				&aMem[pOp->p3]);
+	if (res < 0)
+		goto abort_due_to_error;
+	if (res == 0)
+		goto jump_to_p2;
+	break;
+}
+
 /* Opcode: Savepoint P1 * * P4 *
  *
  * Open, release or rollback the savepoint named by parameter P4, depending
@@ -3188,7 +3571,7 @@ case OP_SorterOpen: {
 	pCx = allocateCursor(p, pOp->p1, pOp->p2, CURTYPE_SORTER);
 	if (pCx==0) goto no_mem;
 	pCx->key_def = def;
-	if (sqlVdbeSorterInit(db, pCx) != 0)
+	if (sqlVdbeSorterInit(db, p, pCx) != 0)
 		goto abort_due_to_error;
 	break;
 }
@@ -88,6 +88,8 @@ struct VdbeOp {
 		struct sql_key_info *key_info;
 		/** Used when p4type is P4_SPACEPTR. */
 		struct space *space;
+		/** Used when p4type is P4_AGGSCAN. */
+		struct sql_agg_scan *agg_scan;
 		/**
 		 * Used to apply types when making a record, or
 		 * doing a cast.
@@ -142,6 +144,63 @@ struct SubProgram {
 #define P4_PTR      (-18)	/* P4 is a generic pointer */
 #define P4_KEYINFO  (-19)       /* P4 is a pointer to sql_key_info structure. */
 #define P4_SPACEPTR (-20)       /* P4 is a space pointer */
+#define P4_AGGSCAN  (-21)       /* P4 is a pointer to sql_agg_scan structure. */
+
+enum {
+	/** Max number of aggregates or filters of OP_AggScan. */
+	SQL_AGG_SCAN_ITEM_MAX = 8,
+};
+
+/** Aggregate function computed by OP_AggScan. */
+enum sql_agg_scan_func {
+	/** COUNT(*). */
+	SQL_AGG_SCAN_COUNT_ALL,
+	SQL_AGG_SCAN_COUNT,
+	SQL_AGG_SCAN_SUM,
+	SQL_AGG_SCAN_TOTAL,
+	SQL_AGG_SCAN_AVG,
+	SQL_AGG_SCAN_MIN,
+	SQL_AGG_SCAN_MAX,
+};
+
+/**
+ * Program of OP_AggScan: aggregate functions without GROUP BY
+ * computed over a full scan of a space, with rows filtered by
+ * comparison of fields with constants. Fields are decoded into
+ * vectors a batch of tuples at a time, then filters and
+ * aggregates are evaluated over the vectors.
+ */
+struct sql_agg_scan {
+	/** Number of decoded fields. */
+	uint32_t field_count;
+	/** Numbers of decoded fields in a tuple. */
+	uint32_t fieldno[2 * SQL_AGG_SCAN_ITEM_MAX];
+	/**
+	 * True if a decoded field must be a number. Otherwise
+	 * it is only checked for NULL.
+	 */
+	bool is_numeric[2 * SQL_AGG_SCAN_ITEM_MAX];
+	/** Number of filters. */
+	uint32_t filter_count;
+	struct {
+		/** TK_EQ, TK_NE, TK_LT, TK_LE, TK_GT or TK_GE. */
+		int op;
+		/** Index of the field in @a fieldno. */
+		uint32_t field;
+	} filter[SQL_AGG_SCAN_ITEM_MAX];
+	/** Number of aggregate functions. */
+	uint32_t func_count;
+	struct {
+		enum sql_agg_scan_func type;
+		/**
+		 * Index of the argument in @a fieldno. Not used
+		 * by COUNT(*).
+		 */
+		uint32_t field;
+		/** Register to store the result to. */
+		int reg;
+	} func[SQL_AGG_SCAN_ITEM_MAX];
+};
 
 /* Error message codes for OP_Halt */
 #define P5_ConstraintNotNull 1
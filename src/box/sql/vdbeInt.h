@@ -555,7 +555,8 @@ int sqlVdbeCloseStatement(Vdbe *, int);
 void sqlVdbeFrameDelete(VdbeFrame *);
 int sqlVdbeFrameRestore(VdbeFrame *);
 
-int sqlVdbeSorterInit(struct sql *db, struct VdbeCursor *cursor);
+int sqlVdbeSorterInit(struct sql *db, struct Vdbe *v,
+		      struct VdbeCursor *cursor);
 void sqlVdbeSorterReset(sql *, VdbeSorter *);
 
 enum field_type
@@ -790,6 +790,13 @@ sql_stmt_schema_version(const struct sql_stmt *stmt)
 	return v->schema_ver;
 }
 
+uint32_t
+sql_stmt_sql_flags(const struct sql_stmt *stmt)
+{
+	const struct Vdbe *v = (const struct Vdbe *) stmt;
+	return v->sql_flags;
+}
+
 static size_t
 sql_metadata_size(const struct sql_column_metadata *metadata)
 {
@@ -848,6 +855,9 @@ sql_stmt_est_size(const struct sql_stmt *stmt)
 		case P4_REAL:
 			size += sizeof(*v->aOp[i].p4.pReal);
 			break;
+		case P4_AGGSCAN:
+			size += sizeof(*v->aOp[i].p4.agg_scan);
+			break;
 		default:
 			size += sizeof(v->aOp[i].p4.p);
 			break;
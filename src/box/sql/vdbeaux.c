@@ -608,7 +608,8 @@ freeP4(sql * db, int p4type, void *p4)
 	case P4_INT64:
 	case P4_UINT64:
 	case P4_DYNAMIC:
-	case P4_INTARRAY:{
+	case P4_INTARRAY:
+	case P4_AGGSCAN:{
 			sqlDbFree(db, p4);
 			break;
 		}
@@ -1149,6 +1150,12 @@ displayP4(Op * pOp, char *zTemp, int nTemp)
 		sqlXPrintf(&x, "space<name=%s>", space_name(pOp->p4.space));
 		break;
 	}
+	case P4_AGGSCAN: {
+		struct sql_agg_scan *scan = pOp->p4.agg_scan;
+		sqlXPrintf(&x, "aggscan<funcs=%u,filters=%u>",
+			   scan->func_count, scan->filter_count);
+		break;
+	}
 	default:{
 			zP4 = pOp->p4.z;
 			if (zP4 == 0) {
@@ -104,19 +104,21 @@
  * merging two or more level-0 PMAs together creates a level-1 PMA.
  *
  * The threshold for the amount of main memory to use before flushing
- * records to a PMA is roughly the same as the limit configured for the
- * page-cache of the main database. Specifically, the threshold is set to
- * the value returned by "PRAGMA main.page_size" multipled by
- * that returned by "PRAGMA main.cache_size", in bytes.
+ * records to a PMA is set by the "sql_sort_memory" session setting. In
+ * multi-threaded mode the budget is shared by the list being filled and
+ * the lists being written by worker threads.
  *
  * If the sorter is running in single-threaded mode, then all PMAs generated
  * are appended to a single temporary file. Or, if the sorter is running in
- * multi-threaded mode then up to (N+1) temporary files may be opened, where
- * N is the configured number of worker threads. In this case, instead of
- * sorting the records and writing the PMA to a temporary file itself, the
- * calling thread usually launches a worker thread to do so. Except, if
- * there are already N worker threads running, the main thread does the work
- * itself.
+ * multi-threaded mode then up to N temporary files may be opened, where
+ * N is SORTER_TASK_MAX. In this case, instead of sorting the records and
+ * writing the PMA to a temporary file itself, the calling fiber hands the
+ * records to a sub-task, which does it in a coio worker thread, and goes
+ * on accepting new records. If the sub-task still has a job running, the
+ * calling fiber waits for it to finish.
+ *
+ * Waiting for a worker thread yields the calling fiber, so the sorter is
+ * multi-threaded only if the current transaction is allowed to yield.
  *
  * When Rewind() is called, any data remaining in memory is flushed to a
  * final PMA. So at this point the data is stored in some number of sorted
@@ -128,13 +130,12 @@
  * MergeEngine object, described in further detail below, performs this
  * merge.
  *
- * Or, if running in multi-threaded mode, then a background thread is
- * launched to merge the existing PMAs. Once the background thread has
- * merged T bytes of data into a single sorted PMA, the main thread
- * begins reading keys from that PMA while the background thread proceeds
- * with merging the next T bytes of data. And so on.
+ * Or, if running in multi-threaded mode, then each sub-task merges
+ * the PMAs of its temporary file into a single PMA in a worker thread,
+ * all sub-tasks in parallel. The VDBE then merges at most SORTER_TASK_MAX
+ * PMAs incrementally.
  *
- * Parameter T is set to half the value of the memory threshold used
+ * Parameter T below is set to half the value of the memory threshold used
  * by Write() above to determine when to create a new PMA.
  *
  * If there are more than SORTER_MAX_MERGE_COUNT PMAs in total when
@@ -144,15 +145,14 @@
  * so on, such that no operation ever merges more than SORTER_MAX_MERGE_COUNT
  * PMAs at a time. This done is to improve locality.
  *
- * If running in multi-threaded mode and there are more than
- * SORTER_MAX_MERGE_COUNT PMAs on disk when Rewind() is called, then more
- * than one background thread may be created. Specifically, there may be
- * one background thread for each temporary file on disk, and one background
- * thread to merge the output of each of the others to a single PMA for
- * the main thread to read from.
+ * In multi-threaded mode the same hierarchy is used by a worker thread
+ * if a sub-task has more than SORTER_MAX_MERGE_COUNT PMAs.
  */
 #include "sqlInt.h"
 #include "vdbeInt.h"
+#include "box/session.h"
+#include "coio_task.h"
+#include "fiber.h"
 
 /*
  * Hard-coded maximum amount of data to accumulate in memory before flushing
@@ -161,6 +161,12 @@
  */
 #define SQL_MAX_PMASZ    (1<<29)
 
+/*
+ * Maximum number of sub-tasks of a sorter. Each of them sorts and
+ * merges PMAs in a worker thread.
+ */
+#define SORTER_TASK_MAX 4
+
 /*
  * Private objects used by the sorter
  */
@@ -291,6 +297,9 @@ struct SortSubtask {
 	SorterCompare xCompare;	/* Compare function to use */
 	SorterFile file;	/* Temp file for level-0 PMAs */
 	SorterFile file2;	/* Space for other PMAs */
+	i64 nData;		/* Bytes of content in level-0 PMAs */
+	i64 iMergeOff;		/* Offset of the merged PMA in file2 */
+	struct fiber *pWorker;	/* Fiber waiting for a worker thread */
 };
 
 /*
@@ -303,21 +312,24 @@ struct SortSubtask {
  *   largest record in the sorter.
  */
 struct VdbeSorter {
-	int mnPmaSize;		/* Minimum PMA size, in bytes */
 	int mxPmaSize;		/* Maximum PMA size, in bytes.  0==no limit */
 	int mxKeysize;		/* Largest serialized key seen so far */
 	int pgsz;		/* Main database page size */
 	PmaReader *pReader;	/* Readr data from here after Rewind() */
 	MergeEngine *pMerger;	/* Or here, if bUseThreads==0 */
 	sql *db;		/* Database connection */
+	struct Vdbe *pVdbe;	/* Program which opened the sorter */
 	struct key_def *key_def;
 	UnpackedRecord *pUnpacked;	/* Used by VdbeSorterCompare() */
 	SorterList list;	/* List of in-memory records */
 	int iMemory;		/* Offset of free space in list.aMemory */
 	int nMemory;		/* Size of list.aMemory allocation in bytes */
 	u8 bUsePMA;		/* True if one or more PMAs created */
+	u8 bUseThreads;		/* True to sort in worker threads */
 	u8 typeMask;
-	SortSubtask aTask;	/* A single subtask */
+	int iPrev;		/* Previous sub-task used to flush a PMA */
+	int nTask;		/* Number of sub-tasks in aTask[] */
+	SortSubtask aTask[SORTER_TASK_MAX];	/* Sub-tasks */
 };
 
 #define SORTER_TYPE_INTEGER 0x01
@@ -786,6 +798,62 @@ vdbeSorterCompare(struct SortSubtask *task, bool *key2_cached,
 	return sqlVdbeRecordCompareMsgpack(key1, r2);
 }
 
+/*
+ * Return true if the current fiber may yield to wait for worker
+ * threads while executing VDBE program @a v. Memtx transactions
+ * are aborted by a yield. Besides, memtx has no read views, so
+ * rows could change under a scan interrupted by a yield. Hence
+ * only statements which read nothing but vinyl spaces, which
+ * yield to read disk anyway, and statement-private ephemeral
+ * spaces may yield. Programs of triggers are run in the middle
+ * of a scan done by the parent program, so they never yield.
+ */
+static bool
+vdbeSorterCanYield(struct Vdbe *v)
+{
+	struct txn *txn = in_txn();
+	if (txn != NULL && !txn_has_flag(txn, TXN_CAN_YIELD))
+		return false;
+	if (v->pFrame != NULL)
+		return false;
+	for (int i = 0; i < v->nOp; i++) {
+		struct VdbeOp *op = &v->aOp[i];
+		if (op->opcode == OP_IteratorOpen &&
+		    op->p4type == P4_SPACEPTR &&
+		    !space_is_vinyl(op->p4.space))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Return true if the sorter of program @a v may yield to wait
+ * for worker threads on rewind, when all of its records have
+ * been written. The records are copies, so a yield can't change
+ * them, but it must not interrupt a memtx scan still running,
+ * e.g. an outer loop of a join or a correlated subquery.
+ */
+static bool
+vdbeSorterCanYieldOnRewind(struct Vdbe *v)
+{
+	struct txn *txn = in_txn();
+	if (txn != NULL && !txn_has_flag(txn, TXN_CAN_YIELD))
+		return false;
+	if (v->pFrame != NULL)
+		return false;
+	for (int i = 0; i < v->nCursor; i++) {
+		struct VdbeCursor *csr = v->apCsr[i];
+		if (csr == NULL || csr->eCurType != CURTYPE_TARANTOOL)
+			continue;
+		struct BtCursor *cursor = csr->uc.pCursor;
+		if ((cursor->curFlags & BTCF_TaCursor) != 0 &&
+		    cursor->eState == CURSOR_VALID &&
+		    !space_is_vinyl(cursor->space))
+			return false;
+	}
+	return true;
+}
+
 /*
  * Initialize the temporary index cursor just opened as a sorter cursor.
  *
@@ -807,6 +875,7 @@ vdbeSorterCompare(struct SortSubtask *task, bool *key2_cached,
  */
 int
 sqlVdbeSorterInit(sql * db,	/* Database connection (for malloc()) */
+		      Vdbe * v,		/* VDBE program which opens the sorter */
 		      VdbeCursor * pCsr	/* Cursor that holds the new sorter */
     )
 {
@@ -825,17 +894,21 @@ sqlVdbeSorterInit(sql * db,	/* Database connection (for malloc()) */
 	pSorter->key_def = pCsr->key_def;
 	pSorter->pgsz = pgsz = 1024;
 	pSorter->db = db;
-	pSorter->aTask.pSorter = pSorter;
-
-	/* Cache size in bytes */
-	i64 mxCache;
-	u32 szPma = sqlGlobalConfig.szPma;
-	pSorter->mnPmaSize = szPma * pgsz;
-
-	mxCache = SQL_DEFAULT_CACHE_SIZE;
-	mxCache = mxCache * -1024;
-	mxCache = MIN(mxCache, SQL_MAX_PMASZ);
-	pSorter->mxPmaSize = MAX(pSorter->mnPmaSize, (int)mxCache);
+	pSorter->pVdbe = v;
+	pSorter->bUseThreads = vdbeSorterCanYield(v);
+	pSorter->nTask = pSorter->bUseThreads ? SORTER_TASK_MAX : 1;
+	for (int i = 0; i < pSorter->nTask; i++)
+		pSorter->aTask[i].pSorter = pSorter;
+
+	/*
+	 * In multi-threaded mode each sub-task may hold a list
+	 * being written to a PMA while a new list is filled.
+	 */
+	i64 mxMemory = current_session()->sql_sort_memory;
+	if (pSorter->bUseThreads)
+		mxMemory /= pSorter->nTask + 1;
+	mxMemory = MIN(mxMemory, SQL_MAX_PMASZ);
+	pSorter->mxPmaSize = MAX(pgsz, (int)mxMemory);
 	assert(pSorter->iMemory == 0);
 	pSorter->nMemory = pgsz;
 	pSorter->list.aMemory = (u8 *) sqlMalloc(pgsz);
@@ -870,10 +943,13 @@ vdbeSorterRecordFree(sql * db, SorterRecord * pRecord)
 static void
 vdbeSortSubtaskCleanup(sql * db, SortSubtask * pTask)
 {
+	assert(pTask->pWorker == NULL);
 	sqlDbFree(db, pTask->pUnpacked);
 
-	assert(pTask->list.aMemory == 0);
-	vdbeSorterRecordFree(0, pTask->list.pList);
+	if (pTask->list.aMemory != NULL)
+		sql_free(pTask->list.aMemory);
+	else
+		vdbeSorterRecordFree(0, pTask->list.pList);
 
 	if (pTask->file.pFd) {
 		sqlOsCloseFree(pTask->file.pFd);
@@ -884,7 +960,80 @@ vdbeSortSubtaskCleanup(sql * db, SortSubtask * pTask)
 	memset(pTask, 0, sizeof(SortSubtask));
 }
 
-#define vdbeSorterJoinAll(x,rcin) (rcin)
+/*
+ * Run a sorter job in a worker thread. Arguments are a sub-task
+ * and a list to be passed to the job.
+ */
+static int
+vdbeSorterWorkerCall(coio_call_cb xJob, SortSubtask * pTask,
+		     SorterList * pList)
+{
+	if (coio_call(xJob, pTask, pList) == 0)
+		return 0;
+	if (diag_is_empty(diag_get()))
+		diag_set(ClientError, ER_SQL_EXECUTE, "failed to sort records");
+	return -1;
+}
+
+/*
+ * Body of a fiber which waits for a sorter job to complete.
+ */
+static int
+vdbeSorterWorkerFiber(va_list ap)
+{
+	coio_call_cb xJob = va_arg(ap, coio_call_cb);
+	SortSubtask *pTask = va_arg(ap, SortSubtask *);
+	SorterList *pList = va_arg(ap, SorterList *);
+	return vdbeSorterWorkerCall(xJob, pTask, pList);
+}
+
+/*
+ * Launch a job of sub-task pTask in a worker thread. The calling
+ * fiber goes on while the job is running.
+ */
+static int
+vdbeSorterStartJob(coio_call_cb xJob, SortSubtask * pTask,
+		   SorterList * pList)
+{
+	assert(pTask->pWorker == NULL);
+	struct fiber *f = fiber_new("sql_sorter", vdbeSorterWorkerFiber);
+	if (f == NULL)
+		return -1;
+	fiber_set_joinable(f, true);
+	pTask->pWorker = f;
+	fiber_start(f, xJob, pTask, pList);
+	return 0;
+}
+
+/*
+ * Wait for the job of sub-task pTask to complete, if any.
+ */
+static int
+vdbeSorterJoinThread(SortSubtask * pTask)
+{
+	int rc = 0;
+	if (pTask->pWorker != NULL) {
+		rc = fiber_join(pTask->pWorker);
+		pTask->pWorker = NULL;
+	}
+	return rc;
+}
+
+/*
+ * Wait for all sub-task jobs to complete. Return rcin, or the
+ * first error code if rcin is 0 and some job failed.
+ */
+static int
+vdbeSorterJoinAll(VdbeSorter * pSorter, int rcin)
+{
+	int rc = rcin;
+	for (int i = pSorter->nTask - 1; i >= 0; i--) {
+		int rc2 = vdbeSorterJoinThread(&pSorter->aTask[i]);
+		if (rc == 0)
+			rc = rc2;
+	}
+	return rc;
+}
 
 /*
  * Allocate a new MergeEngine object capable of handling up to
@@ -954,8 +1103,12 @@ sqlVdbeSorterReset(sql * db, VdbeSorter * pSorter)
 	assert(pSorter->pReader == 0);
 	vdbeMergeEngineFree(pSorter->pMerger);
 	pSorter->pMerger = 0;
-	vdbeSortSubtaskCleanup(db, &pSorter->aTask);
-	pSorter->aTask.pSorter = pSorter;
+	for (int i = 0; i < pSorter->nTask; i++) {
+		SortSubtask *pTask = &pSorter->aTask[i];
+		vdbeSortSubtaskCleanup(db, pTask);
+		pTask->pSorter = pSorter;
+	}
+	pSorter->iPrev = 0;
 	if (pSorter->list.aMemory == 0) {
 		vdbeSorterRecordFree(0, pSorter->list.pList);
 	}
@@ -1327,6 +1480,7 @@ vdbeSorterListToPMA(SortSubtask * pTask, SorterList * pList)
 		vdbePmaWriterInit(pTask->file.pFd, &writer,
 				  pTask->pSorter->pgsz, pTask->file.iEof);
 		pTask->nPMA++;
+		pTask->nData += pList->szPMA;
 		vdbePmaWriteVarint(&writer, pList->szPMA);
 		for (p = pList->pList; p; p = pNext) {
 			pNext = p->u.pNext;
@@ -1428,6 +1582,32 @@ vdbeMergeEngineStep(MergeEngine * pMerger,	/* The merge engine to advance to the
 	return rc;
 }
 
+/*
+ * Allocate the resources which can't be allocated by a worker
+ * thread: memory of the database connection and temporary files.
+ */
+static int
+vdbeSorterPrepareTask(SortSubtask * pTask)
+{
+	if (vdbeSortAllocUnpacked(pTask) != 0)
+		return -1;
+	if (pTask->file.pFd == 0)
+		return vdbeSorterOpenTempFile(pTask->pSorter->db, 0,
+					      &pTask->file.pFd);
+	return 0;
+}
+
+/*
+ * Job of a worker thread: sort a list and write it to a new PMA.
+ */
+static ssize_t
+vdbeSorterFlushThread(va_list ap)
+{
+	SortSubtask *pTask = va_arg(ap, SortSubtask *);
+	SorterList *pList = va_arg(ap, SorterList *);
+	return vdbeSorterListToPMA(pTask, pList);
+}
+
 /*
  * Flush the current contents of VdbeSorter.list to a new PMA, possibly
  * using a background thread.
@@ -1436,7 +1616,38 @@ static int
 vdbeSorterFlushPMA(VdbeSorter * pSorter)
 {
 	pSorter->bUsePMA = 1;
-	return vdbeSorterListToPMA(&pSorter->aTask, &pSorter->list);
+	if (!pSorter->bUseThreads)
+		return vdbeSorterListToPMA(&pSorter->aTask[0], &pSorter->list);
+
+	/* Sub-tasks are used in turn. Wait for the previous job. */
+	int iTask = (pSorter->iPrev + 1) % pSorter->nTask;
+	SortSubtask *pTask = &pSorter->aTask[iTask];
+	int rc = vdbeSorterJoinThread(pTask);
+	if (rc == 0)
+		rc = vdbeSorterPrepareTask(pTask);
+	if (rc != 0)
+		return rc;
+
+	/*
+	 * Hand the list over to the sub-task and take its bulk
+	 * memory, which is not used since its previous job.
+	 */
+	assert(pTask->list.pList == NULL);
+	u8 *aMem = pTask->list.aMemory;
+	if (aMem == NULL && pSorter->list.aMemory != NULL) {
+		aMem = (u8 *) sqlMalloc(pSorter->nMemory);
+		if (aMem == NULL)
+			return -1;
+	}
+	pSorter->iPrev = iTask;
+	pTask->list = pSorter->list;
+	pSorter->list.pList = NULL;
+	pSorter->list.szPMA = 0;
+	if (aMem != NULL) {
+		pSorter->list.aMemory = aMem;
+		pSorter->nMemory = sqlMallocSize(aMem);
+	}
+	return vdbeSorterStartJob(vdbeSorterFlushThread, pTask, &pTask->list);
 }
 
 /*
@@ -1943,9 +2154,9 @@ vdbeSorterAddToTree(SortSubtask * pTask,	/* Task context */
 
 /*
  * This function is called as part of a SorterRewind() operation on a sorter
- * that has already written two or more level-0 PMAs to one or more temp
- * files. It builds a tree of MergeEngine/IncrMerger/PmaReader objects that
- * can be used to incrementally merge all PMAs on disk.
+ * that has already written two or more level-0 PMAs to the temp file of
+ * sub-task pTask. It builds a tree of MergeEngine/IncrMerger/PmaReader
+ * objects that can be used to incrementally merge all PMAs on disk.
  *
  * If successful, 0 is returned and *ppOut set to point to the
  * MergeEngine object at the root of the tree before returning. Or, if an
@@ -1953,14 +2164,13 @@ vdbeSorterAddToTree(SortSubtask * pTask,	/* Task context */
  * of *ppOut is undefined.
  */
 static int
-vdbeSorterMergeTreeBuild(VdbeSorter * pSorter,	/* The VDBE cursor that implements the sort */
+vdbeSorterMergeTreeBuild(SortSubtask * pTask,	/* Sub-task whose PMAs to merge */
 			 MergeEngine ** ppOut	/* Write the MergeEngine here */
     )
 {
 	MergeEngine *pMain = 0;
 	int rc = 0;
 
-	SortSubtask *pTask = &pSorter->aTask;
 	assert(pTask->nPMA > 0);
 	if (pTask->nPMA) {
 		MergeEngine *pRoot = 0;	/* Root node of tree for this task */
@@ -2015,6 +2225,121 @@ vdbeSorterMergeTreeBuild(VdbeSorter * pSorter,	/* The VDBE cursor that implement
 	return rc;
 }
 
+/*
+ * Merge all level-0 PMAs of sub-task pTask into a single PMA
+ * appended to pTask->file2. It is a job of a worker thread, so
+ * pTask->file2 must be opened beforehand. The merge tree is built
+ * as in single-threaded mode, regions of file2 used by the
+ * incremental mergers precede the merged PMA.
+ */
+static int
+vdbeSorterMergeTask(SortSubtask * pTask)
+{
+	MergeEngine *pRoot = 0;
+	PmaWriter writer;
+	int rc = vdbeSorterMergeTreeBuild(pTask, &pRoot);
+	if (rc != 0)
+		return rc;
+	assert(pTask->file2.pFd != 0);
+	pTask->file2.iEof = 0;
+	rc = vdbeMergeEngineInit(pTask, pRoot);
+	if (rc == 0) {
+		int bEof = pRoot->aReadr[pRoot->aTree[1]].pFd == 0;
+		pTask->iMergeOff = pTask->file2.iEof;
+		vdbePmaWriterInit(pTask->file2.pFd, &writer,
+				  pTask->pSorter->pgsz, pTask->iMergeOff);
+		vdbePmaWriteVarint(&writer, pTask->nData);
+		while (rc == 0 && !bEof) {
+			PmaReader *pReadr = &pRoot->aReadr[pRoot->aTree[1]];
+			vdbePmaWriteVarint(&writer, pReadr->nKey);
+			vdbePmaWriteBlob(&writer, pReadr->aKey, pReadr->nKey);
+			rc = vdbeMergeEngineStep(pRoot, &bEof);
+		}
+		int rc2 = vdbePmaWriterFinish(&writer, &pTask->file2.iEof);
+		if (rc == 0)
+			rc = rc2;
+	}
+	vdbeMergeEngineFree(pRoot);
+	return rc;
+}
+
+/*
+ * Job of a worker thread: merge PMAs of a sub-task.
+ */
+static ssize_t
+vdbeSorterMergeThread(va_list ap)
+{
+	SortSubtask *pTask = va_arg(ap, SortSubtask *);
+	return vdbeSorterMergeTask(pTask);
+}
+
+/*
+ * Merge PMAs of each sub-task which has more than one of them
+ * into a single PMA. Sub-tasks are merged in parallel.
+ */
+static int
+vdbeSorterMergeTasks(VdbeSorter * pSorter)
+{
+	int rc = 0;
+	for (int i = 0; i < pSorter->nTask && rc == 0; i++) {
+		SortSubtask *pTask = &pSorter->aTask[i];
+		if (pTask->nPMA <= 1)
+			continue;
+		if (pTask->file2.pFd == 0) {
+			rc = vdbeSorterOpenTempFile(pSorter->db, 0,
+						    &pTask->file2.pFd);
+		}
+		if (rc == 0) {
+			rc = vdbeSorterStartJob(vdbeSorterMergeThread, pTask,
+						NULL);
+		}
+	}
+	return vdbeSorterJoinAll(pSorter, rc);
+}
+
+/*
+ * Create a MergeEngine to read the single PMA of each sub-task
+ * which has any. Set *ppTask to the sub-task to run the engine.
+ */
+static int
+vdbeSorterMergeRuns(VdbeSorter * pSorter, MergeEngine ** ppOut,
+		    SortSubtask ** ppTask)
+{
+	int rc = 0;
+	int nRun = 0;
+	for (int i = 0; i < pSorter->nTask; i++) {
+		if (pSorter->aTask[i].nPMA > 0)
+			nRun++;
+	}
+	assert(nRun > 0);
+	MergeEngine *pNew = vdbeMergeEngineNew(nRun);
+	if (pNew == 0)
+		return -1;
+	int iReadr = 0;
+	for (int i = 0; i < pSorter->nTask && rc == 0; i++) {
+		SortSubtask *pTask = &pSorter->aTask[i];
+		if (pTask->nPMA == 0)
+			continue;
+		SorterFile *pFile = &pTask->file;
+		i64 iOff = 0;
+		if (pTask->nPMA > 1) {
+			pFile = &pTask->file2;
+			iOff = pTask->iMergeOff;
+		}
+		i64 nDummy = 0;
+		rc = vdbePmaReaderInit(pTask, pFile, iOff,
+				       &pNew->aReadr[iReadr++], &nDummy);
+		if (iReadr == 1)
+			*ppTask = pTask;
+	}
+	if (rc != 0) {
+		vdbeMergeEngineFree(pNew);
+		pNew = 0;
+	}
+	*ppOut = pNew;
+	return rc;
+}
+
 /*
  * This function is called as part of an sqlVdbeSorterRewind() operation
  * on a sorter that has written two or more PMAs to temporary files. It sets
@@ -2029,10 +2354,17 @@ vdbeSorterSetupMerge(VdbeSorter * pSorter)
 {
 	int rc;			/* Return code */
 	MergeEngine *pMain = 0;
+	SortSubtask *pTask = &pSorter->aTask[0];
 
-	rc = vdbeSorterMergeTreeBuild(pSorter, &pMain);
+	if (pSorter->bUseThreads) {
+		rc = vdbeSorterMergeTasks(pSorter);
+		if (rc == 0)
+			rc = vdbeSorterMergeRuns(pSorter, &pMain, &pTask);
+	} else {
+		rc = vdbeSorterMergeTreeBuild(pTask, &pMain);
+	}
 	if (rc == 0) {
-		rc = vdbeMergeEngineInit(&pSorter->aTask, pMain);
+		rc = vdbeMergeEngineInit(pTask, pMain);
 		pSorter->pMerger = pMain;
 		pMain = 0;
 	}
@@ -2043,19 +2375,40 @@ vdbeSorterSetupMerge(VdbeSorter * pSorter)
 }
 
 /*
- * Once the sorter has been populated by calls to sqlVdbeSorterWrite,
- * this function is called to prepare for iterating through the records
- * in sorted order.
+ * Job of a worker thread: sort a list in memory.
  */
-int
-sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
+static ssize_t
+vdbeSorterSortThread(va_list ap)
 {
-	VdbeSorter *pSorter;
-	int rc = 0;	/* Return code */
+	SortSubtask *pTask = va_arg(ap, SortSubtask *);
+	SorterList *pList = va_arg(ap, SorterList *);
+	return vdbeSorterSort(pTask, pList);
+}
 
-	assert(pCsr->eCurType == CURTYPE_SORTER);
-	pSorter = pCsr->uc.pSorter;
-	assert(pSorter);
+/*
+ * Sort the in-memory list of a sorter which has not written any
+ * PMAs, in a worker thread if possible.
+ */
+static int
+vdbeSorterSortList(VdbeSorter * pSorter)
+{
+	SortSubtask *pTask = &pSorter->aTask[0];
+	if (!pSorter->bUseThreads)
+		return vdbeSorterSort(pTask, &pSorter->list);
+	if (vdbeSortAllocUnpacked(pTask) != 0)
+		return -1;
+	return vdbeSorterWorkerCall(vdbeSorterSortThread, pTask,
+				    &pSorter->list);
+}
+
+/*
+ * Sort the records of a populated sorter and set it up for
+ * iterating through them.
+ */
+static int
+vdbeSorterDoRewind(VdbeSorter * pSorter, int *pbEof)
+{
+	int rc = 0;	/* Return code */
 
 	/* If no data has been written to disk, then do not do so now. Instead,
 	 * sort the VdbeSorter.pRecord list. The vdbe layer will read data directly
@@ -2064,7 +2417,7 @@ sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
 	if (pSorter->bUsePMA == 0) {
 		if (pSorter->list.pList) {
 			*pbEof = 0;
-			rc = vdbeSorterSort(&pSorter->aTask, &pSorter->list);
+			rc = vdbeSorterSortList(pSorter);
 		} else {
 			*pbEof = 1;
 		}
@@ -2094,6 +2447,32 @@ sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
 	return rc;
 }
 
+/*
+ * Once the sorter has been populated by calls to sqlVdbeSorterWrite,
+ * this function is called to prepare for iterating through the records
+ * in sorted order.
+ *
+ * A sorter fed by a memtx scan sorts and spills records in place,
+ * but once the scan is complete the final sort and merge may be
+ * done in worker threads. A single sub-task is used then, as all
+ * the PMAs were written by the first one.
+ */
+int
+sqlVdbeSorterRewind(const VdbeCursor * pCsr, int *pbEof)
+{
+	assert(pCsr->eCurType == CURTYPE_SORTER);
+	VdbeSorter *pSorter = pCsr->uc.pSorter;
+	assert(pSorter);
+
+	struct Vdbe *v = pSorter->pVdbe;
+	u8 bUseThreads = pSorter->bUseThreads;
+	if (!bUseThreads)
+		pSorter->bUseThreads = vdbeSorterCanYieldOnRewind(v);
+	int rc = vdbeSorterDoRewind(pSorter, pbEof);
+	pSorter->bUseThreads = bUseThreads;
+	return rc;
+}
+
 /*
  * Advance to the next element in the sorter.
  */
@@ -2110,7 +2489,7 @@ sqlVdbeSorterNext(sql * db, const VdbeCursor * pCsr, int *pbEof)
 	if (pSorter->bUsePMA) {
 		assert(pSorter->pReader == 0 || pSorter->pMerger == 0);
 		assert(pSorter->pMerger);
-		assert(pSorter->pMerger->pTask == &pSorter->aTask);
+		assert(pSorter->pMerger->pTask->pSorter == pSorter);
 		rc = vdbeMergeEngineStep(pSorter->pMerger, pbEof);
 	} else {
 		SorterRecord *pFree = pSorter->list.pList;
@@ -35,6 +35,8 @@
 #include "execute.h"
 #include "diag.h"
 #include "info/info.h"
+#include "schema.h"
+#include "sql/sqlInt.h"
 
 static struct sql_stmt_cache sql_stmt_cache;
 
@@ -47,6 +49,12 @@ sql_stmt_cache_init()
 	sql_stmt_cache.mem_quota = 0;
 	sql_stmt_cache.mem_used = 0;
 	rlist_create(&sql_stmt_cache.gc_queue);
+	sql_stmt_cache.auto_hash = mh_i32ptr_new();
+	if (sql_stmt_cache.auto_hash == NULL)
+		panic("out of memory");
+	rlist_create(&sql_stmt_cache.auto_lru);
+	sql_stmt_cache.auto_hits = 0;
+	sql_stmt_cache.auto_misses = 0;
 }
 
 void
@@ -60,6 +68,12 @@ sql_stmt_cache_stat(struct info_handler *h)
 	mh_foreach(sql_stmt_cache.hash, i)
 		entry_count++;
 	info_append_int(h, "stmt_count", entry_count);
+	entry_count = 0;
+	mh_foreach(sql_stmt_cache.auto_hash, i)
+		entry_count++;
+	info_append_int(h, "auto_stmt_count", entry_count);
+	info_append_int(h, "hits", sql_stmt_cache.auto_hits);
+	info_append_int(h, "misses", sql_stmt_cache.auto_misses);
 	info_table_end(h);
 	info_end(h);
 }
@@ -127,6 +141,70 @@ sql_stmt_cache_gc()
 	assert(rlist_empty(&sql_stmt_cache.gc_queue));
 }
 
+/**
+ * Session SQL flags which change the code compiled for a query.
+ * Statements of an unprepared query compiled with different
+ * combinations of them are cached separately.
+ */
+static const uint32_t SQL_STMT_AUTO_FLAGS =
+	SQL_FullColNames | SQL_FullMetadata | SQL_ReverseOrder;
+
+/**
+ * Calculate the @auto_hash key of a normalized query executed
+ * with the given session SQL flags.
+ */
+static uint32_t
+sql_stmt_cache_auto_id(const char *sql_str, size_t len, uint32_t sql_flags)
+{
+	return sql_stmt_calculate_id(sql_str, len) ^
+	       (sql_flags & SQL_STMT_AUTO_FLAGS);
+}
+
+/** Calculate the @auto_hash key of a cached statement. */
+static uint32_t
+sql_stmt_cache_auto_stmt_id(const struct sql_stmt *stmt)
+{
+	const char *sql_str = sql_stmt_query_str(stmt);
+	return sql_stmt_cache_auto_id(sql_str, strlen(sql_str),
+				      sql_stmt_sql_flags(stmt));
+}
+
+/**
+ * Remove statement of an unprepared query from cache: remove
+ * it from hash and LRU list, account cache size changes, then
+ * release occupied memory.
+ */
+static void
+sql_stmt_cache_auto_delete(struct stmt_cache_entry *entry)
+{
+	struct mh_i32ptr_t *hash = sql_stmt_cache.auto_hash;
+	uint32_t stmt_id = sql_stmt_cache_auto_stmt_id(entry->stmt);
+	mh_int_t i = mh_i32ptr_find(hash, stmt_id, NULL);
+	assert(i != mh_end(hash));
+	mh_i32ptr_del(hash, i, NULL);
+	sql_stmt_cache.mem_used -= sql_cache_entry_sizeof(entry->stmt);
+	rlist_del(&entry->link);
+	sql_cache_entry_delete(entry);
+}
+
+/**
+ * Evict least recently used statements of unprepared queries
+ * until @a size more bytes fit into @a quota. Statements which
+ * are being executed right now are skipped.
+ */
+static void
+sql_stmt_cache_auto_evict(size_t size, size_t quota)
+{
+	struct stmt_cache_entry *entry, *prev;
+	rlist_foreach_entry_safe_reverse(entry, &sql_stmt_cache.auto_lru,
+					 link, prev) {
+		if (sql_stmt_cache.mem_used + size <= quota)
+			return;
+		if (! sql_stmt_busy(entry->stmt))
+			sql_stmt_cache_auto_delete(entry);
+	}
+}
+
 /**
  * Allocate new cache entry containing given prepared statement.
  * Add it to the LRU cache list. Account cache size enlargement.
@@ -245,6 +323,11 @@ sql_stmt_cache_insert(struct sql_stmt *stmt)
 
 	if (! sql_cache_check_new_entry_size(new_entry_size))
 		sql_stmt_cache_gc();
+	/*
+	 * Statements of unprepared queries can be compiled
+	 * again, so they are evicted in favour of prepared ones.
+	 */
+	sql_stmt_cache_auto_evict(new_entry_size, cache->mem_quota);
 	/*
 	 * Test memory limit again. Raise an error if it is
 	 * still overcrowded.
@@ -284,11 +367,91 @@ sql_stmt_cache_find(uint32_t stmt_id)
 	return entry->stmt;
 }
 
+struct sql_stmt *
+sql_stmt_cache_auto_find(const char *sql_str, size_t len, uint32_t sql_flags)
+{
+	struct sql_stmt_cache *cache = &sql_stmt_cache;
+	uint32_t stmt_id = sql_stmt_cache_auto_id(sql_str, len, sql_flags);
+	mh_int_t i = mh_i32ptr_find(cache->auto_hash, stmt_id, NULL);
+	if (i == mh_end(cache->auto_hash))
+		goto miss;
+	struct stmt_cache_entry *entry =
+		mh_i32ptr_node(cache->auto_hash, i)->val;
+	struct sql_stmt *stmt = entry->stmt;
+	/* Different queries may have the same id. */
+	const char *entry_str = sql_stmt_query_str(stmt);
+	if (strlen(entry_str) != len || memcmp(entry_str, sql_str, len) != 0)
+		goto miss;
+	if (((sql_stmt_sql_flags(stmt) ^ sql_flags) & SQL_STMT_AUTO_FLAGS) != 0)
+		goto miss;
+	if (sql_stmt_busy(stmt))
+		goto miss;
+	if (sql_stmt_schema_version(stmt) != box_schema_version()) {
+		sql_stmt_cache_auto_delete(entry);
+		goto miss;
+	}
+	rlist_move_entry(&cache->auto_lru, entry, link);
+	cache->auto_hits++;
+	return stmt;
+miss:
+	cache->auto_misses++;
+	return NULL;
+}
+
+bool
+sql_stmt_cache_auto_insert(struct sql_stmt *stmt)
+{
+	assert(stmt != NULL);
+	struct sql_stmt_cache *cache = &sql_stmt_cache;
+	size_t new_entry_size = sql_cache_entry_sizeof(stmt);
+	/*
+	 * Don't let a single statement flush the whole cache
+	 * of unprepared queries.
+	 */
+	if (new_entry_size > cache->mem_quota / 2)
+		return false;
+	if (! sql_cache_check_new_entry_size(new_entry_size))
+		sql_stmt_cache_gc();
+	sql_stmt_cache_auto_evict(new_entry_size, cache->mem_quota);
+	if (! sql_cache_check_new_entry_size(new_entry_size))
+		return false;
+	uint32_t stmt_id = sql_stmt_cache_auto_stmt_id(stmt);
+	/*
+	 * The slot may be taken by a colliding query or by an
+	 * expired statement which is still being executed.
+	 */
+	if (mh_i32ptr_find(cache->auto_hash, stmt_id, NULL) !=
+	    mh_end(cache->auto_hash))
+		return false;
+	struct stmt_cache_entry *entry = sql_cache_entry_new(stmt);
+	if (entry == NULL) {
+		diag_clear(diag_get());
+		return false;
+	}
+	const struct mh_i32ptr_node_t id_node = { stmt_id, entry };
+	if (mh_i32ptr_put(cache->auto_hash, &id_node, NULL, NULL) ==
+	    mh_end(cache->auto_hash)) {
+		TRASH(entry);
+		free(entry);
+		return false;
+	}
+	rlist_add_entry(&cache->auto_lru, entry, link);
+	cache->mem_used += new_entry_size;
+	return true;
+}
+
+bool
+sql_stmt_cache_auto_is_enabled(void)
+{
+	return sql_stmt_cache.mem_quota > 0;
+}
+
 int
 sql_stmt_cache_set_size(size_t size)
 {
 	if (sql_stmt_cache.mem_used > size)
 		sql_stmt_cache_gc();
+	sql_stmt_cache_auto_evict(0, size);
 	if (sql_stmt_cache.mem_used > size) {
 		diag_set(ClientError, ER_SQL_PREPARE, "Can't reduce memory "\
 			 "limit for SQL prepared statements: please, deallocate "\
@@ -32,6 +32,7 @@
  */
 #include <stdint.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #include "small/rlist.h"
 
@@ -82,6 +83,23 @@ struct sql_stmt_cache {
 	 * times.
 	 */
 	struct stmt_cache_entry *last_found;
+	/**
+	 * Normalized query id -> struct stmt_cache_entry hash.
+	 * Holds statements compiled for unprepared queries with
+	 * literals replaced by parameters. Such statements are
+	 * not referenced by sessions and are evicted when the
+	 * memory is needed for anything else.
+	 */
+	struct mh_i32ptr_t *auto_hash;
+	/**
+	 * Statements of @auto_hash, most recently used first.
+	 * Eviction starts from the tail.
+	 */
+	struct rlist auto_lru;
+	/** Number of unprepared queries served by @auto_hash. */
+	uint64_t auto_hits;
+	/** Number of unprepared queries compiled from scratch. */
+	uint64_t auto_misses;
 };
 
 /**
@@ -142,6 +160,31 @@ struct sql_stmt *
 sql_stmt_cache_find(uint32_t stmt_id);
 
 
+/**
+ * Find a statement compiled for a normalized unprepared query
+ * (see sql_stmt_cache_auto_insert()) with session SQL flags
+ * @a sql_flags and account a cache hit or miss. A statement
+ * which is expired or being executed by another fiber is never
+ * returned: an expired one is evicted.
+ */
+struct sql_stmt *
+sql_stmt_cache_auto_find(const char *sql_str, size_t len, uint32_t sql_flags);
+
+/**
+ * Save a statement compiled for a normalized unprepared query,
+ * evicting the least recently used ones if the memory quota is
+ * exceeded. Unlike sql_stmt_cache_insert() no error is raised
+ * if the statement doesn't fit: the caller owns it then.
+ * @retval true The statement is saved and owned by the cache.
+ * @retval false The statement is not saved.
+ */
+bool
+sql_stmt_cache_auto_insert(struct sql_stmt *stmt);
+
+/** Return true if statements of unprepared queries are cached. */
+bool
+sql_stmt_cache_auto_is_enabled(void);
+
 /** Set prepared cache size limit. */
 int
 sql_stmt_cache_set_size(size_t size);
@@ -193,6 +193,7 @@ static const struct index_vtab sysview_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ sysview_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ sysview_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -505,6 +506,7 @@ static const struct space_vtab sysview_space_vtab = {
 	/* .drop_primary_key = */ generic_space_drop_primary_key,
 	/* .check_format = */ generic_space_check_format,
 	/* .build_index = */ generic_space_build_index,
+	/* .bulk_load = */ generic_space_bulk_load,
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
@@ -546,7 +548,7 @@ sysview_engine_create_space(struct engine *engine, struct space_def *def,
 		tuple_format_new(NULL, NULL, keys, key_count, def->fields,
 				 def->field_count, def->exact_field_count,
 				 def->dict, def->opts.is_temporary,
-				 def->opts.is_ephemeral);
+				 def->opts.is_ephemeral, false);
 	if (format == NULL) {
 		free(space);
 		return NULL;
@@ -47,6 +47,8 @@
 
 enum { HASH_SEED = 13U };
 
+const char *tuple_bloom_type_strs[] = { "classic", "fuse" };
+
 struct tuple_bloom_builder *
 tuple_bloom_builder_new(uint32_t part_count)
 {
@@ -149,22 +151,12 @@ tuple_bloom_builder_add_key(struct tuple_bloom_builder *builder,
 	return 0;
 }
 
-struct tuple_bloom *
-tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
+/** Build a bloom filter for each partial key. */
+static int
+tuple_bloom_build_classic(struct tuple_bloom *bloom,
+			  struct tuple_bloom_builder *builder, double fpr)
 {
-	uint32_t part_count = builder->part_count;
-	size_t size = sizeof(struct tuple_bloom) +
-			part_count * sizeof(struct bloom);
-	struct tuple_bloom *bloom = malloc(size);
-	if (bloom == NULL) {
-		diag_set(OutOfMemory, size, "malloc", "tuple bloom");
-		return NULL;
-	}
-
-	bloom->is_legacy = false;
-	bloom->part_count = 0;
-
-	for (uint32_t i = 0; i < part_count; i++) {
+	for (uint32_t i = 0; i < builder->part_count; i++) {
 		struct tuple_hash_array *hash_arr = &builder->parts[i];
 		uint32_t count = hash_arr->count;
 		/*
@@ -177,17 +169,68 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 		 */
 		double part_fpr = fpr;
 		for (uint32_t j = 0; j < i; j++)
-			part_fpr /= bloom_fpr(&bloom->parts[j], count);
+			part_fpr /= bloom_fpr(&bloom->parts[j].bloom, count);
 		part_fpr = MIN(part_fpr, 0.5);
-		if (bloom_create(&bloom->parts[i], count, part_fpr) != 0) {
+		struct bloom *part = &bloom->parts[i].bloom;
+		if (bloom_create(part, count, part_fpr) != 0) {
 			diag_set(OutOfMemory, 0, "bloom_create",
 				 "tuple bloom part");
-			tuple_bloom_delete(bloom);
-			return NULL;
+			return -1;
 		}
 		bloom->part_count++;
 		for (uint32_t k = 0; k < count; k++)
-			bloom_add(&bloom->parts[i], hash_arr->values[k]);
+			bloom_add(part, hash_arr->values[k]);
+	}
+	return 0;
+}
+
+/**
+ * Build a fuse filter for each partial key. Note, fuse_create()
+ * sorts hash arrays so no tuples may be added to the builder
+ * after this point.
+ */
+static int
+tuple_bloom_build_fuse(struct tuple_bloom *bloom,
+		       struct tuple_bloom_builder *builder)
+{
+	for (uint32_t i = 0; i < builder->part_count; i++) {
+		struct tuple_hash_array *hash_arr = &builder->parts[i];
+		if (fuse_create(&bloom->parts[i].fuse, hash_arr->values,
+				hash_arr->count) != 0) {
+			diag_set(OutOfMemory, 0, "fuse_create",
+				 "tuple bloom part");
+			return -1;
+		}
+		bloom->part_count++;
+	}
+	return 0;
+}
+
+struct tuple_bloom *
+tuple_bloom_new(struct tuple_bloom_builder *builder,
+		enum tuple_bloom_type type, double fpr)
+{
+	uint32_t part_count = builder->part_count;
+	size_t size = sizeof(struct tuple_bloom) +
+			part_count * sizeof(struct tuple_bloom_part);
+	struct tuple_bloom *bloom = malloc(size);
+	if (bloom == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "tuple bloom");
+		return NULL;
+	}
+
+	bloom->is_legacy = false;
+	bloom->type = type;
+	bloom->part_count = 0;
+
+	int rc;
+	if (type == TUPLE_BLOOM_FUSE)
+		rc = tuple_bloom_build_fuse(bloom, builder);
+	else
+		rc = tuple_bloom_build_classic(bloom, builder, fpr);
+	if (rc != 0) {
+		tuple_bloom_delete(bloom);
+		return NULL;
 	}
 	return bloom;
 }
@@ -195,11 +238,25 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 void
 tuple_bloom_delete(struct tuple_bloom *bloom)
 {
-	for (uint32_t i = 0; i < bloom->part_count; i++)
-		bloom_destroy(&bloom->parts[i]);
+	for (uint32_t i = 0; i < bloom->part_count; i++) {
+		if (bloom->type == TUPLE_BLOOM_FUSE)
+			fuse_destroy(&bloom->parts[i].fuse);
+		else
+			bloom_destroy(&bloom->parts[i].bloom);
+	}
 	free(bloom);
 }
 
+/** Check if a partial key hash is stored in a filter. */
+static inline bool
+tuple_bloom_part_maybe_has(const struct tuple_bloom *bloom, uint32_t i,
+			   uint32_t hash)
+{
+	if (bloom->type == TUPLE_BLOOM_FUSE)
+		return fuse_maybe_has(&bloom->parts[i].fuse, hash);
+	return bloom_maybe_has(&bloom->parts[i].bloom, hash);
+}
+
 bool
 tuple_bloom_maybe_has(const struct tuple_bloom *bloom, struct tuple *tuple,
 		      struct key_def *key_def, int multikey_idx)
@@ -207,7 +264,7 @@ tuple_bloom_maybe_has(const struct tuple_bloom *bloom, struct tuple *tuple,
 	assert(!key_def->is_multikey || multikey_idx != MULTIKEY_NONE);
 
 	if (bloom->is_legacy) {
-		return bloom_maybe_has(&bloom->parts[0],
+		return bloom_maybe_has(&bloom->parts[0].bloom,
 				       tuple_hash(tuple, key_def));
 	}
 
@@ -222,7 +279,7 @@ tuple_bloom_maybe_has(const struct tuple_bloom *bloom, struct tuple *tuple,
 						  &key_def->parts[i],
 						  multikey_idx);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
@@ -236,7 +293,7 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 	if (bloom->is_legacy) {
 		if (part_count < key_def->part_count)
 			return true;
-		return bloom_maybe_has(&bloom->parts[0],
+		return bloom_maybe_has(&bloom->parts[0].bloom,
 				       key_hash(key, key_def));
 	}
 
@@ -251,17 +308,39 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 		total_size += tuple_hash_field(&h, &carry, &key,
 					       key_def->parts[i].coll);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
 }
 
+/*
+ * A bloom filter part is encoded as
+ *   [table_size, hash_count, table]
+ * while a fuse filter part is encoded as
+ *   [seed, segment_length, segment_count, table]
+ * so the filter type can be told by the array size.
+ */
+enum {
+	TUPLE_BLOOM_PART_CLASSIC_LEN = 3,
+	TUPLE_BLOOM_PART_FUSE_LEN = 4,
+};
+
 static size_t
-tuple_bloom_sizeof_part(const struct bloom *part)
+tuple_bloom_sizeof_part(const struct tuple_bloom *bloom, uint32_t i)
 {
 	size_t size = 0;
-	size += mp_sizeof_array(3);
+	if (bloom->type == TUPLE_BLOOM_FUSE) {
+		const struct fuse *part = &bloom->parts[i].fuse;
+		size += mp_sizeof_array(TUPLE_BLOOM_PART_FUSE_LEN);
+		size += mp_sizeof_uint(part->seed);
+		size += mp_sizeof_uint(part->segment_length);
+		size += mp_sizeof_uint(part->segment_count);
+		size += mp_sizeof_bin(fuse_store_size(part));
+		return size;
+	}
+	const struct bloom *part = &bloom->parts[i].bloom;
+	size += mp_sizeof_array(TUPLE_BLOOM_PART_CLASSIC_LEN);
 	size += mp_sizeof_uint(part->table_size);
 	size += mp_sizeof_uint(part->hash_count);
 	size += mp_sizeof_bin(bloom_store_size(part));
@@ -269,9 +348,21 @@ tuple_bloom_sizeof_part(const struct bloom *part)
 }
 
 static char *
-tuple_bloom_encode_part(const struct bloom *part, char *buf)
+tuple_bloom_encode_part(const struct tuple_bloom *bloom, uint32_t i,
+			char *buf)
 {
-	buf = mp_encode_array(buf, 3);
+	if (bloom->type == TUPLE_BLOOM_FUSE) {
+		const struct fuse *part = &bloom->parts[i].fuse;
+		buf = mp_encode_array(buf, TUPLE_BLOOM_PART_FUSE_LEN);
+		buf = mp_encode_uint(buf, part->seed);
+		buf = mp_encode_uint(buf, part->segment_length);
+		buf = mp_encode_uint(buf, part->segment_count);
+		buf = mp_encode_binl(buf, fuse_store_size(part));
+		buf = fuse_store(part, buf);
+		return buf;
+	}
+	const struct bloom *part = &bloom->parts[i].bloom;
+	buf = mp_encode_array(buf, TUPLE_BLOOM_PART_CLASSIC_LEN);
 	buf = mp_encode_uint(buf, part->table_size);
 	buf = mp_encode_uint(buf, part->hash_count);
 	buf = mp_encode_binl(buf, bloom_store_size(part));
@@ -283,8 +374,6 @@ static int
 tuple_bloom_decode_part(struct bloom *part, const char **data)
 {
 	memset(part, 0, sizeof(*part));
-	if (mp_decode_array(data) != 3)
-		unreachable();
 	part->table_size = mp_decode_uint(data);
 	part->hash_count = mp_decode_uint(data);
 	size_t store_size = mp_decode_binl(data);
@@ -298,13 +387,32 @@ tuple_bloom_decode_part(struct bloom *part, const char **data)
 	return 0;
 }
 
+static int
+tuple_bloom_decode_fuse_part(struct fuse *part, const char **data)
+{
+	memset(part, 0, sizeof(*part));
+	part->seed = mp_decode_uint(data);
+	part->segment_length = mp_decode_uint(data);
+	part->segment_count = mp_decode_uint(data);
+	part->table_size = (part->segment_count + 2) * part->segment_length;
+	size_t store_size = mp_decode_binl(data);
+	assert(store_size == fuse_store_size(part));
+	if (fuse_load_table(part, *data) != 0) {
+		diag_set(OutOfMemory, store_size, "fuse_load_table",
+			 "tuple bloom part");
+		return -1;
+	}
+	*data += store_size;
+	return 0;
+}
+
 size_t
 tuple_bloom_size(const struct tuple_bloom *bloom)
 {
 	size_t size = 0;
 	size += mp_sizeof_array(bloom->part_count);
 	for (uint32_t i = 0; i < bloom->part_count; i++)
-		size += tuple_bloom_sizeof_part(&bloom->parts[i]);
+		size += tuple_bloom_sizeof_part(bloom, i);
 	return size;
 }
 
@@ -313,7 +421,7 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf)
 {
 	buf = mp_encode_array(buf, bloom->part_count);
 	for (uint32_t i = 0; i < bloom->part_count; i++)
-		buf = tuple_bloom_encode_part(&bloom->parts[i], buf);
+		buf = tuple_bloom_encode_part(bloom, i, buf);
 	return buf;
 }
 
@@ -331,10 +439,27 @@ tuple_bloom_decode(const char **data)
 	}
 
 	bloom->is_legacy = false;
+	bloom->type = TUPLE_BLOOM_CLASSIC;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
-		if (tuple_bloom_decode_part(&bloom->parts[i], data) != 0) {
+		int rc;
+		switch (mp_decode_array(data)) {
+		case TUPLE_BLOOM_PART_CLASSIC_LEN:
+			assert(bloom->type == TUPLE_BLOOM_CLASSIC);
+			rc = tuple_bloom_decode_part(&bloom->parts[i].bloom,
+						     data);
+			break;
+		case TUPLE_BLOOM_PART_FUSE_LEN:
+			assert(i == 0 || bloom->type == TUPLE_BLOOM_FUSE);
+			bloom->type = TUPLE_BLOOM_FUSE;
+			rc = tuple_bloom_decode_fuse_part(&bloom->parts[i].fuse,
+							  data);
+			break;
+		default:
+			unreachable();
+		}
+		if (rc != 0) {
 			tuple_bloom_delete(bloom);
 			return NULL;
 		}
@@ -355,6 +480,7 @@ tuple_bloom_decode_legacy(const char **data)
 	}
 
 	bloom->is_legacy = true;
+	bloom->type = TUPLE_BLOOM_CLASSIC;
 	bloom->part_count = 1;
 
 	if (mp_decode_array(data) != 4)
@@ -362,12 +488,13 @@ tuple_bloom_decode_legacy(const char **data)
 	if (mp_decode_uint(data) != 0) /* version */
 		unreachable();
 
-	bloom->parts[0].table_size = mp_decode_uint(data);
-	bloom->parts[0].hash_count = mp_decode_uint(data);
+	struct bloom *part = &bloom->parts[0].bloom;
+	part->table_size = mp_decode_uint(data);
+	part->hash_count = mp_decode_uint(data);
 
 	size_t store_size = mp_decode_binl(data);
-	assert(store_size == bloom_store_size(&bloom->parts[0]));
-	if (bloom_load_table(&bloom->parts[0], *data) != 0) {
+	assert(store_size == bloom_store_size(part));
+	if (bloom_load_table(part, *data) != 0) {
 		diag_set(OutOfMemory, store_size, "bloom_load_table",
 			 "tuple bloom part");
 		free(bloom);
@@ -35,6 +35,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "salad/bloom.h"
+#include "salad/fuse.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,6 +44,27 @@ extern "C" {
 struct tuple;
 struct key_def;
 
+/** Type of filters a tuple bloom filter is built of. */
+enum tuple_bloom_type {
+	/** Cache-line-blocked bloom filter, see salad/bloom.h. */
+	TUPLE_BLOOM_CLASSIC,
+	/** Binary fuse filter, see salad/fuse.h. */
+	TUPLE_BLOOM_FUSE,
+	tuple_bloom_type_MAX,
+};
+
+extern const char *tuple_bloom_type_strs[];
+
+/** Filter storing hashes of one partial key. */
+struct tuple_bloom_part {
+	union {
+		/** TUPLE_BLOOM_CLASSIC filter. */
+		struct bloom bloom;
+		/** TUPLE_BLOOM_FUSE filter. */
+		struct fuse fuse;
+	};
+};
+
 /**
  * Tuple bloom filter.
  *
@@ -58,10 +80,12 @@ struct tuple_bloom {
 	 * (see tuple_bloom_decode_legacy).
 	 */
 	bool is_legacy;
+	/** Type of the partial key filters. */
+	enum tuple_bloom_type type;
 	/** Number of key parts. */
 	uint32_t part_count;
-	/** Array of bloom filters, one per each partial key. */
-	struct bloom parts[0];
+	/** Array of filters, one per each partial key. */
+	struct tuple_bloom_part parts[0];
 };
 
 /**
@@ -153,11 +177,15 @@ tuple_bloom_builder_add_key(struct tuple_bloom_builder *builder,
 /**
  * Create a new tuple bloom filter.
  * @param builder - bloom filter builder
- * @param fpr - desired false positive rate
+ * @param type - type of filters to build
+ * @param fpr - desired false positive rate; fuse filters
+ *  have a fixed false positive rate of 1/256 per partial
+ *  key and ignore it
  * @return bloom filter on success or NULL on OOM
  */
 struct tuple_bloom *
-tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr);
+tuple_bloom_new(struct tuple_bloom_builder *builder,
+		enum tuple_bloom_type type, double fpr);
 
 /**
  * Delete a tuple bloom filter.
@@ -212,6 +240,7 @@ tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf);
 
 /**
  * Decode a tuple bloom filter from MsgPack.
+ * The filter type is detected from the encoded data.
  * @param data - pointer to buffer storing encoded bloom filter;
  *  on success it is advanced by the number of decoded bytes
  * @return the decoded bloom on success or NULL on OOM
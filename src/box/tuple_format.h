@@ -193,6 +193,13 @@ struct tuple_format {
 	 * be shared with other ephemeral spaces.
 	 */
 	bool is_ephemeral;
+	/**
+	 * Tuples of this format are stored compactly: fields
+	 * preceded by fixed size fields only don't get offset
+	 * slots in the field map and the engine may use exact
+	 * size allocations.
+	 */
+	bool is_compact;
 	/**
 	 * Size of minimal field map of tuple where each indexed
 	 * field has own offset slot (in bytes). The real tuple
@@ -332,6 +339,8 @@ tuple_format_unref(struct tuple_format *format)
  * @param exact_field_count Exact field count for format.
  * @param is_temporary Set if format belongs to temporary space.
  * @param is_ephemeral Set if format belongs to ephemeral space.
+ * @param is_compact Set if tuples of the format are stored
+ *        compactly, see tuple_format::is_compact.
  *
  * @retval not NULL Tuple format.
  * @retval     NULL Memory error.
@@ -342,7 +351,7 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, uint32_t exact_field_count,
 		 struct tuple_dictionary *dict, bool is_temporary,
-		 bool is_ephemeral);
+		 bool is_ephemeral, bool is_compact);
 
 /**
  * Check, if @a format1 can store any tuples of @a format2. For
@@ -32,6 +32,7 @@
 #include "engine.h"
 #include "tuple.h"
 #include "journal.h"
+#include "iproto_trace.h"
 #include <fiber.h>
 #include "xrow.h"
 
@@ -473,6 +474,11 @@ txn_entry_done_cb(struct journal_entry *entry, void *data)
 {
 	struct txn *txn = data;
 	txn->signature = entry->res;
+	if (txn->fiber != NULL && txn->fiber->storage.net.trace != NULL) {
+		struct iproto_trace *trace = txn->fiber->storage.net.trace;
+		trace->time[IPROTO_TRACE_WAL_WRITE] = entry->write_time;
+		trace->time[IPROTO_TRACE_WAL_SYNC] = entry->sync_time;
+	}
 	/*
 	 * Some commit/rollback triggers require for in_txn fiber
 	 * variable to be set so restore it for the time triggers
@@ -519,6 +525,10 @@ txn_write_to_wal(struct txn *txn)
 	assert(remote_row == req->rows + txn->n_applier_rows);
 	assert(local_row == remote_row + txn->n_new_rows);
 
+	struct iproto_trace *trace = fiber()->storage.net.trace;
+	if (trace != NULL)
+		iproto_trace_mark(trace, IPROTO_TRACE_WAL_SUBMIT);
+
 	/* Send the entry to the journal. */
 	if (journal_write(req) < 0) {
 		diag_set(ClientError, ER_WAL_IO);
@@ -295,6 +295,7 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tx", tx_manager_mem_used(env->xm));
 	info_append_int(h, "level0", lsregion_used(&env->mem_env.allocator));
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
+	info_append_int(h, "page_cache", env->run_env.page_cache.mem_used);
 	info_append_int(h, "page_index", env->lsm_env.page_index_size);
 	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
 	info_table_end(h); /* memory */
@@ -409,6 +410,10 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h); /* bloom */
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "hit", stat->disk.iterator.page_cache_hit);
+	info_append_int(h, "miss", stat->disk.iterator.page_cache_miss);
+	info_table_end(h); /* page_cache */
 	info_table_end(h); /* iterator */
 	info_table_begin(h, "dump");
 	info_append_int(h, "count", stat->disk.dump.count);
@@ -582,6 +587,11 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.compact_tuples) {
+		diag_set(ClientError, ER_ALTER_SPACE, def->name,
+			 "engine does not support compact_tuples flag");
+		return -1;
+	}
 	return 0;
 }
 
@@ -669,6 +679,10 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "functional index");
 		return -1;
 	}
+	if (index_def->opts.hash_layout != HASH_LAYOUT_LIGHT) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl", "hash_layout");
+		return -1;
+	}
 	return 0;
 }
 
@@ -2677,6 +2691,13 @@ vinyl_engine_set_cache(struct engine *engine, size_t quota)
 	vy_cache_env_set_quota(&env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_run_env_set_page_cache_quota(&env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct engine *engine, size_t size)
 {
@@ -2697,6 +2718,13 @@ vinyl_engine_set_max_tuple_size(struct engine *engine, size_t max_size)
 	env->stmt_env.max_tuple_size = max_size;
 }
 
+void
+vinyl_engine_set_lookup_prefetch(struct engine *engine, int prefetch)
+{
+	struct vy_env *env = vy_env(engine);
+	env->lsm_env.lookup_prefetch = prefetch;
+}
+
 void
 vinyl_engine_set_timeout(struct engine *engine, double timeout)
 {
@@ -2915,9 +2943,22 @@ vinyl_engine_end_recovery(struct engine *engine)
 struct vy_join_entry {
 	struct rlist in_ctx;
 	uint32_t space_id;
+	/** Size of the space data, used to balance streams. */
+	size_t bsize;
+	/** Set for system spaces, see engine_vtab::join(). */
+	bool is_system;
 	struct snapshot_iterator *iterator;
 };
 
+/** Part of the read view sent to one stream by one fiber. */
+struct vy_join_stream {
+	/** List of entries sent to the stream. */
+	struct rlist entries;
+	/** Total size of the entries. */
+	size_t bsize;
+	struct xstream *stream;
+};
+
 struct vy_join_ctx {
 	struct rlist entries;
 };
@@ -2940,6 +2981,8 @@ vy_join_add_space(struct space *space, void *arg)
 		return -1;
 	}
 	entry->space_id = space_id(space);
+	entry->bsize = space_bsize(space);
+	entry->is_system = space_is_system(space);
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL) {
 		free(entry);
@@ -2989,19 +3032,17 @@ vy_join_send_tuple(struct xstream *stream, uint32_t space_id,
 }
 
 static int
-vinyl_engine_join(struct engine *engine, void *arg, struct xstream *stream)
+vy_join_send_stream(struct vy_join_stream *js)
 {
-	(void)engine;
 	int loops = 0;
-	struct vy_join_ctx *ctx = arg;
 	struct vy_join_entry *entry;
-	rlist_foreach_entry(entry, &ctx->entries, in_ctx) {
+	rlist_foreach_entry(entry, &js->entries, in_ctx) {
 		struct snapshot_iterator *it = entry->iterator;
 		int rc;
 		uint32_t size;
 		const char *data;
 		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (vy_join_send_tuple(stream, entry->space_id,
+			if (vy_join_send_tuple(js->stream, entry->space_id,
 					       data, size) != 0)
 				return -1;
 		}
@@ -3013,6 +3054,101 @@ vinyl_engine_join(struct engine *engine, void *arg, struct xstream *stream)
 	return 0;
 }
 
+static int
+vy_join_stream_f(va_list ap)
+{
+	struct vy_join_stream *js = va_arg(ap, struct vy_join_stream *);
+	return vy_join_send_stream(js);
+}
+
+static int
+vinyl_engine_join(struct engine *engine, void *arg, bool is_system,
+		  struct xstream **streams, int stream_count)
+{
+	(void)engine;
+	struct vy_join_ctx *ctx = arg;
+	struct vy_join_stream *js = calloc(stream_count, sizeof(*js));
+	if (js == NULL) {
+		diag_set(OutOfMemory, stream_count * sizeof(*js),
+			 "calloc", "struct vy_join_stream");
+		return -1;
+	}
+	for (int i = 0; i < stream_count; i++) {
+		rlist_create(&js[i].entries);
+		js[i].stream = streams[i];
+	}
+	/*
+	 * Distribute spaces among streams so that the streams
+	 * carry about the same amount of data.
+	 */
+	struct vy_join_entry *entry, *next;
+	rlist_foreach_entry_safe(entry, &ctx->entries, in_ctx, next) {
+		if (entry->is_system != is_system)
+			continue;
+		int k = 0;
+		for (int i = 1; i < stream_count; i++) {
+			if (js[i].bsize < js[k].bsize)
+				k = i;
+		}
+		js[k].bsize += entry->bsize;
+		rlist_move_tail_entry(&js[k].entries, entry, in_ctx);
+	}
+	/*
+	 * Snapshot iterators read disk in reader threads, so
+	 * feeding each stream from its own fiber lets streams
+	 * wait for disk concurrently. The first stream is fed
+	 * by the caller.
+	 */
+	int rc = 0;
+	struct fiber **fibers = calloc(stream_count, sizeof(*fibers));
+	if (fibers == NULL) {
+		diag_set(OutOfMemory, stream_count * sizeof(*fibers),
+			 "calloc", "struct fiber");
+		rc = -1;
+		goto out;
+	}
+	for (int i = 1; i < stream_count; i++) {
+		if (rlist_empty(&js[i].entries))
+			continue;
+		fibers[i] = fiber_new("vinyl.join", vy_join_stream_f);
+		if (fibers[i] == NULL) {
+			rc = -1;
+			break;
+		}
+		fiber_set_joinable(fibers[i], true);
+		fiber_start(fibers[i], &js[i]);
+	}
+	if (rc == 0 && vy_join_send_stream(&js[0]) != 0)
+		rc = -1;
+	/*
+	 * Joining a failed fiber moves its error to the caller
+	 * so keep the original one to report it.
+	 */
+	struct diag diag;
+	diag_create(&diag);
+	if (rc != 0)
+		diag_move(diag_get(), &diag);
+	for (int i = 1; i < stream_count; i++) {
+		if (fibers[i] == NULL)
+			continue;
+		if (rc != 0)
+			fiber_cancel(fibers[i]);
+		if (fiber_join(fibers[i]) != 0 && rc == 0) {
+			rc = -1;
+			diag_move(diag_get(), &diag);
+		}
+	}
+	if (rc != 0)
+		diag_move(&diag, diag_get());
+	diag_destroy(&diag);
+	free(fibers);
+out:
+	for (int i = 0; i < stream_count; i++)
+		rlist_splice_tail(&ctx->entries, &js[i].entries);
+	free(js);
+	return rc;
+}
+
 static void
 vinyl_engine_complete_join(struct engine *engine, void *arg)
 {
@@ -4513,6 +4649,7 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .drop_primary_key = */ generic_space_drop_primary_key,
 	/* .check_format = */ vinyl_space_check_format,
 	/* .build_index = */ vinyl_space_build_index,
+	/* .bulk_load = */ generic_space_bulk_load,
 	/* .swap_index = */ vinyl_space_swap_index,
 	/* .prepare_alter = */ vinyl_space_prepare_alter,
 	/* .invalidate = */ vinyl_space_invalidate,
@@ -4535,6 +4672,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_batch = */ generic_index_get_batch,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -57,6 +57,12 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct engine *engine, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -69,6 +75,12 @@ vinyl_engine_set_memory(struct engine *engine, size_t size);
 void
 vinyl_engine_set_max_tuple_size(struct engine *engine, size_t max_size);
 
+/**
+ * Update the number of slices read ahead by point lookups.
+ */
+void
+vinyl_engine_set_lookup_prefetch(struct engine *engine, int prefetch);
+
 /**
  * Update query timeout.
  */
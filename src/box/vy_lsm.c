@@ -87,6 +87,7 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 	env->upsert_thresh_cb = upsert_thresh_cb;
 	env->upsert_thresh_arg = upsert_thresh_arg;
 	env->too_long_threshold = TIMEOUT_INFINITY;
+	env->lookup_prefetch = 0;
 	env->lsm_count = 0;
 	mempool_create(&env->history_node_pool, cord_slab_cache(),
 		       sizeof(struct vy_history_node));
@@ -79,6 +79,11 @@ struct vy_lsm_env {
 	 * the given value, warn about it in the log.
 	 */
 	double too_long_threshold;
+	/**
+	 * Number of older slices a point lookup reads ahead
+	 * while reading a newer one, see vy_point_lookup().
+	 */
+	int lookup_prefetch;
 	/**
 	 * Callback invoked when the number of upserts for
 	 * the same key exceeds VY_UPSERT_THRESHOLD.
@@ -153,11 +153,119 @@ vy_point_lookup_scan_slice(struct vy_lsm *lsm, struct vy_slice *slice,
 	return rc;
 }
 
+/**
+ * Lookup of a key in one slice. Lookups in older slices may be
+ * done by separate fibers while a newer slice is being read.
+ */
+struct vy_point_lookup_task {
+	struct vy_lsm *lsm;
+	struct vy_slice *slice;
+	const struct vy_read_view **rv;
+	struct vy_entry key;
+	/** Statements found in the slice. */
+	struct vy_history history;
+	/** Fiber doing the lookup or NULL. */
+	struct fiber *fiber;
+	/** Result of the lookup done by the fiber. */
+	int rc;
+	/** Error of the lookup done by the fiber. */
+	struct diag diag;
+};
+
+static void
+vy_point_lookup_task_create(struct vy_point_lookup_task *task,
+			    struct vy_lsm *lsm, struct vy_slice *slice,
+			    const struct vy_read_view **rv,
+			    struct vy_entry key)
+{
+	task->lsm = lsm;
+	task->slice = slice;
+	task->rv = rv;
+	task->key = key;
+	vy_history_create(&task->history, &lsm->env->history_node_pool);
+	task->fiber = NULL;
+	task->rc = 0;
+	diag_create(&task->diag);
+}
+
+static void
+vy_point_lookup_task_destroy(struct vy_point_lookup_task *task)
+{
+	assert(task->fiber == NULL);
+	vy_history_cleanup(&task->history);
+	diag_destroy(&task->diag);
+}
+
+static int
+vy_point_lookup_task_f(va_list ap)
+{
+	struct vy_point_lookup_task *task =
+		va_arg(ap, struct vy_point_lookup_task *);
+	task->rc = vy_point_lookup_scan_slice(task->lsm, task->slice,
+					      task->rv, task->key,
+					      &task->history);
+	if (task->rc != 0)
+		diag_move(diag_get(), &task->diag);
+	return 0;
+}
+
+/** Start the lookup in a new fiber. */
+static void
+vy_point_lookup_task_start(struct vy_point_lookup_task *task)
+{
+	struct fiber *fiber = fiber_new("vinyl.lookup", vy_point_lookup_task_f);
+	if (fiber == NULL) {
+		/* Not a big deal, the caller will do the lookup. */
+		return;
+	}
+	fiber_set_joinable(fiber, true);
+	task->fiber = fiber;
+	fiber_start(fiber, task);
+}
+
+/**
+ * Wait for the lookup to complete if it was started or do it
+ * in the caller otherwise.
+ */
+static int
+vy_point_lookup_task_wait(struct vy_point_lookup_task *task)
+{
+	if (task->fiber == NULL) {
+		return vy_point_lookup_scan_slice(task->lsm, task->slice,
+						  task->rv, task->key,
+						  &task->history);
+	}
+	fiber_join(task->fiber);
+	task->fiber = NULL;
+	if (task->rc != 0)
+		diag_move(&task->diag, diag_get());
+	return task->rc;
+}
+
+/**
+ * Return false if the bloom filter of the run of a slice rules
+ * out statements for the key, true otherwise.
+ */
+static bool
+vy_point_lookup_slice_maybe_has(struct vy_lsm *lsm, struct vy_slice *slice,
+				struct vy_entry key)
+{
+	const struct tuple_bloom *bloom = slice->run->info.bloom;
+	return bloom == NULL || vy_bloom_maybe_has(bloom, key, lsm->key_def);
+}
+
 /**
  * Find a range and scan all slices that belongs to the range.
  * Add found statements to the history list up to terminal statement.
  * All slices are pinned before first slice scan, so it's guaranteed
  * that complete history from runs will be extracted.
+ *
+ * While a slice is being read, lookups in up to lookup_prefetch
+ * older slices are done by separate fibers so that their disk
+ * reads are issued concurrently. Slices whose bloom filters rule
+ * the key out are skipped, as there's nothing to read in them.
+ * The result of such a lookup is thrown away if a newer slice
+ * has a terminal statement.
  */
 static int
 vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
@@ -174,18 +282,55 @@ vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
 			 "region", "slices array");
 		return -1;
 	}
+	struct vy_point_lookup_task *tasks = (struct vy_point_lookup_task *)
+		region_alloc(&fiber()->gc, slice_count * sizeof(*tasks));
+	if (tasks == NULL) {
+		diag_set(OutOfMemory, slice_count * sizeof(*tasks),
+			 "region", "lookup tasks array");
+		return -1;
+	}
 	int i = 0;
 	struct vy_slice *slice;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
 		vy_slice_pin(slice);
+		vy_point_lookup_task_create(&tasks[i], lsm, slice, rv, key);
 		slices[i++] = slice;
 	}
 	assert(i == slice_count);
+	/*
+	 * Without reader threads disk reads block the whole
+	 * thread, so there's no point in reading ahead.
+	 */
+	int prefetch = lsm->env->lookup_prefetch;
+	if (slice_count > 0 && slices[0]->run->env->reader_pool == NULL)
+		prefetch = 0;
 	int rc = 0;
+	int next = 0;
+	/* Number of lookups started in slices after the current one. */
+	int ahead = 0;
 	for (i = 0; i < slice_count; i++) {
-		if (rc == 0 && !vy_history_is_terminal(history))
-			rc = vy_point_lookup_scan_slice(lsm, slices[i],
-							rv, key, history);
+		struct vy_point_lookup_task *task = &tasks[i];
+		if (task->fiber != NULL)
+			ahead--;
+		if (rc == 0 && !vy_history_is_terminal(history)) {
+			for (next = MAX(next, i + 1);
+			     next < slice_count && ahead < prefetch; next++) {
+				struct vy_point_lookup_task *t = &tasks[next];
+				if (!vy_point_lookup_slice_maybe_has(lsm,
+							t->slice, key))
+					continue;
+				vy_point_lookup_task_start(t);
+				if (t->fiber != NULL)
+					ahead++;
+			}
+			rc = vy_point_lookup_task_wait(task);
+			vy_history_splice(history, &task->history);
+		} else if (task->fiber != NULL) {
+			/* The result isn't needed, but the slice is in use. */
+			fiber_join(task->fiber);
+			task->fiber = NULL;
+		}
+		vy_point_lookup_task_destroy(task);
 		vy_slice_unpin(slices[i]);
 	}
 	return rc;
@@ -111,6 +111,166 @@ struct vy_page_read_task {
 	struct vy_page *page;
 };
 
+static void
+vy_page_delete(struct vy_page *page);
+
+/* {{{ Page cache */
+
+struct vy_page_cache_key {
+	int64_t run_id;
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = ((uint64_t)run_id << 32 | page_no) * 0x9E3779B97F4A7C15ULL;
+	return (uint32_t)(h >> 32);
+}
+
+#define mh_name _vy_page_cache
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) (vy_page_cache_hash((*(a))->run_id, (*(a))->page_no))
+#define mh_hash_key(a, arg) (vy_page_cache_hash((a)->run_id, (a)->page_no))
+#define mh_cmp(a, b, arg) ((*(a))->run_id != (*(b))->run_id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run_id || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Amount of memory occupied by a page. */
+static inline size_t
+vy_page_mem_used(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(uint32_t);
+}
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	cache->hash = mh_vy_page_cache_new();
+	if (cache->hash == NULL)
+		panic("failed to allocate vinyl page cache");
+	rlist_create(&cache->lru);
+	cache->mem_used = 0;
+	cache->mem_quota = 0;
+}
+
+/** Remove a page from the cache. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page)
+{
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_cache_del(cache->hash, k, NULL);
+	rlist_del_entry(page, in_cache);
+	assert(cache->mem_used >= vy_page_mem_used(page));
+	cache->mem_used -= vy_page_mem_used(page);
+	vy_page_unref(page);
+}
+
+/** Evict least recently used pages until the quota is met. */
+static void
+vy_page_cache_shrink(struct vy_page_cache *cache)
+{
+	while (cache->mem_used > cache->mem_quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_last_entry(&cache->lru,
+						struct vy_page, in_cache);
+		vy_page_cache_evict(cache, page);
+	}
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	cache->mem_quota = 0;
+	vy_page_cache_shrink(cache);
+	mh_vy_page_cache_delete(cache->hash);
+}
+
+/**
+ * Look up a page in the cache. On success, the page is
+ * moved to the head of the LRU list and referenced.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache,
+		  int64_t run_id, uint32_t page_no)
+{
+	if (mh_size(cache->hash) == 0)
+		return NULL;
+	struct vy_page_cache_key key = { run_id, page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	if (k == mh_end(cache->hash))
+		return NULL;
+	struct vy_page *page = *mh_vy_page_cache_node(cache->hash, k);
+	rlist_move_entry(&cache->lru, page, in_cache);
+	vy_page_ref(page);
+	return page;
+}
+
+/**
+ * Add a page that has just been read from disk to the cache.
+ * The page is silently skipped if it doesn't fit in the quota,
+ * if another fiber has already cached the same page while we
+ * were reading it, or if we fail to allocate memory.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(rlist_empty(&page->in_cache));
+	size_t size = vy_page_mem_used(page);
+	if (size > cache->mem_quota)
+		return;
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	if (k != mh_end(cache->hash))
+		return;
+	k = mh_vy_page_cache_put(cache->hash, &page, NULL, NULL);
+	if (k == mh_end(cache->hash))
+		return;
+	vy_page_ref(page);
+	rlist_add_entry(&cache->lru, page, in_cache);
+	cache->mem_used += size;
+	vy_page_cache_shrink(cache);
+}
+
+/** Drop all cached pages of a run. */
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	for (uint32_t page_no = 0; page_no < run->info.page_count &&
+	     mh_size(cache->hash) > 0; page_no++) {
+		struct vy_page_cache_key key = { run->id, page_no };
+		mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+		if (k != mh_end(cache->hash))
+			vy_page_cache_evict(cache,
+				*mh_vy_page_cache_node(cache->hash, k));
+	}
+}
+
+/* }}} Page cache */
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -183,6 +343,7 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	vy_page_cache_create(&env->page_cache);
 }
 
 /**
@@ -195,6 +356,7 @@ vy_run_env_destroy(struct vy_run_env *env)
 		vy_run_env_stop_readers(env);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
+	vy_page_cache_destroy(&env->page_cache);
 }
 
 /**
@@ -208,6 +370,13 @@ vy_run_env_enable_coio(struct vy_run_env *env)
 	vy_run_env_start_readers(env);
 }
 
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	env->page_cache.mem_quota = quota;
+	vy_page_cache_shrink(&env->page_cache);
+}
+
 /**
  * Execute a task on behalf of a reader thread.
  */
@@ -317,6 +486,7 @@ vy_run_delete(struct vy_run *run)
 	assert(run->refs == 0);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
+	vy_page_cache_purge_run(&run->env->page_cache, run);
 	vy_run_clear(run);
 	TRASH(run);
 	free(run);
@@ -679,6 +849,7 @@ vy_run_info_decode(struct vy_run_info *run_info,
 				return -1;
 			break;
 		case VY_RUN_INFO_BLOOM:
+		case VY_RUN_INFO_BLOOM_FUSE:
 			run_info->bloom = tuple_bloom_decode(&pos);
 			if (run_info->bloom == NULL)
 				return -1;
@@ -711,6 +882,10 @@ vy_page_new(const struct vy_page_info *page_info)
 			 "load_page", "page cache");
 		return NULL;
 	}
+	page->run_id = 0;
+	page->page_no = 0;
+	page->refs = 1;
+	rlist_create(&page->in_cache);
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
@@ -735,6 +910,7 @@ vy_page_new(const struct vy_page_info *page_info)
 static void
 vy_page_delete(struct vy_page *page)
 {
+	assert(rlist_empty(&page->in_cache));
 	uint32_t *row_index = page->row_index;
 	char *data = page->data;
 #if !defined(NDEBUG)
@@ -832,9 +1008,9 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr = vy_entry_none();
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 }
@@ -995,45 +1171,27 @@ vy_page_read_cb(struct cbus_call_msg *base)
 }
 
 /**
- * Read a page from disk given its number.
- * The function caches two most recently read pages.
+ * Read a page from disk given its number and add it to the
+ * page cache.
  *
- * @retval 0 success
- * @retval -1 critical error
+ * @retval the page on success
+ * @retval NULL on critical error
  */
-static NODISCARD int
-vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+static struct vy_page *
+vy_run_iterator_read_page(struct vy_run_iterator *itr, uint32_t page_no,
 			  struct vy_entry key, enum iterator_type iterator_type,
-			  struct vy_page **result, uint32_t *pos_in_page,
-			  bool *equal_found)
+			  uint32_t *pos_in_page, bool *equal_found)
 {
 	struct vy_slice *slice = itr->slice;
 	struct vy_run_env *env = slice->run->env;
 
-	/* Check cache */
-	struct vy_page *page = NULL;
-	if (itr->curr_page != NULL &&
-	    itr->curr_page->page_no == page_no) {
-		page = itr->curr_page;
-	} else if (itr->prev_page != NULL &&
-		   itr->prev_page->page_no == page_no) {
-		SWAP(itr->prev_page, itr->curr_page);
-		page = itr->curr_page;
-	}
-	if (page != NULL) {
-		if (key.stmt != NULL)
-			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
-							itr->format, iterator_type,
-							equal_found);
-		*result = page;
-		return 0;
-	}
-
 	/* Allocate buffers */
 	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	page = vy_page_new(page_info);
+	struct vy_page *page = vy_page_new(page_info);
 	if (page == NULL)
-		return -1;
+		return NULL;
+	page->run_id = slice->run->id;
+	page->page_no = page_no;
 
 	/* Read page data from the disk */
 	struct vy_page_read_task *task = mempool_alloc(&env->read_task_pool);
@@ -1041,7 +1199,7 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		diag_set(OutOfMemory, sizeof(*task),
 			 "mempool", "vy_page_read_task");
 		vy_page_delete(page);
-		return -1;
+		return NULL;
 	}
 	task->run = slice->run;
 	task->page_info = page_info;
@@ -1061,21 +1219,79 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	mempool_free(&env->read_task_pool, task);
 	if (rc != 0) {
 		vy_page_delete(page);
-		return -1;
+		return NULL;
 	}
 
-	/* Update cache */
-	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
-	itr->prev_page = itr->curr_page;
-	itr->curr_page = page;
-	page->page_no = page_no;
+	vy_page_cache_put(&env->page_cache, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
 	itr->stat->read.bytes += page_info->unpacked_size;
 	itr->stat->read.bytes_compressed += page_info->size;
 	itr->stat->read.pages++;
+	return page;
+}
+
+/**
+ * Load a page given its number.
+ * The function caches two most recently read pages in the
+ * iterator. Other pages are looked up in the page cache shared
+ * by all iterators and read from disk on cache miss.
+ *
+ * @retval 0 success
+ * @retval -1 critical error
+ */
+static NODISCARD int
+vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+			  struct vy_entry key, enum iterator_type iterator_type,
+			  struct vy_page **result, uint32_t *pos_in_page,
+			  bool *equal_found)
+{
+	struct vy_run *run = itr->slice->run;
+
+	/* Check cache */
+	struct vy_page *page = NULL;
+	if (itr->curr_page != NULL &&
+	    itr->curr_page->page_no == page_no) {
+		page = itr->curr_page;
+	} else if (itr->prev_page != NULL &&
+		   itr->prev_page->page_no == page_no) {
+		SWAP(itr->prev_page, itr->curr_page);
+		page = itr->curr_page;
+	}
+	if (page != NULL) {
+		if (key.stmt != NULL)
+			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
+							itr->format, iterator_type,
+							equal_found);
+		*result = page;
+		return 0;
+	}
+
+	struct vy_page_cache *page_cache = &run->env->page_cache;
+	page = vy_page_cache_get(page_cache, run->id, page_no);
+	if (page != NULL) {
+		itr->stat->page_cache_hit++;
+		if (key.stmt != NULL)
+			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
+							itr->format, iterator_type,
+							equal_found);
+	} else {
+		/* Don't count misses if the cache is disabled. */
+		if (page_cache->mem_quota > 0)
+			itr->stat->page_cache_miss++;
+		page = vy_run_iterator_read_page(itr, page_no, key,
+						 iterator_type, pos_in_page,
+						 equal_found);
+		if (page == NULL)
+			return -1;
+	}
+
+	/* Update cache */
+	if (itr->prev_page != NULL)
+		vy_page_unref(itr->prev_page);
+	itr->prev_page = itr->curr_page;
+	itr->curr_page = page;
 
 	*result = page;
 	return 0;
@@ -1995,8 +2211,16 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 		mp_sizeof_uint(run_info->max_lsn);
 	size += mp_sizeof_uint(VY_RUN_INFO_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->page_count);
+	/*
+	 * Fuse filters are stored under a separate key, which
+	 * older versions skip rather than fail to decode.
+	 */
+	uint32_t bloom_key = VY_RUN_INFO_BLOOM;
+	if (run_info->bloom != NULL &&
+	    run_info->bloom->type == TUPLE_BLOOM_FUSE)
+		bloom_key = VY_RUN_INFO_BLOOM_FUSE;
 	if (run_info->bloom != NULL)
-		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
+		size += mp_sizeof_uint(bloom_key) +
 			tuple_bloom_size(run_info->bloom);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
@@ -2023,7 +2247,7 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->page_count);
 	if (run_info->bloom != NULL) {
-		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
+		pos = mp_encode_uint(pos, bloom_key);
 		pos = tuple_bloom_encode(run_info->bloom, pos);
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
@@ -2107,7 +2331,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr, bool no_compression)
+		     uint64_t page_size, double bloom_fpr,
+		     enum tuple_bloom_type bloom_type, bool no_compression)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2118,6 +2343,7 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->key_def = key_def;
 	writer->page_size = page_size;
 	writer->bloom_fpr = bloom_fpr;
+	writer->bloom_type = bloom_type;
 	writer->no_compression = no_compression;
 	if (bloom_fpr < 1) {
 		writer->bloom = tuple_bloom_builder_new(key_def->part_count);
@@ -2357,6 +2583,7 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 
 	if (writer->bloom != NULL) {
 		run->info.bloom = tuple_bloom_new(writer->bloom,
+						  writer->bloom_type,
 						  writer->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto out;
@@ -2505,6 +2732,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 
 	if (bloom_builder != NULL) {
 		run->info.bloom = tuple_bloom_new(bloom_builder,
+						  opts->bloom_type,
 						  opts->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto close_err;
@@ -44,6 +44,7 @@
 #include "xlog.h"
 
 #include "small/mempool.h"
+#include "small/rlist.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -51,6 +52,22 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct mh_vy_page_cache_t;
+
+/**
+ * Cache of decompressed run pages shared by all run iterators.
+ * Pages are evicted in LRU order when the memory limit is hit.
+ */
+struct vy_page_cache {
+	/** Cached pages, keyed by run id and page number. */
+	struct mh_vy_page_cache_t *hash;
+	/** Cached pages, most recently used first. */
+	struct rlist lru;
+	/** Memory used by cached pages, in bytes. */
+	size_t mem_used;
+	/** Max memory that may be used by cached pages. */
+	size_t mem_quota;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -69,6 +86,8 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of recently read pages. */
+	struct vy_page_cache page_cache;
 };
 
 /**
@@ -287,8 +306,17 @@ struct vy_run_iterator {
  * Vinyl page stored in memory.
  */
 struct vy_page {
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
 	/** Page position in the run file. */
 	uint32_t page_no;
+	/**
+	 * Number of run iterators using the page plus one
+	 * if the page is cached.
+	 */
+	int refs;
+	/** Link in vy_page_cache::lru, empty if not cached. */
+	struct rlist in_cache;
 	/** Size of page data in memory, i.e. unpacked. */
 	uint32_t unpacked_size;
 	/** Number of statements in the page. */
@@ -330,6 +358,14 @@ vy_run_env_destroy(struct vy_run_env *env);
 void
 vy_run_env_enable_coio(struct vy_run_env *env);
 
+/**
+ * Set the max memory that may be used for caching pages read
+ * from disk. Evicts pages if the new limit is exceeded. Zero
+ * disables the cache.
+ */
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota);
+
 /**
  * Return the size of a run bloom filter.
  */
@@ -618,6 +654,8 @@ struct vy_run_writer {
 	struct xlog data_xlog;
 	/** Bloom filter false positive rate. */
 	double bloom_fpr;
+	/** Type of the bloom filter. */
+	enum tuple_bloom_type bloom_type;
 	/** Bloom filter. */
 	struct tuple_bloom_builder *bloom;
 	/** Buffer of a current page row offsets. */
@@ -634,7 +672,8 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr, bool no_compression);
+		     uint64_t page_size, double bloom_fpr,
+		     enum tuple_bloom_type bloom_type, bool no_compression);
 
 /**
  * Write a specified statement into a run.
@@ -203,6 +203,7 @@ struct vy_task {
 	 * from another thread.
 	 */
 	double bloom_fpr;
+	enum tuple_bloom_type bloom_type;
 	int64_t page_size;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
@@ -1060,7 +1061,7 @@ vy_task_write_run(struct vy_task *task, bool no_compression)
 				 lsm->space_id, lsm->index_id,
 				 task->cmp_def, task->key_def,
 				 task->page_size, task->bloom_fpr,
-				 no_compression) != 0)
+				 task->bloom_type, no_compression) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -1389,6 +1390,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	task->new_run = new_run;
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->bloom_type = lsm->opts.bloom_type;
 	task->page_size = lsm->opts.page_size;
 
 	lsm->is_dumping = true;
@@ -1684,6 +1686,7 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	task->new_run = new_run;
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->bloom_type = lsm->opts.bloom_type;
 	task->page_size = lsm->opts.page_size;
 
 	/*
@@ -94,6 +94,10 @@ struct vy_run_iterator_stat {
 	 * prevent a disk read.
 	 */
 	int64_t bloom_miss;
+	/** Number of page reads served from the page cache. */
+	int64_t page_cache_hit;
+	/** Number of page reads that had to go to disk. */
+	int64_t page_cache_miss;
 	/**
 	 * Number of statements actually read from the disk.
 	 * It may be greater than the number of statements
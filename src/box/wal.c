@@ -32,6 +32,7 @@
 
 #include "vclock.h"
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "fio.h"
 #include "errinj.h"
 #include "error.h"
@@ -39,11 +40,15 @@
 
 #include "xlog.h"
 #include "xrow.h"
+#include "xrow_ring.h"
 #include "vy_log.h"
 #include "cbus.h"
 #include "coio_task.h"
+#include "latency.h"
 #include "replication.h"
 
+#include <pmatomic.h>
+
 enum {
 	/**
 	 * Size of disk space to preallocate with xlog_fallocate().
@@ -91,6 +96,18 @@ struct wal_writer
 	struct cpipe wal_pipe;
 	/** A memory pool for messages. */
 	struct mempool msg_pool;
+	/**
+	 * Group commit delay: the time a batch is kept in
+	 * the pipe input waiting for more transactions.
+	 */
+	double commit_delay;
+	/**
+	 * Approximate batch size reaching which the batch is
+	 * flushed to the WAL thread without waiting.
+	 */
+	int64_t batch_max_size;
+	/** Flushes the pipe input when commit_delay expires. */
+	struct ev_timer commit_timer;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - wal_max_size */
 	int64_t wal_max_size;
@@ -142,6 +159,14 @@ struct wal_writer
 	bool checkpoint_triggered;
 	/** The current WAL file. */
 	struct xlog current_wal;
+	/** A setting from instance configuration - wal_relay_buffer_size */
+	int64_t relay_buffer_size;
+	/**
+	 * Rows recently written to WAL, sent by relays of
+	 * replicas which keep up with the master without
+	 * reading xlog files. NULL if the buffer is disabled.
+	 */
+	struct xrow_ring *relay_buffer;
 	/**
 	 * Used if there was a WAL I/O error and we need to
 	 * keep adding all incoming requests to the rollback
@@ -154,6 +179,47 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * In fsync mode, batches written to the current WAL
+	 * which wait for the next fdatasync() round before they
+	 * are sent back to tx. Formatting and writing of new
+	 * batches goes on while a round is in progress.
+	 */
+	struct stailq sync_queue;
+	/** Batches covered by the fdatasync() in progress. */
+	struct stailq sync_inflight;
+	/**
+	 * Duplicate of the WAL file descriptor synced in a
+	 * coio thread, -1 if no fdatasync() is in progress.
+	 */
+	int sync_fd;
+	/** Signaled when an fdatasync() round is complete. */
+	struct fiber_cond sync_cond;
+	/**
+	 * Set if a rollback has been started in fsync mode. The
+	 * rollback message is sent to tx as soon as the failed
+	 * batch and all batches written before it are synced and
+	 * sent back. Batches rolled back after it have nothing to
+	 * sync and don't hold the rollback.
+	 */
+	bool sync_rollback_pending;
+	/** Time when the fdatasync() in progress was started. */
+	double sync_start;
+	/**
+	 * Statistics of written batches, see struct wal_stat.
+	 * Accessed by the WAL thread after calling
+	 * wal_writer_check_stat_reset().
+	 */
+	int64_t stat_batches;
+	int64_t stat_rows;
+	int64_t stat_bytes;
+	int64_t stat_syncs;
+	/** Latency of fdatasync() rounds. */
+	struct latency sync_latency;
+	/** Incremented by tx on wal_reset_stat(). */
+	unsigned stat_reset_gen;
+	/** Value of stat_reset_gen the statistics are reset at. */
+	unsigned stat_gen;
 };
 
 struct wal_msg {
@@ -169,6 +235,8 @@ struct wal_msg {
 	struct stailq rollback;
 	/** vclock after the batch processed. */
 	struct vclock vclock;
+	/** Link in wal_writer::sync_queue. */
+	struct stailq_entry in_sync;
 };
 
 /**
@@ -199,10 +267,27 @@ static struct cmsg_hop wal_request_route[] = {
 	{tx_schedule_commit, NULL},
 };
 
+/**
+ * In fsync mode a batch is not sent back to tx right after
+ * it has been written: it waits for fdatasync() first, see
+ * wal_writer_sync_batch(), and then follows wal_commit_route.
+ */
+static struct cmsg_hop wal_request_fsync_route[] = {
+	{wal_write_to_disk, NULL},
+};
+
+static struct cmsg_hop wal_commit_route[] = {
+	{tx_schedule_commit, NULL},
+};
+
+static void
+wal_writer_sync_wait(struct wal_writer *writer);
+
 static void
 wal_msg_create(struct wal_msg *batch)
 {
-	cmsg_init(&batch->base, wal_request_route);
+	cmsg_init(&batch->base, wal_mode() == WAL_FSYNC ?
+		  wal_request_fsync_route : wal_request_route);
 	batch->approx_len = 0;
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
@@ -212,7 +297,9 @@ wal_msg_create(struct wal_msg *batch)
 static struct wal_msg *
 wal_msg(struct cmsg *msg)
 {
-	return msg->route == wal_request_route ? (struct wal_msg *) msg : NULL;
+	return msg->route == wal_request_route ||
+	       msg->route == wal_request_fsync_route ?
+	       (struct wal_msg *) msg : NULL;
 }
 
 /** Write a request to a log in a single transaction. */
@@ -340,15 +427,27 @@ tx_notify_checkpoint(struct cmsg *msg)
  * encapsulate the details just in case we may use
  * more writers in the future.
  */
+static void
+wal_commit_timer_cb(struct ev_loop *loop, struct ev_timer *timer, int events)
+{
+	(void)loop;
+	(void)events;
+	struct wal_writer *writer = (struct wal_writer *)timer->data;
+	cpipe_flush_input(&writer->wal_pipe);
+}
+
 static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
-		  const char *wal_dirname,
-		  int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+		  const char *wal_dirname, int64_t wal_max_size,
+		  int64_t relay_buffer_size, const struct tt_uuid *instance_uuid,
 		  wal_on_garbage_collection_f on_garbage_collection,
 		  wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
 	writer->wal_mode = wal_mode;
 	writer->wal_max_size = wal_max_size;
+	writer->relay_buffer_size = wal_mode == WAL_NONE ? 0 :
+				    relay_buffer_size;
+	writer->relay_buffer = NULL;
 	journal_create(&writer->base, wal_mode == WAL_NONE ?
 		       wal_write_in_wal_mode_none : wal_write, NULL);
 
@@ -356,8 +455,6 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	opts.sync_is_async = true;
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid, &opts);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
 
 	stailq_create(&writer->rollback);
 	cmsg_init(&writer->in_rollback, NULL);
@@ -370,6 +467,26 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	vclock_create(&writer->checkpoint_vclock);
 	rlist_create(&writer->watchers);
 
+	stailq_create(&writer->sync_queue);
+	stailq_create(&writer->sync_inflight);
+	writer->sync_fd = -1;
+	fiber_cond_create(&writer->sync_cond);
+	writer->sync_rollback_pending = false;
+	writer->sync_start = 0;
+	writer->stat_batches = 0;
+	writer->stat_rows = 0;
+	writer->stat_bytes = 0;
+	writer->stat_syncs = 0;
+	writer->stat_reset_gen = 0;
+	writer->stat_gen = 0;
+	if (latency_create(&writer->sync_latency) != 0)
+		panic("failed to allocate WAL latency histogram");
+
+	writer->commit_delay = 0;
+	writer->batch_max_size = INT64_MAX;
+	ev_timer_init(&writer->commit_timer, wal_commit_timer_cb, 0, 0);
+	writer->commit_timer.data = writer;
+
 	writer->on_garbage_collection = on_garbage_collection;
 	writer->on_checkpoint_threshold = on_checkpoint_threshold;
 
@@ -381,7 +498,13 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 static void
 wal_writer_destroy(struct wal_writer *writer)
 {
+	fiber_cond_destroy(&writer->sync_cond);
+	latency_destroy(&writer->sync_latency);
 	xdir_destroy(&writer->wal_dir);
+	if (writer->relay_buffer != NULL) {
+		xrow_ring_destroy(writer->relay_buffer);
+		free(writer->relay_buffer);
+	}
 }
 
 /** WAL writer thread routine. */
@@ -459,15 +582,16 @@ wal_open(struct wal_writer *writer)
 
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
-	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+	 int64_t wal_max_size, int64_t relay_buffer_size,
+	 const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
 	/* Initialize the state. */
 	struct wal_writer *writer = &wal_writer_singleton;
-	wal_writer_create(writer, wal_mode, wal_dirname,
-			  wal_max_size, instance_uuid, on_garbage_collection,
-			  on_checkpoint_threshold);
+	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_size,
+			  relay_buffer_size, instance_uuid,
+			  on_garbage_collection, on_checkpoint_threshold);
 
 	/* Start WAL thread. */
 	if (cord_costart(&writer->cord, "wal", wal_writer_f, NULL) != 0)
@@ -499,16 +623,42 @@ wal_enable(void)
 	if (wal_open(writer) != 0)
 		return -1;
 
+	/*
+	 * Rows are buffered for relays starting from the
+	 * first row written after recovery.
+	 */
+	if (writer->relay_buffer_size > 0) {
+		struct xrow_ring *ring = malloc(sizeof(*ring));
+		if (ring == NULL) {
+			diag_set(OutOfMemory, sizeof(*ring), "malloc",
+				 "struct xrow_ring");
+			return -1;
+		}
+		if (xrow_ring_create(ring, writer->relay_buffer_size,
+				     &writer->vclock) != 0) {
+			free(ring);
+			return -1;
+		}
+		writer->relay_buffer = ring;
+	}
+
 	/* Enable journalling. */
 	journal_set(&writer->base);
 	return 0;
 }
 
+struct xrow_ring *
+wal_relay_buffer(void)
+{
+	return wal_writer_singleton.relay_buffer;
+}
+
 void
 wal_free(void)
 {
 	struct wal_writer *writer = &wal_writer_singleton;
 
+	ev_timer_stop(loop(), &writer->commit_timer);
 	cbus_stop_loop(&writer->wal_pipe);
 
 	if (cord_join(&writer->cord)) {
@@ -534,6 +684,7 @@ wal_sync_f(struct cbus_call_msg *data)
 		diag_set(ClientError, ER_WAL_IO);
 		return -1;
 	}
+	wal_writer_sync_wait(writer);
 	vclock_copy(&msg->vclock, &writer->vclock);
 	return 0;
 }
@@ -581,6 +732,11 @@ wal_begin_checkpoint_f(struct cbus_call_msg *data)
 		diag_set(ClientError, ER_CHECKPOINT_ROLLBACK);
 		return -1;
 	}
+	/*
+	 * Make sure tx has received all batches written so far,
+	 * so that the checkpoint vclock matches its state.
+	 */
+	wal_writer_sync_wait(writer);
 	/*
 	 * Avoid closing the current WAL if it has no rows (empty).
 	 */
@@ -695,6 +851,120 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+void
+wal_set_commit_delay(double delay)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->commit_delay = delay;
+	if (delay == 0 && ev_is_active(&writer->commit_timer)) {
+		ev_timer_stop(loop(), &writer->commit_timer);
+		cpipe_flush_input(&writer->wal_pipe);
+	}
+}
+
+void
+wal_set_batch_max_size(int64_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->batch_max_size = size > 0 ? size : INT64_MAX;
+}
+
+/**
+ * Reset the WAL writer statistics if wal_reset_stat() has been
+ * called since the last check. Called by the WAL thread before
+ * accessing the statistics.
+ */
+static void
+wal_writer_check_stat_reset(struct wal_writer *writer)
+{
+	unsigned gen = pm_atomic_load(&writer->stat_reset_gen);
+	if (writer->stat_gen == gen)
+		return;
+	writer->stat_gen = gen;
+	writer->stat_batches = 0;
+	writer->stat_rows = 0;
+	writer->stat_bytes = 0;
+	writer->stat_syncs = 0;
+	latency_reset(&writer->sync_latency);
+}
+
+struct wal_set_compression_level_msg {
+	struct cbus_call_msg base;
+	int level;
+};
+
+static int
+wal_set_compression_level_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_compression_level_msg *msg;
+	msg = (struct wal_set_compression_level_msg *)data;
+	writer->wal_dir.opts.compression_level = msg->level;
+	if (xlog_is_open(&writer->current_wal))
+		writer->current_wal.opts.compression_level = msg->level;
+	return 0;
+}
+
+void
+wal_set_compression_level(int level)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_compression_level_msg msg;
+	msg.level = level;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_compression_level_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	struct wal_stat *stat;
+};
+
+static int
+wal_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat *stat = ((struct wal_stat_msg *)data)->stat;
+	wal_writer_check_stat_reset(writer);
+	stat->batches = writer->stat_batches;
+	stat->rows = writer->stat_rows;
+	stat->bytes = writer->stat_bytes;
+	stat->syncs = writer->stat_syncs;
+	stat->sync_p50 = latency_get(&writer->sync_latency, 50);
+	stat->sync_p75 = latency_get(&writer->sync_latency, 75);
+	stat->sync_p90 = latency_get(&writer->sync_latency, 90);
+	stat->sync_p95 = latency_get(&writer->sync_latency, 95);
+	stat->sync_p99 = latency_get(&writer->sync_latency, 99);
+	return 0;
+}
+
+void
+wal_stat(struct wal_stat *stat)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	memset(stat, 0, sizeof(*stat));
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_stat_msg msg;
+	msg.stat = stat;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_reset_stat(void)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	pm_atomic_fetch_add(&writer->stat_reset_gen, 1);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
@@ -769,6 +1039,8 @@ wal_opt_rotate(struct wal_writer *writer)
 	 */
 	if (xlog_is_open(&writer->current_wal) &&
 	    writer->current_wal.offset >= writer->wal_max_size) {
+		/* Batches waiting for sync must not span WALs. */
+		wal_writer_sync_wait(writer);
 		/*
 		 * We can not handle xlog_close()
 		 * failure in any reasonable way.
@@ -923,9 +1195,185 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 	 * all input until rollback mode is off.
 	 */
 	cmsg_init(&writer->in_rollback, rollback_route);
+	if (writer->wal_mode == WAL_FSYNC) {
+		/*
+		 * The failed batch is queued for sync right
+		 * after this, see wal_write_to_disk(). Let it
+		 * reach tx first.
+		 */
+		writer->sync_rollback_pending = true;
+		return;
+	}
 	cpipe_push(&writer->tx_prio_pipe, &writer->in_rollback);
 }
 
+/**
+ * Append rows of a written batch to the buffer read by relays.
+ * Must be called before watchers are notified about the batch.
+ */
+static void
+wal_writer_buffer_batch(struct wal_writer *writer, struct wal_msg *batch)
+{
+	if (writer->relay_buffer == NULL)
+		return;
+	struct journal_entry *entry;
+	stailq_foreach_entry(entry, &batch->commit, fifo) {
+		if (xrow_ring_append(writer->relay_buffer, entry->rows,
+				     entry->n_rows) != 0) {
+			/*
+			 * Relays will fall back on xlog files for
+			 * the rows of this batch.
+			 */
+			diag_log();
+			diag_clear(diag_get());
+			xrow_ring_reset(writer->relay_buffer, &batch->vclock);
+			return;
+		}
+	}
+}
+
+/* {{{ Pipelined fdatasync() in fsync mode */
+
+static void
+wal_writer_sync_start(struct wal_writer *writer);
+
+/**
+ * Send batches covered by the completed fdatasync() round back
+ * to tx and start the next round if there are new batches.
+ */
+static void
+wal_writer_sync_complete(struct wal_writer *writer)
+{
+	double now = ev_monotonic_time();
+	struct wal_msg *batch, *tmp;
+	stailq_foreach_entry_safe(batch, tmp, &writer->sync_inflight,
+				  in_sync) {
+		struct journal_entry *entry;
+		stailq_foreach_entry(entry, &batch->commit, fifo)
+			entry->sync_time = now;
+		wal_writer_buffer_batch(writer, batch);
+		cmsg_init(&batch->base, wal_commit_route);
+		cpipe_push(&writer->tx_prio_pipe, &batch->base);
+	}
+	stailq_create(&writer->sync_inflight);
+	wal_notify_watchers(writer, WAL_EVENT_WRITE);
+	wal_writer_sync_start(writer);
+	fiber_cond_broadcast(&writer->sync_cond);
+}
+
+static int
+wal_writer_sync_cb(eio_req *req)
+{
+	struct wal_writer *writer = (struct wal_writer *) req->data;
+	if (req->result != 0) {
+		/*
+		 * After a failed fdatasync() the state of the
+		 * written data is unknown, while subsequent
+		 * batches have already been appended to the
+		 * file. There is no way to roll back safely.
+		 */
+		errno = req->errorno;
+		panic_syserror("%s: fdatasync() failed",
+			       fio_filename(writer->sync_fd));
+	}
+	close(writer->sync_fd);
+	writer->sync_fd = -1;
+	wal_writer_check_stat_reset(writer);
+	writer->stat_syncs++;
+	latency_collect(&writer->sync_latency,
+			ev_monotonic_time() - writer->sync_start);
+	wal_writer_sync_complete(writer);
+	return 0;
+}
+
+/**
+ * Send batches which have nothing written, e.g. the ones rolled
+ * back after a failed write, from the head of the sync queue back
+ * to tx. They don't need to wait for fdatasync(). Once the queue
+ * is empty, send a pending rollback to tx.
+ */
+static void
+wal_writer_sync_skip_unwritten(struct wal_writer *writer)
+{
+	while (!stailq_empty(&writer->sync_queue)) {
+		struct wal_msg *batch = stailq_first_entry(&writer->sync_queue,
+							   struct wal_msg,
+							   in_sync);
+		if (!stailq_empty(&batch->commit))
+			return;
+		stailq_shift(&writer->sync_queue);
+		cmsg_init(&batch->base, wal_commit_route);
+		cpipe_push(&writer->tx_prio_pipe, &batch->base);
+	}
+	if (writer->sync_rollback_pending) {
+		writer->sync_rollback_pending = false;
+		cpipe_push(&writer->tx_prio_pipe, &writer->in_rollback);
+	}
+}
+
+/**
+ * Start an fdatasync() round for all batches queued so far.
+ * The current WAL is synced in a coio thread, so that the WAL
+ * thread can format and write the next batches meanwhile.
+ * All batches in the queue belong to the current WAL, since
+ * the queue is drained before the WAL is closed.
+ */
+static void
+wal_writer_sync_start(struct wal_writer *writer)
+{
+	assert(writer->sync_fd < 0);
+	assert(stailq_empty(&writer->sync_inflight));
+	wal_writer_sync_skip_unwritten(writer);
+	if (stailq_empty(&writer->sync_queue))
+		return;
+	stailq_concat(&writer->sync_inflight, &writer->sync_queue);
+	struct xlog *l = &writer->current_wal;
+	if (!xlog_is_open(l)) {
+		/* Nothing has been written, nothing to sync. */
+		return wal_writer_sync_complete(writer);
+	}
+	writer->sync_start = ev_monotonic_time();
+	writer->sync_fd = dup(l->fd);
+	if (writer->sync_fd < 0) {
+		say_syserror("%s: dup() failed", l->filename);
+		if (fdatasync(l->fd) < 0) {
+			panic_syserror("%s: fdatasync() failed",
+				       l->filename);
+		}
+		wal_writer_check_stat_reset(writer);
+		writer->stat_syncs++;
+		latency_collect(&writer->sync_latency,
+				ev_monotonic_time() - writer->sync_start);
+		return wal_writer_sync_complete(writer);
+	}
+	eio_fdatasync(writer->sync_fd, 0, wal_writer_sync_cb, writer);
+}
+
+/**
+ * Queue a processed batch for the next fdatasync() round. The
+ * batch is sent back to tx once the round is over.
+ */
+static void
+wal_writer_sync_batch(struct wal_writer *writer, struct wal_msg *batch)
+{
+	stailq_add_tail_entry(&writer->sync_queue, batch, in_sync);
+	if (writer->sync_fd < 0)
+		wal_writer_sync_start(writer);
+}
+
+/**
+ * Wait until all batches queued for fdatasync() are synced
+ * and sent back to tx.
+ */
+static void
+wal_writer_sync_wait(struct wal_writer *writer)
+{
+	while (writer->sync_fd >= 0 || !stailq_empty(&writer->sync_queue))
+		fiber_cond_wait(&writer->sync_cond);
+}
+
+/* }}} */
+
 /*
  * Assign lsn and replica identifier for local writes and track
  * row into vclock_diff.
@@ -959,10 +1407,8 @@ wal_assign_lsn(struct vclock *vclock_diff, struct vclock *base,
 }
 
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_write_batch(struct wal_writer *writer, struct wal_msg *wal_msg)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
 	struct error *error;
 
 	/*
@@ -1023,6 +1469,7 @@ wal_write_to_disk(struct cmsg *msg)
 	 * Iterate over requests (transactions)
 	 */
 	int rc;
+	int64_t written = 0;
 	struct journal_entry *entry;
 	struct stailq_entry *last_committed = NULL;
 	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
@@ -1035,6 +1482,7 @@ wal_write_to_disk(struct cmsg *msg)
 			goto done;
 		if (rc > 0) {
 			writer->checkpoint_wal_size += rc;
+			written += rc;
 			last_committed = &entry->fifo;
 			vclock_merge(&writer->vclock, &vclock_diff);
 		}
@@ -1045,6 +1493,7 @@ wal_write_to_disk(struct cmsg *msg)
 		goto done;
 
 	writer->checkpoint_wal_size += rc;
+	written += rc;
 	last_committed = stailq_last(&wal_msg->commit);
 	vclock_merge(&writer->vclock, &vclock_diff);
 
@@ -1093,6 +1542,17 @@ done:
 	struct stailq rollback;
 	stailq_cut_tail(&wal_msg->commit, last_committed, &rollback);
 
+	if (written > 0) {
+		double now = ev_monotonic_time();
+		wal_writer_check_stat_reset(writer);
+		writer->stat_batches++;
+		writer->stat_bytes += written;
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			writer->stat_rows += entry->n_rows;
+			entry->write_time = now;
+		}
+	}
+
 	if (!stailq_empty(&rollback)) {
 		/* Update status of the successfully committed requests. */
 		stailq_foreach_entry(entry, &rollback, fifo)
@@ -1102,6 +1562,24 @@ done:
 		wal_writer_begin_rollback(writer);
 	}
 	fiber_gc();
+}
+
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	wal_write_batch(writer, wal_msg);
+	if (writer->wal_mode == WAL_FSYNC) {
+		/*
+		 * Watchers are notified when the batch is
+		 * synced, so that relays never send rows which
+		 * may be lost on a crash.
+		 */
+		wal_writer_sync_batch(writer, wal_msg);
+		return;
+	}
+	wal_writer_buffer_batch(writer, wal_msg);
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
@@ -1126,6 +1604,9 @@ wal_writer_f(va_list ap)
 
 	cbus_loop(&endpoint);
 
+	/* Let the batches being synced reach tx. */
+	wal_writer_sync_wait(writer);
+
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
 	 * have to rescan the last WAL to find the instance vclock.
@@ -1180,12 +1661,25 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		goto fail;
 	}
 
+	/*
+	 * Append the entry to the batch at the tail of the pipe
+	 * input unless the batch is already big enough.
+	 */
 	struct wal_msg *batch;
+	/*
+	 * The batch size is remembered before the batch is
+	 * pushed: the WAL thread may own it right after that.
+	 */
+	size_t batch_len;
 	if (!stailq_empty(&writer->wal_pipe.input) &&
-	    (batch = wal_msg(stailq_first_entry(&writer->wal_pipe.input,
-						struct cmsg, fifo)))) {
+	    (batch = wal_msg(stailq_last_entry(&writer->wal_pipe.input,
+					       struct cmsg, fifo))) &&
+	    (int64_t)batch->approx_len < writer->batch_max_size) {
 
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
+		batch->approx_len += entry->approx_len;
+		batch_len = batch->approx_len;
+		writer->wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
 	} else {
 		batch = (struct wal_msg *)mempool_alloc(&writer->msg_pool);
 		if (batch == NULL) {
@@ -1196,14 +1690,32 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		wal_msg_create(batch);
 		/*
 		 * Sic: first add a request, then push the batch,
-		 * since cpipe_push() may pass the batch to WAL
-		 * thread right away.
+		 * since cpipe_push_input() may pass the batch to
+		 * WAL thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
-		cpipe_push(&writer->wal_pipe, &batch->base);
+		batch->approx_len += entry->approx_len;
+		batch_len = batch->approx_len;
+		writer->wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
+		cpipe_push_input(&writer->wal_pipe, &batch->base);
+	}
+	if (writer->commit_delay > 0 &&
+	    writer->wal_pipe.n_input > 0 &&
+	    writer->wal_pipe.n_input < writer->wal_pipe.max_input &&
+	    (int64_t)batch_len < writer->batch_max_size) {
+		/*
+		 * Group commit: let more transactions join
+		 * the batch before it is sent to the WAL thread.
+		 * The batch is still in the pipe input, since
+		 * the input hasn't been flushed.
+		 */
+		if (!ev_is_active(&writer->commit_timer)) {
+			ev_timer_set(&writer->commit_timer,
+				     writer->commit_delay, 0);
+			ev_timer_start(loop(), &writer->commit_timer);
+		}
+		return 0;
 	}
-	batch->approx_len += entry->approx_len;
-	writer->wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
 	cpipe_flush_input(&writer->wal_pipe);
 	return 0;
 
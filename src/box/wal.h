@@ -40,6 +40,7 @@
 struct fiber;
 struct wal_writer;
 struct tt_uuid;
+struct xrow_ring;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
@@ -82,7 +83,8 @@ typedef void (*wal_on_checkpoint_threshold_f)(void);
  */
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
-	 int64_t wal_max_size, const struct tt_uuid *instance_uuid,
+	 int64_t wal_max_size, int64_t relay_buffer_size,
+	 const struct tt_uuid *instance_uuid,
 	 wal_on_garbage_collection_f on_garbage_collection,
 	 wal_on_checkpoint_threshold_f on_checkpoint_threshold);
 
@@ -92,6 +94,13 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 int
 wal_enable(void);
 
+/**
+ * Return the buffer of rows recently written to WAL, which is
+ * shared with replication relays, or NULL if it is disabled.
+ */
+struct xrow_ring *
+wal_relay_buffer(void);
+
 /**
  * Stop WAL thread and free WAL writer resources.
  */
@@ -230,6 +239,53 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Set the time a WAL batch is held in TX waiting for more
+ * transactions before it is sent to the WAL thread. Zero
+ * means the batch is sent at the end of the current event
+ * loop iteration.
+ */
+void
+wal_set_commit_delay(double delay);
+
+/**
+ * Set the approximate size of a WAL batch, in bytes, reaching
+ * which the batch is sent to the WAL thread right away.
+ * 0 means no limit.
+ */
+void
+wal_set_batch_max_size(int64_t size);
+
+/** Set zstd compression level used for WAL files. */
+void
+wal_set_compression_level(int level);
+
+/** WAL writer statistics. */
+struct wal_stat {
+	/** Number of batches written to the WAL. */
+	int64_t batches;
+	/** Number of rows written to the WAL. */
+	int64_t rows;
+	/** Number of bytes written to the WAL. */
+	int64_t bytes;
+	/** Number of fdatasync() rounds done in fsync mode. */
+	int64_t syncs;
+	/** Percentiles of fdatasync() round latency, in seconds. */
+	double sync_p50;
+	double sync_p75;
+	double sync_p90;
+	double sync_p95;
+	double sync_p99;
+};
+
+/** Get WAL writer statistics. */
+void
+wal_stat(struct wal_stat *stat);
+
+/** Reset WAL writer statistics. Doesn't yield. */
+void
+wal_reset_stat(void);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
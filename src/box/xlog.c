@@ -87,6 +87,8 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/** Default zstd compression level. */
+	XLOG_COMPRESSION_LEVEL_DEFAULT = 3,
 };
 
 const struct xlog_opts xlog_opts_default = {
@@ -95,6 +97,8 @@ const struct xlog_opts xlog_opts_default = {
 	.free_cache = false,
 	.sync_is_async = false,
 	.no_compression = false,
+	.compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT,
+	.compression_threads = 0,
 };
 
 /* {{{ struct xlog_meta */
@@ -768,6 +772,9 @@ xlog_init(struct xlog *xlog, const struct xlog_opts *opts)
 	xlog->opts = *opts;
 	xlog->sync_time = ev_monotonic_time();
 	xlog->is_autocommit = true;
+	stailq_create(&xlog->zjobs);
+	stailq_create(&xlog->zjobs_free);
+	fiber_cond_create(&xlog->zjob_cond);
 	obuf_create(&xlog->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	obuf_create(&xlog->zbuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	if (!opts->no_compression) {
@@ -788,9 +795,14 @@ xlog_clear(struct xlog *l)
 	l->fd = -1;
 }
 
+static void
+xlog_zjobs_destroy(struct xlog *log);
+
 static void
 xlog_destroy(struct xlog *xlog)
 {
+	xlog_zjobs_destroy(xlog);
+	fiber_cond_destroy(&xlog->zjob_cond);
 	assert(xlog->obuf.slabc == &cord()->slabc);
 	assert(xlog->zbuf.slabc == &cord()->slabc);
 	obuf_destroy(&xlog->obuf);
@@ -1034,6 +1046,39 @@ xlog_fallocate(struct xlog *log, size_t len)
 #endif /* HAVE_FALLOCATE */
 }
 
+/**
+ * Encode a fixheader of an xlog_tx block.
+ *
+ * @param fixheader buffer of XLOG_FIXHEADER_SIZE bytes
+ * @param magic row_marker or zrow_marker
+ * @param len size of the block data following the fixheader
+ * @param crc32c checksum of the block data
+ */
+static void
+xlog_encode_fixheader(char *fixheader, log_magic_t magic,
+		      size_t len, uint32_t crc32c)
+{
+	*(log_magic_t *)fixheader = magic;
+	char *data = fixheader + sizeof(log_magic_t);
+	data = mp_encode_uint(data, len);
+	/* Encode crc32 for previous row */
+	data = mp_encode_uint(data, 0);
+	/* Encode crc32 for current row */
+	data = mp_encode_uint(data, crc32c);
+	/*
+	 * Encode a padding, to ensure the resulting
+	 * fixheader always has the same size.
+	 */
+	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
+	if (padding > 0) {
+		data = mp_encode_strl(data, padding - 1);
+		if (padding > 1) {
+			memset(data, 0, padding - 1);
+			data += padding - 1;
+		}
+	}
+}
+
 /**
  * Write a sequence of uncompressed xrow objects.
  *
@@ -1047,15 +1092,6 @@ xlog_tx_write_plain(struct xlog *log)
 	 * We created an obuf savepoint at start of xlog_tx,
 	 * now populate it with data.
 	 */
-	char *fixheader = (char *)log->obuf.iov[0].iov_base;
-	*(log_magic_t *)fixheader = row_marker;
-	char *data = fixheader + sizeof(log_magic_t);
-
-	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
@@ -1065,19 +1101,9 @@ xlog_tx_write_plain(struct xlog *log)
 				    iov->iov_len - offset);
 		offset = 0;
 	}
-	data = mp_encode_uint(data, crc32c);
-	/*
-	 * Encode a padding, to ensure the resulting
-	 * fixheader always has the same size.
-	 */
-	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_encode_fixheader((char *)log->obuf.iov[0].iov_base, row_marker,
+			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1106,8 +1132,7 @@ xlog_tx_write_zstd(struct xlog *log)
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
-	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	ZSTD_compressBegin(log->zctx, log->opts.compression_level);
 	size_t offset = XLOG_FIXHEADER_SIZE;
 	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
@@ -1147,25 +1172,9 @@ xlog_tx_write_zstd(struct xlog *log)
 		offset = 0;
 	}
 
-	*(log_magic_t *)fixheader = zrow_marker;
-	char *data;
-	data = fixheader + sizeof(log_magic_t);
-	data = mp_encode_uint(data,
-			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
-	data = mp_encode_uint(data, crc32c);
-	/* Encode padding */
-	ssize_t padding;
-	padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_encode_fixheader(fixheader, zrow_marker,
+			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1181,6 +1190,8 @@ xlog_tx_write_zstd(struct xlog *log)
 			 log->filename);
 		goto error;
 	}
+	log->zstat_in += obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE;
+	log->zstat_out += obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE;
 	obuf_reset(&log->zbuf);
 	return written;
 error:
@@ -1194,27 +1205,18 @@ error:
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
 /**
- * Writes xlog batch to file
+ * Account a block written to the file. If the write failed,
+ * truncate the file to the last successfully written block.
+ *
+ * @param written the result of the write
+ * @param rows the number of rows in the block
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
  */
 static ssize_t
-xlog_tx_write(struct xlog *log)
+xlog_tx_write_complete(struct xlog *log, ssize_t written, int64_t rows)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
-	ssize_t written;
-
-	if (!log->opts.no_compression &&
-	    obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
-	}
-	ERROR_INJECT(ERRINJ_WAL_WRITE, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		written = -1;
-	});
-
-	obuf_reset(&log->obuf);
 	/*
 	 * Simplify recovery after a temporary write failure:
 	 * truncate the file to the best known good write
@@ -1232,8 +1234,7 @@ xlog_tx_write(struct xlog *log)
 	else
 		log->allocated = 0;
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
+	log->rows += rows;
 	if ((log->opts.sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->opts.sync_interval)) ||
 	    (log->opts.rate_limit && log->offset >=
@@ -1275,6 +1276,322 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+/* {{{ Compression in coio threads */
+
+/**
+ * A block of rows compressed in a coio thread,
+ * see xlog_opts::compression_threads.
+ */
+struct xlog_zjob {
+	/** Link in xlog::zjobs or xlog::zjobs_free. */
+	struct stailq_entry in_list;
+	/** The xlog the block belongs to. */
+	struct xlog *log;
+	/** zstd context, used only by the coio thread. */
+	ZSTD_CCtx *zctx;
+	/** Compression level. */
+	int level;
+	/** Uncompressed rows. */
+	char *src;
+	size_t src_size;
+	size_t src_capacity;
+	/** Fixheader followed by compressed rows. */
+	char *dst;
+	size_t dst_size;
+	size_t dst_capacity;
+	/** Set when the coio thread is done with the block. */
+	bool is_done;
+	/** zstd error message or NULL on success. */
+	const char *error;
+};
+
+static struct xlog_zjob *
+xlog_zjob_new(struct xlog *log)
+{
+	struct xlog_zjob *job = calloc(1, sizeof(*job));
+	if (job == NULL) {
+		diag_set(OutOfMemory, sizeof(*job), "calloc",
+			 "struct xlog_zjob");
+		return NULL;
+	}
+	job->zctx = ZSTD_createCCtx();
+	if (job->zctx == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create context");
+		free(job);
+		return NULL;
+	}
+	job->log = log;
+	log->zjob_count++;
+	return job;
+}
+
+static void
+xlog_zjob_delete(struct xlog_zjob *job)
+{
+	ZSTD_freeCCtx(job->zctx);
+	free(job->src);
+	free(job->dst);
+	free(job);
+}
+
+/**
+ * Copy rows accumulated in the xlog output buffer to the job
+ * and make sure the job has enough room for compressed data.
+ */
+static int
+xlog_zjob_prepare(struct xlog_zjob *job, struct obuf *obuf)
+{
+	size_t size = obuf_size(obuf) - XLOG_FIXHEADER_SIZE;
+	if (size > job->src_capacity) {
+		char *src = realloc(job->src, size);
+		if (src == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "compression input buffer");
+			return -1;
+		}
+		job->src = src;
+		job->src_capacity = size;
+	}
+	size_t zmax_size = XLOG_FIXHEADER_SIZE + ZSTD_compressBound(size);
+	if (zmax_size > job->dst_capacity) {
+		char *dst = realloc(job->dst, zmax_size);
+		if (dst == NULL) {
+			diag_set(OutOfMemory, zmax_size, "realloc",
+				 "compression buffer");
+			return -1;
+		}
+		job->dst = dst;
+		job->dst_capacity = zmax_size;
+	}
+	char *pos = job->src;
+	struct iovec *iov;
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (iov = obuf->iov; iov->iov_len; ++iov) {
+		memcpy(pos, (char *)iov->iov_base + offset,
+		       iov->iov_len - offset);
+		pos += iov->iov_len - offset;
+		offset = 0;
+	}
+	assert(pos == job->src + size);
+	job->src_size = size;
+	job->dst_size = 0;
+	job->level = job->log->opts.compression_level;
+	job->is_done = false;
+	job->error = NULL;
+	return 0;
+}
+
+/** Compress a block and encode its fixheader. */
+static void
+xlog_zjob_execute(struct xlog_zjob *job)
+{
+	char *zdst = job->dst + XLOG_FIXHEADER_SIZE;
+	size_t zsize = ZSTD_compressCCtx(job->zctx, zdst,
+					 job->dst_capacity - XLOG_FIXHEADER_SIZE,
+					 job->src, job->src_size, job->level);
+	if (ZSTD_isError(zsize)) {
+		job->error = ZSTD_getErrorName(zsize);
+		return;
+	}
+	uint32_t crc32c = crc32_calc(0, zdst, zsize);
+	xlog_encode_fixheader(job->dst, zrow_marker, zsize, crc32c);
+	job->dst_size = XLOG_FIXHEADER_SIZE + zsize;
+}
+
+static void
+xlog_zjob_execute_cb(eio_req *req)
+{
+	xlog_zjob_execute((struct xlog_zjob *)req->data);
+}
+
+static int
+xlog_zjob_complete_cb(eio_req *req)
+{
+	struct xlog_zjob *job = (struct xlog_zjob *)req->data;
+	job->is_done = true;
+	fiber_cond_broadcast(&job->log->zjob_cond);
+	return 0;
+}
+
+/** Write a compressed block to the file. */
+static ssize_t
+xlog_zjob_write(struct xlog *log, struct xlog_zjob *job)
+{
+	if (job->error != NULL) {
+		diag_set(ClientError, ER_COMPRESSION, job->error);
+		return -1;
+	}
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		return -1;
+	});
+	if (fio_writen(log->fd, job->dst, job->dst_size) < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
+		return -1;
+	}
+	log->zstat_in += job->src_size;
+	log->zstat_out += job->dst_size - XLOG_FIXHEADER_SIZE;
+	return job->dst_size;
+}
+
+/**
+ * Write compressed blocks to the file in order. If @wait is
+ * set, wait for all blocks in flight, otherwise stop at the
+ * first block which is still being compressed.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_zjobs_flush(struct xlog *log, bool wait)
+{
+	ssize_t total = 0;
+	while (!stailq_empty(&log->zjobs)) {
+		struct xlog_zjob *job = stailq_first_entry(&log->zjobs,
+					struct xlog_zjob, in_list);
+		if (!job->is_done) {
+			if (!wait)
+				break;
+			fiber_cond_wait(&log->zjob_cond);
+			continue;
+		}
+		stailq_shift(&log->zjobs);
+		stailq_add_entry(&log->zjobs_free, job, in_list);
+		/*
+		 * Rows of the block have already been accounted
+		 * in xlog_tx_write_async().
+		 */
+		ssize_t written = xlog_tx_write_complete(log,
+				xlog_zjob_write(log, job), 0);
+		if (written < 0)
+			return -1;
+		total += written;
+	}
+	return total;
+}
+
+/**
+ * Pass the block accumulated in the output buffer to a coio
+ * thread for compression and write blocks compressed by now.
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+static ssize_t
+xlog_tx_write_async(struct xlog *log)
+{
+	assert(log->is_autocommit);
+	ssize_t written = xlog_zjobs_flush(log, false);
+	if (written < 0)
+		goto error;
+	if (stailq_empty(&log->zjobs_free) &&
+	    log->zjob_count >= 2 * log->opts.compression_threads) {
+		/* Too many blocks in flight, wait for the oldest. */
+		struct xlog_zjob *first = stailq_first_entry(&log->zjobs,
+					struct xlog_zjob, in_list);
+		while (!first->is_done)
+			fiber_cond_wait(&log->zjob_cond);
+		ssize_t rc = xlog_zjobs_flush(log, false);
+		if (rc < 0)
+			goto error;
+		written += rc;
+	}
+	struct xlog_zjob *job;
+	if (!stailq_empty(&log->zjobs_free)) {
+		job = stailq_shift_entry(&log->zjobs_free,
+					 struct xlog_zjob, in_list);
+	} else {
+		job = xlog_zjob_new(log);
+		if (job == NULL)
+			goto error;
+	}
+	if (xlog_zjob_prepare(job, &log->obuf) != 0) {
+		stailq_add_entry(&log->zjobs_free, job, in_list);
+		goto error;
+	}
+	/*
+	 * Rows are accounted right away, because row numbers
+	 * are assigned before the block is written, see
+	 * checkpoint_write_row().
+	 */
+	log->rows += log->tx_rows;
+	log->tx_rows = 0;
+	obuf_reset(&log->obuf);
+	stailq_add_tail_entry(&log->zjobs, job, in_list);
+	if (eio_custom(xlog_zjob_execute_cb, 0,
+		       xlog_zjob_complete_cb, job) == NULL) {
+		/* Failed to start a coio task, compress in place. */
+		xlog_zjob_execute(job);
+		job->is_done = true;
+	}
+	return written;
+error:
+	obuf_reset(&log->obuf);
+	return -1;
+}
+
+/**
+ * Wait for coio threads to be done with all compression jobs
+ * of the xlog and free them. Blocks which haven't been written
+ * yet are discarded.
+ */
+static void
+xlog_zjobs_destroy(struct xlog *log)
+{
+	struct xlog_zjob *job, *tmp;
+	stailq_foreach_entry(job, &log->zjobs, in_list) {
+		while (!job->is_done)
+			fiber_cond_wait(&log->zjob_cond);
+	}
+	stailq_concat(&log->zjobs_free, &log->zjobs);
+	stailq_foreach_entry_safe(job, tmp, &log->zjobs_free, in_list)
+		xlog_zjob_delete(job);
+	stailq_create(&log->zjobs_free);
+	log->zjob_count = 0;
+}
+
+/* }}} */
+
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	bool compress = !log->opts.no_compression &&
+			obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD;
+	if (compress && log->opts.compression_threads > 0)
+		return xlog_tx_write_async(log);
+
+	/* Blocks compressed in coio threads go first. */
+	ssize_t zwritten = xlog_zjobs_flush(log, true);
+	if (zwritten < 0) {
+		obuf_reset(&log->obuf);
+		return -1;
+	}
+
+	ssize_t written;
+	if (compress)
+		written = xlog_tx_write_zstd(log);
+	else
+		written = xlog_tx_write_plain(log);
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+
+	obuf_reset(&log->obuf);
+	written = xlog_tx_write_complete(log, written, log->tx_rows);
+	if (written < 0)
+		return -1;
+	log->tx_rows = 0;
+	return written + zwritten;
+}
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1385,9 +1702,17 @@ ssize_t
 xlog_flush(struct xlog *log)
 {
 	assert(log->is_autocommit);
-	if (log->obuf.used == 0)
-		return 0;
-	return xlog_tx_write(log);
+	ssize_t written = 0;
+	if (log->obuf.used > 0) {
+		written = xlog_tx_write(log);
+		if (written < 0)
+			return -1;
+	}
+	/* Wait for blocks compressed in coio threads. */
+	ssize_t zwritten = xlog_zjobs_flush(log, true);
+	if (zwritten < 0)
+		return -1;
+	return written + zwritten;
 }
 
 static int
@@ -1493,6 +1818,8 @@ xlog_atfork(struct xlog *xlog)
 /* {{{ struct xlog_cursor */
 
 #define XLOG_READ_AHEAD		(1 << 14)
+/** Read-ahead used for files that are known to be complete. */
+#define XLOG_READ_AHEAD_COMPLETE	(1 << 20)
 
 /**
  * Ensure that at least count bytes are in read buffer
@@ -1511,7 +1838,7 @@ xlog_cursor_ensure(struct xlog_cursor *cursor, size_t count)
 		return 1;
 
 	size_t to_load = count - ibuf_used(&cursor->rbuf);
-	to_load += XLOG_READ_AHEAD;
+	to_load += cursor->read_ahead;
 
 	void *dst = ibuf_reserve(&cursor->rbuf, to_load);
 	if (dst == NULL) {
@@ -1724,7 +2051,7 @@ xlog_tx_decode(const char *data, const char *data_end,
 ssize_t
 xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx)
+		      ZSTD_DStream *zdctx, struct ibuf *rows_buf)
 {
 	const char *rpos = *data;
 	struct xlog_fixheader fixheader;
@@ -1748,43 +2075,37 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 	}
 	data_end = rpos + fixheader.len;
 
-	ibuf_create(&tx_cursor->rows, &cord()->slabc,
-		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	if (fixheader.magic == row_marker) {
-		void *dst = ibuf_alloc(&tx_cursor->rows, fixheader.len);
-		if (dst == NULL) {
-			diag_set(OutOfMemory, fixheader.len,
-				 "runtime", "xlog rows buffer");
-			ibuf_destroy(&tx_cursor->rows);
-			return -1;
-		}
-		memcpy(dst, rpos, fixheader.len);
-		*data = (char *)rpos + fixheader.len;
-		assert(*data <= data_end);
-		tx_cursor->size = ibuf_used(&tx_cursor->rows);
+		/* Decode rows in place. */
+		tx_cursor->rpos = rpos;
+		tx_cursor->end = data_end;
+		tx_cursor->size = fixheader.len;
+		*data = data_end;
 		return 0;
 	};
 
 	assert(fixheader.magic == zrow_marker);
+	ibuf_reset(rows_buf);
 	ZSTD_initDStream(zdctx);
 	int rc;
 	do {
-		if (ibuf_reserve(&tx_cursor->rows,
+		if (ibuf_reserve(rows_buf,
 				 XLOG_TX_AUTOCOMMIT_THRESHOLD) == NULL) {
 			diag_set(OutOfMemory, XLOG_TX_AUTOCOMMIT_THRESHOLD,
 				  "runtime", "xlog output buffer");
-			ibuf_destroy(&tx_cursor->rows);
 			return -1;
 		}
-	} while ((rc = xlog_cursor_decompress(&tx_cursor->rows.wpos,
-					      tx_cursor->rows.end, &rpos,
+	} while ((rc = xlog_cursor_decompress(&rows_buf->wpos,
+					      rows_buf->end, &rpos,
 					      data_end, zdctx)) == 1);
 	if (rc != 0)
 		return -1;
 
 	*data = rpos;
 	assert(*data <= data_end);
-	tx_cursor->size = ibuf_used(&tx_cursor->rows);
+	tx_cursor->rpos = rows_buf->rpos;
+	tx_cursor->end = rows_buf->wpos;
+	tx_cursor->size = ibuf_used(rows_buf);
 	return 0;
 }
 
@@ -1792,16 +2113,15 @@ int
 xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor,
 		        struct xrow_header *xrow)
 {
-	if (ibuf_used(&tx_cursor->rows) == 0)
+	if (tx_cursor->rpos == tx_cursor->end)
 		return 1;
 	/* Return row from xlog tx buffer */
-	int rc = xrow_header_decode(xrow,
-				    (const char **)&tx_cursor->rows.rpos,
-				    (const char *)tx_cursor->rows.wpos, false);
+	int rc = xrow_header_decode(xrow, &tx_cursor->rpos,
+				    tx_cursor->end, false);
 	if (rc != 0) {
 		diag_set(XlogError, "can't parse row");
 		/* Discard remaining row data */
-		ibuf_reset(&tx_cursor->rows);
+		tx_cursor->rpos = tx_cursor->end;
 		return -1;
 	}
 
@@ -1811,8 +2131,7 @@ xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor,
 int
 xlog_tx_cursor_destroy(struct xlog_tx_cursor *tx_cursor)
 {
-	assert(tx_cursor->rows.slabc == &cord()->slabc);
-	ibuf_destroy(&tx_cursor->rows);
+	tx_cursor->rpos = tx_cursor->end = NULL;
 	return 0;
 }
 
@@ -1862,8 +2181,8 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 
 	ssize_t to_load;
 	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
-						(const char **)&i->rbuf.rpos,
-						i->rbuf.wpos, i->zdctx)) > 0) {
+				(const char **)&i->rbuf.rpos,
+				i->rbuf.wpos, i->zdctx, &i->zbuf)) > 0) {
 		/* not enough data in read buffer */
 		int rc = xlog_cursor_ensure(i, ibuf_used(&i->rbuf) + to_load);
 		if (rc < 0)
@@ -1943,6 +2262,31 @@ xlog_cursor_next(struct xlog_cursor *cursor,
 	return 0;
 }
 
+/**
+ * Set up read-ahead of a cursor. A complete file, i.e. one that
+ * ends with an eof marker, is never written again, so it is read
+ * in large chunks. A file which is still being written is read
+ * ahead a little, because the rest of it may not exist yet.
+ */
+static void
+xlog_cursor_setup_read_ahead(struct xlog_cursor *i)
+{
+	i->read_ahead = XLOG_READ_AHEAD;
+	struct stat st;
+	if (fstat(i->fd, &st) != 0 ||
+	    st.st_size < (off_t)sizeof(log_magic_t))
+		return;
+	log_magic_t magic;
+	if (fio_pread(i->fd, &magic, sizeof(magic),
+		      st.st_size - sizeof(magic)) != sizeof(magic) ||
+	    magic != eof_marker)
+		return;
+	i->read_ahead = XLOG_READ_AHEAD_COMPLETE;
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise(i->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
 int
 xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 {
@@ -1950,6 +2294,9 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 	i->fd = fd;
 	ibuf_create(&i->rbuf, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD << 1);
+	ibuf_create(&i->zbuf, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	xlog_cursor_setup_read_ahead(i);
 
 	ssize_t rc;
 	/*
@@ -1979,6 +2326,7 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 	return 0;
 error:
 	ibuf_destroy(&i->rbuf);
+	ibuf_destroy(&i->zbuf);
 	return -1;
 }
 
@@ -2006,6 +2354,8 @@ xlog_cursor_openmem(struct xlog_cursor *i, const char *data, size_t size,
 	i->fd = -1;
 	ibuf_create(&i->rbuf, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD << 1);
+	ibuf_create(&i->zbuf, &cord()->slabc,
+		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
 
 	void *dst = ibuf_alloc(&i->rbuf, size);
 	if (dst == NULL) {
@@ -2036,6 +2386,7 @@ xlog_cursor_openmem(struct xlog_cursor *i, const char *data, size_t size,
 	return 0;
 error:
 	ibuf_destroy(&i->rbuf);
+	ibuf_destroy(&i->zbuf);
 	return -1;
 }
 
@@ -2046,9 +2397,10 @@ xlog_cursor_close(struct xlog_cursor *i, bool reuse_fd)
 	if (i->fd >= 0 && !reuse_fd)
 		close(i->fd);
 	assert(i->rbuf.slabc == &cord()->slabc);
-	ibuf_destroy(&i->rbuf);
 	if (i->state == XLOG_CURSOR_TX)
 		xlog_tx_cursor_destroy(&i->tx_cursor);
+	ibuf_destroy(&i->rbuf);
+	ibuf_destroy(&i->zbuf);
 	ZSTD_freeDStream(i->zdctx);
 	i->state = (i->state == XLOG_CURSOR_EOF ?
 		    XLOG_CURSOR_EOF_CLOSED : XLOG_CURSOR_CLOSED);
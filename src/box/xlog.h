@@ -41,6 +41,8 @@
 
 #include "small/ibuf.h"
 #include "small/obuf.h"
+#include "salad/stailq.h"
+#include "fiber_cond.h"
 
 struct iovec;
 struct xrow_header;
@@ -82,6 +84,19 @@ struct xlog_opts {
 	 * to be read frequently, e.g. L1 run files in Vinyl.
 	 */
 	bool no_compression;
+	/** zstd compression level. */
+	int compression_level;
+	/**
+	 * If greater than 0, compression of xlog_tx blocks is
+	 * offloaded to coio threads, with up to twice this many
+	 * blocks in flight. Blocks are still written to the file
+	 * in order. The writer must run in a cord with coio
+	 * enabled and must not use multi-statement transactions.
+	 *
+	 * This option is useful for memtx snapshots, which are
+	 * big and CPU-bound because of compression.
+	 */
+	int compression_threads;
 };
 
 extern const struct xlog_opts xlog_opts_default;
@@ -393,6 +408,21 @@ struct xlog {
 	uint64_t synced_size;
 	/** Time when xlog wast synced last time */
 	double sync_time;
+	/**
+	 * Blocks being compressed in coio threads, in the order
+	 * they must be written, see xlog_opts::compression_threads.
+	 */
+	struct stailq zjobs;
+	/** Compression jobs which can be reused. */
+	struct stailq zjobs_free;
+	/** Total number of allocated compression jobs. */
+	int zjob_count;
+	/** Signaled when a compression job is complete. */
+	struct fiber_cond zjob_cond;
+	/** Size of data passed to zstd, for statistics. */
+	uint64_t zstat_in;
+	/** Size of data produced by zstd, for statistics. */
+	uint64_t zstat_out;
 };
 
 /**
@@ -564,8 +594,14 @@ xlog_atfork(struct xlog *xlog);
  */
 struct xlog_tx_cursor
 {
-	/** rows buffer */
-	struct ibuf rows;
+	/**
+	 * Position of the next row. Uncompressed rows are
+	 * decoded right from the source data, compressed ones
+	 * from the buffer passed to xlog_tx_cursor_create().
+	 */
+	const char *rpos;
+	/** End of rows. */
+	const char *end;
 	/** tx size */
 	size_t size;
 };
@@ -574,6 +610,12 @@ struct xlog_tx_cursor
  * Create xlog tx iterator from memory data.
  * *data will be adjusted to end of tx
  *
+ * The source data and @a rows_buf must stay intact until
+ * the cursor is destroyed.
+ *
+ * @param rows_buf a buffer for decompressed rows; it is
+ *        reset, so it can be reused for all transactions
+ *
  * @retval 0 for Ok
  * @retval -1 for error
  * @retval >0 how many additional bytes should be read to parse tx
@@ -581,11 +623,11 @@ struct xlog_tx_cursor
 ssize_t
 xlog_tx_cursor_create(struct xlog_tx_cursor *cursor,
 		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx);
+		      ZSTD_DStream *zdctx, struct ibuf *rows_buf);
 
 /**
- * Destroy xlog tx cursor and free all associated memory
- * including parsed xrows
+ * Destroy xlog tx cursor. Parsed xrows become invalid once
+ * the source data or the rows buffer is reused.
  */
 int
 xlog_tx_cursor_destroy(struct xlog_tx_cursor *tx_cursor);
@@ -608,7 +650,7 @@ xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor, struct xrow_header *xr
 static inline off_t
 xlog_tx_cursor_pos(struct xlog_tx_cursor *tx_cursor)
 {
-	return tx_cursor->size - ibuf_used(&tx_cursor->rows);
+	return tx_cursor->size - (tx_cursor->end - tx_cursor->rpos);
 }
 
 /**
@@ -660,10 +702,14 @@ struct xlog_cursor
 	char name[PATH_MAX];
 	/** file read buffer */
 	struct ibuf rbuf;
+	/** How many bytes to read ahead of requested data. */
+	size_t read_ahead;
 	/** file read position */
 	off_t read_offset;
 	/** cursor for current tx */
 	struct xlog_tx_cursor tx_cursor;
+	/** Buffer for decompressed rows, reused for all tx. */
+	struct ibuf zbuf;
 	/** ZSTD context for decompression */
 	ZSTD_DStream *zdctx;
 };
@@ -1194,7 +1194,8 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock, bool anon)
+		      const struct vclock *vclock, bool anon,
+		      uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock);
@@ -1204,7 +1205,9 @@ xrow_encode_subscribe(struct xrow_header *row,
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 5);
+	/* Don't confuse old masters with unknown keys. */
+	data = mp_encode_map(data, compression != IPROTO_COMPRESSION_NONE ?
+			     6 : 5);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1215,6 +1218,10 @@ xrow_encode_subscribe(struct xrow_header *row,
 	data = mp_encode_uint(data, tarantool_version_id());
 	data = mp_encode_uint(data, IPROTO_REPLICA_ANON);
 	data = mp_encode_bool(data, anon);
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1226,7 +1233,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id, bool *anon)
+		      uint32_t *version_id, bool *anon, uint32_t *compression,
+		      uint32_t *join_streams)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1244,6 +1252,10 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 
 	if (anon)
 		*anon = false;
+	if (compression != NULL)
+		*compression = IPROTO_COMPRESSION_NONE;
+	if (join_streams != NULL)
+		*join_streams = 1;
 	d = data;
 	uint32_t map_size = mp_decode_map(&d);
 	for (uint32_t i = 0; i < map_size; i++) {
@@ -1301,6 +1313,26 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*anon = mp_decode_bool(&d);
 			break;
+		case IPROTO_REPLICA_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid REPLICA_COMPRESSION");
+				return -1;
+			}
+			*compression = mp_decode_uint(&d);
+			break;
+		case IPROTO_REPLICA_JOIN_STREAMS:
+			if (join_streams == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid REPLICA_JOIN_STREAMS");
+				return -1;
+			}
+			*join_streams = mp_decode_uint(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1309,7 +1341,8 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 }
 
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t compression, uint32_t join_streams)
 {
 	memset(row, 0, sizeof(*row));
 
@@ -1320,10 +1353,20 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, 1 +
+			     (compression != IPROTO_COMPRESSION_NONE) +
+			     (join_streams > 1));
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
+	if (join_streams > 1) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_JOIN_STREAMS);
+		data = mp_encode_uint(data, join_streams);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1333,6 +1376,17 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 	return 0;
 }
 
+int
+xrow_encode_join_stream(struct xrow_header *row,
+			const struct tt_uuid *instance_uuid)
+{
+	if (xrow_encode_join(row, instance_uuid, IPROTO_COMPRESSION_NONE,
+			     1) != 0)
+		return -1;
+	row->type = IPROTO_JOIN_STREAM;
+	return 0;
+}
+
 int
 xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 {
@@ -1357,27 +1411,70 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 	return 0;
 }
 
+int
+xrow_encode_join_response(struct xrow_header *row, const struct vclock *vclock,
+			  uint32_t compression, uint32_t join_streams)
+{
+	if (compression == IPROTO_COMPRESSION_NONE && join_streams <= 1)
+		return xrow_encode_vclock(row, vclock);
+	memset(row, 0, sizeof(*row));
+	size_t size = 32 + mp_sizeof_vclock(vclock);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 1 +
+			     (compression != IPROTO_COMPRESSION_NONE) +
+			     (join_streams > 1));
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
+	if (join_streams > 1) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_JOIN_STREAMS);
+		data = mp_encode_uint(data, join_streams);
+	}
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_OK;
+	return 0;
+}
+
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			       const struct tt_uuid *replicaset_uuid,
-			       const struct vclock *vclock)
+			       const struct vclock *vclock,
+			       uint32_t compression)
 {
 	memset(row, 0, sizeof(*row));
-	size_t size = mp_sizeof_map(2) +
+	size_t size = mp_sizeof_map(3) +
 		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
 		      mp_sizeof_uint(IPROTO_CLUSTER_UUID) +
-		      mp_sizeof_str(UUID_STR_LEN);
+		      mp_sizeof_str(UUID_STR_LEN) +
+		      mp_sizeof_uint(IPROTO_REPLICA_COMPRESSION) +
+		      mp_sizeof_uint(compression);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 2);
+	data = mp_encode_map(data, compression != IPROTO_COMPRESSION_NONE ?
+			     3 : 2);
 	data = mp_encode_uint(data, IPROTO_VCLOCK);
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
+	if (compression != IPROTO_COMPRESSION_NONE) {
+		data = mp_encode_uint(data, IPROTO_REPLICA_COMPRESSION);
+		data = mp_encode_uint(data, compression);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
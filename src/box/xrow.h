@@ -322,6 +322,8 @@ xrow_encode_register(struct xrow_header *row,
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
  * @param anon Whether it is an anonymous subscribe request or not.
+ * @param compression Requested compression of the stream,
+ *        see enum iproto_compression.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -330,7 +332,8 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock, bool anon);
+		      const struct vclock *vclock, bool anon,
+		      uint32_t compression);
 
 /**
  * Decode SUBSCRIBE command.
@@ -340,6 +343,10 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] vclock.
  * @param[out] version_id.
  * @param[out] anon Whether it is an anonymous subscribe.
+ * @param[out] compression Compression of the stream, set to
+ *             IPROTO_COMPRESSION_NONE if not specified.
+ * @param[out] join_streams Number of connections to send the
+ *             initial JOIN data over, set to 1 if not specified.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -347,31 +354,67 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id, bool *anon);
+		      uint32_t *version_id, bool *anon, uint32_t *compression,
+		      uint32_t *join_streams);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param compression Requested compression of the stream.
+ * @param join_streams Requested number of connections to send
+ *        the initial data over.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t compression, uint32_t join_streams);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] compression Requested compression of the stream.
+ * @param[out] join_streams Requested number of connections to
+ *             send the initial data over.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 uint32_t *compression, uint32_t *join_streams)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL, NULL,
+				     compression, join_streams);
+}
+
+/**
+ * Encode JOIN_STREAM command.
+ * @param[out] row Row to encode into.
+ * @param instance_uuid UUID of the replica which sent JOIN.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_stream(struct xrow_header *row,
+			const struct tt_uuid *instance_uuid);
+
+/**
+ * Decode JOIN_STREAM command.
+ * @param row Row to decode.
+ * @param[out] instance_uuid UUID of the replica which sent JOIN.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_join_stream(struct xrow_header *row, struct tt_uuid *instance_uuid)
+{
+	return xrow_decode_join(row, instance_uuid, NULL, NULL);
 }
 
 /**
@@ -386,7 +429,8 @@ static inline int
 xrow_decode_register(struct xrow_header *row, struct tt_uuid *instance_uuid,
 		     struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, vclock, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, vclock, NULL, NULL,
+				     NULL, NULL);
 }
 
 /**
@@ -411,7 +455,42 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL, NULL,
+				     NULL);
+}
+
+/**
+ * Encode a response to JOIN request.
+ * @param row[out] Row to encode into.
+ * @param vclock.
+ * @param compression Compression of the rest of the stream.
+ * @param join_streams Number of connections the initial data
+ *        is sent over.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_response(struct xrow_header *row, const struct vclock *vclock,
+			  uint32_t compression, uint32_t join_streams);
+
+/**
+ * Decode a response to JOIN request.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] compression Compression of the rest of the stream.
+ * @param[out] join_streams Number of connections the initial
+ *             data is sent over.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  uint32_t *compression, uint32_t *join_streams)
+{
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     compression, join_streams);
 }
 
 /**
@@ -419,6 +498,7 @@ xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
  * @param row[out] Row to encode into.
  * @param replicaset_uuid.
  * @param vclock.
+ * @param compression Compression of the rest of the stream.
  *
  * @retval 0 Success.
  * @retval -1 Memory error.
@@ -426,13 +506,15 @@ xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			      const struct tt_uuid *replicaset_uuid,
-			      const struct vclock *vclock);
+			      const struct vclock *vclock,
+			      uint32_t compression);
 
 /**
  * Decode a response to subscribe request.
  * @param row Row to decode.
  * @param[out] replicaset_uuid.
  * @param[out] vclock.
+ * @param[out] compression Compression of the rest of the stream.
  *
  * @retval 0 Success.
  * @retval -1 Memory or format error.
@@ -440,9 +522,10 @@ xrow_encode_subscribe_response(struct xrow_header *row,
 static inline int
 xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct tt_uuid *replicaset_uuid,
-			       struct vclock *vclock)
+			       struct vclock *vclock, uint32_t *compression)
 {
-	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL, NULL);
+	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock,
+				     NULL, NULL, compression, NULL);
 }
 
 /**
@@ -817,10 +900,11 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock, bool anon)
+			 const struct vclock *vclock, bool anon,
+			 uint32_t compression)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, anon) != 0)
+				  vclock, anon, compression) != 0)
 		diag_raise();
 }
 
@@ -829,27 +913,51 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id, bool *anon)
+			 uint32_t *replica_version_id, bool *anon,
+			 uint32_t *compression)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id, anon) != 0)
+				  vclock, replica_version_id, anon,
+				  compression, NULL) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid, uint32_t compression,
+		    uint32_t join_streams)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, compression,
+			     join_streams) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    uint32_t *compression, uint32_t *join_streams)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_join(row, instance_uuid, compression,
+			     join_streams) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_stream. */
+static inline void
+xrow_encode_join_stream_xc(struct xrow_header *row,
+			   const struct tt_uuid *instance_uuid)
+{
+	if (xrow_encode_join_stream(row, instance_uuid) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_stream. */
+static inline void
+xrow_decode_join_stream_xc(struct xrow_header *row,
+			   struct tt_uuid *instance_uuid)
+{
+	if (xrow_decode_join_stream(row, instance_uuid) != 0)
 		diag_raise();
 }
 
@@ -878,13 +986,36 @@ xrow_decode_vclock_xc(struct xrow_header *row, struct vclock *vclock)
 		diag_raise();
 }
 
+/** @copydoc xrow_encode_join_response. */
+static inline void
+xrow_encode_join_response_xc(struct xrow_header *row,
+			     const struct vclock *vclock, uint32_t compression,
+			     uint32_t join_streams)
+{
+	if (xrow_encode_join_response(row, vclock, compression,
+				      join_streams) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_response. */
+static inline void
+xrow_decode_join_response_xc(struct xrow_header *row, struct vclock *vclock,
+			     uint32_t *compression, uint32_t *join_streams)
+{
+	if (xrow_decode_join_response(row, vclock, compression,
+				      join_streams) != 0)
+		diag_raise();
+}
+
 /** @copydoc xrow_encode_subscribe_response. */
 static inline void
 xrow_encode_subscribe_response_xc(struct xrow_header *row,
 				  const struct tt_uuid *replicaset_uuid,
-				  const struct vclock *vclock)
+				  const struct vclock *vclock,
+				  uint32_t compression)
 {
-	if (xrow_encode_subscribe_response(row, replicaset_uuid, vclock) != 0)
+	if (xrow_encode_subscribe_response(row, replicaset_uuid, vclock,
+					   compression) != 0)
 		diag_raise();
 }
 
@@ -892,9 +1023,10 @@ xrow_encode_subscribe_response_xc(struct xrow_header *row,
 static inline void
 xrow_decode_subscribe_response_xc(struct xrow_header *row,
 				  struct tt_uuid *replicaset_uuid,
-				  struct vclock *vclock)
+				  struct vclock *vclock, uint32_t *compression)
 {
-	if (xrow_decode_subscribe_response(row, replicaset_uuid, vclock) != 0)
+	if (xrow_decode_subscribe_response(row, replicaset_uuid, vclock,
+					   compression) != 0)
 		diag_raise();
 }
 
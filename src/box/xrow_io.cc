@@ -29,10 +29,18 @@
  * SUCH DAMAGE.
  */
 #include "xrow_io.h"
+
+#include <small/ibuf.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd.h"
+
 #include "xrow.h"
 #include "coio.h"
 #include "coio_buf.h"
 #include "error.h"
+#include "clock.h"
+#include "trivia/util.h"
 #include "msgpuck/msgpuck.h"
 
 void
@@ -103,3 +111,279 @@ coio_write_xrow(struct ev_io *coio, const struct xrow_header *row)
 	coio_writev(coio, iov, iovcnt, 0);
 }
 
+struct xrow_compressor {
+	/** zstd stream context. */
+	ZSTD_CStream *zctx;
+	/** Output buffer, ZSTD_CStreamOutSize() bytes. */
+	char *buf;
+	/** Statistics to update. */
+	struct xrow_stream_stat *stat;
+};
+
+struct xrow_decompressor {
+	/** zstd stream context. */
+	ZSTD_DStream *zctx;
+	/** Compressed data read from the socket. */
+	struct ibuf buf;
+	/** Statistics to update. */
+	struct xrow_stream_stat *stat;
+};
+
+struct xrow_compressor *
+xrow_compressor_new(struct xrow_stream_stat *stat)
+{
+	/*
+	 * Rows are flushed one by one, so a low level gives
+	 * almost the same ratio at a fraction of CPU cost.
+	 */
+	enum { XROW_COMPRESSION_LEVEL = 1 };
+	struct xrow_compressor *c =
+		(struct xrow_compressor *)malloc(sizeof(*c));
+	if (c == NULL) {
+		diag_set(OutOfMemory, sizeof(*c), "malloc",
+			 "struct xrow_compressor");
+		return NULL;
+	}
+	c->stat = stat;
+	c->buf = (char *)malloc(ZSTD_CStreamOutSize());
+	if (c->buf == NULL) {
+		free(c);
+		diag_set(OutOfMemory, ZSTD_CStreamOutSize(), "malloc",
+			 "compression buffer");
+		return NULL;
+	}
+	c->zctx = ZSTD_createCStream();
+	if (c->zctx == NULL) {
+		free(c->buf);
+		free(c);
+		diag_set(OutOfMemory, 0, "ZSTD_createCStream", "zctx");
+		return NULL;
+	}
+	size_t rc = ZSTD_initCStream(c->zctx, XROW_COMPRESSION_LEVEL);
+	if (ZSTD_isError(rc)) {
+		ZSTD_freeCStream(c->zctx);
+		free(c->buf);
+		free(c);
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		return NULL;
+	}
+	return c;
+}
+
+void
+xrow_compressor_delete(struct xrow_compressor *c)
+{
+	ZSTD_freeCStream(c->zctx);
+	free(c->buf);
+	free(c);
+}
+
+struct xrow_stream_stat *
+xrow_compressor_stat(struct xrow_compressor *c)
+{
+	return c->stat;
+}
+
+struct xrow_decompressor *
+xrow_decompressor_new(struct slab_cache *slabc,
+		      struct xrow_stream_stat *stat)
+{
+	struct xrow_decompressor *d =
+		(struct xrow_decompressor *)malloc(sizeof(*d));
+	if (d == NULL) {
+		diag_set(OutOfMemory, sizeof(*d), "malloc",
+			 "struct xrow_decompressor");
+		return NULL;
+	}
+	d->stat = stat;
+	d->zctx = ZSTD_createDStream();
+	if (d->zctx == NULL) {
+		diag_set(OutOfMemory, 0, "ZSTD_createDStream", "zctx");
+		free(d);
+		return NULL;
+	}
+	size_t rc = ZSTD_initDStream(d->zctx);
+	if (ZSTD_isError(rc)) {
+		ZSTD_freeDStream(d->zctx);
+		free(d);
+		diag_set(ClientError, ER_DECOMPRESSION, ZSTD_getErrorName(rc));
+		return NULL;
+	}
+	ibuf_create(&d->buf, slabc, 16 * 1024);
+	return d;
+}
+
+void
+xrow_decompressor_delete(struct xrow_decompressor *d)
+{
+	ZSTD_freeDStream(d->zctx);
+	ibuf_destroy(&d->buf);
+	free(d);
+}
+
+int
+xrow_decompressor_feed(struct xrow_decompressor *d, const char *data,
+		       size_t size)
+{
+	if (size == 0)
+		return 0;
+	void *dst = ibuf_alloc(&d->buf, size);
+	if (dst == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "compressed data");
+		return -1;
+	}
+	memcpy(dst, data, size);
+	return 0;
+}
+
+/**
+ * Decompress all input buffered in @a d to @a in.
+ * Return 0 on success, -1 on error.
+ */
+static int
+xrow_decompress(struct xrow_decompressor *d, struct ibuf *in)
+{
+	double start = clock_thread();
+	size_t in_size = ibuf_used(in);
+	ZSTD_inBuffer input = {d->buf.rpos, ibuf_used(&d->buf), 0};
+	int rc = 0;
+	while (true) {
+		size_t size = ZSTD_DStreamOutSize();
+		void *dst = ibuf_reserve(in, size);
+		if (dst == NULL) {
+			diag_set(OutOfMemory, size, "ibuf", "decompressed data");
+			rc = -1;
+			break;
+		}
+		ZSTD_outBuffer output = {dst, size, 0};
+		size_t zrc = ZSTD_decompressStream(d->zctx, &output, &input);
+		if (ZSTD_isError(zrc)) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 ZSTD_getErrorName(zrc));
+			rc = -1;
+			break;
+		}
+		in->wpos += output.pos;
+		/*
+		 * The output buffer isn't full, so all decodable
+		 * data has been flushed from the context.
+		 */
+		if (output.pos < output.size)
+			break;
+	}
+	d->buf.rpos += input.pos;
+	if (ibuf_used(&d->buf) == 0)
+		ibuf_reset(&d->buf);
+	d->stat->compressed_bytes += input.pos;
+	d->stat->bytes += ibuf_used(in) - in_size;
+	d->stat->cpu_time += clock_thread() - start;
+	return rc;
+}
+
+/**
+ * Read and decompress data until there are at least @a size
+ * bytes in @a in.
+ */
+static void
+coio_fill_decompressed(struct ev_io *coio, struct xrow_decompressor *d,
+		       struct ibuf *in, size_t size, ev_tstamp timeout)
+{
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+	while (ibuf_used(in) < size) {
+		if (ibuf_used(&d->buf) == 0) {
+			coio_breadn_timeout(coio, &d->buf, 1, delay);
+			coio_timeout_update(&start, &delay);
+		}
+		if (xrow_decompress(d, in) != 0)
+			diag_raise();
+	}
+}
+
+void
+coio_read_xrow_compressed_xc(struct ev_io *coio, struct xrow_decompressor *d,
+			     struct ibuf *in, struct xrow_header *row,
+			     ev_tstamp timeout)
+{
+	if (d == NULL)
+		return coio_read_xrow_timeout_xc(coio, in, row, timeout);
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+	/* Read fixed header */
+	coio_fill_decompressed(coio, d, in, 1, delay);
+	coio_timeout_update(&start, &delay);
+
+	/* Read length */
+	if (mp_typeof(*in->rpos) != MP_UINT) {
+		tnt_raise(ClientError, ER_INVALID_MSGPACK,
+			  "packet length");
+	}
+	ssize_t to_read = mp_check_uint(in->rpos, in->wpos);
+	if (to_read > 0) {
+		coio_fill_decompressed(coio, d, in, ibuf_used(in) + to_read,
+				       delay);
+	}
+	coio_timeout_update(&start, &delay);
+
+	uint32_t len = mp_decode_uint((const char **) &in->rpos);
+
+	/* Read header and body */
+	coio_fill_decompressed(coio, d, in, len, delay);
+
+	xrow_header_decode_xc(row, (const char **) &in->rpos, in->rpos + len,
+			      true);
+}
+
+/** Send compressed data accumulated in the output buffer. */
+static void
+xrow_compressor_send(struct ev_io *coio, struct xrow_compressor *c,
+		     ZSTD_outBuffer *output)
+{
+	coio_write(coio, output->dst, output->pos);
+	c->stat->compressed_bytes += output->pos;
+	output->pos = 0;
+}
+
+void
+coio_write_xrow_compressed(struct ev_io *coio, struct xrow_compressor *c,
+			   const struct xrow_header *row)
+{
+	if (c == NULL)
+		return coio_write_xrow(coio, row);
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(row, iov);
+	/* Don't account the time spent waiting for the socket. */
+	double start = clock_thread();
+	ZSTD_outBuffer output = {c->buf, ZSTD_CStreamOutSize(), 0};
+	size_t rc;
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = {iov[i].iov_base, iov[i].iov_len, 0};
+		while (input.pos < input.size) {
+			if (output.pos == output.size) {
+				c->stat->cpu_time += clock_thread() - start;
+				xrow_compressor_send(coio, c, &output);
+				start = clock_thread();
+			}
+			rc = ZSTD_compressStream(c->zctx, &output, &input);
+			if (ZSTD_isError(rc))
+				goto error;
+		}
+		c->stat->bytes += iov[i].iov_len;
+	}
+	do {
+		if (output.pos == output.size) {
+			c->stat->cpu_time += clock_thread() - start;
+			xrow_compressor_send(coio, c, &output);
+			start = clock_thread();
+		}
+		/* Returns the number of bytes left to flush. */
+		rc = ZSTD_flushStream(c->zctx, &output);
+		if (ZSTD_isError(rc))
+			goto error;
+	} while (rc > 0);
+	c->stat->cpu_time += clock_thread() - start;
+	xrow_compressor_send(coio, c, &output);
+	return;
+error:
+	tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+}
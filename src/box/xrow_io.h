@@ -30,14 +30,74 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
+#include <stdint.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 struct ev_io;
 struct ibuf;
+struct slab_cache;
 struct xrow_header;
 
+/** Statistics of a compressed replication stream. */
+struct xrow_stream_stat {
+	/** Size of rows passed through the stream. */
+	int64_t bytes;
+	/** Size of the rows after compression. */
+	int64_t compressed_bytes;
+	/** CPU time spent on (de)compression, in seconds. */
+	double cpu_time;
+};
+
+/**
+ * Compressor of a replication stream. All rows are compressed
+ * as one zstd stream so that repeating field names, keys and
+ * values are encoded as references to the preceding rows. Each
+ * row is flushed to the socket in full so that the peer can
+ * decode it as soon as it is received.
+ */
+struct xrow_compressor;
+
+/**
+ * Create a compressor. Statistics are accumulated in @a stat.
+ * Return NULL and set diag on error.
+ */
+struct xrow_compressor *
+xrow_compressor_new(struct xrow_stream_stat *stat);
+
+void
+xrow_compressor_delete(struct xrow_compressor *c);
+
+/** Statistics a compressor accumulates. */
+struct xrow_stream_stat *
+xrow_compressor_stat(struct xrow_compressor *c);
+
+/** Decompressor of a stream written by xrow_compressor. */
+struct xrow_decompressor;
+
+/**
+ * Create a decompressor. Its input buffer is allocated with
+ * @a slabc. Return NULL and set diag on error.
+ */
+struct xrow_decompressor *
+xrow_decompressor_new(struct slab_cache *slabc,
+		      struct xrow_stream_stat *stat);
+
+void
+xrow_decompressor_delete(struct xrow_decompressor *d);
+
+/**
+ * Feed @a size bytes of compressed data, e.g. read from
+ * a socket along with the last uncompressed packet, to
+ * a decompressor. Return 0 on success, -1 on memory error.
+ */
+int
+xrow_decompressor_feed(struct xrow_decompressor *d, const char *data,
+		       size_t size);
+
 void
 coio_read_xrow(struct ev_io *coio, struct ibuf *in, struct xrow_header *row);
 
@@ -48,6 +108,24 @@ coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
 void
 coio_write_xrow(struct ev_io *coio, const struct xrow_header *row);
 
+/**
+ * Same as coio_read_xrow_timeout_xc(), but the data read from
+ * the socket is decompressed with @a d first, unless it is NULL.
+ * Decompressed data is accumulated in @a in.
+ */
+void
+coio_read_xrow_compressed_xc(struct ev_io *coio, struct xrow_decompressor *d,
+			     struct ibuf *in, struct xrow_header *row,
+			     double timeout);
+
+/**
+ * Same as coio_write_xrow(), but compresses the row with @a c
+ * unless it is NULL.
+ */
+void
+coio_write_xrow_compressed(struct ev_io *coio, struct xrow_compressor *c,
+			   const struct xrow_header *row);
+
 
 #if defined(__cplusplus)
 } /* extern "C" */
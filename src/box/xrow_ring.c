@@ -0,0 +1,233 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xrow_ring.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <small/ibuf.h>
+#include <small/region.h>
+
+#include "diag.h"
+#include "fiber.h"
+#include "trivia/util.h"
+#include "xrow.h"
+
+int
+xrow_ring_create(struct xrow_ring *ring, size_t size,
+		 const struct vclock *vclock)
+{
+	ring->data = malloc(size);
+	if (ring->data == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "xrow ring");
+		return -1;
+	}
+	ring->size = size;
+	ring->begin = ring->end = 0;
+	vclock_copy(&ring->vclock, vclock);
+	tt_pthread_mutex_init(&ring->mutex, NULL);
+	return 0;
+}
+
+void
+xrow_ring_destroy(struct xrow_ring *ring)
+{
+	tt_pthread_mutex_destroy(&ring->mutex);
+	free(ring->data);
+}
+
+void
+xrow_ring_reset(struct xrow_ring *ring, const struct vclock *vclock)
+{
+	tt_pthread_mutex_lock(&ring->mutex);
+	ring->begin = ring->end;
+	vclock_copy(&ring->vclock, vclock);
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+/** Copy data to a ring at the given position. */
+static void
+xrow_ring_write(struct xrow_ring *ring, uint64_t pos,
+		const void *src, size_t len)
+{
+	size_t offset = pos % ring->size;
+	size_t n = MIN(len, ring->size - offset);
+	memcpy(ring->data + offset, src, n);
+	memcpy(ring->data, (const char *)src + n, len - n);
+}
+
+/** Copy data from a ring at the given position. */
+static void
+xrow_ring_copy(struct xrow_ring *ring, uint64_t pos, void *dst, size_t len)
+{
+	size_t offset = pos % ring->size;
+	size_t n = MIN(len, ring->size - offset);
+	memcpy(dst, ring->data + offset, n);
+	memcpy((char *)dst + n, ring->data, len - n);
+}
+
+/** Advance the ring vclock past a discarded row. */
+static void
+xrow_ring_follow(struct xrow_ring *ring, uint32_t replica_id, int64_t lsn)
+{
+	if (lsn > vclock_get(&ring->vclock, replica_id))
+		vclock_follow(&ring->vclock, replica_id, lsn);
+}
+
+/** Discard the oldest record of a ring. */
+static void
+xrow_ring_pop(struct xrow_ring *ring)
+{
+	assert(ring->begin < ring->end);
+	struct xrow_ring_rec rec;
+	xrow_ring_copy(ring, ring->begin, &rec, sizeof(rec));
+	xrow_ring_follow(ring, rec.replica_id, rec.lsn);
+	ring->begin += sizeof(rec) + rec.len;
+}
+
+int
+xrow_ring_append(struct xrow_ring *ring, struct xrow_header **rows,
+		 int row_count)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = 0;
+	tt_pthread_mutex_lock(&ring->mutex);
+	for (int i = 0; i < row_count; i++) {
+		struct xrow_header *row = rows[i];
+		struct iovec iov[XROW_IOVMAX];
+		int iovcnt = xrow_header_encode(row, 0, iov, 0);
+		if (iovcnt < 0) {
+			rc = -1;
+			break;
+		}
+		struct xrow_ring_rec rec;
+		rec.len = 0;
+		for (int j = 0; j < iovcnt; j++)
+			rec.len += iov[j].iov_len;
+		rec.replica_id = row->replica_id;
+		rec.lsn = row->lsn;
+		size_t len = sizeof(rec) + rec.len;
+		if (len > ring->size) {
+			/* Readers will have to find it in xlogs. */
+			while (ring->begin < ring->end)
+				xrow_ring_pop(ring);
+			xrow_ring_follow(ring, rec.replica_id, rec.lsn);
+			continue;
+		}
+		while (ring->end + len - ring->begin > ring->size)
+			xrow_ring_pop(ring);
+		uint64_t pos = ring->end;
+		xrow_ring_write(ring, pos, &rec, sizeof(rec));
+		pos += sizeof(rec);
+		for (int j = 0; j < iovcnt; j++) {
+			xrow_ring_write(ring, pos, iov[j].iov_base,
+					iov[j].iov_len);
+			pos += iov[j].iov_len;
+		}
+		ring->end = pos;
+	}
+	tt_pthread_mutex_unlock(&ring->mutex);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+bool
+xrow_ring_seek(struct xrow_ring *ring, const struct vclock *vclock,
+	       uint64_t *pos)
+{
+	tt_pthread_mutex_lock(&ring->mutex);
+	bool found = vclock_compare(&ring->vclock, vclock) <= 0;
+	if (found)
+		*pos = ring->begin;
+	tt_pthread_mutex_unlock(&ring->mutex);
+	return found;
+}
+
+ssize_t
+xrow_ring_read(struct xrow_ring *ring, uint64_t *pos, struct ibuf *buf)
+{
+	/*
+	 * Only record headers are looked up under the lock, so as
+	 * not to stall the WAL writer while rows are copied.
+	 */
+	uint64_t begin = *pos;
+	uint64_t end = begin;
+	tt_pthread_mutex_lock(&ring->mutex);
+	if (begin < ring->begin) {
+		tt_pthread_mutex_unlock(&ring->mutex);
+		return -1;
+	}
+	while (end < ring->end && end - begin < XROW_RING_READ_MAX) {
+		struct xrow_ring_rec rec;
+		xrow_ring_copy(ring, end, &rec, sizeof(rec));
+		end += sizeof(rec) + rec.len;
+	}
+	tt_pthread_mutex_unlock(&ring->mutex);
+	if (end == begin)
+		return 0;
+	size_t len = end - begin;
+	void *dst = ibuf_alloc(buf, len);
+	if (dst == NULL)
+		return -1;
+	xrow_ring_copy(ring, begin, dst, len);
+	/*
+	 * The writer discards records before overwriting them,
+	 * so the copy is intact unless the beginning of the ring
+	 * moved past the first copied record meanwhile.
+	 */
+	tt_pthread_mutex_lock(&ring->mutex);
+	bool is_discarded = begin < ring->begin;
+	tt_pthread_mutex_unlock(&ring->mutex);
+	if (is_discarded) {
+		buf->wpos -= len;
+		return -1;
+	}
+	*pos = end;
+	return len;
+}
+
+int
+xrow_ring_decode(const char **data, const char *end,
+		 struct xrow_header *row)
+{
+	struct xrow_ring_rec rec;
+	assert(*data + sizeof(rec) <= end);
+	memcpy(&rec, *data, sizeof(rec));
+	*data += sizeof(rec);
+	const char *row_end = *data + rec.len;
+	assert(row_end <= end);
+	(void)end;
+	if (xrow_header_decode(row, data, row_end, false) != 0)
+		return -1;
+	*data = row_end;
+	return 0;
+}
@@ -0,0 +1,178 @@
+#ifndef TARANTOOL_BOX_XROW_RING_H_INCLUDED
+#define TARANTOOL_BOX_XROW_RING_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "tt_pthread.h"
+#include "vclock.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct ibuf;
+struct xrow_header;
+
+enum {
+	/**
+	 * Max number of bytes a reader copies from a ring at
+	 * once.
+	 */
+	XROW_RING_READ_MAX = 1024 * 1024,
+};
+
+/**
+ * A bounded in-memory buffer of rows recently written to WAL.
+ * The WAL thread appends rows to it, while replication relays
+ * read rows from it instead of xlog files as long as they keep
+ * up with the writer. When the buffer is full, the oldest rows
+ * are discarded to free space for new ones.
+ *
+ * A row is stored as struct xrow_ring_rec followed by the row
+ * encoded the same way as in an xlog file. A record may wrap
+ * around the end of the buffer.
+ */
+struct xrow_ring {
+	/** Protects the ring from concurrent access. */
+	pthread_mutex_t mutex;
+	/** Memory for records. */
+	char *data;
+	/** Size of the data buffer. */
+	size_t size;
+	/**
+	 * Position of the oldest record. Positions grow
+	 * monotonically, the offset of a record in the data
+	 * buffer is its position modulo size.
+	 */
+	uint64_t begin;
+	/** Position following the newest record. */
+	uint64_t end;
+	/**
+	 * Vclock of all rows which precede the oldest record,
+	 * i.e. were discarded or never stored in the ring. A
+	 * reader whose vclock is greater than or equal to this
+	 * one may read the rest of the rows from the ring.
+	 */
+	struct vclock vclock;
+};
+
+/** Header of a row stored in a ring. */
+struct xrow_ring_rec {
+	/** Length of the encoded row following the header. */
+	uint32_t len;
+	/** Replica id of the row. */
+	uint32_t replica_id;
+	/** LSN of the row. */
+	int64_t lsn;
+};
+
+/**
+ * Initialize a ring of the given size.
+ * @param vclock vclock of the first row appended to the ring
+ *        minus one, i.e. the vclock of the WAL writer.
+ * @retval 0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_ring_create(struct xrow_ring *ring, size_t size,
+		 const struct vclock *vclock);
+
+void
+xrow_ring_destroy(struct xrow_ring *ring);
+
+/**
+ * Discard all rows stored in a ring and set its vclock. Used
+ * when rows written to WAL could not be appended to the ring.
+ */
+void
+xrow_ring_reset(struct xrow_ring *ring, const struct vclock *vclock);
+
+/**
+ * Append rows to a ring, discarding the oldest rows if there's
+ * not enough space. A row which is larger than the ring itself
+ * is discarded right away.
+ * @retval 0 Success.
+ * @retval -1 Failed to encode a row, diag is set. Some of the
+ *         rows may have been appended, so the caller is supposed
+ *         to reset the ring.
+ */
+int
+xrow_ring_append(struct xrow_ring *ring, struct xrow_header **rows,
+		 int row_count);
+
+/**
+ * Find the position to read a ring from for a reader which has
+ * got all rows up to the given vclock.
+ * @retval true All rows newer than @a vclock are either in the
+ *         ring or not written yet, @a pos is set to the position
+ *         of the oldest record.
+ * @retval false Some rows newer than @a vclock are discarded.
+ */
+bool
+xrow_ring_seek(struct xrow_ring *ring, const struct vclock *vclock,
+	       uint64_t *pos);
+
+/**
+ * Copy records starting from the given position to a buffer
+ * and advance the position. Up to XROW_RING_READ_MAX bytes are
+ * copied, but at least one record if any. Copied records are
+ * supposed to be decoded with xrow_ring_decode().
+ * @retval >0 Number of bytes copied.
+ * @retval 0 No new records.
+ * @retval -1 The record at @a pos is discarded, possibly while
+ *         it was being copied, or the copy failed to allocate
+ *         memory. The reader has to read rows from xlog files.
+ *
+ * The ring lock is only taken to look up record headers, rows
+ * are copied without it.
+ */
+ssize_t
+xrow_ring_read(struct xrow_ring *ring, uint64_t *pos, struct ibuf *buf);
+
+/**
+ * Decode a record copied by xrow_ring_read() and advance @a data.
+ * The row body points to the copied record.
+ * @retval 0 Success.
+ * @retval -1 Decode error, diag is set.
+ */
+int
+xrow_ring_decode(const char **data, const char *end,
+		 struct xrow_header *row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XROW_RING_H_INCLUDED */
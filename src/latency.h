@@ -70,6 +70,12 @@ latency_reset(struct latency *latency);
 void
 latency_collect(struct latency *latency, double value);
 
+/**
+ * Add all observations of latency counter @src to @dst.
+ */
+void
+latency_merge(struct latency *dst, const struct latency *src);
+
 /**
  * Get accumulated latency value, in seconds.
  * Returns @pct-th percentile of all observations.
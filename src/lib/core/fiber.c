@@ -244,6 +244,8 @@ enum {
 	FIBER_STACK_SIZE_MINIMAL = 16384,
 	/* Default fiber stack size in bytes */
 	FIBER_STACK_SIZE_DEFAULT = 524288,
+	/* Small fiber stack size in bytes, @sa fiber_new_small() */
+	FIBER_STACK_SIZE_SMALL = 65536,
 	/* Stack size watermark in bytes. */
 	FIBER_STACK_SIZE_WATERMARK = 65536,
 };
@@ -254,6 +256,12 @@ static const struct fiber_attr fiber_attr_default = {
        .flags = FIBER_DEFAULT_FLAGS
 };
 
+/** Attributes of fibers with small stacks */
+static const struct fiber_attr fiber_attr_small = {
+       .stack_size = FIBER_STACK_SIZE_SMALL,
+       .flags = FIBER_DEFAULT_FLAGS | FIBER_SMALL_STACK
+};
+
 #ifdef HAVE_MADV_DONTNEED
 /*
  * Random values generated with uuid.
@@ -803,6 +811,7 @@ fiber_recycle(struct fiber *fiber)
 	/* no pending wakeup */
 	assert(rlist_empty(&fiber->state));
 	bool has_custom_stack = fiber->flags & FIBER_CUSTOM_STACK;
+	bool has_small_stack = fiber->flags & FIBER_SMALL_STACK;
 	fiber_stack_recycle(fiber);
 	fiber_reset(fiber);
 	fiber->name[0] = '\0';
@@ -812,7 +821,9 @@ fiber_recycle(struct fiber *fiber)
 	unregister_fid(fiber);
 	fiber->fid = 0;
 	region_free(&fiber->gc);
-	if (!has_custom_stack) {
+	if (has_small_stack) {
+		rlist_move_entry(&cord()->dead_small, fiber, link);
+	} else if (!has_custom_stack) {
 		rlist_move_entry(&cord()->dead, fiber, link);
 	} else {
 		fiber_destroy(cord(), fiber);
@@ -963,8 +974,11 @@ fiber_stack_watermark_create(struct fiber *fiber)
 {
 	assert(fiber->stack_watermark == NULL);
 
-	/* No tracking on custom stacks for simplicity. */
-	if (fiber->flags & FIBER_CUSTOM_STACK)
+	/*
+	 * No tracking on custom stacks for simplicity. Small
+	 * stacks are shorter than the watermark offset.
+	 */
+	if (fiber->flags & (FIBER_CUSTOM_STACK | FIBER_SMALL_STACK))
 		return;
 
 	/*
@@ -1080,12 +1094,14 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 	struct fiber *fiber = NULL;
 	assert(fiber_attr != NULL);
 
+	struct rlist *dead = fiber_attr->flags & FIBER_SMALL_STACK ?
+			     &cord->dead_small : &cord->dead;
 	/* Now we can not reuse fiber if custom attribute was set */
 	if (!(fiber_attr->flags & FIBER_CUSTOM_STACK) &&
-	    !rlist_empty(&cord->dead)) {
-		fiber = rlist_first_entry(&cord->dead,
-					  struct fiber, link);
+	    !rlist_empty(dead)) {
+		fiber = rlist_first_entry(dead, struct fiber, link);
 		rlist_move_entry(&cord->alive, fiber, link);
+		fiber->flags = fiber_attr->flags;
 	} else {
 		fiber = (struct fiber *)
 			mempool_alloc(&cord->fiber_mempool);
@@ -1095,6 +1111,8 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 			return NULL;
 		}
 		memset(fiber, 0, sizeof(struct fiber));
+		/* Let the stack allocator see the stack kind. */
+		fiber->flags = fiber_attr->flags;
 
 		if (fiber_stack_create(fiber, &cord()->slabc,
 				       fiber_attr->stack_size)) {
@@ -1144,6 +1162,12 @@ fiber_new(const char *name, fiber_func f)
 	return fiber_new_ex(name, &fiber_attr_default, f);
 }
 
+struct fiber *
+fiber_new_small(const char *name, fiber_func f)
+{
+	return fiber_new_ex(name, &fiber_attr_small, f);
+}
+
 /**
  * Free as much memory as possible taken by the fiber.
  *
@@ -1178,6 +1202,9 @@ fiber_destroy_all(struct cord *cord)
 	while (!rlist_empty(&cord->dead))
 		fiber_destroy(cord, rlist_first_entry(&cord->dead,
 						      struct fiber, link));
+	while (!rlist_empty(&cord->dead_small))
+		fiber_destroy(cord, rlist_first_entry(&cord->dead_small,
+						      struct fiber, link));
 }
 
 #if ENABLE_FIBER_TOP
@@ -1275,6 +1302,7 @@ cord_create(struct cord *cord, const char *name)
 	rlist_create(&cord->alive);
 	rlist_create(&cord->ready);
 	rlist_create(&cord->dead);
+	rlist_create(&cord->dead_small);
 	cord->fiber_registry = mh_i32ptr_new();
 
 	/* sched fiber is not present in alive/ready/dead list. */
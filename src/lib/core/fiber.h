@@ -158,6 +158,11 @@ enum {
 	 * This flag is set when fiber uses custom stack size.
 	 */
 	FIBER_CUSTOM_STACK	= 1 << 5,
+	/**
+	 * This flag is set when fiber uses a small stack,
+	 * @sa fiber_new_small().
+	 */
+	FIBER_SMALL_STACK	= 1 << 6,
 	FIBER_DEFAULT_FLAGS = FIBER_IS_CANCELLABLE
 };
 
@@ -408,6 +413,7 @@ fiber_attr_create(struct fiber_attr *fiber_attr);
 struct session;
 struct txn;
 struct credentials;
+struct iproto_trace;
 struct lua_State;
 struct ipc_wait_pad;
 
@@ -492,10 +498,12 @@ struct fiber {
 			int ref;
 		} lua;
 		/**
-		 * Iproto sync.
+		 * Iproto sync and the latency trace of the
+		 * request, if it is sampled.
 		 */
 		struct {
 			uint64_t sync;
+			struct iproto_trace *trace;
 		} net;
 	} storage;
 	/** An object to wait for incoming message or a reader. */
@@ -535,6 +543,8 @@ struct cord {
 	struct rlist ready;
 	/** A cache of dead fibers for reuse */
 	struct rlist dead;
+	/** A cache of dead fibers with small stacks for reuse */
+	struct rlist dead_small;
 	/** A watcher to have a single async event for all ready fibers.
 	 * This technique is necessary to be able to suspend
 	 * a single fiber on a few watchers (for example,
@@ -670,6 +680,17 @@ fiber_name(struct fiber *f)
 bool
 fiber_checkstack();
 
+/**
+ * Create a new fiber with a small stack, which is enough to
+ * handle a request in C, but not to run Lua or SQL code. Such
+ * fibers are much cheaper in memory than regular ones and are
+ * reused via their own cache.
+ *
+ * @sa fiber_new().
+ */
+struct fiber *
+fiber_new_small(const char *name, fiber_func f);
+
 /**
  * @brief yield & check for timeout
  * @return true if timeout exceeded
@@ -29,6 +29,42 @@
  * SUCH DAMAGE.
  */
 #include "fiber_pool.h"
+
+static void
+fiber_pool_run(struct fiber_pool *pool);
+
+/** Return true if @a msg may be handled by a small stack fiber. */
+static inline bool
+fiber_pool_msg_is_light(struct fiber_pool *pool, struct cmsg *msg)
+{
+	return pool->is_light != NULL && pool->is_light(msg);
+}
+
+/** The number of fibers in the pool. */
+static inline int
+fiber_pool_size(struct fiber_pool *pool)
+{
+	return pool->workers.size + pool->small_workers.size;
+}
+
+/**
+ * Take an idle fiber which can handle @a msg from the cache.
+ * Fibers with the default stack size can handle any message.
+ * Return NULL if there's no such fiber.
+ */
+static struct fiber *
+fiber_pool_take_idle(struct fiber_pool *pool, struct cmsg *msg)
+{
+	if (!rlist_empty(&pool->small_workers.idle) &&
+	    fiber_pool_msg_is_light(pool, msg))
+		return rlist_shift_entry(&pool->small_workers.idle,
+					 struct fiber, state);
+	if (!rlist_empty(&pool->workers.idle))
+		return rlist_shift_entry(&pool->workers.idle,
+					 struct fiber, state);
+	return NULL;
+}
+
 /**
  * Main function of the fiber invoked to handle all outstanding
  * tasks in a queue.
@@ -37,32 +73,59 @@ static int
 fiber_pool_f(va_list ap)
 {
 	struct fiber_pool *pool = va_arg(ap, struct fiber_pool *);
+	struct fiber_pool_workers *workers =
+		va_arg(ap, struct fiber_pool_workers *);
 	struct cord *cord = cord();
 	struct fiber *f = fiber();
 	struct ev_loop *loop = pool->consumer;
 	struct stailq *output = &pool->output;
 	struct cmsg *msg;
 	ev_tstamp last_active_at = ev_monotonic_now(loop);
-	pool->size++;
+	workers->size++;
 restart:
 	msg = NULL;
 	while (!stailq_empty(output) && !fiber_is_cancelled(fiber())) {
-		 msg = stailq_shift_entry(output, struct cmsg, fifo);
+		struct cmsg *next = stailq_first_entry(output, struct cmsg,
+						       fifo);
+		/*
+		 * Messages are started in the order they came, so
+		 * stop at one which needs a fiber with the default
+		 * stack size.
+		 */
+		if (workers->is_small && !fiber_pool_msg_is_light(pool, next))
+			break;
+		msg = stailq_shift_entry(output, struct cmsg, fifo);
 
-		if (f->caller == &cord->sched && ! stailq_empty(output) &&
-		    ! rlist_empty(&pool->idle)) {
+		if (f->caller == &cord->sched && ! stailq_empty(output)) {
 			/*
 			 * Activate a "backup" fiber for the next
 			 * message in the queue.
 			 */
-			f->caller = rlist_shift_entry(&pool->idle,
-						      struct fiber,
-						      state);
-			f->caller->flags |= FIBER_IS_READY;
-			assert(f->caller->caller == &cord->sched);
+			next = stailq_first_entry(output, struct cmsg, fifo);
+			struct fiber *backup = fiber_pool_take_idle(pool, next);
+			if (backup != NULL) {
+				f->caller = backup;
+				f->caller->flags |= FIBER_IS_READY;
+				assert(f->caller->caller == &cord->sched);
+			}
 		}
 		cmsg_deliver(msg);
 	}
+	if (!stailq_empty(output) && !fiber_is_cancelled(fiber())) {
+		assert(workers->is_small);
+		if (rlist_empty(&pool->workers.idle) &&
+		    fiber_pool_size(pool) >= pool->max_size) {
+			/*
+			 * Leave the pool to make room for a fiber
+			 * with the default stack size.
+			 */
+			workers->size--;
+			fiber_cond_signal(&pool->worker_cond);
+			fiber_pool_run(pool);
+			return 0;
+		}
+		fiber_pool_run(pool);
+	}
 	/** Put the current fiber into a fiber cache. */
 	if (!fiber_is_cancelled(fiber()) && (msg != NULL ||
 	    ev_monotonic_now(loop) - last_active_at < pool->idle_timeout)) {
@@ -72,11 +135,11 @@ restart:
 		 * Add the fiber to the front of the list, so that
 		 * it is most likely to get scheduled again.
 		 */
-		rlist_add_entry(&pool->idle, fiber(), state);
+		rlist_add_entry(&workers->idle, fiber(), state);
 		fiber_yield();
 		goto restart;
 	}
-	pool->size--;
+	workers->size--;
 	fiber_cond_signal(&pool->worker_cond);
 
 	return 0;
@@ -87,42 +150,66 @@ fiber_pool_idle_cb(ev_loop *loop, struct ev_timer *watcher, int events)
 {
 	(void) events;
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
-	if (! rlist_empty(&pool->idle)) {
+	struct fiber_pool_workers *all[] = {
+		&pool->workers, &pool->small_workers,
+	};
+	for (unsigned i = 0; i < lengthof(all); i++) {
+		if (rlist_empty(&all[i]->idle))
+			continue;
 		struct fiber *f;
 		/*
 		 * Schedule the fiber at the tail of the list,
 		 * it's the one most likely to have not been
 		 * scheduled lately.
 		 */
-		f = rlist_shift_tail_entry(&pool->idle, struct fiber, state);
+		f = rlist_shift_tail_entry(&all[i]->idle, struct fiber,
+					   state);
 		fiber_call(f);
 	}
 	ev_timer_again(loop, watcher);
 }
 
-/** Create fibers to handle all outstanding tasks. */
+/**
+ * Create fibers to handle all staged tasks. The limit on the
+ * number of fibers is shared by fibers of both stack sizes.
+ */
 static void
-fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
+fiber_pool_run(struct fiber_pool *pool)
 {
-	(void) loop;
-	(void) events;
-	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
-	/** Fetch messages */
-	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
-
 	struct stailq *output = &pool->output;
 	while (! stailq_empty(output)) {
-		struct fiber *f;
-		if (! rlist_empty(&pool->idle)) {
-			f = rlist_shift_entry(&pool->idle, struct fiber, state);
+		struct cmsg *msg = stailq_first_entry(output, struct cmsg,
+						      fifo);
+		bool is_light = fiber_pool_msg_is_light(pool, msg);
+		struct fiber *f = fiber_pool_take_idle(pool, msg);
+		if (f != NULL) {
 			fiber_call(f);
-		} else if (pool->size < pool->max_size) {
-			f = fiber_new(cord_name(cord()), fiber_pool_f);
+		} else if (fiber_pool_size(pool) < pool->max_size) {
+			struct fiber_pool_workers *workers;
+			if (is_light) {
+				workers = &pool->small_workers;
+				f = fiber_new_small(cord_name(cord()),
+						    fiber_pool_f);
+			} else {
+				workers = &pool->workers;
+				f = fiber_new(cord_name(cord()), fiber_pool_f);
+			}
 			if (f == NULL) {
 				diag_log();
 				break;
 			}
-			fiber_start(f, pool);
+			fiber_start(f, pool, workers);
+		} else if (!is_light &&
+			   !rlist_empty(&pool->small_workers.idle)) {
+			/*
+			 * Shut down an idle fiber with a small
+			 * stack to make room for one with the
+			 * default stack size.
+			 */
+			f = rlist_shift_tail_entry(&pool->small_workers.idle,
+						   struct fiber, state);
+			f->flags |= FIBER_IS_CANCELLED;
+			fiber_call(f);
 		} else {
 			/**
 			 * No worries that this watcher may not
@@ -136,26 +223,54 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	}
 }
 
+/** Create fibers to handle all outstanding tasks. */
+static void
+fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
+{
+	(void) loop;
+	(void) events;
+	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
+	/** Fetch messages */
+	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
+	fiber_pool_run(pool);
+}
+
 void
 fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size)
 {
 	pool->max_size = new_max_size;
 }
 
+void
+fiber_pool_set_is_light(struct fiber_pool *pool,
+			fiber_pool_is_light_f is_light)
+{
+	pool->is_light = is_light;
+}
+
+static void
+fiber_pool_workers_create(struct fiber_pool_workers *workers, bool is_small)
+{
+	rlist_create(&workers->idle);
+	workers->size = 0;
+	workers->is_small = is_small;
+}
+
 void
 fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 		  float idle_timeout)
 {
 	pool->consumer = loop();
 	pool->idle_timeout = idle_timeout;
-	rlist_create(&pool->idle);
+	fiber_pool_workers_create(&pool->workers, false);
+	fiber_pool_workers_create(&pool->small_workers, true);
+	pool->is_light = NULL;
+	stailq_create(&pool->output);
 	ev_timer_init(&pool->idle_timer, fiber_pool_idle_cb, 0,
 		      pool->idle_timeout);
 	pool->idle_timer.data = pool;
 	ev_timer_again(loop(), &pool->idle_timer);
-	pool->size = 0;
 	pool->max_size = max_pool_size;
-	stailq_create(&pool->output);
 	fiber_cond_create(&pool->worker_cond);
 	/* Join fiber pool to cbus */
 	cbus_endpoint_create(&pool->endpoint, name, fiber_pool_cb, pool);
@@ -175,13 +290,14 @@ fiber_pool_destroy(struct fiber_pool *pool)
 	 */
 	pool->idle_timeout = 0;
 	struct fiber *idle_fiber;
-	rlist_foreach_entry(idle_fiber, &pool->idle, state)
+	rlist_foreach_entry(idle_fiber, &pool->workers.idle, state)
+		fiber_wakeup(idle_fiber);
+	rlist_foreach_entry(idle_fiber, &pool->small_workers.idle, state)
 		fiber_wakeup(idle_fiber);
 	/**
 	 * Just wait on fiber exit condition until all fibers are done
 	 */
-	while (pool->size > 0)
+	while (pool->workers.size + pool->small_workers.size > 0)
 		fiber_cond_wait(&pool->worker_cond);
 	fiber_cond_destroy(&pool->worker_cond);
 }
-
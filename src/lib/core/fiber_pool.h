@@ -44,24 +44,59 @@ extern "C" {
 /** Period after which an idle fiber in the pool is shut down. */
 enum { FIBER_POOL_IDLE_TIMEOUT = 1 };
 
+/**
+ * Return true if a message may be handled by a fiber with
+ * a small stack, i.e. it doesn't run Lua or SQL code.
+ * @sa fiber_new_small().
+ */
+typedef bool
+(*fiber_pool_is_light_f)(struct cmsg *msg);
+
+/** Worker fibers of a pool which have the same stack size. */
+struct fiber_pool_workers {
+	/** Cache of fibers which work on incoming messages. */
+	struct rlist idle;
+	/** The number of fibers. */
+	int size;
+	/** Set if the fibers are created with fiber_new_small(). */
+	bool is_small;
+};
+
 /**
  * A pool of worker fibers to handle messages,
  * so that each message is handled in its own fiber.
  */
 struct fiber_pool {
 	struct {
-		/** Cache of fibers which work on incoming messages. */
-		alignas(CACHELINE_SIZE) struct rlist idle;
-		/** The number of fibers in the pool. */
-		int size;
-		/** The limit on the number of fibers working on tasks. */
+		/** Workers with the default stack size. */
+		alignas(CACHELINE_SIZE) struct fiber_pool_workers workers;
+		/**
+		 * Workers with small stacks which handle messages
+		 * accepted by @a is_light. A small stack costs much
+		 * less memory, so many more messages may be in
+		 * progress at once, e.g. waiting for WAL.
+		 */
+		struct fiber_pool_workers small_workers;
+		/**
+		 * Message classifier, NULL if all messages are
+		 * handled by workers with the default stack size.
+		 */
+		fiber_pool_is_light_f is_light;
+		/**
+		 * The limit on the number of fibers of both sizes
+		 * working on tasks.
+		 */
 		int max_size;
 		/**
 		 * Fibers in leave the pool if they have nothing to do
 		 * for longer than this.
 		 */
 		float idle_timeout;
-		/** Staged messages (for fibers to work on) */
+		/**
+		 * Staged messages (for fibers to work on). They are
+		 * started in the order they came, whatever stack
+		 * size they need.
+		 */
 		struct stailq output;
 		/** Timer for idle workers */
 		struct ev_timer idle_timer;
@@ -84,6 +119,16 @@ void
 fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 		  float idle_timeout);
 
+/**
+ * Let fibers with small stacks handle messages accepted by
+ * @a is_light. The classifier is called right before a message
+ * is handled, so a message which stopped being light while it
+ * was staged is handled by a fiber with the default stack size.
+ */
+void
+fiber_pool_set_is_light(struct fiber_pool *pool,
+			fiber_pool_is_light_f is_light);
+
 /**
  * Set maximal fiber pool size.
  * @param pool Fiber pool to set size.
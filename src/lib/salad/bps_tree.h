@@ -137,6 +137,7 @@
  * void bps_tree_destroy(tree);
  * int bps_tree_build(tree, sorted_array, array_size);
  * bps_tree_elem_t *bps_tree_find(tree, key);
+ * void bps_tree_find_batch(tree, keys, count, result);
  * int bps_tree_insert(tree, new_elem, replaced_elem);
  * int bps_tree_insert_get_iterator(tree, new_elem, replaced_elem,
  * 				    inserted_iterator)
@@ -357,6 +358,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_build _api_name(build)
 #define bps_tree_destroy _api_name(destroy)
 #define bps_tree_find _api_name(find)
+#define bps_tree_find_batch _api_name(find_batch)
 #define bps_tree_insert _api_name(insert)
 #define bps_tree_insert_get_iterator _api_name(insert_get_iterator)
 #define bps_tree_delete _api_name(delete)
@@ -394,6 +396,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define BPS_TREE_BT_LEAF _BPS_TREE(BT_LEAF)
 
 #define bps_tree_restore_block _bps_tree(restore_block)
+#define bps_tree_prefetch_block _bps_tree(prefetch_block)
 #define bps_tree_restore_block_ver _bps_tree(restore_block_ver)
 #define bps_tree_root _bps_tree(root)
 #define bps_tree_touch_block _bps_tree(touch_block)
@@ -608,6 +611,23 @@ bps_tree_destroy(struct bps_tree *tree);
 static inline bps_tree_elem_t *
 bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key);
 
+/**
+ * @brief Find the first elements that are equal to each of the keys.
+ * Same as calling bps_tree_find() for every key, but the keys are
+ *  looked up in groups that descend the tree level by level, and the
+ *  blocks of the next level are prefetched for the whole group before
+ *  any of them is visited, so that cache misses of different keys
+ *  overlap instead of following one after another.
+ * @param tree - pointer to a tree
+ * @param keys - array of keys that will be compared with elements
+ * @param count - number of keys
+ * @param result - array of count pointers, filled with pointers to the
+ *  first equal elements or NULL for keys that are not found
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **result);
+
 /**
  * @brief Insert an element to the tree or replace an element in the tree
  * In case of replacing, if 'replaced' argument is not null,
@@ -1276,6 +1296,17 @@ bps_tree_restore_block(const struct bps_tree *tree, bps_tree_block_id_t id)
 	return (struct bps_block *)matras_get(&tree->matras, id);
 }
 
+/**
+ * @brief Prefetch the cache lines of a block that a binary search
+ *  is going to visit first: the header and the middle element.
+ */
+static inline void
+bps_tree_prefetch_block(const struct bps_block *block)
+{
+	__builtin_prefetch(block);
+	__builtin_prefetch((const char *)block + BPS_TREE_BLOCK_SIZE / 2);
+}
+
 /**
  * @brief Get a pointer to block by it's ID and provided read view.
  */
@@ -2095,6 +2126,55 @@ bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key)
 		return 0;
 }
 
+/**
+ * @brief Find elements equal to each of the keys, see the declaration.
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **result)
+{
+	/* Number of lookups in flight, bounded by the CPU fill buffers. */
+	enum { GROUP_SIZE = 16 };
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		for (size_t k = 0; k < count; k++)
+			result[k] = 0;
+		return;
+	}
+	struct bps_block *root = bps_tree_root(tree);
+	struct bps_block *blocks[GROUP_SIZE];
+	for (size_t start = 0; start < count; start += GROUP_SIZE) {
+		size_t size = count - start < GROUP_SIZE ?
+			      count - start : GROUP_SIZE;
+		bps_tree_key_t *group = keys + start;
+		for (size_t k = 0; k < size; k++)
+			blocks[k] = root;
+		for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+			for (size_t k = 0; k < size; k++) {
+				struct bps_inner *inner =
+					(struct bps_inner *)blocks[k];
+				bool exact = false;
+				bps_tree_pos_t pos;
+				pos = bps_tree_find_ins_point_key(tree,
+						inner->elems,
+						inner->header.size - 1,
+						group[k], &exact);
+				blocks[k] = bps_tree_restore_block(tree,
+						inner->child_ids[pos]);
+				bps_tree_prefetch_block(blocks[k]);
+			}
+		}
+		for (size_t k = 0; k < size; k++) {
+			struct bps_leaf *leaf = (struct bps_leaf *)blocks[k];
+			bool exact = false;
+			bps_tree_pos_t pos;
+			pos = bps_tree_find_ins_point_key(tree, leaf->elems,
+							  leaf->header.size,
+							  group[k], &exact);
+			result[start + k] = exact ? leaf->elems + pos : 0;
+		}
+	}
+}
+
 /**
  * @brief Add a block to the garbage for future reuse
  */
@@ -6082,6 +6162,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_build
 #undef bps_tree_destroy
 #undef bps_tree_find
+#undef bps_tree_find_batch
 #undef bps_tree_insert
 #undef bps_tree_delete
 #undef bps_tree_delete_value
@@ -6117,6 +6198,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef BPS_TREE_BT_LEAF
 
 #undef bps_tree_restore_block
+#undef bps_tree_prefetch_block
 #undef bps_tree_restore_block_ver
 #undef bps_tree_root
 #undef bps_tree_touch_block
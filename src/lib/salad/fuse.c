@@ -0,0 +1,247 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "fuse.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+
+enum {
+	/* Max segment length, keeps positions in 18 bits of hash. */
+	FUSE_SEGMENT_LENGTH_MAX = 1 << 18,
+	/* Number of attempts to build a filter with new seeds. */
+	FUSE_MAX_ITERATIONS = 100,
+};
+
+static int
+fuse_hash_cmp(const void *a, const void *b)
+{
+	fuse_hash_t h1 = *(const fuse_hash_t *)a;
+	fuse_hash_t h2 = *(const fuse_hash_t *)b;
+	return h1 < h2 ? -1 : h1 > h2;
+}
+
+/** Sort hashes and remove duplicates. Returns the new count. */
+static uint32_t
+fuse_hash_unique(fuse_hash_t *hashes, uint32_t count)
+{
+	if (count <= 1)
+		return count;
+	qsort(hashes, count, sizeof(*hashes), fuse_hash_cmp);
+	uint32_t n = 1;
+	for (uint32_t i = 1; i < count; i++) {
+		if (hashes[i] != hashes[n - 1])
+			hashes[n++] = hashes[i];
+	}
+	return n;
+}
+
+/** splitmix64 generator used for picking seeds. */
+static uint64_t
+fuse_next_seed(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/** Choose the table geometry for the given number of values. */
+static void
+fuse_init_size(struct fuse *fuse, uint32_t count)
+{
+	uint32_t segment_length = 4;
+	if (count > 1) {
+		segment_length = 1U << (int)floor(log(count) / log(3.33) +
+						  2.25);
+	}
+	if (segment_length > FUSE_SEGMENT_LENGTH_MAX)
+		segment_length = FUSE_SEGMENT_LENGTH_MAX;
+	double size_factor = count <= 1 ? 0 :
+		fmax(1.125, 0.875 + 0.25 * log(1000000) / log(count));
+	uint64_t capacity = round(count * size_factor);
+	int64_t segment_count = (capacity + segment_length - 1) /
+				segment_length - 2;
+	if (segment_count < 1)
+		segment_count = 1;
+	fuse->segment_length = segment_length;
+	fuse->segment_count = segment_count;
+	fuse->table_size = (segment_count + 2) * segment_length;
+}
+
+/**
+ * Try to find an assignment of values to fingerprint slots
+ * by peeling: repeatedly take a slot referenced by exactly one
+ * value and assign the value to it. On success, the values are
+ * stored in the peeling order in @a stack along with the index
+ * (0..2) of the slot each value was assigned to.
+ */
+static bool
+fuse_peel(struct fuse *fuse, const fuse_hash_t *hashes, uint32_t count,
+	  uint64_t *stack, uint8_t *stack_pos, uint8_t *slot_count,
+	  uint64_t *slot_xor, uint32_t *queue)
+{
+	uint32_t size = fuse->table_size;
+	memset(slot_count, 0, size);
+	memset(slot_xor, 0, size * sizeof(*slot_xor));
+	/*
+	 * Every slot keeps the number of values referencing
+	 * it (upper 6 bits), xor of their slot indexes (lower
+	 * 2 bits) and xor of their mixed hashes, so that the
+	 * only value referencing a slot can be recovered.
+	 */
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t h = fuse_mix(hashes[i], fuse->seed);
+		for (int j = 0; j < 3; j++) {
+			uint32_t pos = fuse_pos(fuse, h, j);
+			if (slot_count[pos] >= 0xfc)
+				return false; /* counter overflow */
+			slot_count[pos] += 4;
+			slot_count[pos] ^= j;
+			slot_xor[pos] ^= h;
+		}
+	}
+	uint32_t queue_size = 0;
+	for (uint32_t pos = 0; pos < size; pos++) {
+		if ((slot_count[pos] >> 2) == 1)
+			queue[queue_size++] = pos;
+	}
+	uint32_t stack_size = 0;
+	while (queue_size > 0) {
+		uint32_t pos = queue[--queue_size];
+		if ((slot_count[pos] >> 2) != 1)
+			continue;
+		uint64_t h = slot_xor[pos];
+		uint8_t found = slot_count[pos] & 3;
+		stack[stack_size] = h;
+		stack_pos[stack_size] = found;
+		stack_size++;
+		for (int j = 0; j < 3; j++) {
+			uint32_t other = fuse_pos(fuse, h, j);
+			slot_count[other] -= 4;
+			slot_count[other] ^= j;
+			slot_xor[other] ^= h;
+			if (j != found && (slot_count[other] >> 2) == 1)
+				queue[queue_size++] = other;
+		}
+	}
+	return stack_size == count;
+}
+
+int
+fuse_create(struct fuse *fuse, fuse_hash_t *hashes, uint32_t count)
+{
+	count = fuse_hash_unique(hashes, count);
+	fuse_init_size(fuse, count);
+	uint32_t size = fuse->table_size;
+	fuse->table = calloc(size, sizeof(*fuse->table));
+	uint64_t *stack = malloc(count * sizeof(*stack) + 1);
+	uint8_t *stack_pos = malloc(count + 1);
+	uint8_t *slot_count = malloc(size);
+	uint64_t *slot_xor = malloc(size * sizeof(*slot_xor));
+	uint32_t *queue = malloc(size * sizeof(*queue));
+	int rc = -1;
+	if (fuse->table == NULL || stack == NULL || stack_pos == NULL ||
+	    slot_count == NULL || slot_xor == NULL || queue == NULL)
+		goto out;
+
+	uint64_t state = 0x726b2b9d438b9d4dULL;
+	bool done = false;
+	for (int i = 0; i < FUSE_MAX_ITERATIONS && !done; i++) {
+		fuse->seed = fuse_next_seed(&state);
+		done = fuse_peel(fuse, hashes, count, stack, stack_pos,
+				 slot_count, slot_xor, queue);
+	}
+	if (!done) {
+		/* Practically impossible for distinct hashes. */
+		goto out;
+	}
+	/*
+	 * Assign fingerprints in the reverse peeling order so
+	 * that a slot is set after all the other slots of its
+	 * value have been.
+	 */
+	for (uint32_t i = count; i-- > 0; ) {
+		uint64_t h = stack[i];
+		uint32_t pos[3];
+		for (int j = 0; j < 3; j++)
+			pos[j] = fuse_pos(fuse, h, j);
+		uint8_t found = stack_pos[i];
+		fuse->table[pos[found]] = fuse_fingerprint(h) ^
+			fuse->table[pos[(found + 1) % 3]] ^
+			fuse->table[pos[(found + 2) % 3]];
+	}
+	rc = 0;
+out:
+	free(stack);
+	free(stack_pos);
+	free(slot_count);
+	free(slot_xor);
+	free(queue);
+	if (rc != 0)
+		free(fuse->table);
+	return rc;
+}
+
+void
+fuse_destroy(struct fuse *fuse)
+{
+	free(fuse->table);
+}
+
+size_t
+fuse_store_size(const struct fuse *fuse)
+{
+	return fuse->table_size * sizeof(*fuse->table);
+}
+
+char *
+fuse_store(const struct fuse *fuse, char *table)
+{
+	size_t store_size = fuse_store_size(fuse);
+	memcpy(table, fuse->table, store_size);
+	return table + store_size;
+}
+
+int
+fuse_load_table(struct fuse *fuse, const char *table)
+{
+	size_t size = fuse_store_size(fuse);
+	fuse->table = malloc(size);
+	if (fuse->table == NULL)
+		return -1;
+	memcpy(fuse->table, table, size);
+	return 0;
+}
@@ -0,0 +1,197 @@
+#ifndef TARANTOOL_LIB_SALAD_FUSE_H_INCLUDED
+#define TARANTOOL_LIB_SALAD_FUSE_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Binary fuse filter with 8-bit fingerprints:
+ *  Graf, Thomas Mueller; Lemire, Daniel (2022)
+ *  "Binary Fuse Filters: Fast and Smaller Than Xor Filters"
+ *  https://arxiv.org/abs/2201.01174
+ *
+ * Unlike a bloom filter, the filter is built at once from
+ * a known set of values and can't be extended afterwards.
+ * It takes about 9 bits per value and has a fixed false positive
+ * rate of 1/256. A lookup touches three fingerprints which are
+ * located within a small window of the table.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+typedef uint32_t fuse_hash_t;
+
+/**
+ * Binary fuse filter data structure
+ */
+struct fuse {
+	/* Seed of the hash function. */
+	uint64_t seed;
+	/* Number of fingerprints in a segment, a power of 2. */
+	uint32_t segment_length;
+	/* Number of segments a value can start at. */
+	uint32_t segment_count;
+	/* Number of fingerprints in the table. */
+	uint32_t table_size;
+	/* Fingerprint table. */
+	uint8_t *table;
+};
+
+/* {{{ API declaration */
+
+/**
+ * Allocate a binary fuse filter and populate it
+ *
+ * @param fuse - structure to initialize
+ * @param hashes - hashes of the values to be stored in the filter;
+ *  the array is sorted and deduplicated in place
+ * @param count - number of hashes in the array
+ * @return 0 - OK, -1 - memory error or failure to find a mapping
+ *  of values to fingerprints (practically impossible)
+ */
+int
+fuse_create(struct fuse *fuse, fuse_hash_t *hashes, uint32_t count);
+
+/**
+ * Free resources of the fuse filter
+ *
+ * @param fuse - the fuse filter
+ */
+void
+fuse_destroy(struct fuse *fuse);
+
+/**
+ * Query for presence of a value in the data set
+ * @param fuse - the fuse filter
+ * @param hash - hash of the value
+ * @return true - the value could be in data set; false - the value is
+ *  definitively not in data set
+ */
+static inline bool
+fuse_maybe_has(const struct fuse *fuse, fuse_hash_t hash);
+
+/**
+ * Calculate size of a buffer that is needed for storing fuse table
+ * @param fuse - the fuse filter to store
+ * @return - Exact size
+ */
+size_t
+fuse_store_size(const struct fuse *fuse);
+
+/**
+ * Store fuse filter table to the given buffer
+ * Other struct fuse members must be stored manually.
+ * @param fuse - the fuse filter to store
+ * @param table - buffer to store to
+ * #return - end of written buffer
+ */
+char *
+fuse_store(const struct fuse *fuse, char *table);
+
+/**
+ * Allocate table and load it from given buffer.
+ * Other struct fuse members must be loaded manually.
+ *
+ * @param fuse - structure to load to
+ * @param table - data to load
+ * @return 0 - OK, -1 - memory error
+ */
+int
+fuse_load_table(struct fuse *fuse, const char *table);
+
+/* }}} API declaration */
+
+/* {{{ API definition */
+
+/** Mix a value hash with the filter seed (murmur3 finalizer). */
+static inline uint64_t
+fuse_mix(fuse_hash_t hash, uint64_t seed)
+{
+	uint64_t h = hash + seed;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint8_t
+fuse_fingerprint(uint64_t h)
+{
+	return (uint8_t)(h ^ (h >> 32));
+}
+
+/**
+ * Position of the i-th (0..2) fingerprint of a mixed hash.
+ * The first one is chosen among the first segment_count
+ * segments, the other two lie in the following segments.
+ */
+static inline uint32_t
+fuse_pos(const struct fuse *fuse, uint64_t h, int i)
+{
+	/* High 64 bits of h * (segment_count * segment_length). */
+	uint64_t range = (uint64_t)fuse->segment_count *
+			 fuse->segment_length;
+	uint64_t pos = ((h >> 32) * range +
+			(((h & UINT32_MAX) * range) >> 32)) >> 32;
+	pos += (uint64_t)i * fuse->segment_length;
+	uint64_t mask = fuse->segment_length - 1;
+	if (i == 1)
+		pos ^= (h >> 18) & mask;
+	else if (i == 2)
+		pos ^= h & mask;
+	return (uint32_t)pos;
+}
+
+static inline bool
+fuse_maybe_has(const struct fuse *fuse, fuse_hash_t hash)
+{
+	uint64_t h = fuse_mix(hash, fuse->seed);
+	uint8_t f = fuse_fingerprint(h);
+	f ^= fuse->table[fuse_pos(fuse, h, 0)];
+	f ^= fuse->table[fuse_pos(fuse, h, 1)];
+	f ^= fuse->table[fuse_pos(fuse, h, 2)];
+	return f == 0;
+}
+
+/* }}} API definition */
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_LIB_SALAD_FUSE_H_INCLUDED */
@@ -226,6 +226,25 @@ LIGHT(find)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_DATA_TYPE data);
 static inline uint32_t
 LIGHT(find_key)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_KEY_TYPE data);
 
+/**
+ * @brief Find records with given hashes and keys
+ * Same as calling LIGHT(find_key) for every key, but the first
+ * records of a group of keys are prefetched before any of them
+ * is compared, so that their cache misses overlap. Resolving
+ * a record address reads matras extents, which isn't
+ * prefetched: the extents are few and usually cached.
+ * @param ht - pointer to a hash table struct
+ * @param hashes - array of hashes to find
+ * @param keys - array of keys to find
+ * @param count - number of keys
+ * @param result - array of count integer IDs of found records,
+ *  light_end for keys that are not found
+ */
+static inline void
+LIGHT(find_key_batch)(const struct LIGHT(core) *ht, const uint32_t *hashes,
+		      LIGHT_KEY_TYPE *keys, uint32_t count,
+		      uint32_t *result);
+
 /**
  * @brief Insert a record with given hash and value
  * @param ht - pointer to a hash table struct
@@ -450,6 +469,31 @@ LIGHT(find_key)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_KEY_TYPE key)
 	return LIGHT(end);
 }
 
+/**
+ * @brief Find records with given hashes and keys, see the declaration.
+ */
+static inline void
+LIGHT(find_key_batch)(const struct LIGHT(core) *ht, const uint32_t *hashes,
+		      LIGHT_KEY_TYPE *keys, uint32_t count,
+		      uint32_t *result)
+{
+	/* Number of lookups in flight, bounded by the CPU fill buffers. */
+	enum { GROUP_SIZE = 16 };
+	for (uint32_t start = 0; start < count; start += GROUP_SIZE) {
+		uint32_t end = count - start < GROUP_SIZE ?
+			       count : start + GROUP_SIZE;
+		if (ht->count != 0) {
+			for (uint32_t k = start; k < end; k++) {
+				uint32_t slot = LIGHT(slot)(ht, hashes[k]);
+				__builtin_prefetch(matras_get(&ht->mtable,
+							      slot));
+			}
+		}
+		for (uint32_t k = start; k < end; k++)
+			result[k] = LIGHT(find_key)(ht, hashes[k], keys[k]);
+	}
+}
+
 /**
  * @brief Replace a record with given hash and value
  * @param ht - pointer to a hash table struct
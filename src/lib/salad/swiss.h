@@ -0,0 +1,1062 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "small/matras.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Open addressing hash table with tagged chunks.
+ *
+ * Values are stored in chunks of SWISS_CHUNK_SLOTS slots. Every
+ * chunk starts with an array of one byte tags, one per slot: zero
+ * for a free slot and seven bits of the value hash with the high
+ * bit set for an occupied one. A lookup compares the tags of a
+ * whole chunk against the tag of the looked up hash at once and
+ * only calls the comparison function for the slots that match, so
+ * in the common case it costs one chunk fetch and one comparison.
+ *
+ * A value is stored in the first chunk of its probe sequence that
+ * has a free slot. Every chunk counts the values that overflowed
+ * it on insertion, so a lookup stops at the first chunk with a
+ * zero overflow counter and deletion needs no tombstones.
+ *
+ * Chunks live in matras, which gives frozen iterators for free.
+ * The table grows by doubling, but the work is spread over the
+ * following modifications: first the new chunks are allocated a
+ * few at a time, then values are moved from the old table chunk
+ * by chunk. Lookups check both tables while a move is in progress.
+ */
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ * for all names of structs and functions in this header file.
+ * All names use pattern: swiss<SWISS_NAME>_<name of func/struct>
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing function.
+ * If not needed, simply use #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value1, value2 and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data comparing function. Takes 3 parameters - value, key and
+ * optional value that stored in hash table struct.
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Hash function of a stored value. Takes 2 parameters - value and
+ * optional value that stored in hash table struct. Hashes are not
+ * stored in the table, so it is used to move values on resize.
+ * Must return the same hash that was passed on insertion.
+ */
+#ifndef SWISS_HASH
+#error "SWISS_HASH must be defined"
+#endif
+
+#ifndef SWISS_COMMON_DEFINED
+#define SWISS_COMMON_DEFINED
+
+enum {
+	/** Number of slots in a chunk. */
+	SWISS_CHUNK_SLOTS = 14,
+	/**
+	 * Average number of values per chunk that triggers
+	 * growth of the table.
+	 */
+	SWISS_GROW_LOAD = 11,
+	/**
+	 * Average number of values per chunk at which growth
+	 * is finished synchronously.
+	 */
+	SWISS_MAX_LOAD = 13,
+	/** Number of chunks allocated per modification on grow. */
+	SWISS_GROW_STEP = 4,
+	/** Maximal value of a chunk overflow counter. */
+	SWISS_OVERFLOW_MAX = UINT8_MAX,
+};
+
+/** Tag of a hash stored in a chunk: 7 bits and the high bit. */
+static inline uint8_t
+swiss_tag(uint32_t hash)
+{
+	/*
+	 * Low bits of the hash select the chunk, so mix the
+	 * hash to get the tag bits independent from them.
+	 */
+	return 0x80 | ((hash * 0x9E3779B1u) >> 25);
+}
+
+/**
+ * Return a bit mask of slots of a chunk whose tag is @a tag.
+ * @a tags must point to 16 readable bytes.
+ */
+static inline uint32_t
+swiss_tag_match(const uint8_t *tags, uint8_t tag)
+{
+	const uint32_t slot_mask = (1u << SWISS_CHUNK_SLOTS) - 1;
+#if defined(__SSE2__)
+	__m128i group = _mm_loadu_si128((const __m128i *)tags);
+	__m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag));
+	return (uint32_t)_mm_movemask_epi8(match) & slot_mask;
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_CHUNK_SLOTS; i++)
+		mask |= (uint32_t)(tags[i] == tag) << i;
+	return mask & slot_mask;
+#endif
+}
+
+#endif /* SWISS_COMMON_DEFINED */
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#ifdef _
+#error '_' must be undefinded!
+#endif
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+/**
+ * A chunk of the hash table. Tags go first, so that all of them
+ * can be loaded with one 16 byte load.
+ */
+struct SWISS(chunk) {
+	/** Slot tags, see swiss_tag(). Zero marks a free slot. */
+	uint8_t tags[SWISS_CHUNK_SLOTS];
+	uint8_t unused;
+	/**
+	 * Number of values that have this chunk in their probe
+	 * sequence but are stored further because the chunk was
+	 * full. Saturates at SWISS_OVERFLOW_MAX.
+	 */
+	uint8_t overflow;
+	/** Values. */
+	SWISS_DATA_TYPE values[SWISS_CHUNK_SLOTS];
+};
+
+/**
+ * Type of functions for memory allocation and deallocation
+ */
+typedef void *(*SWISS(extent_alloc_t))(void *ctx);
+typedef void (*SWISS(extent_free_t))(void *ctx, void *extent);
+
+/** Chunk array of a fixed size. */
+struct SWISS(table) {
+	/** Chunks storage. */
+	struct matras mtable;
+	/** Number of chunks, a power of two. */
+	uint32_t chunk_count;
+	/** Number of values stored in the table. */
+	uint32_t count;
+	/** Number of frozen iterators that use the table. */
+	uint32_t view_count;
+	/**
+	 * Set if the table is not used by the hash table anymore
+	 * and is only kept alive by frozen iterators.
+	 */
+	bool is_retired;
+	/** Next table in the list of retired tables. */
+	struct SWISS(table) *next_retired;
+};
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/** Count of values in hash table. */
+	uint32_t count;
+	/** Table new values are inserted to, NULL if empty. */
+	struct SWISS(table) *table;
+	/**
+	 * Table of twice as many chunks that is being allocated
+	 * to replace @table, or NULL.
+	 */
+	struct SWISS(table) *next;
+	/** Table values are being moved from to @table, or NULL. */
+	struct SWISS(table) *old;
+	/** Chunk of @old to move next. */
+	uint32_t move_pos;
+	/** Retired tables kept alive by frozen iterators. */
+	struct SWISS(table) *retired;
+	/** Additional parameter for data comparison. */
+	SWISS_CMP_ARG_TYPE arg;
+	/** Memory allocator for tables. */
+	size_t extent_size;
+	SWISS(extent_alloc_t) extent_alloc;
+	SWISS(extent_free_t) extent_free;
+	void *alloc_ctx;
+};
+
+/**
+ * Iterator, for iterating all values in hash_table.
+ * It also may be used for restoring one value by key.
+ * The table that is being emptied by resize is visited first.
+ */
+struct SWISS(iterator) {
+	/** 0 - moved from table, 1 - main table, 2 - end. */
+	uint32_t stage;
+	/** Current position: chunk * SWISS_CHUNK_SLOTS + slot. */
+	uint32_t pos;
+	/** Set if the iterator was frozen. */
+	bool is_frozen;
+	/** Frozen tables, one per stage. */
+	struct SWISS(table) *tables[2];
+	/** Versions of matras memory for MVCC, one per stage. */
+	struct matras_view views[2];
+};
+
+/** Size of matras block that holds a chunk. */
+static inline uint32_t
+SWISS(block_size)(void)
+{
+	return 1u << (32 - __builtin_clz(sizeof(struct SWISS(chunk)) - 1));
+}
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param alloc_ctx - argument passed to memory block allocator
+ * @param arg - optional parameter to save for comparing function
+ */
+static inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      void *alloc_ctx, SWISS_CMP_ARG_TYPE arg)
+{
+	memset(ht, 0, sizeof(*ht));
+	ht->arg = arg;
+	ht->extent_size = extent_size;
+	ht->extent_alloc = extent_alloc_func;
+	ht->extent_free = extent_free_func;
+	ht->alloc_ctx = alloc_ctx;
+}
+
+/** Allocate a table of @a chunk_count chunks, none allocated. */
+static inline struct SWISS(table) *
+SWISS(table_new)(struct SWISS(core) *ht, uint32_t chunk_count)
+{
+	struct SWISS(table) *t = (struct SWISS(table) *)
+		calloc(1, sizeof(*t));
+	if (t == NULL)
+		return NULL;
+	matras_create(&t->mtable, ht->extent_size, SWISS(block_size)(),
+		      ht->extent_alloc, ht->extent_free, ht->alloc_ctx);
+	t->chunk_count = chunk_count;
+	return t;
+}
+
+static inline void
+SWISS(table_delete)(struct SWISS(table) *t)
+{
+	matras_destroy(&t->mtable);
+	free(t);
+}
+
+/**
+ * Allocate up to @a step chunks of a table that is not complete.
+ * @retval 0 success, -1 memory error
+ */
+static inline int
+SWISS(table_alloc)(struct SWISS(table) *t, uint32_t step)
+{
+	while (step-- > 0 && t->mtable.head.block_count < t->chunk_count) {
+		matras_id_t id;
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_alloc(&t->mtable, &id);
+		if (chunk == NULL)
+			return -1;
+		memset(chunk, 0, sizeof(*chunk));
+	}
+	return 0;
+}
+
+/**
+ * Stop using a table. It is deleted immediately unless there
+ * are frozen iterators that read it.
+ */
+static inline void
+SWISS(table_retire)(struct SWISS(core) *ht, struct SWISS(table) *t)
+{
+	if (t->view_count == 0) {
+		SWISS(table_delete)(t);
+		return;
+	}
+	t->is_retired = true;
+	t->next_retired = ht->retired;
+	ht->retired = t;
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * @param ht - pointer to a hash table struct
+ */
+static inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	if (ht->table != NULL)
+		SWISS(table_delete)(ht->table);
+	if (ht->next != NULL)
+		SWISS(table_delete)(ht->next);
+	if (ht->old != NULL)
+		SWISS(table_delete)(ht->old);
+	while (ht->retired != NULL) {
+		struct SWISS(table) *t = ht->retired;
+		ht->retired = t->next_retired;
+		SWISS(table_delete)(t);
+	}
+}
+
+/** Step between chunks of a probe sequence, always odd. */
+static inline uint32_t
+SWISS(probe_delta)(uint8_t tag)
+{
+	return 2 * (uint32_t)tag + 1;
+}
+
+/**
+ * Find a value equal to @a value in table @a t.
+ * Returns the chunk and sets @a slot or returns NULL.
+ */
+static inline struct SWISS(chunk) *
+SWISS(table_find)(const struct SWISS(core) *ht,
+		  const struct SWISS(table) *t, uint32_t hash,
+		  SWISS_DATA_TYPE value, uint32_t *chunk_id, uint32_t *slot)
+{
+	uint8_t tag = swiss_tag(hash);
+	uint32_t mask = t->chunk_count - 1;
+	uint32_t delta = SWISS(probe_delta)(tag);
+	uint32_t id = hash & mask;
+	for (uint32_t i = 0; i < t->chunk_count; i++) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, id);
+		uint32_t match = swiss_tag_match(chunk->tags, tag);
+		while (match != 0) {
+			uint32_t s = __builtin_ctz(match);
+			if (SWISS_EQUAL((chunk->values[s]), (value),
+					(ht->arg))) {
+				*chunk_id = id;
+				*slot = s;
+				return chunk;
+			}
+			match &= match - 1;
+		}
+		if (chunk->overflow == 0)
+			break;
+		id = (id + delta) & mask;
+	}
+	return NULL;
+}
+
+/**
+ * Find a value matching key @a key in table @a t.
+ * Returns the chunk and sets @a slot or returns NULL.
+ */
+static inline struct SWISS(chunk) *
+SWISS(table_find_key)(const struct SWISS(core) *ht,
+		      const struct SWISS(table) *t, uint32_t hash,
+		      SWISS_KEY_TYPE key, uint32_t *chunk_id, uint32_t *slot)
+{
+	uint8_t tag = swiss_tag(hash);
+	uint32_t mask = t->chunk_count - 1;
+	uint32_t delta = SWISS(probe_delta)(tag);
+	uint32_t id = hash & mask;
+	for (uint32_t i = 0; i < t->chunk_count; i++) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, id);
+		uint32_t match = swiss_tag_match(chunk->tags, tag);
+		while (match != 0) {
+			uint32_t s = __builtin_ctz(match);
+			if (SWISS_EQUAL_KEY((chunk->values[s]), (key),
+					    (ht->arg))) {
+				*chunk_id = id;
+				*slot = s;
+				return chunk;
+			}
+			match &= match - 1;
+		}
+		if (chunk->overflow == 0)
+			break;
+		id = (id + delta) & mask;
+	}
+	return NULL;
+}
+
+/**
+ * Insert a value to table @a t without checking duplicates.
+ * @retval 0 success, -1 memory error or the table is full
+ */
+static inline int
+SWISS(table_insert)(struct SWISS(table) *t, uint32_t hash,
+		    SWISS_DATA_TYPE value)
+{
+	uint8_t tag = swiss_tag(hash);
+	uint32_t mask = t->chunk_count - 1;
+	uint32_t delta = SWISS(probe_delta)(tag);
+	uint32_t home = hash & mask;
+	/* Find the chunk to insert to. */
+	uint32_t id = home;
+	uint32_t i;
+	for (i = 0; i < t->chunk_count; i++) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, id);
+		if (swiss_tag_match(chunk->tags, 0) != 0)
+			break;
+		id = (id + delta) & mask;
+	}
+	if (i == t->chunk_count)
+		return -1;
+	uint32_t target = id;
+	/*
+	 * Make all chunks on the way writable before changing
+	 * anything so that a memory error leaves the table intact.
+	 */
+	for (id = home; ; id = (id + delta) & mask) {
+		if (matras_touch(&t->mtable, id) == NULL)
+			return -1;
+		if (id == target)
+			break;
+	}
+	for (id = home; id != target; id = (id + delta) & mask) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, id);
+		if (chunk->overflow < SWISS_OVERFLOW_MAX)
+			chunk->overflow++;
+	}
+	struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+		matras_get(&t->mtable, target);
+	uint32_t s = __builtin_ctz(swiss_tag_match(chunk->tags, 0));
+	chunk->tags[s] = tag;
+	chunk->values[s] = value;
+	t->count++;
+	return 0;
+}
+
+/**
+ * Delete the value stored in @a slot of chunk @a target of
+ * table @a t. @a hash must be the hash of the value.
+ * @retval 0 success, -1 memory error
+ */
+static inline int
+SWISS(table_delete_at)(struct SWISS(table) *t, uint32_t hash,
+		       uint32_t target, uint32_t slot)
+{
+	uint8_t tag = swiss_tag(hash);
+	uint32_t mask = t->chunk_count - 1;
+	uint32_t delta = SWISS(probe_delta)(tag);
+	uint32_t home = hash & mask;
+	uint32_t id;
+	for (id = home; ; id = (id + delta) & mask) {
+		if (matras_touch(&t->mtable, id) == NULL)
+			return -1;
+		if (id == target)
+			break;
+	}
+	for (id = home; id != target; id = (id + delta) & mask) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, id);
+		assert(chunk->overflow > 0);
+		if (chunk->overflow < SWISS_OVERFLOW_MAX)
+			chunk->overflow--;
+	}
+	struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+		matras_get(&t->mtable, target);
+	assert(chunk->tags[slot] == tag);
+	chunk->tags[slot] = 0;
+	t->count--;
+	return 0;
+}
+
+/**
+ * Move values of the next chunk of the old table to the main
+ * table. Overflow counters of the old table are left as is:
+ * they only get larger than necessary, which is harmless.
+ * @retval 0 success, -1 memory error
+ */
+static inline int
+SWISS(move_chunk)(struct SWISS(core) *ht)
+{
+	struct SWISS(table) *old = ht->old;
+	assert(old != NULL && ht->move_pos < old->chunk_count);
+	struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+		matras_get(&old->mtable, ht->move_pos);
+	if (swiss_tag_match(chunk->tags, 0) !=
+	    (1u << SWISS_CHUNK_SLOTS) - 1) {
+		chunk = (struct SWISS(chunk) *)
+			matras_touch(&old->mtable, ht->move_pos);
+		if (chunk == NULL)
+			return -1;
+		for (uint32_t s = 0; s < SWISS_CHUNK_SLOTS; s++) {
+			if (chunk->tags[s] == 0)
+				continue;
+			uint32_t h = SWISS_HASH((chunk->values[s]),
+						(ht->arg));
+			if (SWISS(table_insert)(ht->table, h,
+						chunk->values[s]) != 0)
+				return -1;
+			chunk->tags[s] = 0;
+			old->count--;
+		}
+	}
+	if (++ht->move_pos == old->chunk_count) {
+		assert(old->count == 0);
+		ht->old = NULL;
+		SWISS(table_retire)(ht, old);
+	}
+	return 0;
+}
+
+/**
+ * Do a portion of the resize work, if any is in progress.
+ * @retval 0 success, -1 memory error
+ */
+static inline int
+SWISS(resize_step)(struct SWISS(core) *ht)
+{
+	if (ht->old != NULL)
+		return SWISS(move_chunk)(ht);
+	if (ht->next == NULL)
+		return 0;
+	struct SWISS(table) *next = ht->next;
+	if (SWISS(table_alloc)(next, SWISS_GROW_STEP) != 0)
+		return -1;
+	if (next->mtable.head.block_count == next->chunk_count) {
+		ht->old = ht->table;
+		ht->table = next;
+		ht->next = NULL;
+		ht->move_pos = 0;
+	}
+	return 0;
+}
+
+/**
+ * Prepare the table for insertion of one more value: allocate
+ * the first table, start growing or advance the resize.
+ * @retval 0 success, -1 memory error
+ */
+static inline int
+SWISS(prepare_insert)(struct SWISS(core) *ht)
+{
+	if (ht->table == NULL) {
+		struct SWISS(table) *t = SWISS(table_new)(ht, 1);
+		if (t == NULL)
+			return -1;
+		if (SWISS(table_alloc)(t, 1) != 0) {
+			SWISS(table_delete)(t);
+			return -1;
+		}
+		ht->table = t;
+		return 0;
+	}
+	struct SWISS(table) *t = ht->table;
+	if (ht->next == NULL && ht->old == NULL &&
+	    t->count >= t->chunk_count * SWISS_GROW_LOAD &&
+	    t->chunk_count <= UINT32_MAX / SWISS_CHUNK_SLOTS / 2) {
+		/* Failure is not fatal, we'll retry later. */
+		ht->next = SWISS(table_new)(ht, t->chunk_count * 2);
+		return 0;
+	}
+	/*
+	 * Resize is too slow to keep up with insertions,
+	 * finish it right away.
+	 */
+	while ((ht->next != NULL || ht->old != NULL) &&
+	       ht->table->count >= ht->table->chunk_count * SWISS_MAX_LOAD) {
+		if (SWISS(resize_step)(ht) != 0)
+			return -1;
+	}
+	/* Memory errors are reported by the insertion itself. */
+	(void)SWISS(resize_step)(ht);
+	return 0;
+}
+
+/**
+ * @brief Find a value with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find
+ * @return pointer to the found value or NULL if nothing found
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash,
+	    SWISS_DATA_TYPE value)
+{
+	uint32_t id, slot;
+	struct SWISS(chunk) *chunk = NULL;
+	if (ht->table != NULL)
+		chunk = SWISS(table_find)(ht, ht->table, hash, value,
+					  &id, &slot);
+	if (chunk == NULL && ht->old != NULL)
+		chunk = SWISS(table_find)(ht, ht->old, hash, value,
+					  &id, &slot);
+	return chunk != NULL ? &chunk->values[slot] : NULL;
+}
+
+/**
+ * @brief Find a value with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return pointer to the found value or NULL if nothing found
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash,
+		SWISS_KEY_TYPE key)
+{
+	uint32_t id, slot;
+	struct SWISS(chunk) *chunk = NULL;
+	if (ht->table != NULL)
+		chunk = SWISS(table_find_key)(ht, ht->table, hash, key,
+					      &id, &slot);
+	if (chunk == NULL && ht->old != NULL)
+		chunk = SWISS(table_find_key)(ht, ht->old, hash, key,
+					      &id, &slot);
+	return chunk != NULL ? &chunk->values[slot] : NULL;
+}
+
+/**
+ * @brief Find values with given hashes and keys. Same as calling
+ * find_key for every key, but the first chunks probed for a group
+ * of keys are prefetched before any of them is compared.
+ * @param ht - pointer to a hash table struct
+ * @param hashes - array of hashes to find
+ * @param keys - array of keys to find
+ * @param count - number of keys
+ * @param result - array of count pointers to the found values,
+ *  NULL for keys that are not found
+ */
+static inline void
+SWISS(find_key_batch)(const struct SWISS(core) *ht, const uint32_t *hashes,
+		      SWISS_KEY_TYPE *keys, uint32_t count,
+		      SWISS_DATA_TYPE **result)
+{
+	/* Number of lookups in flight, bounded by the CPU fill buffers. */
+	enum { GROUP_SIZE = 16 };
+	const struct SWISS(table) *t = ht->table;
+	for (uint32_t start = 0; start < count; start += GROUP_SIZE) {
+		uint32_t end = count - start < GROUP_SIZE ?
+			       count : start + GROUP_SIZE;
+		if (t != NULL) {
+			uint32_t mask = t->chunk_count - 1;
+			for (uint32_t k = start; k < end; k++)
+				__builtin_prefetch(matras_get(&t->mtable,
+						hashes[k] & mask));
+		}
+		for (uint32_t k = start; k < end; k++)
+			result[k] = SWISS(find_key)(ht, hashes[k], keys[k]);
+	}
+}
+
+/**
+ * @brief Insert a value with given hash. The value must not be
+ * in the table already.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param value - value to insert
+ * @return 0 if ok, -1 on memory error
+ */
+static inline int
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (SWISS(prepare_insert)(ht) != 0)
+		return -1;
+	if (SWISS(table_insert)(ht->table, hash, value) != 0)
+		return -1;
+	ht->count++;
+	return 0;
+}
+
+/**
+ * @brief Replace a value equal to the given one
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find and replace
+ * @param replaced - pointer to a value that was stored in table
+ *  before replace
+ * @return 0 if replaced, 1 if nothing found, -1 on memory error
+ */
+static inline int
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE value, SWISS_DATA_TYPE *replaced)
+{
+	struct SWISS(table) *t = ht->table;
+	uint32_t id, slot;
+	struct SWISS(chunk) *chunk = NULL;
+	if (t != NULL)
+		chunk = SWISS(table_find)(ht, t, hash, value, &id, &slot);
+	if (chunk == NULL && ht->old != NULL) {
+		t = ht->old;
+		chunk = SWISS(table_find)(ht, t, hash, value, &id, &slot);
+	}
+	if (chunk == NULL)
+		return 1;
+	chunk = (struct SWISS(chunk) *)matras_touch(&t->mtable, id);
+	if (chunk == NULL)
+		return -1;
+	*replaced = chunk->values[slot];
+	chunk->values[slot] = value;
+	return 0;
+}
+
+/**
+ * @brief Delete a value from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash of the value
+ * @param value - value to delete
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ */
+static inline int
+SWISS(delete_value)(struct SWISS(core) *ht, uint32_t hash,
+		    SWISS_DATA_TYPE value)
+{
+	/* Memory errors are reported by the deletion itself. */
+	(void)SWISS(resize_step)(ht);
+	struct SWISS(table) *t = ht->table;
+	uint32_t id, slot;
+	struct SWISS(chunk) *chunk = NULL;
+	if (t != NULL)
+		chunk = SWISS(table_find)(ht, t, hash, value, &id, &slot);
+	if (chunk == NULL && ht->old != NULL) {
+		t = ht->old;
+		chunk = SWISS(table_find)(ht, t, hash, value, &id, &slot);
+	}
+	if (chunk == NULL)
+		return 1;
+	if (SWISS(table_delete_at)(t, hash, id, slot) != 0)
+		return -1;
+	ht->count--;
+	return 0;
+}
+
+/**
+ * @brief Get a random value.
+ * @param ht - pointer to a hash table struct
+ * @param rnd - random number
+ * @return pointer to a value or NULL if the table is empty
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(random)(const struct SWISS(core) *ht, uint32_t rnd)
+{
+	const struct SWISS(table) *t = ht->table;
+	if (t == NULL || t->count == 0)
+		t = ht->old;
+	if (t == NULL || t->count == 0)
+		return NULL;
+	uint32_t slot_count = t->chunk_count * SWISS_CHUNK_SLOTS;
+	uint32_t pos = rnd % slot_count;
+	while (true) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, pos / SWISS_CHUNK_SLOTS);
+		uint32_t slot = pos % SWISS_CHUNK_SLOTS;
+		if (chunk->tags[slot] != 0)
+			return &chunk->values[slot];
+		if (++pos == slot_count)
+			pos = 0;
+	}
+}
+
+/**
+ * @brief Number of memory extents used by a hash table.
+ * @param ht - pointer to a hash table struct
+ */
+static inline size_t
+SWISS(extent_count)(const struct SWISS(core) *ht)
+{
+	size_t count = 0;
+	if (ht->table != NULL)
+		count += matras_extent_count(&ht->table->mtable);
+	if (ht->next != NULL)
+		count += matras_extent_count(&ht->next->mtable);
+	if (ht->old != NULL)
+		count += matras_extent_count(&ht->old->mtable);
+	for (struct SWISS(table) *t = ht->retired; t != NULL;
+	     t = t->next_retired)
+		count += matras_extent_count(&t->mtable);
+	return count;
+}
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+static inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht,
+		      struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	itr->stage = 0;
+	itr->pos = 0;
+	itr->is_frozen = false;
+}
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param key - key to find
+ */
+static inline void
+SWISS(iterator_key)(const struct SWISS(core) *ht,
+		    struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE key)
+{
+	uint32_t id, slot;
+	itr->is_frozen = false;
+	if (ht->table != NULL &&
+	    SWISS(table_find_key)(ht, ht->table, hash, key,
+				  &id, &slot) != NULL) {
+		itr->stage = 1;
+		itr->pos = id * SWISS_CHUNK_SLOTS + slot;
+	} else if (ht->old != NULL &&
+		   SWISS(table_find_key)(ht, ht->old, hash, key,
+					 &id, &slot) != NULL) {
+		itr->stage = 0;
+		itr->pos = id * SWISS_CHUNK_SLOTS + slot;
+	} else {
+		itr->stage = 2;
+		itr->pos = 0;
+	}
+}
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr)
+{
+	for (; itr->stage < 2; itr->stage++, itr->pos = 0) {
+		const struct SWISS(table) *t;
+		const struct matras_view *view;
+		if (itr->is_frozen) {
+			t = itr->tables[itr->stage];
+			view = &itr->views[itr->stage];
+		} else {
+			t = itr->stage == 0 ? ht->old : ht->table;
+			view = t != NULL ? &t->mtable.head : NULL;
+		}
+		if (t == NULL)
+			continue;
+		uint32_t slot_count = view->block_count * SWISS_CHUNK_SLOTS;
+		while (itr->pos < slot_count) {
+			uint32_t pos = itr->pos++;
+			struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+				matras_view_get(&t->mtable, view,
+						pos / SWISS_CHUNK_SLOTS);
+			uint32_t slot = pos % SWISS_CHUNK_SLOTS;
+			if (chunk->tags[slot] != 0)
+				return &chunk->values[slot];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Freezes state for given iterator. All following hash table
+ * modification will not apply to that iterator iteration. That
+ * iterator should be destroyed with a swiss_iterator_destroy call
+ * after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+static inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	assert(!itr->is_frozen);
+	itr->is_frozen = true;
+	itr->tables[0] = ht->old;
+	itr->tables[1] = ht->table;
+	for (int i = 0; i < 2; i++) {
+		struct SWISS(table) *t = itr->tables[i];
+		if (t == NULL)
+			continue;
+		matras_create_read_view(&t->mtable, &itr->views[i]);
+		t->view_count++;
+	}
+}
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for not
+ * frozen iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+static inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	if (!itr->is_frozen)
+		return;
+	itr->is_frozen = false;
+	for (int i = 0; i < 2; i++) {
+		struct SWISS(table) *t = itr->tables[i];
+		if (t == NULL)
+			continue;
+		matras_destroy_read_view(&t->mtable, &itr->views[i]);
+		assert(t->view_count > 0);
+		if (--t->view_count > 0 || !t->is_retired)
+			continue;
+		struct SWISS(table) **prev = &ht->retired;
+		while (*prev != t)
+			prev = &(*prev)->next_retired;
+		*prev = t->next_retired;
+		SWISS(table_delete)(t);
+	}
+}
+
+/*
+ * Selfcheck of the internal state of a table. Used only for
+ * debugging. If return not zero, something went terribly wrong.
+ */
+static inline int
+SWISS(table_selfcheck)(const struct SWISS(core) *ht,
+		       const struct SWISS(table) *t)
+{
+	int res = 0;
+	if ((t->chunk_count & (t->chunk_count - 1)) != 0)
+		res |= 1; /* chunk count is not a power of two */
+	if (t->mtable.head.block_count != t->chunk_count)
+		res |= 2; /* table is incomplete */
+	uint32_t count = 0;
+	uint32_t mask = t->chunk_count - 1;
+	for (uint32_t i = 0; i < t->mtable.head.block_count; i++) {
+		struct SWISS(chunk) *chunk = (struct SWISS(chunk) *)
+			matras_get(&t->mtable, i);
+		for (uint32_t s = 0; s < SWISS_CHUNK_SLOTS; s++) {
+			if (chunk->tags[s] == 0)
+				continue;
+			count++;
+			uint32_t h = SWISS_HASH((chunk->values[s]),
+						(ht->arg));
+			uint8_t tag = swiss_tag(h);
+			if (chunk->tags[s] != tag)
+				res |= 4; /* wrong tag */
+			uint32_t delta = SWISS(probe_delta)(tag);
+			uint32_t id = h & mask;
+			uint32_t step;
+			for (step = 0; step < t->chunk_count && id != i;
+			     step++) {
+				struct SWISS(chunk) *c =
+					(struct SWISS(chunk) *)
+					matras_get(&t->mtable, id);
+				if (c->overflow == 0)
+					res |= 8; /* unreachable value */
+				id = (id + delta) & mask;
+			}
+			if (id != i)
+				res |= 16; /* value off its probe sequence */
+		}
+	}
+	if (count != t->count)
+		res |= 32; /* wrong count */
+	return res;
+}
+
+/*
+ * Selfcheck of the internal state of hash table. Used only for
+ * debugging. That means that you should not use this function.
+ * If return not zero, something went terribly wrong.
+ */
+static inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	uint32_t count = 0;
+	if (ht->table != NULL) {
+		res |= SWISS(table_selfcheck)(ht, ht->table);
+		count += ht->table->count;
+	}
+	if (ht->old != NULL) {
+		/* Overflow counters of moved chunks may be stale. */
+		res |= SWISS(table_selfcheck)(ht, ht->old) & ~8;
+		count += ht->old->count;
+	}
+	if (ht->next != NULL && ht->next->count != 0)
+		res |= 64; /* values in a table being allocated */
+	if (count != ht->count)
+		res |= 128; /* wrong total count */
+	return res;
+}
@@ -0,0 +1,136 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that an empty space can be filled in bulk without
+-- per-row transactions and that the loaded data is persisted
+-- by a checkpoint.
+--
+local tap = require('tap')
+local fiber = require('fiber')
+local fio = require('fio')
+local msgpack = require('msgpack')
+local test = tap.test('bulk_load')
+test:plan(20)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+local s = box.schema.space.create('test', {format = {
+    {'id', 'unsigned'}, {'a', 'unsigned'}, {'b', 'string'},
+}})
+s:create_index('pk')
+s:create_index('a', {type = 'hash', parts = {2, 'unsigned'}})
+s:create_index('b', {parts = {3, 'string'}, unique = false})
+
+local count = 10000
+local function make_tuples(n)
+    local tuples = {}
+    for i = 1, n do
+        local id = (i * 7919) % n + 1
+        tuples[i] = {id, id * 2, string.format('%05d', id % 100)}
+    end
+    return tuples
+end
+
+local ref = box.schema.space.create('ref')
+ref:create_index('pk')
+box.begin()
+for _, t in ipairs(make_tuples(count)) do
+    ref:insert(t)
+end
+box.commit()
+
+local function last_checkpoint()
+    local checkpoints = box.info.gc().checkpoints
+    return checkpoints[#checkpoints].signature
+end
+
+local signature = last_checkpoint()
+local ok, err = pcall(s.bulk_load, s, make_tuples(count))
+test:ok(ok, "tuples are loaded")
+test:is(s:count(), count, "all tuples are in the primary key")
+test:is(s.index.a:count(), count, "all tuples are in the hash index")
+test:is(#s.index.b:select{'00042'}, count / 100, "non-unique index is built")
+test:is(s:bsize(), ref:bsize(), "space size is accounted")
+test:ok(last_checkpoint() > signature and
+        last_checkpoint() == box.info.signature, "checkpoint is made")
+s:replace{count + 1, 0, ''}
+test:is(s:get{count + 1}[2], 0, "space is writable after the load")
+
+ok, err = pcall(s.bulk_load, s, {{count + 2, 1, ''}})
+test:like(err, 'non%-empty spaces', "non-empty space")
+s:truncate()
+
+ok, err = pcall(s.bulk_load, s, {{1, 1, 'a'}, {2, 2, 'b'}, {1, 3, 'c'}})
+test:like(err, 'Duplicate key exists in unique index \'pk\'',
+          "duplicate in the primary key")
+ok, err = pcall(s.bulk_load, s, {{1, 1, 'a'}, {2, 2, 'b'}, {3, 1, 'c'}})
+test:like(err, 'Duplicate key exists in unique index \'a\'',
+          "duplicate in a secondary key")
+ok, err = pcall(s.bulk_load, s, {{1, 1, 'a'}, {2, 'x', 'b'}})
+test:like(err, 'type does not match', "invalid tuple")
+ok, err = pcall(s.bulk_load, s, {{1, 1, 'a'}, 2})
+test:like(err, 'Tuple/Key must be MsgPack array', "not an array")
+test:ok(s:count() == 0 and s.index.a:count() == 0 and
+        s.index.b:count() == 0 and s:bsize() == 0,
+        "space is left empty after errors")
+
+ok = pcall(s.bulk_load, s, msgpack.encode(make_tuples(100)))
+test:ok(ok and s:count() == 100, "tuples are loaded from MsgPack")
+s:truncate()
+
+-- The space can be neither read nor changed until the load is
+-- complete, so partially built indexes are never seen.
+local f = fiber.new(function()
+    s:bulk_load(make_tuples(count))
+end)
+f:set_joinable(true)
+local partial = false
+fiber.create(function()
+    while f:status() ~= 'dead' do
+        local ok1, n = pcall(s.index.a.count, s.index.a)
+        local ok2, rows = pcall(s.index.b.select, s.index.b, {'00042'})
+        if (ok1 and n ~= 0 and n ~= count) or
+           (ok2 and #rows ~= 0 and #rows ~= count / 100) then
+            partial = true
+        end
+        fiber.sleep(0)
+    end
+end)
+fiber.yield()
+ok, err = pcall(s.insert, s, {count + 1, 0, ''})
+local ok2, err2 = pcall(s.create_index, s, 'c', {parts = {2, 'unsigned'}})
+local ok3, err3 = pcall(s.get, s, {1})
+test:ok(not ok and not ok2 and not ok3 and
+        tostring(err):match('access to the space being loaded') and
+        tostring(err2):match('the space is being bulk loaded') and
+        tostring(err3):match('access to the space being loaded'),
+        "space is locked during the load")
+test:ok(f:join() and s:count() == count, "concurrent load is complete")
+test:ok(not partial, "partially loaded space is not visible")
+
+-- The loaded tuples are dropped if they can't be persisted.
+s:truncate()
+local dir = fio.pathjoin(box.cfg.memtx_dir,
+    string.format('%020d.snap.inprogress', box.info.signature + 1))
+fio.mkdir(dir)
+ok, err = pcall(s.bulk_load, s, make_tuples(100))
+fio.rmdir(dir)
+test:ok(not ok and s:count() == 0, "space is truncated if checkpoint fails")
+
+box.begin()
+ok, err = pcall(ref.bulk_load, ref, {})
+box.rollback()
+test:like(err, 'active transaction', "transactions are not allowed")
+
+local v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+v:create_index('pk')
+ok, err = pcall(v.bulk_load, v, {{1}})
+test:like(err, 'vinyl does not support bulk load', "vinyl")
+
+v:drop()
+ref:drop()
+s:drop()
+
+os.exit(test:check() and 0 or 1)
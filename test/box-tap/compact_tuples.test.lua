@@ -0,0 +1,75 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that memtx spaces can store tuples in the compact format.
+--
+local tap = require('tap')
+local test = tap.test('compact_tuples')
+test:plan(9)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+local function fill(space)
+    local used = box.slab.info().items_used
+    for i = 1, 1000 do
+        space:replace{i, i * 2, 'v' .. i}
+    end
+    return box.slab.info().items_used - used
+end
+
+local format = {
+    {name = 'id', type = 'unsigned'},
+    {name = 'val', type = 'unsigned'},
+    {name = 'str', type = 'string'},
+}
+local s1 = box.schema.space.create('regular', {format = format})
+s1:create_index('pk')
+s1:create_index('val', {parts = {2, 'unsigned'}})
+s1:create_index('str', {parts = {3, 'string'}})
+local s2 = box.schema.space.create('compact', {format = format,
+                                               compact_tuples = true})
+s2:create_index('pk')
+s2:create_index('val', {parts = {2, 'unsigned'}})
+s2:create_index('str', {parts = {3, 'string'}})
+
+local regular = fill(s1)
+local compact = fill(s2)
+test:ok(compact < regular, "compact tuples take less memory")
+
+test:is(s2:get{500}.str, 'v500', "lookup by primary key")
+test:is(s2.index.val:get{1000}.id, 500, "lookup by a leading field")
+test:is(s2.index.str:get{'v750'}.val, 1500, "lookup by a field after them")
+s2:update({10}, {{'=', 3, string.rep('x', 200)}})
+test:is(#s2:get{10}.str, 200, "tuples may grow past exact size pools")
+
+-- Tuples freed while a read view is open must stay readable.
+local rv = box.read_view.open({'compact'})
+for i = 1, 1000 do
+    s2:delete{i}
+end
+s2:replace{1, 1, 'new'}
+local count = 0
+for _, t in rv:pairs('compact') do
+    if t[2] == t[1] * 2 then
+        count = count + 1
+    end
+end
+rv:close()
+test:is(count, 1000, "read view sees tuples freed after it was opened")
+for i = 2, 1000 do
+    s2:replace{i, i, 'new'}
+end
+test:is(s2:count(), 1000, "space is usable after the read view is closed")
+
+local ok, err = pcall(box.schema.space.create, 'v',
+                      {engine = 'vinyl', compact_tuples = true})
+test:ok(not ok and err.code == box.error.ALTER_SPACE,
+        "vinyl doesn't support compact tuples")
+
+s1:drop()
+s2:drop()
+test:is(box.space._space.index.name:get{'compact'}, nil, "space is dropped")
+
+os.exit(test:check() and 0 or 1)
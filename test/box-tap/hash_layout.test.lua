@@ -0,0 +1,57 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check HASH indexes built with the swiss table layout.
+--
+local tap = require('tap')
+local test = tap.test('hash_layout')
+test:plan(15)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+local s = box.schema.space.create('test')
+local pk = s:create_index('pk', {type = 'hash', hash_layout = 'swiss'})
+local sk = s:create_index('sk', {type = 'hash', parts = {2, 'string'},
+                                 hash_layout = 'swiss'})
+test:is(pk.hash_layout, 'swiss', "layout is reported")
+
+for i = 1, 10000 do
+    s:replace{i, 'v' .. i}
+end
+test:is(pk:len(), 10000, "all tuples are inserted")
+test:is(s:get{5000}[2], 'v5000', "lookup by primary key")
+test:is(sk:get{'v777'}[1], 777, "lookup by secondary key")
+
+for i = 1, 10000, 2 do
+    s:delete{i}
+end
+test:is(sk:len(), 5000, "tuples are deleted")
+test:is(s:get{1}, nil, "deleted tuple is not found")
+
+local ok = pcall(s.insert, s, {2, 'x'})
+test:ok(not ok, "duplicate key is rejected")
+test:is(sk:get{'x'}, nil, "failed insert is rolled back")
+
+test:is(#pk:select({}, {iterator = 'all'}), 5000, "full scan")
+test:is(box.snapshot(), 'ok', "snapshot")
+
+ok = pcall(s.create_index, s, 'bad', {type = 'hash', hash_layout = 'foo'})
+test:ok(not ok, "unknown layout is rejected")
+local tree = s:create_index('tree', {type = 'tree', hash_layout = 'swiss'})
+test:is(tree.hash_layout, nil, "layout is ignored by a non-HASH index")
+sk:alter({type = 'tree'})
+sk = s.index.sk
+test:ok(sk.type == 'TREE' and sk.hash_layout == nil and
+        box.space._index:get{s.id, sk.id}.opts.hash_layout == nil,
+        "layout is cleared when a HASH index is altered to TREE")
+
+s:drop()
+
+local v = box.schema.space.create('v', {engine = 'vinyl'})
+ok = pcall(v.create_index, v, 'pk', {hash_layout = 'swiss'})
+test:ok(not ok, "vinyl rejects the layout")
+v:drop()
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,95 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that net.box can look up a batch of keys in one request.
+--
+local tap = require('tap')
+local net_box = require('net.box')
+local test = tap.test('net.box_get_batch')
+test:plan(15)
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    log = 'tarantool.log',
+}
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+local s = box.schema.space.create('test')
+s:create_index('pk', {parts = {1, 'unsigned'}})
+s:create_index('sk', {parts = {2, 'string'}})
+s:create_index('nu', {parts = {3, 'unsigned'}, unique = false})
+local h = box.schema.space.create('hash')
+h:create_index('pk', {type = 'hash'})
+h:create_index('sk', {type = 'hash', parts = {2, 'unsigned'},
+                      hash_layout = 'swiss'})
+for i = 1, 10 do
+    s:replace{i, 'v' .. i, i % 2}
+end
+for i = 1, 1000 do
+    h:replace{i, i * 2}
+end
+
+local c = net_box.connect(box.cfg.listen)
+local rs = c.space.test
+
+local res = rs:get_batch({{3}, {20}, 7, {1}})
+test:is(#res, 4, "one result per key")
+test:is(res[1][1], 3, "found first key")
+test:is(res[2], box.NULL, "missing key is null")
+test:is(res[3][2], 'v7', "scalar key is accepted")
+test:is(res[4][1], 1, "results preserve key order")
+
+res = rs.index.sk:get_batch({{'v5'}, {'v9'}})
+test:is(res[1][1] + res[2][1], 14, "lookup by secondary index")
+
+test:is(#rs:get_batch({}), 0, "empty batch")
+
+--
+-- Keys 1..1000 are present, the rest are not. Use batches larger
+-- than an index lookup group to check that groups are stitched.
+--
+local function check_batch(index, n, mult)
+    local keys = {}
+    for i = 1, n do
+        keys[i] = {i * mult}
+    end
+    local res = index:get_batch(keys)
+    if #res ~= n then
+        return false
+    end
+    for i = 1, n do
+        if (res[i] == nil) ~= (i > 1000) or
+           (res[i] ~= nil and res[i][1] ~= i) then
+            return false
+        end
+    end
+    return true
+end
+test:ok(check_batch(c.space.hash.index.pk, 1500, 1), "lookup in hash index")
+test:ok(check_batch(c.space.hash.index.sk, 1500, 2),
+        "lookup in swiss hash index")
+test:ok(check_batch(c.space.hash.index.pk, 0, 1), "empty batch in hash index")
+
+res = c.space.test:get_batch({{2}}, {is_async = true}):wait_result()
+test:is(res[1][1], 2, "async request")
+
+local ok, err = pcall(rs.index.nu.get_batch, rs.index.nu, {{1}})
+test:ok(not ok and err.code == box.error.MORE_THAN_ONE_TUPLE,
+        "non-unique index is rejected")
+
+ok, err = pcall(rs.get_batch, rs, {{1}, {'x'}})
+test:ok(not ok and err.code == box.error.KEY_PART_TYPE,
+        "invalid key is rejected")
+
+ok, err = pcall(rs.get_batch, rs, {{1, 2}})
+test:ok(not ok and err.code == box.error.EXACT_MATCH,
+        "partial or extra key parts are rejected")
+
+test:is(c:ping(), true, "connection is alive after errors")
+
+c:close()
+s:drop()
+h:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+
+os.exit(test:check() and 0 or 1)
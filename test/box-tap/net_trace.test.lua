@@ -0,0 +1,70 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that sampled iproto requests are timestamped along
+-- their path and reported by box.stat.net.trace().
+--
+local tap = require('tap')
+local net_box = require('net.box')
+local test = tap.test('net_trace')
+test:plan(14)
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    log = 'tarantool.log',
+}
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+
+test:is(box.stat.net.trace().count, 0, "requests are not traced by default")
+local ok = pcall(box.cfg, {net_trace_rate = 2})
+test:ok(not ok, "rate must not be greater than 1")
+ok = pcall(box.cfg, {net_trace_slow_threshold = -1})
+test:ok(not ok, "slow threshold must not be negative")
+
+local c = net_box.connect(box.cfg.listen)
+box.cfg{net_trace_rate = 1, net_trace_slow_threshold = 0}
+for i = 1, 10 do
+    c.space.test:replace{i}
+end
+c.space.test:select{}
+c:ping()
+
+local stat = box.stat.net.trace()
+test:is(stat.count, 12, "all requests are traced")
+test:ok(stat.total.p99 > 0, "total latency is collected")
+test:ok(stat.stages.wal_write.p50 > 0, "WAL write latency is collected")
+test:ok(stat.stages.flush.p50 > 0, "flush latency is collected")
+test:is(#stat.slow, 12, "slow requests are kept")
+
+local replace = stat.slow[1]
+local select = stat.slow[11]
+test:is(replace.type, 'REPLACE', "request type is kept")
+test:ok(replace.stages.wal_submit ~= nil and replace.stages.wal_write ~= nil and
+        replace.stages.wal_sync == nil, "write request passes WAL")
+test:ok(select.type == 'SELECT' and select.stages.wal_write == nil and
+        select.stages.reply ~= nil, "read request doesn't pass WAL")
+
+for i = 1, 100 do
+    c.space.test:get{i}
+end
+stat = box.stat.net.trace()
+test:is(#stat.slow, 32, "only the latest slow requests are kept")
+
+box.stat.reset()
+box.cfg{net_trace_rate = 0.25, net_trace_slow_threshold = 10}
+for i = 1, 100 do
+    c.space.test:get{i}
+end
+stat = box.stat.net.trace()
+test:is(stat.count, 25, "requests are sampled")
+test:is(#stat.slow, 0, "fast requests are not slow")
+
+box.cfg{net_trace_rate = 0}
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+
+os.exit(test:check() and 0 or 1)
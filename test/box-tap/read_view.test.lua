@@ -0,0 +1,77 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that a read view gives a consistent picture of spaces
+-- that keep changing while they are scanned.
+--
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('read_view')
+test:plan(10)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+local s1 = box.schema.space.create('s1')
+s1:create_index('pk')
+local s2 = box.schema.space.create('s2')
+s2:create_index('pk', {type = 'hash'})
+local v = box.schema.space.create('v', {engine = 'vinyl'})
+v:create_index('pk')
+for i = 1, 1000 do
+    s1:replace{i, i}
+    s2:replace{i, -i}
+end
+
+local rv = box.read_view.open({'s1', s2.id})
+
+local function scan(space)
+    local count, sum = 0, 0
+    for _, t in rv:pairs(space) do
+        count = count + 1
+        sum = sum + t[2]
+        if count % 100 == 0 then
+            fiber.yield()
+        end
+    end
+    return count, sum
+end
+
+-- Change the spaces while they are scanned.
+local writer = fiber.create(function()
+    for i = 1, 1000 do
+        s1:delete{i}
+        s2:replace{i + 1000, i}
+        if i % 10 == 0 then
+            fiber.yield()
+        end
+    end
+end)
+writer:set_joinable(true)
+
+local count, sum = scan('s1')
+test:is(count, 1000, "tree index: all tuples are seen")
+test:is(sum, 500500, "tree index: no changes are seen")
+count, sum = scan('s2')
+test:is(count, 1000, "hash index: all tuples are seen")
+test:is(sum, -500500, "hash index: no changes are seen")
+writer:join()
+test:is(s1:len(), 0, "writer was not blocked")
+
+test:is(select('#', rv:pairs('s1')()), 0, "a scanned space is exhausted")
+rv:close()
+test:ok(not pcall(rv.pairs, rv, 's1'), "closed read view can't be scanned")
+
+test:ok(not pcall(box.read_view.open, {'v'}), "vinyl is not supported")
+test:ok(not pcall(box.read_view.open, {'no_such_space'}),
+        "unknown space is rejected")
+rv = box.read_view.open({'s1'})
+test:ok(not pcall(rv.pairs, rv, 's2'), "space is not in the read view")
+rv:close()
+
+s1:drop()
+s2:drop()
+v:drop()
+
+os.exit(test:check() and 0 or 1)
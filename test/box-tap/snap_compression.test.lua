@@ -0,0 +1,61 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that a snapshot compressed in coio threads is written
+-- in order and can be read back.
+--
+local tap = require('tap')
+local fio = require('fio')
+local xlog = require('xlog').pairs
+local test = tap.test('snap_compression')
+test:plan(9)
+
+box.cfg{log = 'tarantool.log', snap_compression_threads = 4}
+
+test:ok(not pcall(box.cfg, {snap_compression_level = 0}),
+        'invalid compression level')
+test:ok(not pcall(box.cfg, {snap_compression_threads = -1}),
+        'invalid thread count')
+test:ok(not pcall(box.cfg, {wal_compression_level = 100}),
+        'invalid wal compression level')
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+
+local ROW_COUNT = 20000
+box.begin()
+for i = 1, ROW_COUNT do
+    s:insert{i, string.rep('x', 100) .. i}
+end
+box.commit()
+
+box.cfg{snap_compression_level = 5, wal_compression_level = 1}
+test:ok(pcall(box.snapshot), 'snapshot is written')
+
+local stat = box.info.gc().checkpoint_compression
+test:ok(stat.input > 0, 'compression input')
+test:ok(stat.output > 0 and stat.output < stat.input, 'compression output')
+test:ok(stat.time > 0 and stat.rate > 0, 'compression rate')
+
+local snap = fio.pathjoin(box.cfg.memtx_dir,
+                          string.format('%020d.snap', box.info.signature))
+local count = 0
+local in_order = true
+local prev_lsn = 0
+for _, row in xlog(snap) do
+    if row.HEADER.lsn <= prev_lsn then
+        in_order = false
+    end
+    prev_lsn = row.HEADER.lsn
+    if row.BODY.space_id == s.id then
+        count = count + 1
+        if row.BODY.tuple[1] ~= count then
+            in_order = false
+        end
+    end
+end
+test:is(count, ROW_COUNT, 'all rows are in the snapshot')
+test:ok(in_order, 'rows are written in order')
+
+s:drop()
+os.exit(test:check() and 0 or 1)
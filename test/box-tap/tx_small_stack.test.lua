@@ -0,0 +1,110 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that simple requests are handled by tx fibers with small
+-- stacks, while requests which may run Lua get full size stacks.
+--
+local tap = require('tap')
+local net_box = require('net.box')
+local fiber = require('fiber')
+local test = tap.test('tx_small_stack')
+test:plan(7)
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    log = 'tarantool.log',
+    net_msg_max = 4096,
+}
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+
+local c = net_box.connect(box.cfg.listen)
+local rs = c.space.test
+
+local function replace_many(n)
+    local futures = {}
+    for i = 1, n do
+        futures[i] = rs:replace({i, i}, {is_async = true})
+    end
+    for i = 1, n do
+        if futures[i]:wait_result()[1] ~= i then
+            return false
+        end
+    end
+    return true
+end
+
+test:ok(replace_many(3000), "many writes are in flight at once")
+test:is(s:count(), 3000, "all writes are done")
+
+-- Fibers with a small stack take less than this in fiber.info().
+local SMALL_STACK_MAX = 256 * 1024
+
+local function fiber_memory(f)
+    return fiber.info({backtrace = false})[f:id()].memory.total
+end
+
+-- Check the stack of fibers handling writes blocked on WAL.
+local errinj = box.error.injection
+if type(errinj) == 'table' then
+    errinj.set('ERRINJ_WAL_DELAY', true)
+    local futures = {}
+    for i = 1, 100 do
+        futures[i] = rs:replace({i, -i}, {is_async = true})
+    end
+    local function all_replaced()
+        for i = 1, 100 do
+            if s:get{i}[2] ~= -i then
+                return false
+            end
+        end
+        return true
+    end
+    while not all_replaced() do
+        fiber.sleep(0.01)
+    end
+    local small = 0
+    for _, f in pairs(fiber.info({backtrace = false})) do
+        if f.memory.total < SMALL_STACK_MAX then
+            small = small + 1
+        end
+    end
+    errinj.set('ERRINJ_WAL_DELAY', false)
+    for i = 1, 100 do
+        futures[i]:wait_result()
+    end
+    test:ok(small >= 100, "writes run on small stacks")
+else
+    test:skip("writes run on small stacks")
+end
+
+-- A trigger makes writes to the space run on full size stacks.
+local depth = 0
+local function recurse(n)
+    depth = depth + 1
+    if n > 0 then
+        return recurse(n - 1) + 1
+    end
+    return 0
+end
+local on_full_stack = true
+s:on_replace(function()
+    recurse(100)
+    if fiber_memory(fiber.self()) < SMALL_STACK_MAX then
+        on_full_stack = false
+    end
+end)
+test:ok(replace_many(500), "writes with a trigger are done")
+test:is(depth, 500 * 101, "trigger runs for each write")
+test:ok(on_full_stack, "writes with a trigger run on full size stacks")
+
+local res = rs:select({}, {limit = 10})
+test:is(#res, 10, "select is handled")
+
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,74 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that vinyl point lookups read older runs ahead and
+-- still return the newest visible version.
+--
+local tap = require('tap')
+local test = tap.test('vinyl_lookup_prefetch')
+test:plan(8)
+
+box.cfg{
+    log = 'tarantool.log',
+    vinyl_cache = 0,
+    vinyl_page_cache = 0,
+}
+
+test:is(box.cfg.vinyl_lookup_prefetch, 1, "default prefetch")
+local ok = pcall(box.cfg, {vinyl_lookup_prefetch = -1})
+test:ok(not ok, "prefetch must not be negative")
+
+local s = box.schema.space.create('test', {engine = 'vinyl'})
+local pk = s:create_index('pk', {run_count_per_level = 10})
+-- Every key has a REPLACE in the oldest run and UPSERTs in
+-- the others, so a lookup has to read all runs.
+for r = 1, 4 do
+    for i = 1, 100 do
+        s:upsert({i, 1}, {{'+', 2, 1}})
+    end
+    box.snapshot()
+end
+
+local function lookups()
+    return pk:stat().disk.iterator.lookup
+end
+
+local function get_all()
+    local result = {}
+    for i = 1, 100 do
+        table.insert(result, s:get{i}[2])
+    end
+    return result
+end
+
+box.cfg{vinyl_lookup_prefetch = 0}
+local count = lookups()
+local serial = get_all()
+local serial_lookups = lookups() - count
+
+box.cfg{vinyl_lookup_prefetch = 10}
+count = lookups()
+local parallel = get_all()
+test:is_deeply(parallel, serial, "same results with prefetch")
+test:is(serial[1], 4, "all runs are read")
+test:is(lookups() - count, serial_lookups, "same number of lookups")
+
+-- Now the newest run shadows the older ones.
+s:replace{1, 100}
+box.snapshot()
+
+box.cfg{vinyl_lookup_prefetch = 0}
+count = lookups()
+local v1 = s:get{1}[2]
+local serial_count = lookups() - count
+box.cfg{vinyl_lookup_prefetch = 10}
+count = lookups()
+local v2 = s:get{1}[2]
+local parallel_count = lookups() - count
+test:ok(v1 == 100 and v2 == 100, "newest version is returned")
+test:is(serial_count, 1, "serial lookup stops at the newest run")
+test:is(parallel_count, 5, "older runs are read ahead")
+
+s:drop()
+
+os.exit(test:check() and 0 or 1)
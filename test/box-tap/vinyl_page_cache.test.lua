@@ -0,0 +1,47 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that vinyl caches pages read from disk.
+--
+local tap = require('tap')
+local test = tap.test('vinyl_page_cache')
+test:plan(7)
+
+box.cfg{
+    log = 'tarantool.log',
+    vinyl_cache = 0,
+    vinyl_page_size = 1024,
+    vinyl_page_cache = 1024 * 1024,
+}
+
+local s = box.schema.space.create('test', {engine = 'vinyl'})
+local pk = s:create_index('pk')
+for i = 1, 1000 do
+    s:replace{i, string.rep('x', 100)}
+end
+box.snapshot()
+
+local function iterator_stat()
+    return pk:stat().disk.iterator
+end
+
+test:is(box.stat.vinyl().memory.page_cache, 0, "cache is empty after dump")
+
+s:get{500}
+local st = iterator_stat()
+test:is(st.page_cache.miss, 1, "first read is a cache miss")
+test:is(st.read.pages, 1, "first read goes to disk")
+
+s:get{500}
+s:get{500}
+st = iterator_stat()
+test:is(st.page_cache.hit, 2, "reads of the same page are cache hits")
+test:is(st.read.pages, 1, "cache hits don't go to disk")
+test:ok(box.stat.vinyl().memory.page_cache > 0, "memory usage is reported")
+
+box.cfg{vinyl_page_cache = 0}
+test:is(box.stat.vinyl().memory.page_cache, 0, "cache is purged on resize")
+
+s:drop()
+
+os.exit(test:check() and 0 or 1)
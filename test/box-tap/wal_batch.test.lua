@@ -0,0 +1,58 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check WAL group commit settings and batch statistics.
+--
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('wal_batch')
+test:plan(11)
+
+box.cfg{log = 'tarantool.log'}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+
+local function insert_concurrently(count)
+    local ch = fiber.channel(count)
+    for i = 1, count do
+        fiber.create(function()
+            ch:put(pcall(s.replace, s, {i}))
+        end)
+    end
+    local ok = true
+    for _ = 1, count do
+        ok = ch:get() and ok
+    end
+    return ok
+end
+
+test:ok(not pcall(box.cfg, {wal_commit_delay = -1}),
+        'negative commit delay')
+test:ok(not pcall(box.cfg, {wal_batch_max_size = -1}),
+        'negative batch size')
+
+box.stat.reset()
+local stat = box.stat.wal()
+test:is(stat.batches, 0, 'batches are reset')
+test:is(stat.rows, 0, 'rows are reset')
+
+-- Every transaction makes a batch of its own.
+box.cfg{wal_batch_max_size = 1}
+test:ok(insert_concurrently(100), 'small batches are written')
+stat = box.stat.wal()
+test:is(stat.batches, 100, 'batch count')
+test:is(stat.rows, 100, 'row count')
+test:is(stat.sync.count, 0, 'no syncs in write mode')
+
+-- Concurrent transactions are written in one batch.
+box.cfg{wal_batch_max_size = 0, wal_commit_delay = 0.01}
+box.stat.reset()
+test:ok(insert_concurrently(100), 'delayed batches are written')
+stat = box.stat.wal()
+test:ok(stat.rows_per_batch > 1, 'transactions are grouped')
+test:ok(stat.bytes_per_write > 0, 'bytes per write')
+
+box.cfg{wal_commit_delay = 0}
+s:drop()
+os.exit(test:check() and 0 or 1)
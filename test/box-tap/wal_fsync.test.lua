@@ -0,0 +1,94 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that transactions are committed while fdatasync() of
+-- previous WAL batches is in progress in fsync mode.
+--
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('wal_fsync')
+test:plan(7)
+
+box.cfg{
+    log = 'tarantool.log',
+    wal_mode = 'fsync',
+    -- Rotate WAL files often to drain the sync queue.
+    wal_max_size = 64 * 1024,
+}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+
+local FIBER_COUNT = 100
+local ROW_COUNT = 20
+local errors = 0
+local ch = fiber.channel(FIBER_COUNT)
+for i = 1, FIBER_COUNT do
+    fiber.create(function()
+        for j = 1, ROW_COUNT do
+            local id = (i - 1) * ROW_COUNT + j
+            if not pcall(s.insert, s, {id, string.rep('x', 100)}) then
+                errors = errors + 1
+            end
+        end
+        ch:put(true)
+    end)
+end
+for _ = 1, FIBER_COUNT do
+    ch:get()
+end
+
+test:is(errors, 0, 'all transactions are committed')
+test:is(s:count(), FIBER_COUNT * ROW_COUNT, 'all rows are inserted')
+test:ok(pcall(box.snapshot), 'checkpoint waits for pending syncs')
+s:insert{FIBER_COUNT * ROW_COUNT + 1}
+test:is(s:count(), FIBER_COUNT * ROW_COUNT + 1, 'writes after checkpoint')
+
+--
+-- A failed write is rolled back while fibers keep the sync queue
+-- full: the rollback must not wait for the queue to drain.
+--
+local errinj = box.error.injection
+if type(errinj) == 'table' then
+    local count = s:count()
+    local next_id = count + 1
+    local committed = 0
+    local failed = 0
+    local stop = false
+    for _ = 1, FIBER_COUNT do
+        fiber.create(function()
+            while not stop do
+                local id = next_id
+                next_id = next_id + 1
+                if pcall(s.insert, s, {id}) then
+                    committed = committed + 1
+                else
+                    failed = failed + 1
+                end
+            end
+            ch:put(true)
+        end)
+    end
+    fiber.sleep(0.1)
+    errinj.set('ERRINJ_WAL_WRITE', true)
+    fiber.sleep(0.1)
+    errinj.set('ERRINJ_WAL_WRITE', false)
+    fiber.sleep(0.1)
+    stop = true
+    local finished = 0
+    for _ = 1, FIBER_COUNT do
+        if ch:get(10) then
+            finished = finished + 1
+        end
+    end
+    test:is(finished, FIBER_COUNT, 'writers are not stuck after rollback')
+    test:ok(failed > 0, 'failed writes are rolled back')
+    test:is(s:count(), count + committed, 'only committed rows are visible')
+else
+    test:skip('writers are not stuck after rollback')
+    test:skip('failed writes are rolled back')
+    test:skip('only committed rows are visible')
+end
+
+s:drop()
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,71 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that a complete xlog file, which is read ahead in large
+-- chunks, can be read safely when it is truncated while being
+-- read or is corrupted.
+--
+local tap = require('tap')
+local fio = require('fio')
+local digest = require('digest')
+local xlog = require('xlog').pairs
+local test = tap.test('xlog_read')
+test:plan(3)
+
+box.cfg{log = 'tarantool.log'}
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+box.begin()
+for i = 1, 20000 do
+    -- Random data isn't compressed, so the file is large.
+    s:insert{i, digest.urandom(128)}
+end
+box.commit()
+box.snapshot()
+
+local snap = fio.pathjoin(box.cfg.memtx_dir,
+                          string.format('%020d.snap', box.info.signature))
+local dir = fio.tempdir()
+local copy = fio.pathjoin(dir, 'copy.snap')
+
+local function count_rows(on_row)
+    local count = 0
+    for _ in xlog(copy) do
+        count = count + 1
+        if on_row ~= nil then
+            on_row(count)
+        end
+    end
+    return count
+end
+
+fio.copyfile(snap, copy)
+local size = fio.stat(copy).size
+local middle = math.floor(size / 2)
+local total = count_rows()
+test:ok(total > 20000, "complete file is read")
+
+-- Truncate the file after a quarter of it has been read, so
+-- that rows already read ahead are decoded after truncation.
+local ok, count = pcall(count_rows, function(n)
+    if n == math.floor(total / 4) then
+        fio.truncate(copy, middle)
+    end
+end)
+test:ok(ok and count > 0 and count < total,
+        "file truncated while being read is read up to the end")
+
+copy = fio.pathjoin(dir, 'corrupt.snap')
+fio.copyfile(snap, copy)
+local fh = fio.open(copy, {'O_WRONLY'})
+fh:pwrite(string.rep('x', 1000), middle)
+fh:close()
+ok, count = pcall(count_rows)
+test:ok(ok and count > 0 and count < total,
+        "corrupted transactions are skipped")
+
+fio.rmtree(dir)
+s:drop()
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,70 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- A secondary index of a big memtx space is built in bulk, while
+-- the space stays writable. Changes made by statements which are
+-- rolled back during the build must not get into the index.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+N = 100000
+test_run:cmd("setopt delimiter ';'")
+for i = 1, N, 1000 do
+    box.begin()
+    for j = i, i + 999 do
+        s:insert{j, j}
+    end
+    box.commit()
+end;
+
+done = false;
+committed = 0;
+rolled_back = 0;
+function dml()
+    local i = 0
+    while not done do
+        i = i + 1
+        -- Rolled back explicitly.
+        box.begin()
+        s:replace{i % N + 1, -i}
+        s:insert{2 * N + i, -i}
+        s:delete{(i + 1) % N + 1}
+        box.rollback()
+        -- Rolled back by a yield.
+        box.begin()
+        s:replace{(i + 2) % N + 1, -i}
+        fiber.sleep(0)
+        pcall(box.commit)
+        rolled_back = rolled_back + 2
+        -- Committed.
+        s:replace{N + i, N + i}
+        s:delete{i}
+        committed = committed + 1
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+
+f = fiber.new(dml)
+f:set_joinable(true)
+_ = s:create_index('sk', {parts = {2, 'integer'}})
+done = true
+f:join()
+rolled_back > 0 and committed > 0
+
+-- No rolled back changes in the new index.
+s.index.sk:select({0}, {iterator = 'LT'})
+s.index.sk:count() == s:count()
+test_run:cmd("setopt delimiter ';'")
+ok = true;
+for _, t in s.index.sk:pairs() do
+    local pk_t = s:get(t[1])
+    if pk_t == nil or pk_t[2] ~= t[2] then
+        ok = false
+        break
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+ok
+
+s:drop()
@@ -0,0 +1,80 @@
+test_run = require('test_run').new()
+
+--
+-- net_msg_max is applied to each network thread separately.
+--
+test_run:cmd('create server iproto_threads with script = "box/lua/iproto_threads.lua"')
+test_run:cmd('start server iproto_threads')
+test_run:cmd('switch iproto_threads')
+
+fiber = require('fiber')
+net_box = require('net.box')
+box.cfg.iproto_threads
+#box.stat.net.thread()
+
+active = 0
+finished = 0
+continue = false
+conns = {}
+for i = 1, 10 do conns[i] = net_box.connect(box.cfg.listen) end
+box.stat.net.CONNECTIONS.current >= 10
+-- Connections are handed over to threads in turn.
+conns1 = box.stat.net.thread(1).CONNECTIONS.current
+conns2 = box.stat.net.thread(2).CONNECTIONS.current
+math.abs(conns1 - conns2) <= 1 or {conns1, conns2}
+
+test_run:cmd("setopt delimiter ';'")
+function do_long_f()
+    active = active + 1
+    while not continue do
+        fiber.sleep(0.01)
+    end
+    active = active - 1
+    finished = finished + 1
+end;
+
+function run_workers(count)
+    finished = 0
+    continue = false
+    for i = 1, count do
+        fiber.create(function() conns[i % #conns + 1]:call('do_long_f') end)
+    end
+end;
+
+-- Wait until 'active' stops growing - it means, that the input
+-- is blocked in all threads.
+function wait_blocked()
+    local old_active
+    repeat
+        old_active = active
+        fiber.sleep(0.1)
+    until old_active == active
+    return active
+end;
+test_run:cmd("setopt delimiter ''");
+
+--
+-- No more than net_msg_max + 1 requests are in fly in each
+-- thread.
+--
+box.cfg{net_msg_max = 2}
+run_workers(100)
+n = wait_blocked()
+n > 0 and n <= 2 * 3 or n
+
+--
+-- The limit is changed in all threads while they are serving
+-- requests, and raising it resumes stopped connections.
+--
+for i = 1, 20 do box.cfg{net_msg_max = 2 + i % 2 * 100} end
+box.cfg{net_msg_max = 1024}
+test_run:wait_cond(function() return active == 100 end)
+continue = true
+test_run:wait_cond(function() return finished == 100 end)
+
+for _, c in ipairs(conns) do c:close() end
+
+test_run:cmd('switch default')
+test_run:cmd('stop server iproto_threads')
+test_run:cmd('cleanup server iproto_threads')
+test_run:cmd('delete server iproto_threads')
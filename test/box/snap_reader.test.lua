@@ -0,0 +1,43 @@
+test_run = require('test_run').new()
+
+--
+-- A snapshot is read by a separate thread on recovery, and its
+-- rows are fed right to the primary key build. Check that all
+-- indexes of a space are recovered from a checkpoint, along with
+-- rows written to the WAL after it.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('hash', {type = 'hash', parts = {2, 'unsigned'}})
+_ = s:create_index('multi', {parts = {{3, 'string'}, {1, 'unsigned'}}})
+_ = s:create_index('nonunique', {unique = false, parts = {4, 'unsigned'}})
+box.begin() for i = 1, 100000 do s:replace{i, i * 2, 'v' .. i % 100, i % 10} end box.commit()
+box.snapshot()
+_ = s:replace{100001, 1, 'xlog', 0}
+
+test_run:cmd('restart server default')
+
+s = box.space.test
+s:count()
+s.index.hash:count()
+s.index.multi:count()
+s.index.nonunique:count()
+s.index.hash:get{2000}
+s:get{100001}
+#s.index.multi:select{'v7'}
+s.index.nonunique:count{0}
+
+test_run:cmd("setopt delimiter ';'")
+function check()
+    for _, t in s:pairs() do
+        if s.index.hash:get{t[2]}[1] ~= t[1] or
+           s.index.multi:get{t[3], t[1]}[1] ~= t[1] then
+            return t
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+check()
+
+s:drop()
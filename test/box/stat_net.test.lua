@@ -62,6 +62,12 @@ box.stat.net.REQUESTS.total
 box.stat.net.CONNECTIONS.current
 box.stat.net.REQUESTS.current
 
+-- per thread statistics
+#box.stat.net.thread()
+box.stat.net.thread(1).CONNECTIONS.current
+box.stat.net.thread()[1].REQUESTS.current
+box.stat.net.thread(2)
+
 box.schema.func.drop('tweedledee')
 space:drop() -- tweedledum
 cn:close()
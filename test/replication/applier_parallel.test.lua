@@ -0,0 +1,52 @@
+test_run = require('test_run').new()
+--
+-- Check that transactions changing different vinyl spaces, which
+-- the applier applies concurrently, and transactions changing
+-- memtx and system spaces in between are replicated in order.
+--
+box.schema.user.grant('guest', 'replication')
+_ = box.schema.space.create('v1', {engine = 'vinyl'})
+_ = box.space.v1:create_index('pk')
+_ = box.schema.space.create('v2', {engine = 'vinyl'})
+_ = box.space.v2:create_index('pk')
+_ = box.schema.space.create('m', {engine = 'memtx'})
+_ = box.space.m:create_index('pk')
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 1000 do
+    box.space.v1:replace{i, i}
+    box.space.v2:replace{i, i}
+    if i % 100 == 0 then
+        box.space.m:replace{i, box.space.v1:count()}
+        box.space.v1:replace{i, -i}
+    end
+    if i == 500 then
+        box.schema.space.create('v3', {engine = 'vinyl'})
+        box.space.v3:create_index('pk')
+    end
+    if i > 500 then
+        box.space.v3:replace{i}
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+
+test_run:wait_lsn('replica', 'default')
+test_run:switch('replica')
+box.space.v1:count(), box.space.v2:count(), box.space.v3:count()
+box.space.v1:get{300}, box.space.v1:get{301}, box.space.v2:get{300}
+box.space.m:select{}
+box.info.replication[1].upstream.status
+
+test_run:switch('default')
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.space.v1:drop()
+box.space.v2:drop()
+box.space.v3:drop()
+box.space.m:drop()
+box.schema.user.revoke('guest', 'replication')
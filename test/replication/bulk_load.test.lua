@@ -0,0 +1,37 @@
+test_run = require('test_run').new()
+--
+-- The tuples loaded with space:bulk_load() aren't written to
+-- WAL, so the load is refused while there are other instances
+-- in the replica set, even disconnected ones, unless the space
+-- isn't replicated.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = 'memtx'})
+_ = s:create_index('pk')
+l = box.schema.space.create('test_local', {engine = 'memtx', is_local = true})
+_ = l:create_index('pk')
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+test_run:wait_downstream(2, {status = 'follow'})
+
+s:bulk_load({{1}, {2}, {3}})
+s:count()
+l:bulk_load({{1}, {2}, {3}})
+l:count()
+
+-- A disconnected replica would miss the tuples on resubscribe.
+test_run:cmd("stop server replica")
+test_run:wait_downstream(2, {status = 'stopped'})
+s:bulk_load({{1}, {2}, {3}})
+s:count()
+
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+box.space._cluster:delete(2) ~= nil
+s:bulk_load({{1}, {2}, {3}})
+s:count()
+
+s:drop()
+l:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+--
+-- Check that a replica can ask the master to compress the JOIN
+-- and SUBSCRIBE streams.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica_compression.lua"')
+test_run:cmd('start server replica')
+
+for i = 1001, 2000 do s:replace{i, string.rep('y', 100)} end
+test_run:wait_lsn('replica', 'default')
+test_run:switch('replica')
+box.space.test:count()
+box.space.test:get{1000}[2] == string.rep('x', 100)
+box.space.test:get{2000}[2] == string.rep('y', 100)
+stat = box.info.replication[1].upstream.compression
+stat.bytes > stat.compressed_bytes, stat.ratio > 1
+test_run:switch('default')
+stat = box.info.replication[2].downstream.compression
+stat.bytes > stat.compressed_bytes, stat.ratio > 1
+
+--
+-- Compression is turned off on the next SUBSCRIBE.
+--
+test_run:switch('replica')
+box.cfg{replication_compression = false}
+replication = box.cfg.replication
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:switch('default')
+for i = 2001, 2100 do s:replace{i} end
+test_run:wait_lsn('replica', 'default')
+test_run:switch('replica')
+box.space.test:count()
+box.info.replication[1].upstream.compression
+test_run:switch('default')
+box.info.replication[2].downstream.compression
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+--
+-- Check that a replica can receive the initial JOIN data over
+-- several connections.
+--
+box.schema.user.grant('guest', 'replication')
+for i = 1, 3 do                                                     \
+    local m = box.schema.space.create('memtx' .. i)                 \
+    m:create_index('pk')                                            \
+    m:create_index('sk', {parts = {2, 'unsigned'}, unique = false}) \
+    local v = box.schema.space.create('vinyl' .. i, {engine = 'vinyl'}) \
+    v:create_index('pk')                                            \
+    for j = 1, 1000 * i do                                          \
+        m:replace{j, j % 10}                                        \
+        v:replace{j, j % 10}                                        \
+    end                                                             \
+end
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica_join_streams.lua"')
+test_run:cmd('start server replica')
+test_run:grep_log('default', 'sending initial data to replica') ~= nil
+
+for i = 1, 3 do box.space['memtx' .. i]:replace{0, 0} end
+test_run:wait_lsn('replica', 'default')
+test_run:switch('replica')
+counts = {}
+for i = 1, 3 do                                                     \
+    table.insert(counts, box.space['memtx' .. i]:count())           \
+    table.insert(counts, box.space['memtx' .. i].index.sk:count(5)) \
+    table.insert(counts, box.space['vinyl' .. i]:count())           \
+end
+counts
+
+box.cfg{replication_join_streams = 0}
+box.cfg{replication_join_streams = 17}
+box.cfg{replication_join_streams = 1}
+box.cfg.replication_join_streams
+
+test_run:switch('default')
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+for i = 1, 3 do                                                     \
+    box.space['memtx' .. i]:drop()                                  \
+    box.space['vinyl' .. i]:drop()                                  \
+end
+box.schema.user.revoke('guest', 'replication')
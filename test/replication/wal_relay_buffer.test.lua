@@ -0,0 +1,61 @@
+test_run = require('test_run').new()
+
+--
+-- A relay of a replica which keeps up with the master sends
+-- rows from the WAL memory buffer and goes back to xlog files
+-- when the rows it needs are discarded from the buffer.
+--
+test_run:cmd("create server master with script='replication/master_wal_buf.lua'")
+test_run:cmd('start server master')
+test_run:cmd('switch master')
+engine = test_run:get_cfg('engine')
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=master, script='replication/replica_timeout.lua'")
+test_run:cmd("start server replica with args='1'")
+
+-- The replica is in sync, rows are sent from the buffer.
+for i = 1, 100 do s:replace{i, i} end
+test_run:wait_log('master', 'reading rows from the WAL buffer', nil, 10) ~= nil
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test:count() == 100 end, 10)
+test_run:cmd('switch master')
+
+-- Stall the relay while the buffer overflows.
+fio = require('fio')
+log_size = fio.stat(box.cfg.log).size
+box.error.injection.set('ERRINJ_RELAY_SEND_DELAY', true)
+s:replace{0, 0}
+pad = string.rep('x', 1000)
+for i = 1, 200 do s:replace{i, pad} end
+box.error.injection.set('ERRINJ_RELAY_SEND_DELAY', false)
+test_run:wait_log('master', 'fell behind the WAL buffer', nil, 10) ~= nil
+
+-- All rows are sent, including the discarded ones.
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test:count() == 201 end, 10)
+box.space.test:get{1}[2] == string.rep('x', 1000)
+box.space.test:get{200}[2] == string.rep('x', 1000)
+test_run:cmd('switch master')
+
+-- Once caught up, the relay switches back to the buffer.
+test_run:cmd("setopt delimiter ';'")
+test_run:wait_cond(function()
+    local bytes = fio.stat(box.cfg.log).size - log_size
+    return test_run:grep_log('master', 'reading rows from the WAL buffer',
+                             bytes) ~= nil
+end, 10);
+test_run:cmd("setopt delimiter ''");
+s:replace{201, 201}
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test:get{201} ~= nil end, 10)
+
+test_run:cmd('switch default')
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+test_run:cmd('stop server master')
+test_run:cmd('cleanup server master')
+test_run:cmd('delete server master')
@@ -0,0 +1,124 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that aggregates over a full scan computed on vectors of
+-- decoded fields give the same results as the ordinary loop.
+--
+local tap = require('tap')
+local ffi = require('ffi')
+local fiber = require('fiber')
+local test = tap.test('sql_agg_scan')
+test:plan(13)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+box.execute([[CREATE TABLE t (id INT PRIMARY KEY, a INT, b DOUBLE,
+                              c NUMBER, d TEXT)]])
+local s = box.space.T
+for i = 1, 1000 do
+    local a = i % 7 == 0 and box.NULL or (i % 3 == 0 and -i or i)
+    s:replace{i, a, ffi.cast('double', i / 4), i % 2 == 0 and i or i / 2,
+              'v' .. i % 10}
+end
+
+local function rows(sql, ...)
+    local res, err = box.execute(sql, ...)
+    if res == nil then
+        return tostring(err)
+    end
+    return res.rows
+end
+
+local function uses_scan(sql)
+    for _, row in pairs(box.execute('EXPLAIN ' .. sql).rows) do
+        if row[2] == 'AggScan' then
+            return true
+        end
+    end
+    return false
+end
+
+--
+-- An unary plus hides a column from the vectorized scan, so the
+-- same query with pluses is computed by the ordinary loop.
+--
+local aggs = 'count(*), count(a), count(d), sum(a), total(a), avg(a), ' ..
+             'min(a), max(a), sum(b), min(c), max(c)'
+local plain = 'count(*), count(+a), count(+d), sum(+a), total(+a), ' ..
+              'avg(+a), min(+a), max(+a), sum(+b), min(+c), max(+c)'
+
+local sql = 'SELECT ' .. aggs .. ' FROM t'
+test:ok(uses_scan(sql), "vectorized scan is used")
+test:ok(not uses_scan('SELECT ' .. plain .. ' FROM t'),
+        "expressions are computed by the ordinary loop")
+test:is_deeply(rows(sql), rows('SELECT ' .. plain .. ' FROM t'),
+               "aggregates without filters")
+
+local where = ' WHERE b > 10 AND 600 >= c AND a <> 5'
+local plain_where = ' WHERE +b > 10 AND 600 >= +c AND +a <> 5'
+test:is_deeply(rows(sql .. where),
+               rows('SELECT ' .. plain .. ' FROM t' .. plain_where),
+               "aggregates with filters")
+
+test:is_deeply(rows(sql .. ' WHERE b > ? AND c < ?', {100.5, 300}),
+               rows('SELECT ' .. plain .. ' FROM t WHERE +b > ? AND +c < ?',
+                    {100.5, 300}),
+               "filters with parameters")
+test:is_deeply(rows(sql .. ' WHERE b > ?', {'abc'}),
+               rows('SELECT ' .. plain .. ' FROM t WHERE +b > ?', {'abc'}),
+               "filters with a non-numeric parameter")
+
+test:is_deeply(rows(sql .. ' WHERE b > 1000000'),
+               rows('SELECT ' .. plain .. ' FROM t WHERE +b > 1000000'),
+               "no rows pass the filter")
+
+-- Integer overflow is reported by the ordinary loop.
+local zero = ffi.cast('double', 0)
+s:replace{1001, 9223372036854775807LL, zero, 0, ''}
+s:replace{1002, 9223372036854775807LL, zero, 0, ''}
+test:is(rows('SELECT sum(a) FROM t'), rows('SELECT sum(+a) FROM t'),
+        "integer overflow")
+
+box.execute('DROP TABLE t')
+test:is(box.space.T, nil, "table is dropped")
+
+-- The scan reads within the current transaction.
+local v = box.schema.space.create('TV', {engine = 'vinyl', format = {
+    {'ID', 'integer'}, {'A', 'integer'}}})
+v:create_index('pk')
+for i = 1, 100 do
+    v:replace{i, i}
+end
+sql = 'SELECT count(*), sum(a) FROM tv'
+test:ok(uses_scan(sql), "vectorized scan is used for vinyl")
+box.begin()
+v:replace{101, 1000}
+local in_txn = rows(sql)[1]
+box.rollback()
+test:is_deeply({in_txn[1], in_txn[2]}, {101, 6050},
+               "scan sees changes of the transaction")
+v:drop()
+
+-- The scan can't access a space that is being bulk loaded.
+box.execute('CREATE TABLE tl (id INT PRIMARY KEY, a INT)')
+local tuples = {}
+for i = 1, 100000 do
+    tuples[i] = {i, i % 10}
+end
+local f = fiber.new(function()
+    box.space.TL:bulk_load(tuples)
+end)
+f:set_joinable(true)
+fiber.yield()
+test:like(rows('SELECT count(*), sum(a) FROM tl'),
+          'access to the space being loaded',
+          "space being loaded is not scanned")
+f:join()
+local loaded = rows('SELECT count(*), sum(a) FROM tl')[1]
+test:is_deeply({loaded[1], loaded[2]}, {100000, 450000},
+               "loaded space is scanned")
+box.execute('DROP TABLE tl')
+
+os.exit(test:check() and 0 or 1)
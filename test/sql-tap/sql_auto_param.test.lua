@@ -0,0 +1,125 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that unprepared queries which differ only in literals
+-- share a compiled statement in the prepared statement cache when
+-- the sql_auto_parameterize session setting is on.
+--
+local tap = require('tap')
+local net_box = require('net.box')
+local test = tap.test('sql_auto_param')
+test:plan(19)
+
+box.cfg{
+    log = 'tarantool.log',
+    listen = os.getenv('LISTEN') or 'localhost:3301',
+}
+
+local function stat()
+    return box.info.sql().cache
+end
+
+box.execute('CREATE TABLE t (id INT PRIMARY KEY, a INT, b TEXT)')
+box.execute("INSERT INTO t VALUES (1, 10, 'x'), (2, 20, 'y'), (3, 30, 'it''s')")
+
+local settings = box.session.settings
+test:is(settings.sql_auto_parameterize, false, "disabled by default")
+local before = stat()
+box.execute('SELECT id, a FROM t WHERE id = 1')
+box.execute('SELECT id, a FROM t WHERE id = 2')
+test:is(stat().auto_stmt_count, before.auto_stmt_count,
+        "nothing is cached when disabled")
+
+-- A literal and a parameter may be typed differently, so compare
+-- results and errors with the ones of the original queries.
+local queries = {
+    'SELECT id FROM t WHERE a > 15.5 ORDER BY id',
+    'SELECT id FROM t WHERE a = 20.0',
+    "SELECT id FROM t WHERE a = '20'",
+    "SELECT id FROM t WHERE b = 1",
+    'SELECT id FROM t WHERE id IN (1, 2.5, 3) ORDER BY id',
+    'SELECT id FROM t WHERE a = 18446744073709551615',
+    "UPDATE t SET a = a WHERE b = 'x' AND a < 1e2",
+}
+local function run_all()
+    local res = {}
+    for i, sql in ipairs(queries) do
+        local r, err = box.execute(sql)
+        if r ~= nil and r.rows ~= nil then
+            local rows = {}
+            for j, row in ipairs(r.rows) do
+                rows[j] = row[1]
+            end
+            res[i] = rows
+        else
+            res[i] = r ~= nil and r.row_count or tostring(err)
+        end
+    end
+    return res
+end
+local plain = run_all()
+settings.sql_auto_parameterize = true
+before = stat()
+test:is_deeply(run_all(), plain, "literals and parameters give same results")
+test:ok(stat().auto_stmt_count > before.auto_stmt_count,
+        "statements are cached when enabled")
+
+before = stat()
+local res = box.execute('SELECT id, a FROM t WHERE id = 1')
+test:is(res.rows[1][2], 10, "first query is executed")
+res = box.execute('SELECT  id, a FROM t   WHERE id = 2 -- comment')
+test:is(res.rows[1][2], 20, "query with another literal is executed")
+local after = stat()
+test:ok(after.hits > before.hits and after.misses > before.misses,
+        "second query reuses the statement")
+test:is(after.auto_stmt_count, before.auto_stmt_count + 1,
+        "one statement is cached")
+test:is_deeply({res.metadata[1].name, res.metadata[2].name}, {'ID', 'A'},
+               "metadata is not changed")
+
+res = box.execute("SELECT 'z', id FROM t WHERE b = 'it''s'")
+test:is_deeply(res.rows[1], {'z', 3},
+               "string literals are unescaped, result set is kept")
+
+box.execute("INSERT INTO t VALUES (4, 40, 'a'), (5, 50, 'ab')")
+res = box.execute('SELECT COUNT(*) FROM t WHERE id IN (4, 5, 6)')
+test:is(res.rows[1][1], 2, "IN and VALUES lists")
+res = box.execute("SELECT id FROM t WHERE b LIKE 'a%' ORDER BY id LIMIT 1")
+test:is(res.rows[1][1], 4, "LIKE and LIMIT")
+
+-- A schema change expires cached statements.
+box.execute('SELECT a FROM t WHERE id = 1')
+box.execute('ALTER TABLE t ADD CONSTRAINT c CHECK (a > 0)')
+before = stat()
+res = box.execute('SELECT a FROM t WHERE id = 2')
+test:ok(res.rows[1][1] == 20 and stat().misses == before.misses + 1,
+        "expired statement is compiled again")
+
+local _, cached_err = box.execute("SELECT * FROM t WHERE id = 'abc'")
+box.cfg{sql_cache_size = 0}
+test:is(stat().auto_stmt_count, 0, "statements are evicted with the quota")
+local _, err = box.execute("SELECT * FROM t WHERE id = 'abc'")
+test:is(tostring(cached_err), tostring(err), "errors are not changed")
+box.cfg{sql_cache_size = 5 * 1024 * 1024}
+
+-- Sessions with different SQL settings don't share statements.
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+local conn = net_box.connect(box.cfg.listen)
+conn:execute([[UPDATE "_session_settings" SET "value" = true
+               WHERE "name" = 'sql_full_column_names'
+               OR "name" = 'sql_auto_parameterize']])
+before = stat()
+res = conn:execute('SELECT id FROM t WHERE id = 1')
+test:is(res.metadata[1].name, 'T.ID', "session setting is applied")
+res = box.execute('SELECT id FROM t WHERE id = 2')
+test:is(res.metadata[1].name, 'ID',
+        "statement of another session is not reused")
+test:is(stat().auto_stmt_count, before.auto_stmt_count + 2,
+        "statement is cached per session settings")
+conn:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+
+box.execute('DROP TABLE t')
+test:is(box.space.T, nil, "table is dropped")
+
+os.exit(test:check() and 0 or 1)
@@ -0,0 +1,140 @@
+#!/usr/bin/env tarantool
+
+--
+-- Check that sorts which spill to temporary files give the same
+-- results as in-memory sorts and are done in worker threads only
+-- when the scanned spaces provide a consistent read view or the
+-- scan is complete.
+--
+local tap = require('tap')
+local fiber = require('fiber')
+local test = tap.test('sql_sort_memory')
+test:plan(15)
+
+box.cfg{
+    log = 'tarantool.log',
+}
+
+local settings = box.session.settings
+test:is(settings.sql_sort_memory, 16 * 1024 * 1024, "default budget")
+local ok = pcall(function() settings.sql_sort_memory = 'abc' end)
+test:ok(not ok, "budget must be unsigned")
+
+box.execute('CREATE TABLE t (id INT PRIMARY KEY, a INT, b TEXT)')
+local s = box.space.T
+local count = 20000
+box.begin()
+for i = 1, count do
+    s:replace{i, (i * 7919) % 1000, string.format('%05d', (i * 104729) % count)}
+end
+box.commit()
+
+local function sorted()
+    return box.execute('SELECT b, a FROM t ORDER BY b DESC, a').rows
+end
+local function grouped()
+    return box.execute('SELECT a, COUNT(*), MIN(b) FROM t GROUP BY a').rows
+end
+
+local in_memory = sorted()
+local groups = grouped()
+test:is(#in_memory, count, "all rows are sorted in memory")
+
+-- A small budget makes the sorter spill many runs to disk.
+settings.sql_sort_memory = 64 * 1024
+test:is_deeply(sorted(), in_memory, "spilled rows are sorted")
+test:is_deeply(grouped(), groups, "spilled groups are computed")
+
+-- Memtx has no read views, so a scan of a memtx space must not
+-- yield: rows written concurrently must not get into the middle of
+-- it. The final merge is done in a worker thread when the scan is
+-- complete, so rows inserted meanwhile are not sorted.
+local function expected(max_id)
+    local rows = {}
+    for _, t in s:pairs() do
+        if t[1] <= max_id then
+            table.insert(rows, {t[3], t[2]})
+        end
+    end
+    table.sort(rows, function(x, y)
+        if x[1] ~= y[1] then
+            return x[1] > y[1]
+        end
+        return x[2] < y[2]
+    end)
+    return rows
+end
+local function totable(rows)
+    local res = {}
+    for i, r in ipairs(rows) do
+        res[i] = {r[1], r[2]}
+    end
+    return res
+end
+local done = false
+local inserted = 0
+local writer = fiber.create(function()
+    while not done do
+        inserted = inserted + 1
+        s:replace{count + 1 + inserted, 0, '00000'}
+    end
+end)
+local before = inserted
+local spilled = totable(sorted())
+test:ok(inserted > before, "DML is done during the final merge")
+local snapshot = expected(#spilled + 1)
+local sum = 0
+before = inserted
+for _, r in ipairs(grouped()) do
+    sum = sum + r[2]
+end
+done = true
+test:is_deeply(spilled, snapshot, "spilled rows are consistent under DML")
+test:ok(sum >= count + before and sum <= count + inserted,
+        "spilled groups are consistent under DML")
+while writer:status() ~= 'dead' do
+    fiber.sleep(0.01)
+end
+test:ok(inserted > 0, "DML is done concurrently")
+for i = 1, inserted do
+    s:delete{count + 1 + i}
+end
+
+-- Vinyl reads from a read view, so the sort is done in a worker
+-- thread and other fibers run meanwhile.
+local v = box.schema.create_space('TV', {engine = 'vinyl', format = {
+    {'ID', 'integer'}, {'A', 'integer'}, {'B', 'string'}}})
+v:create_index('pk')
+for _, t in s:pairs() do
+    v:replace(t)
+end
+local steps = 0
+done = false
+fiber.create(function()
+    while not done do
+        steps = steps + 1
+        fiber.yield()
+    end
+end)
+local vinyl = box.execute('SELECT b, a FROM tv ORDER BY b DESC, a').rows
+done = true
+test:is_deeply(vinyl, in_memory, "spilled vinyl rows are sorted")
+test:ok(steps > 0, "other fibers run while vinyl rows are sorted")
+v:drop()
+
+-- Memtx transactions can't yield, so the sort is done in place.
+box.begin()
+local in_txn = sorted()
+s:replace{count + 1, 0, '99999'}
+box.commit()
+test:is_deeply(in_txn, in_memory, "rows are sorted in a transaction")
+test:is(s:get{count + 1}[3], '99999', "transaction is not aborted")
+
+settings.sql_sort_memory = 0
+test:is(#sorted(), count + 1, "minimal budget")
+settings.sql_sort_memory = 16 * 1024 * 1024
+
+box.execute('DROP TABLE t')
+test:is(box.space.T, nil, "table is dropped")
+
+os.exit(test:check() and 0 or 1)
@@ -1,4 +1,5 @@
 #include "salad/bloom.h"
+#include "salad/fuse.h"
 #include <unordered_set>
 #include <vector>
 #include <iostream>
@@ -96,9 +97,56 @@ store_load_test()
 	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
 }
 
+void
+fuse_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	srand(time(0));
+	uint32_t error_count = 0;
+	uint32_t fp_rate_too_big = 0;
+	for (uint32_t count = 0; count <= 100000; count = count * 3 + 1) {
+		uint64_t tests = 0;
+		uint64_t false_positive = 0;
+		unordered_set<uint32_t> check;
+		vector<uint32_t> hashes;
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t val = rand() % (count * 10);
+			check.insert(val);
+			hashes.push_back(h(val));
+		}
+		struct fuse fuse;
+		if (fuse_create(&fuse, hashes.data(), hashes.size()) != 0) {
+			error_count++;
+			continue;
+		}
+		struct fuse test = fuse;
+		char *buf = (char *)malloc(fuse_store_size(&fuse));
+		fuse_store(&fuse, buf);
+		fuse_destroy(&fuse);
+		fuse_load_table(&test, buf);
+		free(buf);
+		for (uint32_t i = 0; i < count * 10 + 10000; i++) {
+			bool has = check.find(i) != check.end();
+			bool fuse_possible = fuse_maybe_has(&test, h(i));
+			tests++;
+			if (has && !fuse_possible)
+				error_count++;
+			if (!has && fuse_possible)
+				false_positive++;
+		}
+		fuse_destroy(&test);
+		double fp_rate = (double)false_positive / tests;
+		if (fp_rate > 1. / 256 + 0.002)
+			fp_rate_too_big++;
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
+}
+
 int
 main(void)
 {
 	simple_test();
 	store_load_test();
+	fuse_test();
 }
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <time.h>
+#include <vector>
 
 #include "unit.h"
 #include "sptree.h"
@@ -187,6 +188,16 @@ simple_check()
 	if (test_size(&tree) != rounds)
 		fail("Tree count mismatch (1)", "true");
 
+	std::vector<type_t> keys;
+	for (unsigned int i = 0; i < 2 * rounds; i += 3)
+		keys.push_back(i);
+	std::vector<type_t *> found(keys.size());
+	test_find_batch(&tree, keys.data(), keys.size(), found.data());
+	for (size_t i = 0; i < keys.size(); i++) {
+		if (found[i] != test_find(&tree, keys[i]))
+			fail("batch find mismatch", "true");
+	}
+
 	for (unsigned int i = 0; i < rounds; i++) {
 		type_t v = i;
 		if (test_find(&tree, v) == NULL)
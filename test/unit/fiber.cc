@@ -158,6 +158,29 @@ fiber_stack_test()
 	fiber_sleep(0);
 	note("big-stack fiber not crashed");
 
+	/*
+	 * Test a fiber with a small stack. Such fibers are
+	 * reused only by fiber_new_small().
+	 */
+	stack_expand_limit = 32 * 1024;
+	struct fiber *small = fiber_new_small("test_stack", test_stack_f);
+	if (small == NULL)
+		diag_raise();
+	fiber_wakeup(small);
+	fiber_sleep(0);
+	note("small-stack fiber not crashed");
+	fiber = fiber_new_xc("noop", noop_f);
+	if (fiber == small)
+		fail("small stack is reused by a regular fiber", "true");
+	fiber_wakeup(fiber);
+	fiber = fiber_new_small("noop", noop_f);
+	if (fiber != small)
+		fail("small stack is not reused", "false");
+	if ((fiber->flags & FIBER_SMALL_STACK) == 0)
+		fail("small stack flag is lost", "false");
+	fiber_wakeup(fiber);
+	fiber_sleep(0);
+
 	footer();
 }
 
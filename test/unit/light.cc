@@ -109,6 +109,19 @@ simple_test()
 						identical = false;
 				}
 			}
+			std::vector<hash_t> hashes;
+			std::vector<hash_value_t> keys;
+			for (hash_value_t test = 0; test < limits; test++) {
+				hashes.push_back(hash(test));
+				keys.push_back(test);
+			}
+			std::vector<uint32_t> found(limits);
+			light_find_key_batch(&ht, hashes.data(), keys.data(),
+					     limits, found.data());
+			for (hash_value_t test = 0; test < limits; test++) {
+				if ((found[test] != light_end) != vect[test])
+					identical = false;
+			}
 			if (!identical)
 				fail("internal test failed!", "true");
 
@@ -0,0 +1,326 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <vector>
+#include <algorithm>
+#include <time.h>
+
+#include "unit.h"
+
+typedef uint64_t hash_value_t;
+typedef uint32_t hash_t;
+
+static const size_t swiss_extent_size = 16 * 1024;
+static size_t extents_count = 0;
+
+/* Multiplier applied to hashes, 1024 to test collisions. */
+static hash_t hash_mult = 1;
+
+hash_t
+hash(hash_value_t value)
+{
+	return (hash_t) value * hash_mult;
+}
+
+bool
+equal(hash_value_t v1, hash_value_t v2)
+{
+	return v1 == v2;
+}
+
+bool
+equal_key(hash_value_t v1, hash_value_t v2)
+{
+	return v1 == v2;
+}
+
+#define SWISS_NAME
+#define SWISS_DATA_TYPE uint64_t
+#define SWISS_KEY_TYPE uint64_t
+#define SWISS_CMP_ARG_TYPE int
+#define SWISS_EQUAL(a, b, arg) equal(a, b)
+#define SWISS_EQUAL_KEY(a, b, arg) equal_key(a, b)
+#define SWISS_HASH(a, arg) hash(a)
+#include "salad/swiss.h"
+
+inline void *
+my_swiss_alloc(void *ctx)
+{
+	size_t *p_extents_count = (size_t *)ctx;
+	assert(p_extents_count == &extents_count);
+	++*p_extents_count;
+	return malloc(swiss_extent_size);
+}
+
+inline void
+my_swiss_free(void *ctx, void *p)
+{
+	size_t *p_extents_count = (size_t *)ctx;
+	assert(p_extents_count == &extents_count);
+	--*p_extents_count;
+	free(p);
+}
+
+static void
+check_contents(struct swiss_core *ht, std::vector<bool> &vect)
+{
+	bool identical = true;
+	for (hash_value_t test = 0; test < vect.size(); test++) {
+		bool found = swiss_find(ht, hash(test), test) != NULL;
+		if (found != vect[test])
+			identical = false;
+		found = swiss_find_key(ht, hash(test), test) != NULL;
+		if (found != vect[test])
+			identical = false;
+	}
+	std::vector<hash_t> hashes;
+	std::vector<hash_value_t> keys;
+	for (hash_value_t test = 0; test < vect.size(); test++) {
+		hashes.push_back(hash(test));
+		keys.push_back(test);
+	}
+	std::vector<hash_value_t *> found(vect.size());
+	swiss_find_key_batch(ht, hashes.data(), keys.data(), vect.size(),
+			     found.data());
+	for (hash_value_t test = 0; test < vect.size(); test++) {
+		if ((found[test] != NULL) != vect[test])
+			identical = false;
+	}
+	if (!identical)
+		fail("internal test failed!", "true");
+	if (swiss_selfcheck(ht))
+		fail("selfcheck failed!", "true");
+}
+
+static void
+insert_delete_test(size_t rounds, size_t max_limits)
+{
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	std::vector<bool> vect;
+	size_t count = 0;
+	const size_t start_limits = 20;
+	for (size_t limits = start_limits; limits <= max_limits;
+	     limits *= 10) {
+		while (vect.size() < limits)
+			vect.push_back(false);
+		for (size_t i = 0; i < rounds; i++) {
+			hash_value_t val = rand() % limits;
+			hash_t h = hash(val);
+			bool has1 = swiss_find(&ht, h, val) != NULL;
+			bool has2 = vect[val];
+			if (has1 != has2) {
+				fail("find key failed!", "true");
+				return;
+			}
+			/* Insert more often than delete to grow. */
+			if (!has1) {
+				count++;
+				vect[val] = true;
+				if (swiss_insert(&ht, h, val) != 0)
+					fail("insert failed!", "true");
+			} else if (rand() % 3 == 0) {
+				hash_value_t replaced;
+				if (swiss_replace(&ht, h, val, &replaced) != 0 ||
+				    replaced != val)
+					fail("replace failed!", "true");
+			} else {
+				count--;
+				vect[val] = false;
+				if (swiss_delete_value(&ht, h, val) != 0)
+					fail("delete failed!", "true");
+			}
+			if (count != ht.count)
+				fail("count check failed!", "true");
+			if (i % 64 == 0)
+				check_contents(&ht, vect);
+		}
+		check_contents(&ht, vect);
+	}
+	swiss_destroy(&ht);
+}
+
+static void
+simple_test()
+{
+	header();
+	hash_mult = 1;
+	insert_delete_test(5000, 20000);
+	footer();
+}
+
+static void
+collision_test()
+{
+	header();
+	hash_mult = 1024;
+	insert_delete_test(1000, 2000);
+	hash_mult = 1;
+	footer();
+}
+
+static void
+iterator_test()
+{
+	header();
+
+	struct swiss_core ht;
+	swiss_create(&ht, swiss_extent_size,
+		     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+	const size_t rounds = 1000;
+	const size_t start_limits = 20;
+
+	const size_t iterator_count = 16;
+	struct swiss_iterator iterators[iterator_count];
+	for (size_t i = 0; i < iterator_count; i++)
+		swiss_iterator_begin(&ht, iterators + i);
+	size_t cur_iterator = 0;
+	hash_value_t strage_thing = 0;
+
+	for (size_t limits = start_limits; limits <= 2 * rounds;
+	     limits *= 10) {
+		for (size_t i = 0; i < rounds; i++) {
+			hash_value_t val = rand() % limits;
+			hash_t h = hash(val);
+			if (swiss_find(&ht, h, val) == NULL)
+				swiss_insert(&ht, h, val);
+			else
+				swiss_delete_value(&ht, h, val);
+
+			hash_value_t *pval = swiss_iterator_get_and_next(
+				&ht, iterators + cur_iterator);
+			if (pval)
+				strage_thing ^= *pval;
+			if (!pval || (rand() % iterator_count) == 0) {
+				if (rand() % iterator_count) {
+					hash_value_t val = rand() % limits;
+					hash_t h = hash(val);
+					swiss_iterator_key(&ht,
+						iterators + cur_iterator,
+						h, val);
+				} else {
+					swiss_iterator_begin(&ht,
+						iterators + cur_iterator);
+				}
+			}
+
+			cur_iterator++;
+			if (cur_iterator >= iterator_count)
+				cur_iterator = 0;
+		}
+	}
+
+	/* A full scan of a table that is not modified. */
+	std::vector<hash_value_t> scan;
+	struct swiss_iterator itr;
+	swiss_iterator_begin(&ht, &itr);
+	hash_value_t *e;
+	while ((e = swiss_iterator_get_and_next(&ht, &itr)))
+		scan.push_back(*e);
+	if (scan.size() != ht.count)
+		fail("full scan failed", "true");
+	std::sort(scan.begin(), scan.end());
+	if (std::unique(scan.begin(), scan.end()) != scan.end())
+		fail("full scan returned duplicates", "true");
+
+	swiss_destroy(&ht);
+
+	if (strage_thing >> 20) {
+		printf("impossible!\n"); // prevent strage_thing to be optimized out
+	}
+
+	footer();
+}
+
+static void
+iterator_freeze_check()
+{
+	header();
+
+	const int test_data_size = 1000;
+	const int test_data_mod = 2000;
+	srand(0);
+	struct swiss_core ht;
+
+	for (int i = 0; i < 10; i++) {
+		swiss_create(&ht, swiss_extent_size,
+			     my_swiss_alloc, my_swiss_free, &extents_count, 0);
+		/* Vary the size to freeze in different resize states. */
+		int size = test_data_size + i * 97;
+		for (int j = 0; j < size; j++) {
+			hash_value_t val = rand() % test_data_mod;
+			hash_t h = hash(val);
+			if (swiss_find(&ht, h, val) == NULL)
+				swiss_insert(&ht, h, val);
+		}
+		std::vector<hash_value_t> comp_buf;
+		struct swiss_iterator iterator;
+		swiss_iterator_begin(&ht, &iterator);
+		hash_value_t *e;
+		while ((e = swiss_iterator_get_and_next(&ht, &iterator)))
+			comp_buf.push_back(*e);
+		struct swiss_iterator iterator1;
+		swiss_iterator_begin(&ht, &iterator1);
+		swiss_iterator_freeze(&ht, &iterator1);
+		struct swiss_iterator iterator2;
+		swiss_iterator_begin(&ht, &iterator2);
+		swiss_iterator_freeze(&ht, &iterator2);
+		/* Grow the table several times. */
+		for (int j = 0; j < 8 * size; j++) {
+			hash_value_t val = test_data_mod + rand();
+			hash_t h = hash(val);
+			if (swiss_find(&ht, h, val) == NULL)
+				swiss_insert(&ht, h, val);
+		}
+		size_t tested_count = 0;
+		while ((e = swiss_iterator_get_and_next(&ht, &iterator1))) {
+			if (tested_count >= comp_buf.size() ||
+			    *e != comp_buf[tested_count]) {
+				fail("version restore failed (1)", "true");
+			}
+			tested_count++;
+		}
+		if (tested_count != comp_buf.size())
+			fail("version restore failed (2)", "true");
+		swiss_iterator_destroy(&ht, &iterator1);
+		for (int j = 0; j < test_data_size; j++) {
+			hash_value_t val = rand() % test_data_mod;
+			hash_t h = hash(val);
+			swiss_delete_value(&ht, h, val);
+		}
+		if (swiss_selfcheck(&ht))
+			fail("selfcheck failed!", "true");
+
+		tested_count = 0;
+		while ((e = swiss_iterator_get_and_next(&ht, &iterator2))) {
+			if (tested_count >= comp_buf.size() ||
+			    *e != comp_buf[tested_count]) {
+				fail("version restore failed (3)", "true");
+			}
+			tested_count++;
+		}
+		if (tested_count != comp_buf.size())
+			fail("version restore failed (4)", "true");
+		swiss_iterator_destroy(&ht, &iterator2);
+		if (ht.retired != NULL)
+			fail("retired table is not freed", "true");
+
+		swiss_destroy(&ht);
+	}
+
+	footer();
+}
+
+int
+main(int, const char**)
+{
+	srand(time(0));
+	simple_test();
+	collision_test();
+	iterator_test();
+	iterator_freeze_check();
+	if (extents_count != 0)
+		fail("memory leak!", "true");
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "unit.h"
+#include "msgpuck.h"
+#include "small/ibuf.h"
+
+#include "iproto_constants.h"
+#include "xrow.h"
+#include "xrow_ring.h"
+
+enum { BODY_SIZE_MAX = 4096 };
+
+static char body_buf[BODY_SIZE_MAX];
+
+static void
+row_create(struct xrow_header *row, uint32_t replica_id, int64_t lsn,
+	   uint32_t body_size)
+{
+	memset(row, 0, sizeof(*row));
+	row->type = IPROTO_INSERT;
+	row->replica_id = replica_id;
+	row->lsn = lsn;
+	row->tsn = lsn;
+	row->is_commit = true;
+	char *data = mp_encode_strl(body_buf, body_size);
+	memset(data, 'a' + lsn % 26, body_size);
+	row->body[0].iov_base = body_buf;
+	row->body[0].iov_len = data + body_size - body_buf;
+	row->bodycnt = 1;
+}
+
+/** Append rows with LSNs [from, to] of replica 1. */
+static int
+append_rows(struct xrow_ring *ring, int64_t from, int64_t to,
+	    uint32_t body_size)
+{
+	for (int64_t lsn = from; lsn <= to; lsn++) {
+		struct xrow_header row;
+		struct xrow_header *rows[] = { &row };
+		row_create(&row, 1, lsn, body_size);
+		if (xrow_ring_append(ring, rows, 1) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Read all rows starting from @a pos and check that they have
+ * contiguous LSNs starting from @a lsn. Return the number of
+ * rows read or -1 on error.
+ */
+static int
+read_rows(struct xrow_ring *ring, uint64_t *pos, int64_t lsn,
+	  uint32_t body_size)
+{
+	struct ibuf buf;
+	ibuf_create(&buf, &cord()->slabc, 1024);
+	int count = 0;
+	ssize_t len;
+	while ((len = xrow_ring_read(ring, pos, &buf)) > 0) {
+		const char *data = buf.rpos;
+		const char *end = data + len;
+		while (data < end) {
+			struct xrow_header row;
+			if (xrow_ring_decode(&data, end, &row) != 0 ||
+			    row.replica_id != 1 || row.lsn != lsn ||
+			    row.type != IPROTO_INSERT || row.bodycnt != 1) {
+				count = -1;
+				goto out;
+			}
+			const char *body = row.body[0].iov_base;
+			uint32_t size;
+			const char *str = mp_decode_str(&body, &size);
+			if (size != body_size || str[0] != 'a' + lsn % 26 ||
+			    str[size - 1] != 'a' + lsn % 26) {
+				count = -1;
+				goto out;
+			}
+			lsn++;
+			count++;
+		}
+		ibuf_reset(&buf);
+	}
+	if (len < 0)
+		count = -1;
+out:
+	ibuf_destroy(&buf);
+	return count;
+}
+
+static void
+test_basic(void)
+{
+	header();
+	plan(6);
+
+	struct vclock vclock;
+	vclock_create(&vclock);
+	vclock_follow(&vclock, 1, 10);
+	struct xrow_ring ring;
+	xrow_ring_create(&ring, 64 * 1024, &vclock);
+
+	uint64_t pos;
+	ok(xrow_ring_seek(&ring, &vclock, &pos), "seek empty ring");
+	is(read_rows(&ring, &pos, 11, 10), 0, "read empty ring");
+
+	is(append_rows(&ring, 11, 110, 10), 0, "append");
+	is(read_rows(&ring, &pos, 11, 10), 100, "read appended rows");
+	is(read_rows(&ring, &pos, 111, 10), 0, "read up to the end");
+
+	struct vclock older;
+	vclock_create(&older);
+	vclock_follow(&older, 1, 5);
+	ok(!xrow_ring_seek(&ring, &older, &pos), "seek older rows");
+
+	xrow_ring_destroy(&ring);
+	check_plan();
+	footer();
+}
+
+static void
+test_overflow(void)
+{
+	header();
+	plan(7);
+
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct xrow_ring ring;
+	xrow_ring_create(&ring, 1000, &vclock);
+
+	uint64_t old_pos;
+	xrow_ring_seek(&ring, &vclock, &old_pos);
+	is(append_rows(&ring, 1, 100, 50), 0, "append more than fits");
+	int64_t lsn = vclock_get(&ring.vclock, 1);
+	ok(lsn > 0 && lsn < 100, "old rows are discarded");
+	ok(ring.end - ring.begin <= ring.size, "ring size is not exceeded");
+
+	uint64_t pos;
+	ok(!xrow_ring_seek(&ring, &vclock, &pos), "seek discarded rows");
+	is(read_rows(&ring, &old_pos, 1, 50), -1, "read discarded rows");
+	ok(xrow_ring_seek(&ring, &ring.vclock, &pos), "seek oldest row");
+	is(read_rows(&ring, &pos, lsn + 1, 50), 100 - lsn,
+	   "read rows which fit");
+
+	xrow_ring_destroy(&ring);
+	check_plan();
+	footer();
+}
+
+static void
+test_big_row(void)
+{
+	header();
+	plan(5);
+
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct xrow_ring ring;
+	xrow_ring_create(&ring, 1000, &vclock);
+
+	uint64_t pos;
+	xrow_ring_seek(&ring, &vclock, &pos);
+	is(append_rows(&ring, 1, 5, 10), 0, "append small rows");
+	is(append_rows(&ring, 6, 6, 2000), 0, "append a row larger than ring");
+	is(vclock_get(&ring.vclock, 1), 6, "all rows are discarded");
+	is(read_rows(&ring, &pos, 1, 10), -1, "read discarded rows");
+
+	append_rows(&ring, 7, 8, 10);
+	xrow_ring_seek(&ring, &ring.vclock, &pos);
+	is(read_rows(&ring, &pos, 7, 10), 2, "read rows after the large one");
+
+	xrow_ring_destroy(&ring);
+	check_plan();
+	footer();
+}
+
+static void
+test_reset(void)
+{
+	header();
+	plan(3);
+
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct xrow_ring ring;
+	xrow_ring_create(&ring, 1000, &vclock);
+
+	append_rows(&ring, 1, 5, 10);
+	vclock_follow(&vclock, 1, 7);
+	xrow_ring_reset(&ring, &vclock);
+
+	uint64_t pos;
+	ok(xrow_ring_seek(&ring, &vclock, &pos), "seek after reset");
+	is(read_rows(&ring, &pos, 8, 10), 0, "ring is empty after reset");
+	append_rows(&ring, 8, 9, 10);
+	is(read_rows(&ring, &pos, 8, 10), 2, "read rows after reset");
+
+	xrow_ring_destroy(&ring);
+	check_plan();
+	footer();
+}
+
+int
+main(void)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	plan(4);
+
+	test_basic();
+	test_overflow();
+	test_big_row();
+	test_reset();
+
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
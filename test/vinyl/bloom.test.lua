@@ -151,3 +151,80 @@ s:get(-1LL)
 s:get(9007199254740992LL)
 s:get(-9007199254740994LL)
 s:drop()
+
+--
+-- Binary fuse filters.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}, bloom_type = 'fuse'})
+s.index.pk.options.bloom_type
+
+reflects = 0
+function cur_reflects() return box.space.test.index.pk:stat().disk.iterator.bloom.hit end
+function new_reflects() local o = reflects reflects = cur_reflects() return reflects - o end
+seeks = 0
+function cur_seeks() return box.space.test.index.pk:stat().disk.iterator.lookup end
+function new_seeks() local o = seeks seeks = cur_seeks() return seeks - o end
+
+for i = 1, 1000 do s:replace{math.ceil(i / 10), i} end
+box.snapshot()
+
+_ = new_reflects()
+_ = new_seeks()
+
+for i = 1, 100 do s:select{i} end
+new_reflects() == 0
+new_seeks() == 100
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), i} end
+new_reflects() == 0
+new_seeks() == 1000
+
+for i = 1001, 2000 do s:select{i} end
+new_reflects() > 980
+new_seeks() < 20
+
+for i = 1, 1000 do s:select{i, i + 1000} end
+new_reflects() > 980
+new_seeks() < 20
+
+test_run:cmd('restart server default')
+
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.space.test
+s.index.pk.options.bloom_type
+
+reflects = 0
+function cur_reflects() return box.space.test.index.pk:stat().disk.iterator.bloom.hit end
+function new_reflects() local o = reflects reflects = cur_reflects() return reflects - o end
+seeks = 0
+function cur_seeks() return box.space.test.index.pk:stat().disk.iterator.lookup end
+function new_seeks() local o = seeks seeks = cur_seeks() return seeks - o end
+
+_ = new_reflects()
+_ = new_seeks()
+
+for i = 1, 100 do s:select{i} end
+new_reflects() == 0
+new_seeks() == 100
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), i} end
+new_reflects() == 0
+new_seeks() == 1000
+
+for i = 1001, 2000 do s:select{i} end
+new_reflects() > 980
+new_seeks() < 20
+
+for i = 1, 1000 do s:select{i, i + 1000} end
+new_reflects() > 980
+new_seeks() < 20
+
+s:drop()
+
+box.cfg{vinyl_cache = vinyl_cache}
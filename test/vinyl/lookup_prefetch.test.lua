@@ -0,0 +1,127 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Point lookups with older runs read ahead. The suite turns
+-- read-ahead off to keep disk statistics stable, so check its
+-- results here.
+--
+box.cfg{vinyl_lookup_prefetch = 4}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 20})
+
+-- Every run has REPLACE, DELETE and UPSERT statements, some of
+-- them shadowing statements of older runs.
+test_run:cmd("setopt delimiter ';'")
+model = {}
+for r = 1, 8 do
+    for i = 1, 200 do
+        local op = (i * 7 + r * 3) % 4
+        if op == 0 then
+            s:replace{i, r, 0}
+            model[i] = {i, r, 0}
+        elseif op == 1 then
+            s:delete{i}
+            model[i] = nil
+        elseif op == 2 then
+            s:upsert({i, r, 0}, {{'+', 3, 1}})
+            if model[i] == nil then
+                model[i] = {i, r, 0}
+            else
+                model[i] = {i, model[i][2], model[i][3] + 1}
+            end
+        end
+    end
+    box.snapshot()
+end;
+function equal(t, m)
+    if t == nil or m == nil then
+        return t == nil and m == nil
+    end
+    return t[1] == m[1] and t[2] == m[2] and t[3] == m[3]
+end;
+function check()
+    for i = 1, 200 do
+        if not equal(s:get{i}, model[i]) then
+            return i
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+s.index.pk:stat().run_count
+check()
+
+-- Keys absent in all runs are ruled out by bloom filters.
+hit = s.index.pk:stat().disk.iterator.bloom.hit
+absent = 0
+for i = 1001, 1100 do if s:get{i} == nil then absent = absent + 1 end end
+absent
+s.index.pk:stat().disk.iterator.bloom.hit - hit > 0
+
+-- Concurrent lookups.
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() ch:put(check()) end) end
+ok = true
+for i = 1, 10 do ok = ch:get() == true and ok end
+ok
+
+-- A transaction doesn't see statements committed after its
+-- read view was opened, read-ahead results included.
+s:replace{1, 50, 50}
+box.snapshot()
+c = fiber.channel(1)
+function update() s:replace{1, 100, 100} box.snapshot() c:put(true) end
+box.begin() old = s:get{1} _ = fiber.create(update) c:get() new = s:get{1} box.commit()
+old
+new
+s:get{1}
+model[1] = {1, 100, 100}
+check()
+
+-- Lookups racing with dumps. A reader may see either version
+-- of a tuple being replaced.
+test_run:cmd("setopt delimiter ';'")
+function check_racing()
+    for i = 1, 200 do
+        local t = s:get{i}
+        if not equal(t, model[i]) and not equal(t, {i, i, i}) then
+            return i
+        end
+    end
+    return true
+end;
+done = false;
+readers = {};
+for i = 1, 5 do
+    readers[i] = fiber.new(function()
+        local r = true
+        while not done do
+            r = check_racing() == true and r
+            fiber.yield()
+        end
+        return r
+    end)
+    readers[i]:set_joinable(true)
+end;
+for i = 1, 200 do
+    s:replace{i, i, i}
+    if i % 50 == 0 then
+        box.snapshot()
+    end
+end;
+done = true;
+ok = true;
+for i = 1, 5 do
+    local _, r = readers[i]:join()
+    ok = r and ok
+end;
+test_run:cmd("setopt delimiter ''");
+ok
+for i = 1, 200 do model[i] = {i, i, i} end
+check()
+
+s:drop()
+box.cfg{vinyl_lookup_prefetch = 0}
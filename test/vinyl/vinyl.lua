@@ -12,6 +12,8 @@ box.cfg {
     vinyl_run_count_per_level = 1,
     vinyl_run_size_ratio = 2,
     vinyl_cache = 10240, -- 10kB
+    vinyl_page_cache = 0,
+    vinyl_lookup_prefetch = 0,
     vinyl_max_tuple_size = 1024 * 1024 * 6,
 }
 
@@ -213,15 +213,6 @@ loop:SWAPINIT(a, es);
 /*		qsort_arg(pn - r, r / es, es, cmp, arg);*/
 }
 
-#ifdef HAVE_OPENMP
-/**
- * Multi-thread version of qsort. Only present when target machine supports
- * open MP.
- */
-void qsort_arg_mt(void *a, size_t n, size_t es,
-		  int (*cmp)(const void *, const void *, void *), void *arg);
-#endif
-
 /**
  * General version of qsort that calls single-threaded of multi-threaded
  * qsort depending on open MP availability and given array size.
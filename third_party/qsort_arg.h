@@ -15,6 +15,15 @@ extern "C" {
 void qsort_arg(void *a, size_t n, size_t es,
 	       int (*cmp)(const void *a, const void *b, void *arg), void *arg);
 
+#ifdef HAVE_OPENMP
+/**
+ * Multi-thread version of qsort. Only present when target machine supports
+ * open MP.
+ */
+void qsort_arg_mt(void *a, size_t n, size_t es,
+		  int (*cmp)(const void *, const void *, void *), void *arg);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif /* defined(__cplusplus) */